@@ -0,0 +1,150 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*! \file AsmBinaryCache.h
+ * \brief on-disk cache of binaries generated by assembler
+ */
+
+#ifndef __CLRX_ASMBINARYCACHE_H__
+#define __CLRX_ASMBINARYCACHE_H__
+
+#include <CLRX/Config.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/amdasm/Assembler.h>
+
+/// main namespace
+namespace CLRX
+{
+
+/// key of the assembler binary cache (128-bit hash)
+struct AsmCacheKey
+{
+    uint64_t hash[2];   ///< hash value
+    
+    /// equal operator
+    bool operator==(const AsmCacheKey& k) const
+    { return hash[0]==k.hash[0] && hash[1]==k.hash[1]; }
+    /// not equal operator
+    bool operator!=(const AsmCacheKey& k) const
+    { return hash[0]!=k.hash[0] || hash[1]!=k.hash[1]; }
+    /// less operator
+    bool operator<(const AsmCacheKey& k) const
+    { return hash[0]<k.hash[0] || (hash[0]==k.hash[0] && hash[1]<k.hash[1]); }
+    
+    /// get key as hexadecimal string (32 digits)
+    std::string toString() const;
+};
+
+/// incremental 128-bit hasher (non-cryptographic, MurmurHash3 x64 128-bit)
+class AsmCacheHasher
+{
+private:
+    uint64_t h1, h2;
+    uint64_t length;
+    cxbyte buffer[16];
+    cxuint bufferSize;
+    
+    void processBlock(const cxbyte* block);
+public:
+    /// constructor
+    AsmCacheHasher();
+    
+    /// add data to hash
+    void update(size_t size, const void* data);
+    /// add integer value to hash (in little-endian order)
+    void updateValue(uint64_t value);
+    /// add string with its length to hash
+    void updateString(const char* str);
+    
+    /// get final hash
+    AsmCacheKey finish() const;
+};
+
+/// on-disk content-addressed cache of binaries generated by assembler
+/** Entry key is the hash of the source code content and all assembler settings which
+ * change the output: binary format, GPU device type, bitness, driver and LLVM versions,
+ * policy version, flags, defsyms and include paths. An entry holds also paths and
+ * content hashes of all files included by '.include' and '.incbin'. An entry is valid
+ * only if these files have not been changed. Paths tried without success while
+ * searching these files are also kept, and an entry is not valid if any of them exists
+ * (because assembler would include other file).
+ *
+ * Entries are written to temporary files and renamed to final names, hence
+ * many processes can use the same cache directory without locks. If total size of
+ * the entries exceeds maximal size, then the least recently used entries are removed.
+ */
+class AsmBinaryCache: public NonCopyableAndNonMovable
+{
+private:
+    std::string directory;
+    uint64_t maxSize;
+    
+    std::string getEntryPath(const AsmCacheKey& key) const;
+public:
+    /// constructor
+    /**
+     * \param directory cache directory (created if it does not exist)
+     * \param maxSize maximal total size of entries in bytes (0 - unlimited)
+     */
+    explicit AsmBinaryCache(const CString& directory, uint64_t maxSize = 0);
+    
+    /// get cache directory
+    const std::string& getDirectory() const
+    { return directory; }
+    /// get maximal total size of entries
+    uint64_t getMaxSize() const
+    { return maxSize; }
+    
+    /// compute key from assembler settings and source code given in memory
+    /** assembler must be fully set up (before assembling) */
+    static AsmCacheKey computeKey(const Assembler& assembler, size_t sourceSize,
+                const char* source);
+    /// compute key from assembler settings and content of its source files
+    /** assembler must be fully set up (before assembling) */
+    static AsmCacheKey computeKey(const Assembler& assembler);
+    
+    /// find binary in cache
+    /**
+     * \param key entry key
+     * \param binary output binary
+     * \param depFiles optional output for included files of entry
+     * \param failedPaths optional output for paths tried while searching included files
+     * \return true if valid entry found
+     */
+    bool find(const AsmCacheKey& key, Array<cxbyte>& binary,
+                std::vector<CString>* depFiles = nullptr,
+                std::vector<CString>* failedPaths = nullptr) const;
+    /// store binary generated by assembler in cache
+    /**
+     * \param key entry key
+     * \param assembler assembler after assembling (to get dependency files)
+     * \param binary binary
+     */
+    void store(const AsmCacheKey& key, const Assembler& assembler,
+                const Array<cxbyte>& binary) const;
+    /// remove least recently used entries if total size is greater than maximal size
+    void evict() const;
+};
+
+};
+
+#endif
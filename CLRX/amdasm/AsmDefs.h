@@ -154,6 +154,7 @@ struct AsmSymbol
     cxuint regRange:1;          ///< if symbol is register range
     cxuint detached:1;
     cxuint withUnevalExpr:1;
+    cxuint pendingResolve:1;    ///< symbol is in pending symbols of assembler
     uint64_t value;         ///< value of symbol
     uint64_t size;          ///< size of symbol
     union {
@@ -169,21 +170,21 @@ struct AsmSymbol
             refCount(1), sectionId(ASMSECT_ABS), info(0), other(0), hasValue(false),
             onceDefined(_onceDefined), resolving(false), base(false), snapshot(false),
             regRange(false), detached(false), withUnevalExpr(false),
-            value(0), size(0), expression(nullptr)
+            pendingResolve(false), value(0), size(0), expression(nullptr)
     { }
     /// constructor with expression
     explicit AsmSymbol(AsmExpression* expr, bool _onceDefined = false, bool _base = false) :
             refCount(1), sectionId(ASMSECT_ABS), info(0), other(0), hasValue(false),
             onceDefined(_onceDefined), resolving(false), base(_base),
             snapshot(false), regRange(false), detached(false), withUnevalExpr(false),
-            value(0), size(0), expression(expr)
+            pendingResolve(false), value(0), size(0), expression(expr)
     { }
     /// constructor with value and section id
     explicit AsmSymbol(AsmSectionId _sectionId, uint64_t _value, bool _onceDefined = false)
             : refCount(1), sectionId(_sectionId), info(0), other(0), hasValue(true),
             onceDefined(_onceDefined), resolving(false), base(false), snapshot(false),
             regRange(false), detached(false), withUnevalExpr(false),
-            value(_value), size(0), expression(nullptr)
+            pendingResolve(false), value(_value), size(0), expression(nullptr)
     { }
     /// destructor
     ~AsmSymbol();
@@ -722,6 +723,10 @@ struct AsmSection
     AsmSection(const AsmSection& section);
     /// copy assignment
     AsmSection& operator=(const AsmSection& section);
+    /// move constructor (content and handlers are not copied)
+    AsmSection(AsmSection&& section) noexcept;
+    /// move assignment (content and handlers are not copied)
+    AsmSection& operator=(AsmSection&& section) noexcept;
     
     /// add code flow entry to this section
     void addCodeFlowEntry(const AsmCodeFlowEntry& entry)
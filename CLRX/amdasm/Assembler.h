@@ -63,10 +63,14 @@ enum: Flags
     ASM_MACRONOCASE = 16, /// disable case-insensitive naming (default)
     ASM_OLDMODPARAM = 32,   ///< use old modifier parametrization (values 0 and 1 only)
     ASM_WAVE32 = 64, ///< use WAVESIZE32
+    ASM_ALIGNOPT = 128, ///< optimise code alignment of labels (jump targets)
+    ASM_SHRINKCODE = 256, ///< choose shortest encoding by swapping operands
+    ASM_STATS = 512,    ///< collect statistics (phase timings and counters)
     ASM_TESTRESOLVE = (1U<<30), ///< enable resolving symbols if ASM_TESTRUN enabled
     ASM_TESTRUN = (1U<<31), ///< only for running tests
     ASM_ALL = FLAGS_ALL&~(ASM_TESTRUN|ASM_TESTRESOLVE|ASM_BUGGYFPLIT|ASM_MACRONOCASE|
-                    ASM_WAVE32|ASM_OLDMODPARAM)  ///< all flags
+                    ASM_WAVE32|ASM_OLDMODPARAM|ASM_ALIGNOPT|
+                    ASM_SHRINKCODE|ASM_STATS)  ///< all flags
 };
 
 enum: Flags
@@ -263,6 +267,15 @@ public:
     virtual void getRegisterRanges(size_t& regTypesNum, cxuint* regRanges) const = 0;
     /// fill alignment when value is not given
     virtual void fillAlignment(size_t size, cxbyte* output) = 0;
+    /// get padding size before code label at offset to avoid jump penalties
+    /** only labels that are targets of already assembled jumps are padded.
+     * \param offset offset of label in code section
+     * \param label label symbol (with occurrences in jump expressions)
+     * \param penaltyCycles returned penalty cycles removed by padding
+     * \return padding size in bytes (filled by fillAlignment)
+     */
+    virtual size_t getCodeLabelPadding(uint64_t offset, const AsmSymbol& label,
+                cxuint& penaltyCycles) const = 0;
     /// parse register range
     virtual bool parseRegisterRange(const char*& linePtr, cxuint& regStart,
                         cxuint& regEnd, const AsmRegVar*& regVar) = 0;
@@ -359,6 +372,8 @@ public:
     void getMaxRegistersNum(size_t& regTypesNum, cxuint* maxRegs) const;
     void getRegisterRanges(size_t& regTypesNum, cxuint* regRanges) const;
     void fillAlignment(size_t size, cxbyte* output);
+    size_t getCodeLabelPadding(uint64_t offset, const AsmSymbol& label,
+                cxuint& penaltyCycles) const;
     bool parseRegisterRange(const char*& linePtr, cxuint& regStart, cxuint& regEnd,
                 const AsmRegVar*& regVar);
     bool relocationIsFit(cxuint bits, AsmExprTargetType tgtType);
@@ -477,6 +492,11 @@ public:
     const VarIndexMap* getVregIndexMaps() const
     { return vregIndexMaps; }
     
+    const InterGraph* getInterGraphs() const
+    { return interGraphs; }
+    const Array<cxuint>* getGraphColorMaps() const
+    { return graphColorMaps; }
+    
     const std::unordered_map<size_t, VIdxSetEntry>& getVIdxRoutineMap() const
     { return vidxRoutineMap; }
     const std::unordered_map<size_t, VIdxSetEntry>& getVIdxCallMap() const
@@ -525,6 +545,43 @@ struct AsmClause
     AsmSourcePos prevIfPos; ///< position of previous if-clause
 };
 
+/// assembler phases measured by statistics
+enum: cxuint
+{
+    ASMPHASE_READLINE = 0,  ///< reading lines (from files, macros and repetitions)
+    ASMPHASE_MACROSUBST,    ///< macro substitutions
+    ASMPHASE_PSEUDOOPS,     ///< parsing pseudo-ops
+    ASMPHASE_INSTRS,        ///< parsing and encoding instructions
+    ASMPHASE_RESOLVESYMS,   ///< resolving symbols after assembling
+    ASMPHASE_SECTDIFFS,     ///< resolving section differences
+    ASMPHASE_PREPAREBIN,    ///< preparing binary by format handler
+    ASMPHASE_WRITEBIN,      ///< generating and writing binary
+    ASMPHASE_MAX = ASMPHASE_WRITEBIN    ///< last value
+};
+
+/// get name of the assembler phase
+extern const char* getAsmPhaseName(cxuint phase);
+
+/// assembler statistics (collected only if ASM_STATS is enabled)
+struct AsmStats
+{
+    uint64_t phaseNanos[ASMPHASE_MAX+1];    ///< time of the phases in nanoseconds
+    uint64_t linesRead;     ///< lines read (including lines from macros and repetitions)
+    uint64_t macroSubsts;   ///< number of macro substitutions
+    uint64_t exprsCreated;  ///< created expressions (except fast evaluated)
+    uint64_t symbolsNum;    ///< number of symbols in all scopes after assembling
+    uint64_t peakSectionBytes;  ///< peak of total size of sections content
+    
+    AsmStats()
+    { reset(); }
+    /// clear all counters
+    void reset()
+    {
+        std::fill(phaseNanos, phaseNanos+ASMPHASE_MAX+1, uint64_t(0));
+        linesRead = macroSubsts = exprsCreated = symbolsNum = peakSectionBytes = 0;
+    }
+};
+
 /// main class of assembler
 class Assembler: public NonCopyableAndNonMovable
 {
@@ -574,11 +631,15 @@ private:
     ISAAssembler* isaAssembler;
     std::vector<DefSym> defSyms;
     std::vector<CString> includeDirs;
+    std::vector<CString> dependencyFiles;
+    std::vector<CString> failedIncludePaths;
     std::vector<AsmSection> sections;
     std::vector<Array<AsmSectionId> > relSpacesSections;
     std::unordered_set<AsmSymbolEntry*> symbolSnapshots;
     std::unordered_set<AsmSymbolEntry*> symbolClones;
     std::vector<AsmExpression*> unevalExpressions;
+    // symbols that must be resolved at end of assembly
+    std::vector<AsmSymbolEntry*> pendingSymbols;
     std::vector<AsmRelocation> relocations;
     std::unordered_map<const AsmRegVar*, AsmRegVarLinears> regVarLinearsMap;
     AsmScope globalScope;
@@ -595,6 +656,12 @@ private:
     bool buggyFPLit;
     bool macroCase;
     bool oldModParam;
+    bool alignOpt;
+    uint64_t alignOptPenaltyCycles;
+    bool shrinkCode;
+    uint64_t shrinkCodeSavedBytes;
+    bool collectStats;
+    mutable AsmStats stats;
     Flags codeFlags;
     
     cxuint inclusionLevel;
@@ -749,6 +816,10 @@ private:
     }
     
     cxbyte* reserveData(size_t size, cxbyte fillValue = 0);
+    void alignCodeLabel(const AsmSymbol& label);
+    // get statistics if collecting enabled, otherwise null
+    AsmStats* getStatsIfEnabled() const
+    { return collectStats ? &stats : nullptr; }
     
     void goToMain(const char* pseudoOpPlace);
     void goToKernel(const char* pseudoOpPlace, const char* kernelName);
@@ -785,8 +856,11 @@ private:
     void handleRegionsOnKernels(const std::vector<AsmKernelId>& newKernels,
                 const std::vector<AsmKernelId>& oldKernels, AsmSectionId codeSection);
     
+    void addPendingSymbol(AsmSymbolEntry& symEntry);
     void tryToResolveSymbol(AsmSymbolEntry& symEntry);
     void tryToResolveSymbols(AsmScope* scope);
+    void detachScopeSymbols(AsmScope* scope);
+    void tryToResolvePendingSymbols();
     void printUnresolvedSymbols(AsmScope* scope);
     
     bool resolveExprTarget(const AsmExpression* expr, uint64_t value,
@@ -921,11 +995,40 @@ public:
     /// get true if buggyFPLit enabled
     bool isBuggyFPLit() const
     { return buggyFPLit; }
+    /// get true if alignment optimisation of code labels enabled
+    bool isAlignOpt() const
+    { return alignOpt; }
+    /// get penalty cycles removed by alignment optimisation
+    uint64_t getAlignOptPenaltyCycles() const
+    { return alignOptPenaltyCycles; }
+    /// get true if code shrinking enabled
+    bool isShrinkCode() const
+    { return shrinkCode; }
+    /// get number of bytes saved by code shrinking
+    uint64_t getShrinkCodeSavedBytes() const
+    { return shrinkCodeSavedBytes; }
+    /// get statistics (filled only if ASM_STATS enabled)
+    const AsmStats& getStats() const
+    { return stats; }
+    /// print statistics in human-readable form
+    void printStats(std::ostream& os) const;
     /// get include directory list
     const std::vector<CString>& getIncludeDirs() const
     { return includeDirs; }
     /// adds include directory
     void addIncludeDir(const CString& includeDir);
+    /// get source filenames (empty if source from stream)
+    const Array<CString>& getFilenames() const
+    { return filenames; }
+    /// get initial defsyms
+    const std::vector<DefSym>& getInitialDefSyms() const
+    { return defSyms; }
+    /// get paths of files included by '.include' and '.incbin' (after assembling)
+    const std::vector<CString>& getDependencyFiles() const
+    { return dependencyFiles; }
+    /// get paths tried without success while searching '.include' and '.incbin' files
+    const std::vector<CString>& getFailedIncludePaths() const
+    { return failedIncludePaths; }
     /// get symbols map
     const AsmSymbolMap& getSymbolMap() const
     { return globalScope.symbolMap; }
@@ -72,10 +72,84 @@ enum: Flags
     DISASM_HSACONFIG = 0x400,  ///< print HSA configuration
     DISASM_HSALAYOUT = 0x800,  ///< print in HSA layout (like Gallium or ROCm)
     DISASM_WAVE32 = 0x1000, ///< use WAVESIZE32
+    DISASM_CFG = 0x2000,    ///< build control flow graph of disassembled code
     
     ///< all disassembler flags (without config)
     DISASM_ALL = FLAGS_ALL&(~(DISASM_CONFIG|DISASM_BUGGYFPLIT|DISASM_WAVE32|
-                    DISASM_HSACONFIG|DISASM_HSALAYOUT))
+                    DISASM_HSACONFIG|DISASM_HSALAYOUT|DISASM_CFG))
+};
+
+/// type of instruction that ends basic block
+enum class DisasmCFGEndType: cxbyte
+{
+    FALLTHROUGH = 0,    ///< block ends before label (no control flow instruction)
+    JUMP,       ///< unconditional jump (s_branch)
+    CJUMP,      ///< conditional jump (s_cbranch_*, s_cbranch_i_fork)
+    CALL,       ///< subroutine call (s_call_b64)
+    SETPC,      ///< indirect jump or return (s_setpc_b64)
+    SWAPPC,     ///< indirect call (s_swappc_b64)
+    END         ///< end of program (s_endpgm*)
+};
+
+/// type of control flow graph edge
+enum class DisasmCFGEdgeType: cxbyte
+{
+    NEXT = 0,   ///< to next block
+    JUMP,       ///< to jump target
+    CALL        ///< to called subroutine
+};
+
+/// basic block of control flow graph
+struct DisasmCFGBlock
+{
+    size_t offset;      ///< offset of block in code
+    size_t size;        ///< size of block in bytes
+    size_t instrsNum;   ///< number of instructions
+    DisasmCFGEndType endType;   ///< type of last instruction
+};
+
+/// edge of control flow graph (between block offsets)
+struct DisasmCFGEdge
+{
+    size_t from;    ///< offset of source block
+    size_t to;      ///< target offset
+    DisasmCFGEdgeType type; ///< edge type
+};
+
+/// instruction of control flow graph
+struct DisasmCFGInstr
+{
+    size_t offset;          ///< offset of instruction in code
+    const char* mnemonic;   ///< instruction mnemonic (null if illegal)
+    cxbyte encoding;        ///< instruction encoding (ISA specific)
+    cxbyte size;            ///< size in bytes
+    uint32_t code;          ///< first word of instruction
+};
+
+/// control flow graph of single kernel (or code region)
+struct DisasmCFG
+{
+    CString name;       ///< kernel name (empty if unknown)
+    size_t codeIndex;   ///< index of code (kernels with separate code have own index)
+    std::vector<DisasmCFGBlock> blocks; ///< blocks sorted by offset
+    std::vector<DisasmCFGEdge> edges;   ///< edges
+    std::vector<DisasmCFGInstr> instrs; ///< instructions (in order of blocks)
+};
+
+/// resources used by kernel (recorded with DISASM_CFG and DISASM_CONFIG)
+struct DisasmKernelResources
+{
+    CString name;       ///< kernel name
+    cxuint sgprsNum;    ///< number of used SGPRs
+    cxuint vgprsNum;    ///< number of used VGPRs
+    size_t localSize;   ///< local (LDS) memory size
+};
+
+/// control flow graph output format
+enum class DisasmCFGFormat: cxbyte
+{
+    DOT = 0,    ///< Graphviz DOT
+    JSON        ///< JSON
 };
 
 struct GCNDisasmUtils;
@@ -86,9 +160,29 @@ class ISADisassembler: public NonCopyableAndNonMovable
 private:
     friend struct GCNDisasmUtils; // INTERNAL LOGIC
 public:
-    typedef std::vector<size_t>::const_iterator LabelIter;  ///< label iterator
+    /// label event type
+    enum: cxbyte
+    {
+        LABELEVENT_LABEL = 0,   ///< numbered label
+        LABELEVENT_NAMED,   ///< named label
+        LABELEVENT_RELOC,   ///< relocation
+        LABELEVENT_END      ///< end of events (always last)
+    };
     
+    /// label event (label, named label or relocation at offset)
+    struct LabelEvent
+    {
+        size_t offset;  ///< offset in code
+        cxbyte type;    ///< event type
+        size_t index;   ///< index of named label or relocation
+    };
+    /// label event iterator
+    typedef std::vector<LabelEvent>::const_iterator LabelEventIter;
+    /// label iterator
+    /** \deprecated use LabelEventIter */
+    typedef std::vector<size_t>::const_iterator LabelIter;
     /// named label iterator
+    /** \deprecated use LabelEventIter */
     typedef std::vector<std::pair<size_t, CString> >::const_iterator NamedLabelIter;
 protected:
     /// internal relocation structure
@@ -99,8 +193,16 @@ protected:
         int64_t addend; ///< relocation addend
     };
     
-    /// relocation iterator
-    typedef std::vector<std::pair<size_t, Relocation> >::const_iterator RelocIter;
+    /// control flow instruction (for building CFG)
+    struct CFGInstr
+    {
+        size_t offset;  ///< offset of instruction in input
+        DisasmCFGEndType type;  ///< instruction type
+        size_t target;  ///< target offset (jump or call)
+    };
+    
+    /// relocation iterator (relocations are in label events)
+    typedef LabelEventIter RelocIter;
     
     Disassembler& disassembler; ///< disassembler instance
     size_t startOffset; ///< start offset
@@ -112,24 +214,49 @@ protected:
     std::vector<std::pair<size_t, CString> > namedLabels;   ///< named labels
     std::vector<CString> relSymbols;    ///< symbols used by relocations
     std::vector<std::pair<size_t, Relocation> > relocations;    ///< relocations
+    /// labels, named labels and relocations sorted by offset (with end event)
+    std::vector<LabelEvent> labelEvents;
+    CString codeName;   ///< name of current code (for CFG)
+    size_t codeIndex;   ///< index of current code (for CFG)
     FastOutputBuffer output;    ///< output buffer
     
     /// constructor
-    explicit ISADisassembler(Disassembler& disassembler, cxuint outBufSize = 600);
+    explicit ISADisassembler(Disassembler& disassembler, cxuint outBufSize = 16384);
     
     /// write location in the code
     void writeLocation(size_t pos);
     /// write relocation to current place in instruction
     bool writeRelocation(size_t pos, RelocIter& relocIter);
+    /// write labels from label events before specified position
+    void writeLabelEvents(size_t pos, LabelEventIter& eventIter);
+    /// build control flow graphs of input code and add them to disassembler
+    /**
+     * \param instrs all instructions (in order, offsets relative to input)
+     * \param cfInstrs control flow instructions (in order)
+     */
+    void buildCFG(const std::vector<DisasmCFGInstr>& instrs,
+                  const std::vector<CFGInstr>& cfInstrs);
     
 public:
     virtual ~ISADisassembler();
     
     /// write all labels before specified position
+    void writeLabelsToPosition(size_t pos, LabelEventIter& eventIter)
+    {
+        if (eventIter->offset <= pos+startOffset)
+            writeLabelEvents(pos, eventIter);
+    }
+    /// write all labels to end
+    void writeLabelsToEnd(size_t start, LabelEventIter eventIter);
+    /// write all labels before specified position
+    /** \deprecated use version with LabelEventIter */
     void writeLabelsToPosition(size_t pos, LabelIter& labelIter,
                NamedLabelIter& namedLabelIter);
     /// write all labels to end
+    /** \deprecated use version with LabelEventIter */
     void writeLabelsToEnd(size_t start, LabelIter labelIter, NamedLabelIter namedLabelIter);
+    /// get first label event at or after specified offset
+    LabelEventIter findLabelEvent(size_t offset) const;
     
     /// set input code
     void setInput(size_t inputSize, const cxbyte* input, size_t startOffset = 0,
@@ -144,6 +271,13 @@ public:
     void setDontPrintLabels(bool after)
     { dontPrintLabelsAfterCode = after; }
     
+    /// set name and index of current code (used by CFG if no named label)
+    void setCodeName(const CString& name, size_t index)
+    {
+        codeName = name;
+        codeIndex = index;
+    }
+    
     /// analyze code before disassemblying
     virtual void analyzeBeforeDisassemble() = 0;
     
@@ -185,14 +319,27 @@ public:
     /// get named labels
     const std::vector<std::pair<size_t, CString> >& getNamedLabels() const
     { return namedLabels; }
+    /// get label events (prepared by prepareLabelsAndRelocations)
+    const std::vector<LabelEvent>& getLabelEvents() const
+    { return labelEvents; }
     /// flush output
     void flushOutput()
     { return output.flush(); }
     
+    /// get disassembler
+    const Disassembler& getDisassembler() const
+    { return disassembler; }
+    /// get disassembler
+    Disassembler& getDisassembler()
+    { return disassembler; }
+    
     /// get disassemblers flags
     Flags getFlags() const;
     /// set disassemblers flags
     void setFlags(Flags flags);
+    
+    /// add resources used by kernel (used if DISASM_CFG is set)
+    void addKernelResources(const DisasmKernelResources& resources);
 };
 
 /// GCN architectur dissassembler
@@ -204,7 +351,11 @@ private:
     friend struct GCNDisasmUtils; // INTERNAL LOGIC
 public:
     /// constructor
-    GCNDisassembler(Disassembler& disassembler);
+    /**
+     * \param disassembler main disassembler
+     * \param outBufSize size of output buffer
+     */
+    explicit GCNDisassembler(Disassembler& disassembler, cxuint outBufSize = 16384);
     /// destructor
     ~GCNDisassembler();
     
@@ -390,56 +541,75 @@ private:
     std::ostream& output;
     Flags flags;
     size_t sectionCount;
+    std::vector<CString> kernelNames;
+    CString dataFileName;
+    size_t dataFileMinSize;
+    std::unique_ptr<std::ostream> dataFile;
+    uint64_t dataFileSize;
+    std::vector<DisasmCFG> cfgs;
+    std::vector<DisasmKernelResources> kernelResources;
 public:
     /// constructor for 32-bit GPU binary
     /**
      * \param binary main GPU binary
      * \param output output stream
      * \param flags flags for disassembler
+     * \param kernelNames names of kernels to disassemble (empty - all kernels)
      */
     Disassembler(const AmdMainGPUBinary32& binary, std::ostream& output,
-                 Flags flags = 0);
+                 Flags flags = 0,
+                 const std::vector<CString>& kernelNames = std::vector<CString>());
     /// constructor for 64-bit GPU binary
     /**
      * \param binary main GPU binary
      * \param output output stream
      * \param flags flags for disassembler
+     * \param kernelNames names of kernels to disassemble (empty - all kernels)
      */
     Disassembler(const AmdMainGPUBinary64& binary, std::ostream& output,
-                 Flags flags = 0);
+                 Flags flags = 0,
+                 const std::vector<CString>& kernelNames = std::vector<CString>());
     /// constructor for AMD OpenCL 2.0 GPU binary 32-bit
     /**
      * \param binary main GPU binary
      * \param output output stream
      * \param flags flags for disassembler
      * \param driverVersion driverVersion (0 - detected by disassembler)
+     * \param kernelNames names of kernels to disassemble (empty - all kernels)
      */
     Disassembler(const AmdCL2MainGPUBinary32& binary, std::ostream& output,
-                 Flags flags = 0, cxuint driverVersion = 0);
+                 Flags flags = 0, cxuint driverVersion = 0,
+                 const std::vector<CString>& kernelNames = std::vector<CString>());
     /// constructor for AMD OpenCL 2.0 GPU binary 64-bit
     /**
      * \param binary main GPU binary
      * \param output output stream
      * \param flags flags for disassembler
      * \param driverVersion driverVersion (0 - detected by disassembler)
+     * \param kernelNames names of kernels to disassemble (empty - all kernels)
      */
     Disassembler(const AmdCL2MainGPUBinary64& binary, std::ostream& output,
-                 Flags flags = 0, cxuint driverVersion = 0);
+                 Flags flags = 0, cxuint driverVersion = 0,
+                 const std::vector<CString>& kernelNames = std::vector<CString>());
     /// constructor for ROCm GPU binary
     /**
      * \param binary main GPU binary
      * \param output output stream
      * \param flags flags for disassembler
+     * \param kernelNames names of kernels to disassemble (empty - all kernels)
      */
-    Disassembler(const ROCmBinary& binary, std::ostream& output, Flags flags = 0);
+    Disassembler(const ROCmBinary& binary, std::ostream& output, Flags flags = 0,
+                 const std::vector<CString>& kernelNames = std::vector<CString>());
     /// constructor for ROCm GPU binary 2
     /**
      * \param binary main GPU binary
      * \param output output stream
      * \param flags flags for disassembler
+     * \param kernelNames names of kernels to disassemble (empty - all kernels)
      */
     Disassembler(const ROCmBinary& binary, std::ostream& output, bool hasGPUDeviceType,
-                 GPUDeviceType deviceType, Flags flags = 0);
+                 GPUDeviceType deviceType, Flags flags = 0,
+                 const std::vector<CString>& kernelNames = std::vector<CString>());
     /// constructor for AMD disassembler input
     /**
      * \param disasmInput disassembler input object
@@ -504,6 +674,46 @@ public:
     /// get deviceType
     GPUDeviceType getDeviceType() const;
     
+    /// get names of selected kernels (empty if all kernels will be disassembled)
+    const std::vector<CString>& getKernelNames() const
+    { return kernelNames; }
+    /// set names of kernels to disassemble (empty - all kernels)
+    /** for inputs created from binaries, only kernels given in constructor
+     * are available */
+    void setKernelNames(const std::vector<CString>& kernelNames);
+    /// return true if kernel will be disassembled
+    bool isKernelSelected(const CString& kernelName) const;
+    
+    /// get name of data file (empty if data will be printed in text form)
+    const CString& getDataFileName() const
+    { return dataFileName; }
+    /// get minimal size of data block written to data file
+    size_t getDataFileMinSize() const
+    { return dataFileMinSize; }
+    /// set data file (empty - print all data in text form)
+    /** data blocks not smaller than minSize will be written in raw form to
+     * this file and included by '.incbin' pseudo-op */
+    void setDataFile(const CString& filename, size_t minSize = 256)
+    {
+        dataFileName = filename;
+        dataFileMinSize = minSize;
+    }
+    /// minimal size of buffer for disassembled code
+    static const cxuint minOutputBufferSize = 1024;
+    /// set size of buffer for disassembled code (default is 16384 bytes)
+    /** throws DisasmException if size is smaller than minOutputBufferSize */
+    void setOutputBufferSize(cxuint bufSize);
+    
+    /// print data block in text form or write it to data file
+    void printDataBlock(size_t size, const cxbyte* data);
+    
+    /// get control flow graphs (built by disassemble if DISASM_CFG is set)
+    const std::vector<DisasmCFG>& getCFGs() const
+    { return cfgs; }
+    /// get resources used by kernels (recorded with DISASM_CFG and DISASM_CONFIG)
+    const std::vector<DisasmKernelResources>& getKernelResources() const
+    { return kernelResources; }
+    
     /// get disassembler input
     const AmdDisasmInput* getAmdInput() const
     { return amdInput; }
@@ -535,25 +745,47 @@ inline Flags ISADisassembler::getFlags() const
 inline void ISADisassembler::setFlags(Flags flags)
 { disassembler.setFlags(flags); }
 
+inline void ISADisassembler::addKernelResources(const DisasmKernelResources& resources)
+{
+    if ((disassembler.getFlags() & DISASM_CFG) != 0)
+        disassembler.kernelResources.push_back(resources);
+}
+
+/// write control flow graphs in specified format
+extern void writeDisasmCFG(std::ostream& os, const std::vector<DisasmCFG>& cfgs,
+            DisasmCFGFormat format = DisasmCFGFormat::DOT);
+
 // routines to get binary config inputs
 
+/*
+ * kernelNames - sorted list of kernel names to include (empty - all kernels).
+ * Data of not included kernels (CAL notes, headers, relocations) will not be prepared.
+ * For lazy AMD binaries (AMDBIN_CREATE_LAZY), only inner binaries of included kernels
+ * will be parsed.
+ */
+
 /// prepare AMD OpenCL input from AMD 32-bit binary
 extern AmdDisasmInput* getAmdDisasmInputFromBinary32(
-            const AmdMainGPUBinary32& binary, Flags flags);
+            const AmdMainGPUBinary32& binary, Flags flags,
+            const std::vector<CString>& kernelNames = std::vector<CString>());
 /// prepare AMD OpenCL input from AMD 64-bit binary
 extern AmdDisasmInput* getAmdDisasmInputFromBinary64(
-            const AmdMainGPUBinary64& binary, Flags flags);
+            const AmdMainGPUBinary64& binary, Flags flags,
+            const std::vector<CString>& kernelNames = std::vector<CString>());
 /// prepare AMD OpenCL 2.0 input from AMD 32-bit binary
 extern AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary32(
             const AmdCL2MainGPUBinary32& binary, cxuint driverVersion,
-            bool hsaLayout = false);
+            bool hsaLayout = false,
+            const std::vector<CString>& kernelNames = std::vector<CString>());
 /// prepare AMD OpenCL 2.0 input from AMD 64-bit binary
 extern AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary64(
             const AmdCL2MainGPUBinary64& binary, cxuint driverVersion,
-            bool hsaLayout = false);
+            bool hsaLayout = false,
+            const std::vector<CString>& kernelNames = std::vector<CString>());
 /// prepare ROCM input from ROCM binary
 extern ROCmDisasmInput* getROCmDisasmInputFromBinary(
-            const ROCmBinary& binary);
+            const ROCmBinary& binary,
+            const std::vector<CString>& kernelNames = std::vector<CString>());
 /// prepare Gallium input from Gallium binary
 extern GalliumDisasmInput* getGalliumDisasmInputFromBinary(
             GPUDeviceType deviceType, const GalliumBinary& binary, cxuint llvmVersion);
@@ -0,0 +1,118 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*! \file GCNAnalyzer.h
+ * \brief static estimation of GCN code timings (cycles, penalties, occupancy)
+ */
+
+#ifndef __CLRX_GCNANALYZER_H__
+#define __CLRX_GCNANALYZER_H__
+
+#include <CLRX/Config.h>
+#include <ostream>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/GPUId.h>
+#include <CLRX/amdasm/Disassembler.h>
+
+/// main namespace
+namespace CLRX
+{
+
+/// estimated timing of basic block
+struct GCNBlockTiming
+{
+    size_t offset;      ///< offset of block in code
+    size_t size;        ///< size of block in bytes
+    size_t instrsNum;   ///< number of instructions
+    uint64_t cycles;    ///< cycles of instructions (without penalties)
+    cxuint alignPenalties;  ///< number of alignment penalties (4 cycles each)
+    DisasmCFGEndType endType;   ///< type of last instruction
+};
+
+/// estimated timing of kernel
+struct GCNKernelTiming
+{
+    CString name;       ///< kernel name
+    std::vector<GCNBlockTiming> blocks; ///< timings of blocks
+    size_t instrsNum;   ///< number of instructions
+    uint64_t cycles;    ///< cycles of all blocks (without penalties)
+    uint64_t penaltyCycles; ///< cycles of alignment penalties
+    bool hasResources;  ///< true if used registers and local size are known
+    cxuint sgprsNum;    ///< number of used SGPRs
+    cxuint vgprsNum;    ///< number of used VGPRs
+    size_t localSize;   ///< local (LDS) memory size
+    cxuint waves;       ///< theoretical occupancy (waves per SIMD, 0 if unknown)
+};
+
+/// static analyzer of GCN code (based on GCN timings documentation)
+/** estimates cycles of basic blocks from control flow graphs built by disassembler
+ * (DISASM_CFG). Blocks are counted once (loops are not unrolled), taken branches
+ * cost 20 cycles and not taken conditional branches 4 cycles */
+class GCNCodeAnalyzer
+{
+private:
+    GPUArchitecture arch;
+    cxuint dpFactor;
+public:
+    /// constructor
+    /**
+     * \param deviceType GPU device type
+     * \param dpFactor DPFACTOR (0 - choose default for device)
+     */
+    explicit GCNCodeAnalyzer(GPUDeviceType deviceType, cxuint dpFactor = 0);
+    
+    /// get DPFACTOR (1 - DP speed 1/2, 2 - 1/4, 4 - 1/8, 8 - 1/16)
+    cxuint getDPFactor() const
+    { return dpFactor; }
+    
+    /// get cycles of instruction
+    cxuint getInstrCycles(const DisasmCFGInstr& instr) const;
+    
+    /// get theoretical occupancy (waves per SIMD)
+    /** throws DisasmException if kernel does not fit in SIMD (more than 256 VGPRs)
+     * or in compute unit (more than 64 KB of local memory)
+     * \param sgprsNum number of used SGPRs
+     * \param vgprsNum number of used VGPRs
+     * \param localSize local memory size per work group
+     * \param groupWaves number of waves per work group
+     */
+    cxuint getOccupancy(cxuint sgprsNum, cxuint vgprsNum, size_t localSize,
+                cxuint groupWaves = 1) const;
+    
+    /// estimate timings of kernel code
+    GCNKernelTiming analyzeKernel(const DisasmCFG& cfg) const;
+    
+    /// estimate timings of all kernels
+    /**
+     * \param cfgs control flow graphs of kernels
+     * \param resources resources used by kernels (matched by kernel name)
+     * \param groupWaves number of waves per work group (for local memory occupancy)
+     */
+    std::vector<GCNKernelTiming> analyze(const std::vector<DisasmCFG>& cfgs,
+                const std::vector<DisasmKernelResources>& resources,
+                cxuint groupWaves = 1) const;
+};
+
+/// write per-kernel timing report in text form
+extern void writeGCNTimingReport(std::ostream& os,
+            const std::vector<GCNKernelTiming>& timings, bool printBlocks = true);
+
+};
+
+#endif
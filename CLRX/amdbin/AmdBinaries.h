@@ -61,6 +61,8 @@ enum : Flags {
     AMDBIN_INNER_CREATE_CALNOTES = 0x10000, ///< create CAL notes for AMD inner GPU binary
     
     AMDBIN_CREATE_ALL = ELF_CREATE_ALL | 0xffff0, ///< all AMD binaries creation flags
+    /** parse inner binaries and kernel informations at first access (GPU binaries) */
+    AMDBIN_CREATE_LAZY = 0x100000,
     AMDBIN_INNER_SHIFT = 12 ///< shift for convert inner binary flags into elf binary flags
 };
 
@@ -417,14 +419,21 @@ public:
     typedef Array<std::pair<CString, size_t> > KernelInfoMap;
 protected:
     AmdMainType type;   ///< type of binaries
-    Array<KernelInfo> kernelInfos;    ///< kernel informations
+    mutable Array<KernelInfo> kernelInfos;    ///< kernel informations (filled lazily)
     KernelInfoMap kernelInfosMap;   ///< kernel informations map
+    /// once flags for lazily parsed kernel informations (null if not lazy)
+    std::unique_ptr<OnceFlag[]> kernelInfoOnceFlags;
     
     CString driverInfo; ///< driver info string
     CString compileOptions; ///< compiler options string
     
     /// constructor
     explicit AmdMainBinaryBase(AmdMainType type);
+    
+    /// parse kernel information with specified index (for lazy parsing)
+    virtual void parseKernelInfo(size_t index) const;
+    /// initialize kernel information at first access (for lazy parsing)
+    void initKernelInfo(size_t index) const;
 public:
     virtual ~AmdMainBinaryBase();
     
@@ -438,11 +447,20 @@ public:
     
     /// get kernel informations array
     const KernelInfo* getKernelInfos() const
-    { return kernelInfos.data(); }
+    {
+        if (kernelInfoOnceFlags)
+            for (size_t i = 0; i < kernelInfos.size(); i++)
+                initKernelInfo(i);
+        return kernelInfos.data();
+    }
     
     /// get kernel information with specified index
     const KernelInfo& getKernelInfo(size_t index) const
-    { return kernelInfos[index]; }
+    {
+        if (kernelInfoOnceFlags)
+            initKernelInfo(index);
+        return kernelInfos[index];
+    }
     
     /// get kernel information with specified kernel name (requires kernel info map)
     const KernelInfo& getKernelInfo(const char* name) const;
@@ -480,8 +498,21 @@ public:
     /// kernel header map type
     typedef Array<std::pair<CString, size_t> > KernelHeaderMap;
 protected:
-    Array<AmdInnerGPUBinary32> innerBinaries;   ///< inner binaries
+    /// source of lazily parsed inner binary or kernel information
+    struct LazyEntry
+    {
+        const char* symName;    ///< symbol name in main binary
+        size_t size;    ///< size of content
+        cxbyte* data;   ///< content
+    };
+    
+    mutable Array<AmdInnerGPUBinary32> innerBinaries;   ///< inner binaries (filled lazily)
     InnerBinaryMap innerBinaryMap;  ///< inner binary map
+    Flags innerCreationFlags;   ///< creation flags for inner binaries
+    Array<LazyEntry> lazyInnerBinaries; ///< sources of lazily parsed inner binaries
+    Array<const char*> lazyMetadataSymNames; ///< metadata symbol names (for lazy parsing)
+    /// once flags for lazily parsed inner binaries (null if not lazy)
+    std::unique_ptr<OnceFlag[]> innerBinaryOnceFlags;
     std::unique_ptr<AmdGPUKernelMetadata[]> metadatas;  ///< AMD metadatas
     Array<AmdGPUKernelHeader> kernelHeaders;    ///< kernel headers
     KernelHeaderMap kernelHeaderMap;    ///< kernel header map
@@ -494,6 +525,11 @@ protected:
     /// initialize main gpu binary (internal use only)
     template<typename Types>
     void initMainGPUBinary(typename Types::ElfBinary& binary);
+    
+    /// parse kernel information from metadata (for lazy parsing)
+    void parseKernelInfo(size_t index) const;
+    /// initialize inner binary at first access (for lazy parsing)
+    void initInnerBinary(size_t index) const;
 public:
     /// get number of inner binaries
     size_t getInnerBinariesNum() const
@@ -501,15 +537,27 @@ public:
     
     /// get inner binary with specified index
     AmdInnerGPUBinary32& getInnerBinary(size_t index)
-    { return innerBinaries[index]; }
+    {
+        if (innerBinaryOnceFlags)
+            initInnerBinary(index);
+        return innerBinaries[index];
+    }
     
     /// get inner binary with specified index
     const AmdInnerGPUBinary32& getInnerBinary(size_t index) const
-    { return innerBinaries[index]; }
+    {
+        if (innerBinaryOnceFlags)
+            initInnerBinary(index);
+        return innerBinaries[index];
+    }
     
     /// get inner binary with specified name (requires inner binary map)
     const AmdInnerGPUBinary32& getInnerBinary(const char* name) const;
     
+    /// get kernel name of kernel information with specified index
+    /** for lazy binary, name is taken from metadata symbol without parsing metadata */
+    CString getKernelInfoName(size_t index) const;
+    
     /// get metadata size for specified inner binary
     size_t getMetadataSize(size_t index) const
     { return metadatas[index].size; }
@@ -572,6 +620,10 @@ public:
      * \param binaryCodeSize binary code size
      * \param binaryCode pointer to binary code
      * \param creationFlags flags that specified what will be created during creation
+     *
+     * If AMDBIN_CREATE_LAZY is set, then inner binaries (with CAL notes) and kernel
+     * informations will be parsed at first access (thread-safe) and errors in them
+     * will be reported at that access.
      */
     AmdMainGPUBinary32(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
@@ -603,6 +655,10 @@ public:
     /// return true if binary has kernel header map
     bool hasKernelHeaderMap() const
     { return (creationFlags & AMDBIN_CREATE_KERNELHEADERMAP) != 0; }
+    
+    /// return true if inner binaries and kernel informations are parsed lazily
+    bool isLazy() const
+    { return (creationFlags & AMDBIN_CREATE_LAZY) != 0; }
 };
 
 /// AMD main binary for GPU for 64-bit mode
@@ -616,6 +672,10 @@ public:
      * \param binaryCodeSize binary code size
      * \param binaryCode pointer to binary code
      * \param creationFlags flags that specified what will be created during creation
+     *
+     * If AMDBIN_CREATE_LAZY is set, then inner binaries (with CAL notes) and kernel
+     * informations will be parsed at first access (thread-safe) and errors in them
+     * will be reported at that access.
      */
     AmdMainGPUBinary64(size_t binaryCodeSize, cxbyte* binaryCode,
             Flags creationFlags = AMDBIN_CREATE_ALL);
@@ -647,6 +707,10 @@ public:
     /// return true if binary has kernel header map
     bool hasKernelHeaderMap() const
     { return (creationFlags & AMDBIN_CREATE_KERNELHEADERMAP) != 0; }
+    
+    /// return true if inner binaries and kernel informations are parsed lazily
+    bool isLazy() const
+    { return (creationFlags & AMDBIN_CREATE_LAZY) != 0; }
 };
 
 /// AMD main binary for X86 systems
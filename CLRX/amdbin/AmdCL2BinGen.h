@@ -31,6 +31,7 @@
 #include <vector>
 #include <CLRX/amdbin/Commons.h>
 #include <CLRX/amdbin/AmdBinGen.h>
+#include <CLRX/amdbin/BinaryTemplate.h>
 #include <CLRX/utils/Containers.h>
 #include <CLRX/utils/GPUId.h>
 #include <CLRX/utils/InputOutput.h>
@@ -156,8 +157,10 @@ private:
     bool manageable;
     const AmdCL2Input* input;
     
+    void generateBinary(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* templateOut) const;
     void generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr) const;
+             Array<cxbyte>* aPtr, BinaryTemplate* binTemplate) const;
 public:
     AmdCL2GPUBinGenerator();
     
@@ -204,6 +207,19 @@ public:
     
     /// generates binary to vector
     void generate(std::vector<char>& vector) const;
+    
+    /// generates binary to array of bytes using binary template
+    /** In template mode, binary is fully generated only if template is not prepared,
+     * non-code input has been changed or code does not fit in its capacity.
+     * Otherwise, only code and code sizes are replaced in template.
+     * \param array output array
+     * \param binTemplate binary template (updated if needed)
+     */
+    void generate(Array<cxbyte>& array, BinaryTemplate& binTemplate) const;
+    /// generates binary to output stream using binary template
+    void generate(std::ostream& os, BinaryTemplate& binTemplate) const;
+    /// generates binary to vector of char using binary template
+    void generate(std::vector<char>& vector, BinaryTemplate& binTemplate) const;
 };
 
 };
@@ -0,0 +1,86 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*! \file BinarySummary.h
+ * \brief summary of kernels (names, code and resources) for all binary formats
+ */
+
+#ifndef __CLRX_BINARYSUMMARY_H__
+#define __CLRX_BINARYSUMMARY_H__
+
+#include <CLRX/Config.h>
+#include <cstdint>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/GPUId.h>
+#include <CLRX/utils/CString.h>
+
+/// main namespace
+namespace CLRX
+{
+
+/// format of the summarized binary
+enum class SummaryBinaryFormat: cxbyte
+{
+    AMD = 0,    ///< AMD Catalyst (CAL) binary
+    AMDCL2,     ///< AMD OpenCL 2.0 binary
+    ROCM,       ///< ROCm binary
+    GALLIUM     ///< GalliumCompute binary
+};
+
+/// kernel summary (code place and resource usage)
+struct KernelSummary
+{
+    CString kernelName;     ///< kernel name
+    size_t codeOffset;      ///< offset of kernel code in whole binary
+    size_t codeSize;        ///< size of kernel code
+    cxuint sgprsNum;        ///< number of SGPRs
+    cxuint vgprsNum;        ///< number of VGPRs
+    size_t localSize;       ///< local memory (LDS) size in bytes
+    size_t scratchSize;     ///< scratch buffer size (as in kernel configuration)
+    cxuint reqdWorkGroupSize[3];    ///< required work group size (zeroes if not given)
+};
+
+/// binary summary
+struct BinarySummary
+{
+    SummaryBinaryFormat format; ///< binary format
+    bool is64Bit;       ///< true if 64-bit binary (or 64-bit inner binary)
+    GPUDeviceType deviceType;   ///< GPU device type
+    std::vector<KernelSummary> kernels; ///< kernels
+};
+
+/// get summary of kernels of AMD, AMD OpenCL 2.0, ROCm or GalliumCompute binary
+/** This routine touches only ELF headers, symbol tables, notes, kernel setups and
+ * metadata, and it does not parse kernel arguments. Register numbers are real numbers
+ * of used registers if binary holds them, otherwise they are computed from PGM_RSRC1.
+ * Device type of GalliumCompute binaries can not be determined, hence
+ * it must be given to compute register and local memory granularity.
+ *
+ * \param binarySize binary size
+ * \param binary binary content
+ * \param summary output summary
+ * \param galliumDeviceType device type for GalliumCompute binaries
+ */
+extern void getBinarySummary(size_t binarySize, const cxbyte* binary,
+            BinarySummary& summary,
+            GPUDeviceType galliumDeviceType = GPUDeviceType::CAPE_VERDE);
+
+};
+
+#endif
@@ -0,0 +1,160 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+/*! \file BinaryTemplate.h
+ * \brief template binary (for fast regeneration of binaries with changed code)
+ */
+
+#ifndef __CLRX_BINARYTEMPLATE_H__
+#define __CLRX_BINARYTEMPLATE_H__
+
+#include <CLRX/Config.h>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/CString.h>
+#include <CLRX/amdbin/ElfBinaries.h>
+
+/// main namespace
+namespace CLRX
+{
+
+/// template binary used by binary generators in template mode
+/** Binary generator generates whole binary once (template) for codes padded to
+ * their capacities and keeps places of the code and places of fields that depend on
+ * code sizes (section sizes, symbol sizes) in this binary. Next generations only copy
+ * template, put current code in these places and patch these fields.
+ * Template can be used only if non-code input is unchanged (same key), number of codes
+ * is same and all codes fit in their capacities.
+ * Template is owned by caller and passed explicitly to the generator.
+ */
+class BinaryTemplate: public NonCopyableAndNonMovable
+{
+public:
+    /// code given to generator
+    struct Code
+    {
+        size_t size;        ///< code size
+        const cxbyte* data; ///< code data
+    };
+    /// place of code part in binary
+    struct CodePlace
+    {
+        size_t codeId;      ///< code index
+        size_t codeOffset;  ///< offset in code
+        size_t offset;      ///< offset in binary
+        size_t size;        ///< size of code part (in padded code)
+    };
+    /// place of field whose value is base plus code size (section or symbol size)
+    struct SizePlace
+    {
+        size_t codeId;      ///< code index
+        size_t offset;      ///< offset in binary
+        cxuint fieldSize;   ///< field size in bytes (4 or 8)
+        uint64_t base;      ///< field value minus code size
+    };
+    
+    /// hasher for key of template (non-code input of generator)
+    class KeyHasher
+    {
+    private:
+        uint64_t hash;
+    public:
+        /// constructor
+        KeyHasher() : hash(UINT64_C(0xcbf29ce484222325))
+        { }
+        
+        /// update hash by bytes
+        void update(size_t size, const void* data);
+        
+        /// update hash by value (scalar or enum)
+        template<typename T>
+        void updateValue(const T& value)
+        { update(sizeof(T), &value); }
+        
+        /// update hash by data given by pointer and size (null pointer is allowed)
+        void updateData(size_t size, const void* data);
+        /// update hash by string
+        void updateString(const CString& str)
+        { updateData(str.size(), str.c_str()); }
+        /// update hash by extra sections
+        void updateSections(const std::vector<BinSection>& sections);
+        /// update hash by extra symbols
+        void updateSymbols(const std::vector<BinSymbol>& symbols);
+        
+        /// get key
+        uint64_t getKey() const
+        { return hash; }
+    };
+private:
+    bool prepared;
+    uint64_t key;
+    Array<cxbyte> binary;
+    std::vector<size_t> codeCapacities;
+    std::vector<Array<cxbyte> > paddedCodes;
+    std::vector<CodePlace> codePlaces;
+    std::vector<SizePlace> sizePlaces;
+public:
+    /// constructor
+    BinaryTemplate() : prepared(false), key(0)
+    { }
+    
+    /// return true if template is prepared
+    bool isPrepared() const
+    { return prepared; }
+    
+    /// reset template (next generation will be full)
+    void reset();
+    
+    /// return true if template is prepared for key and codes fit in capacities
+    bool matches(uint64_t key, const std::vector<Code>& codes) const;
+    
+    /// start preparing template for key and codes (clears template)
+    void prepare(uint64_t key, const std::vector<Code>& codes);
+    /// get capacity of code (size of region reserved for code)
+    size_t getCodeCapacity(size_t codeId) const
+    { return codeCapacities[codeId]; }
+    /// get code padded by zeroes to capacity (only while preparing)
+    const cxbyte* getPaddedCode(size_t codeId) const
+    { return paddedCodes[codeId].data(); }
+    /// get binary (output for full generation while preparing)
+    Array<cxbyte>& getBinary()
+    { return binary; }
+    /// add code place (while preparing)
+    void addCodePlace(size_t codeId, size_t codeOffset, size_t offset, size_t size);
+    /// add place of size field (while preparing)
+    /** value of field in binary must be value for padded code
+     * \param codeId code index
+     * \param offset offset of field in binary
+     * \param fieldSize size of field in bytes (4 or 8)
+     */
+    void addSizePlace(size_t codeId, size_t offset, cxuint fieldSize);
+    /// finish preparing
+    void setPrepared();
+    
+    /// write binary with current codes to output (only one output must be given)
+    void write(const std::vector<Code>& codes, std::ostream* osPtr,
+               std::vector<char>* vPtr, Array<cxbyte>* aPtr) const;
+};
+
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <climits>
+#include <memory>
 #include <string>
 #include <utility>
 #include <ostream>
@@ -139,6 +140,31 @@ struct Elf64Types
     static const cxuint relSymShift = 32;
 };
 
+/// once flags to build name indices (section, symbol, dynamic symbol) of ELF binary
+/** copy of ELF binary gets new flags, because its name indices can be built again */
+class ElfNameIndexOnceFlags
+{
+private:
+    std::unique_ptr<OnceFlag[]> flags;
+public:
+    /// constructor
+    ElfNameIndexOnceFlags() : flags(new OnceFlag[3])
+    { }
+    /// copy constructor
+    ElfNameIndexOnceFlags(const ElfNameIndexOnceFlags&) : flags(new OnceFlag[3])
+    { }
+    /// copy assignment
+    ElfNameIndexOnceFlags& operator=(const ElfNameIndexOnceFlags&)
+    {
+        flags.reset(new OnceFlag[3]);
+        return *this;
+    }
+    
+    /// get once flag
+    OnceFlag& operator[](size_t index) const
+    { return flags[index]; }
+};
+
 /// ELF binary class
 /** This object doesn't copy binary code content.
  * Only it takes and uses a binary code.
@@ -165,6 +191,14 @@ protected:
     SectionIndexMap sectionIndexMap;    ///< section's index map
     SymbolIndexMap symbolIndexMap;      ///< symbol's index map
     SymbolIndexMap dynSymIndexMap;      ///< dynamic symbol's index map
+    cxbyte* symHashTable;       ///< pointer to SysV hash table (.hash) of symbols
+    cxbyte* dynSymHashTable;    ///< pointer to SysV hash table (.hash) of dynamic symbols
+    /* lazily built open-addressing indices (if no map and no hash table) */
+    mutable Array<size_t> sectionNameIndex;   ///< section's name index
+    mutable Array<size_t> symbolNameIndex;    ///< symbol's name index
+    mutable Array<size_t> dynSymNameIndex;    ///< dynamic symbol's name index
+    /// once flags to build name indices
+    ElfNameIndexOnceFlags nameIndexOnceFlags;
     
     typename Types::Size symbolsNum;    ///< symbols number
     typename Types::Size dynSymbolsNum; ///< dynamic symbols number
@@ -201,6 +235,14 @@ public:
     bool hasDynSymbolMap() const
     { return (creationFlags & ELF_CREATE_DYNSYMMAP) != 0; }
     
+    /// returns true if symbol table has usable SysV hash table (.hash section)
+    bool hasSymbolHashTable() const
+    { return symHashTable != nullptr; }
+    
+    /// returns true if dynamic symbol table has usable SysV hash table (.hash section)
+    bool hasDynSymbolHashTable() const
+    { return dynSymHashTable != nullptr; }
+    
     /// get size of binaries
     size_t getSize() const
     { return binaryCodeSize; }
@@ -340,12 +382,18 @@ public:
     }
     
     /// get section index with specified name
+    /** uses section index map if created, otherwise uses an index built at first call
+     * (thread-safe) */
     uint16_t getSectionIndex(const char* name) const;
     
-    /// get symbol index with specified name (requires symbol index map)
+    /// get symbol index with specified name
+    /** uses symbol index map if created, otherwise SysV hash table (.hash section)
+     * or an index built at first call (thread-safe) */
     typename Types::Size getSymbolIndex(const char* name) const;
     
-    /// get dynamic symbol index with specified name (requires dynamic symbol index map)
+    /// get dynamic symbol index with specified name
+    /** uses dynamic symbol index map if created, otherwise SysV hash table
+     * (.hash section) or an index built at first call (thread-safe) */
     typename Types::Size getDynSymbolIndex(const char* name) const;
     
     /// get end iterator of symbol index map
@@ -384,19 +432,19 @@ public:
     typename Types::Shdr& getSectionHeader(const char* name)
     { return getSectionHeader(getSectionIndex(name)); }
     
-    /// get symbol with specified name (requires symbol index map)
+    /// get symbol with specified name
     const typename Types::Sym& getSymbol(const char* name) const
     { return getSymbol(getSymbolIndex(name)); }
     
-    /// get symbol with specified name (requires symbol index map)
+    /// get symbol with specified name
     typename Types::Sym& getSymbol(const char* name)
     { return getSymbol(getSymbolIndex(name)); }
     
-    /// get dynamic symbol with specified name (requires dynamic symbol index map)
+    /// get dynamic symbol with specified name
     const typename Types::Sym& getDynSymbol(const char* name) const
     { return getDynSymbol(getDynSymbolIndex(name)); }
     
-    /// get dynamic symbol with specified name (requires dynamic symbol index map)
+    /// get dynamic symbol with specified name
     typename Types::Sym& getDynSymbol(const char* name)
     { return getDynSymbol(getDynSymbolIndex(name)); }
     
@@ -844,6 +892,7 @@ private:
     uint32_t bucketsNum;
     std::unique_ptr<uint32_t[]> hashCodes;
     bool isHashDynSym;
+    uint64_t outputOffset;
     
     void computeSize();
 public:
@@ -897,6 +946,14 @@ public:
     // return offset for specified region
     typename Types::Word getRegionOffset(cxuint i) const
     { return regionOffsets[i]; }
+    /// return offset for specified region in output (after generation)
+    uint64_t getRegionOutputOffset(cxuint i) const
+    { return outputOffset + regionOffsets[i]; }
+    /// return offset of section header of specified region in output (after generation)
+    uint64_t getSectionHeaderOutputOffset(cxuint regionIndex) const;
+    /// return offset of specified symbol in output (after generation)
+    /** symbol index is index in added symbols (without null symbol) */
+    uint64_t getSymbolOutputOffset(size_t symbolIndex, bool dynamic = false) const;
     
     /// generate binary
     void generate(FastOutputBuffer& fob);
@@ -904,7 +961,7 @@ public:
     /// generate binary
     void generate(std::ostream& os)
     {
-        FastOutputBuffer fob(256, os);
+        FastOutputBuffer fob(4096, os);
         generate(fob);
     }
     
@@ -26,12 +26,14 @@
 #include <CLRX/Config.h>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <vector>
 #include <CLRX/amdbin/Elf.h>
 #include <CLRX/amdbin/ElfBinaries.h>
 #include <CLRX/amdbin/Commons.h>
+#include <CLRX/amdbin/BinaryTemplate.h>
 #include <CLRX/utils/MemAccess.h>
 #include <CLRX/utils/Containers.h>
 #include <CLRX/utils/Utilities.h>
@@ -480,8 +482,10 @@ private:
     void* rocmLLVMGDataGen;
     Array<CString> kdescSymNames;
     
+    void generateBinary(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* templateOut);
     void generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr);
+             Array<cxbyte>* aPtr, BinaryTemplate* binTemplate);
 public:
     /// constructor
     ROCmBinGenerator();
@@ -534,6 +538,19 @@ public:
     
     /// generates binary to vector of char
     void generate(std::vector<char>& vector);
+    
+    /// generates binary to array of bytes using binary template
+    /** In template mode, binary is fully generated only if template is not prepared,
+     * non-code input has been changed or code does not fit in its capacity.
+     * Otherwise, only code and code sizes are replaced in template.
+     * \param array output array
+     * \param binTemplate binary template (updated if needed)
+     */
+    void generate(Array<cxbyte>& array, BinaryTemplate& binTemplate);
+    /// generates binary to output stream using binary template
+    void generate(std::ostream& os, BinaryTemplate& binTemplate);
+    /// generates binary to vector of char using binary template
+    void generate(std::vector<char>& vector, BinaryTemplate& binTemplate);
 };
 
 void generateROCmMetadata(const ROCmMetadata& mdInfo,
@@ -548,6 +565,45 @@ void parseROCmMetadata(size_t metadataSize, const char* metadata,
 void parseROCmMetadataMsgPack(size_t metadataSize, const cxbyte* metadata,
                 ROCmMetadata& metadataInfo);
 
+/// parse metadata of single kernel from MsgPack metadata
+/** metadata of other kernels are skipped without parsing.
+ * \param metadataSize metadata size
+ * \param metadata MsgPack metadata
+ * \param kernelName kernel name
+ * \param kernelMetadata output kernel metadata
+ * \return true if kernel found, false if not found
+ */
+bool parseROCmKernelMetadataMsgPack(size_t metadataSize, const cxbyte* metadata,
+                const char* kernelName, ROCmKernelMetadata& kernelMetadata);
+
+/// reference to string in MsgPack data (string is not null-terminated)
+struct MsgPackStringRef
+{
+    const char* ptr;    ///< string data
+    size_t size;        ///< string size
+    
+    /// get begin of string
+    const char* begin() const
+    { return ptr; }
+    /// get end of string
+    const char* end() const
+    { return ptr+size; }
+    /// return true if string is empty
+    bool empty() const
+    { return size==0; }
+    
+    /// return true if string is equal to null-terminated string
+    bool operator==(const char* str) const
+    { return ::strlen(str)==size && ::memcmp(ptr, str, size)==0; }
+    /// return true if string is not equal to null-terminated string
+    bool operator!=(const char* str) const
+    { return !(*this == str); }
+    
+    /// make std::string
+    std::string toString() const
+    { return std::string(ptr, ptr+size); }
+};
+
 class MsgPackMapParser;
 
 class MsgPackArrayParser
@@ -565,9 +621,13 @@ public:
     uint64_t parseInteger(cxbyte signess);
     double parseFloat();
     std::string parseString();
+    /// parse string without copying (returns reference to MsgPack data)
+    MsgPackStringRef parseStringRef();
     Array<cxbyte> parseData();
     MsgPackArrayParser parseArray();
     MsgPackMapParser parseMap();
+    /// skip single element
+    void skipElement();
     size_t end(); // return left elements
     
     bool haveElements() const
@@ -596,6 +656,8 @@ public:
     uint64_t parseKeyInteger(cxbyte signess);
     double parseKeyFloat();
     std::string parseKeyString();
+    /// parse key string without copying (returns reference to MsgPack data)
+    MsgPackStringRef parseKeyStringRef();
     Array<cxbyte> parseKeyData();
     MsgPackArrayParser parseKeyArray();
     MsgPackMapParser parseKeyMap();
@@ -604,6 +666,8 @@ public:
     uint64_t parseValueInteger(cxbyte signess);
     double parseValueFloat();
     std::string parseValueString();
+    /// parse value string without copying (returns reference to MsgPack data)
+    MsgPackStringRef parseValueStringRef();
     Array<cxbyte> parseValueData();
     MsgPackArrayParser parseValueArray();
     MsgPackMapParser parseValueMap();
@@ -288,6 +288,69 @@ public:
     { return buffer.getVector(); }
 };
 
+/// output stream buffer that writes directly to file descriptor
+/** Stream buffer holds large buffer. Big data chunks (not smaller than buffer)
+ * are written with buffered data by single vectored write (if system supports it),
+ * without copying to the buffer. */
+class FileOutStreamBuf: public std::streambuf
+{
+private:
+    int fd;
+    size_t bufSize;
+    std::unique_ptr<char[]> buffer;
+    
+    bool writeAll(const char* data, size_t size);
+    bool writeAll2(const char* data1, size_t size1, const char* data2, size_t size2);
+public:
+    /// default buffer size
+    static const size_t defaultBufSize = 256U<<10;
+    
+    /// constructor
+    /**
+     * \param filename output file name (file will be created or truncated)
+     * \param bufSize buffer size
+     */
+    explicit FileOutStreamBuf(const char* filename, size_t bufSize = defaultBufSize);
+    /// destructor (writes out buffer and closes file)
+    ~FileOutStreamBuf();
+    
+    /// return true if file opened
+    bool isOpen() const
+    { return fd >= 0; }
+    /// close file (returns false if any writing failed)
+    bool close();
+protected:
+    /// overflow implementation
+    int_type overflow(int_type ch);
+    /// xsputn implementation
+    std::streamsize xsputn(const char_type* s, std::streamsize n);
+    /// sync implementation
+    int sync();
+};
+
+/// specialized output stream that writes to file through FileOutStreamBuf
+class FileOStream: public std::ostream
+{
+private:
+    FileOutStreamBuf buffer;
+public:
+    /// constructor
+    /**
+     * \param filename output file name (file will be created or truncated)
+     * \param bufSize buffer size
+     */
+    explicit FileOStream(const char* filename,
+                size_t bufSize = FileOutStreamBuf::defaultBufSize);
+    /// destructor
+    ~FileOStream() = default;
+    
+    /// return true if file opened
+    bool isOpen() const
+    { return buffer.isOpen(); }
+    /// write out buffer and close file (sets badbit if writing failed)
+    void close();
+};
+
 /*
  * adaptor
  */
@@ -347,28 +410,49 @@ public:
 };
 
 /// fast and direct output buffer
+/** buffer can write to output stream or directly to memory of known size (in this case
+ * data is not copied through any stream and flush does nothing) */
 class FastOutputBuffer: public NonCopyableAndNonMovable
 {
 private:
-    std::ostream& os;
-    cxuint endPos;
-    cxuint bufSize;
-    std::unique_ptr<char[]> buffer;
+    std::ostream* os;   // null if buffer writes directly to memory
+    size_t endPos;
+    size_t bufSize;
+    std::unique_ptr<char[]> bufferHolder;
+    char* buffer;
     uint64_t written;
+    
+    // make space in buffer, throw exception if buffer writes directly to memory
+    void flushForSpace()
+    {
+        if (os == nullptr)
+            throw Exception("Output memory is too small");
+        flush();
+    }
 public:
     /// constructor with inBufSize and output
     /**
      * \param _bufSize max buffer size
      * \param output output stream
      */
-    FastOutputBuffer(cxuint _bufSize, std::ostream& output) : os(output), endPos(0),
-            bufSize(_bufSize), buffer(new char[_bufSize]), written(0)
+    FastOutputBuffer(cxuint _bufSize, std::ostream& output) : os(&output), endPos(0),
+            bufSize(_bufSize), bufferHolder(new char[_bufSize]),
+            buffer(bufferHolder.get()), written(0)
+    { }
+    /// constructor with output memory
+    /**
+     * \param _memSize size of output memory
+     * \param output output memory (all data will be written directly to it)
+     */
+    FastOutputBuffer(size_t _memSize, char* output) : os(nullptr), endPos(0),
+            bufSize(_memSize), buffer(output), written(0)
     { }
     /// destructor
     ~FastOutputBuffer()
     { 
         flush();
-        os.flush();
+        if (os != nullptr)
+            os->flush();
     }
     
     /// get written bytes number
@@ -378,7 +462,9 @@ public:
     /// write output buffer
     void flush()
     {
-        os.write(buffer.get(), endPos);
+        if (os == nullptr)
+            return; // data already in output memory
+        os->write(buffer, endPos);
         endPos = 0;
     }
     
@@ -386,8 +472,8 @@ public:
     char* reserve(cxuint toReserve)
     {
         if (toReserve > bufSize-endPos)
-            flush();
-        return buffer.get() + endPos;
+            flushForSpace();
+        return buffer + endPos;
     }
     
     /// finish reservation and go forward
@@ -402,12 +488,12 @@ public:
     {
         if (length > bufSize-endPos)
         {
-            flush();
-            os.write(string, length);
+            flushForSpace();
+            os->write(string, length);
         }
         else
         {
-            ::memcpy(buffer.get()+endPos, string, length);
+            ::memcpy(buffer+endPos, string, length);
             endPos += length;
         }
         written += length;
@@ -431,7 +517,7 @@ public:
     void put(char c)
     {
         if (endPos == bufSize)
-            flush();
+            flushForSpace();
         buffer[endPos++] = c;
         written++;
     }
@@ -442,22 +528,26 @@ public:
         size_t count = num;
         while (count != 0)
         {
-             size_t bufNum = std::min(size_t(bufSize-endPos), count);
-             ::memset(buffer.get()+endPos, c, bufNum);
+             if (endPos == bufSize)
+                 flushForSpace();
+             size_t bufNum = std::min(bufSize-endPos, count);
+             ::memset(buffer+endPos, c, bufNum);
              count -= bufNum;
              endPos += bufNum;
-             if (endPos == bufSize)
-                 flush();
         }
         written += num;
     }
     
-    /// get output stream
+    /// return true if buffer writes directly to memory
+    bool isMemoryOutput() const
+    { return os == nullptr; }
+    
+    /// get output stream (only if buffer writes to output stream)
     const std::ostream& getOStream() const
-    { return os; }
-    /// get output stream
+    { return *os; }
+    /// get output stream (only if buffer writes to output stream)
     std::ostream& getOStream()
-    { return os; }
+    { return *os; }
 };
 
 };
@@ -0,0 +1,521 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#ifdef HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdbin/AmdBinGen.h>
+#include <CLRX/amdbin/GalliumBinaries.h>
+#include <CLRX/amdasm/AsmBinaryCache.h>
+
+using namespace CLRX;
+
+/*
+ * AsmCacheHasher
+ */
+
+static const uint64_t murmurC1 = 0x87c37b91114253d5ULL;
+static const uint64_t murmurC2 = 0x4cf5ad432745937fULL;
+
+static inline uint64_t rotl64(uint64_t v, cxuint shift)
+{ return (v<<shift) | (v>>(64-shift)); }
+
+static inline uint64_t fmix64(uint64_t k)
+{
+    k ^= k>>33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k>>33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k>>33;
+    return k;
+}
+
+// read 64-bit little-endian value
+static inline uint64_t readLE64(const cxbyte* data)
+{
+    uint64_t v = 0;
+    for (cxuint i = 0; i < 8; i++)
+        v |= uint64_t(data[i])<<(i<<3);
+    return v;
+}
+
+std::string AsmCacheKey::toString() const
+{
+    char buf[40];
+    ::snprintf(buf, 40, "%016llx%016llx", (unsigned long long)hash[0],
+               (unsigned long long)hash[1]);
+    return buf;
+}
+
+AsmCacheHasher::AsmCacheHasher() : h1(0), h2(0), length(0), bufferSize(0)
+{ }
+
+void AsmCacheHasher::processBlock(const cxbyte* block)
+{
+    uint64_t k1 = readLE64(block);
+    uint64_t k2 = readLE64(block+8);
+    k1 *= murmurC1; k1 = rotl64(k1, 31); k1 *= murmurC2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1*5 + 0x52dce729;
+    k2 *= murmurC2; k2 = rotl64(k2, 33); k2 *= murmurC1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2*5 + 0x38495ab5;
+}
+
+void AsmCacheHasher::update(size_t size, const void* data)
+{
+    const cxbyte* bytes = reinterpret_cast<const cxbyte*>(data);
+    length += size;
+    if (bufferSize != 0)
+    {
+        // fill up buffer
+        const size_t toCopy = std::min(size, size_t(16-bufferSize));
+        ::memcpy(buffer+bufferSize, bytes, toCopy);
+        bufferSize += toCopy;
+        bytes += toCopy;
+        size -= toCopy;
+        if (bufferSize < 16)
+            return;
+        processBlock(buffer);
+        bufferSize = 0;
+    }
+    for (; size >= 16; size -= 16, bytes += 16)
+        processBlock(bytes);
+    // keep rest in buffer
+    ::memcpy(buffer, bytes, size);
+    bufferSize = size;
+}
+
+void AsmCacheHasher::updateValue(uint64_t value)
+{
+    cxbyte bytes[8];
+    for (cxuint i = 0; i < 8; i++)
+        bytes[i] = (value>>(i<<3))&0xff;
+    update(8, bytes);
+}
+
+void AsmCacheHasher::updateString(const char* str)
+{
+    const size_t len = ::strlen(str);
+    updateValue(len);
+    update(len, str);
+}
+
+AsmCacheKey AsmCacheHasher::finish() const
+{
+    uint64_t f1 = h1, f2 = h2;
+    // process tail
+    uint64_t k1 = 0, k2 = 0;
+    for (cxuint i = 8; i < bufferSize; i++)
+        k2 |= uint64_t(buffer[i])<<((i-8)<<3);
+    for (cxuint i = 0; i < std::min(bufferSize, 8U); i++)
+        k1 |= uint64_t(buffer[i])<<(i<<3);
+    if (bufferSize > 8)
+    {
+        k2 *= murmurC2; k2 = rotl64(k2, 33); k2 *= murmurC1; f2 ^= k2;
+    }
+    if (bufferSize != 0)
+    {
+        k1 *= murmurC1; k1 = rotl64(k1, 31); k1 *= murmurC2; f1 ^= k1;
+    }
+    // finalization
+    f1 ^= length;
+    f2 ^= length;
+    f1 += f2;
+    f2 += f1;
+    f1 = fmix64(f1);
+    f2 = fmix64(f2);
+    f1 += f2;
+    f2 += f1;
+    return { { f1, f2 } };
+}
+
+/*
+ * AsmBinaryCache
+ */
+
+static const char* cacheEntryExt = ".clrxbc";
+static const char cacheEntryMagic[8] = { 'C', 'L', 'R', 'X', 'B', 'C', '0', '2' };
+// temporary files older than this time are treated as abandoned
+static const time_t abandonedTmpFileAge = 86400;
+
+static std::atomic<uint32_t> cacheTmpFileCounter(0);
+
+AsmBinaryCache::AsmBinaryCache(const CString& _directory, uint64_t _maxSize)
+        : directory(_directory.c_str()), maxSize(_maxSize)
+{
+    filesystemPath(directory);
+    if (!isFileExists(directory.c_str()))
+    {
+        try
+        { makeDir(directory.c_str()); }
+        catch(const Exception& ex)
+        {
+            // other process can create this directory in this same time
+            if (!isFileExists(directory.c_str()))
+                throw;
+        }
+    }
+    if (!isDirectory(directory.c_str()))
+        throw Exception("Cache path is not directory");
+}
+
+std::string AsmBinaryCache::getEntryPath(const AsmCacheKey& key) const
+{
+    return joinPaths(directory, key.toString() + cacheEntryExt);
+}
+
+// add assembler settings that change output
+static void hashAssemblerSetup(AsmCacheHasher& hasher, const Assembler& assembler)
+{
+    hasher.updateString("CLRX " CLRX_VERSION);
+    hasher.updateValue(cxuint(assembler.getBinaryFormat()));
+    hasher.updateValue(cxuint(assembler.getDeviceType()));
+    hasher.updateValue(assembler.is64Bit());
+    hasher.updateValue(assembler.isNewROCmBinFormat());
+    hasher.updateValue(assembler.isLLVM10BinFormat());
+    hasher.updateValue(assembler.isROCmMetadataV3());
+    hasher.updateValue(assembler.getPolicyVersion());
+    // warnings and statistics do not change output
+    hasher.updateValue(assembler.getFlags() & ~Flags(ASM_WARNINGS|ASM_STATS));
+    /* if versions are not given, then assembler uses detected versions.
+     * source code can change binary format, hence all versions must be detected */
+    hasher.updateValue(assembler.getDriverVersion());
+    if (assembler.getDriverVersion() == 0)
+    {
+        hasher.updateValue(detectAmdDriverVersion());
+        hasher.updateValue(detectMesaDriverVersion());
+    }
+    hasher.updateValue(assembler.getLLVMVersion());
+    if (assembler.getLLVMVersion() == 0)
+        hasher.updateValue(detectLLVMCompilerVersion());
+    
+    hasher.updateValue(assembler.getInitialDefSyms().size());
+    for (const Assembler::DefSym& defSym: assembler.getInitialDefSyms())
+    {
+        hasher.updateString(defSym.first.c_str());
+        hasher.updateValue(defSym.second);
+    }
+    hasher.updateValue(assembler.getIncludeDirs().size());
+    for (const CString& incDir: assembler.getIncludeDirs())
+        hasher.updateString(incDir.c_str());
+}
+
+AsmCacheKey AsmBinaryCache::computeKey(const Assembler& assembler, size_t sourceSize,
+            const char* source)
+{
+    AsmCacheHasher hasher;
+    hashAssemblerSetup(hasher, assembler);
+    hasher.updateValue(sourceSize);
+    hasher.update(sourceSize, source);
+    return hasher.finish();
+}
+
+AsmCacheKey AsmBinaryCache::computeKey(const Assembler& assembler)
+{
+    const Array<CString>& filenames = assembler.getFilenames();
+    if (filenames.empty())
+        throw Exception("No source files to compute cache key");
+    AsmCacheHasher hasher;
+    hashAssemblerSetup(hasher, assembler);
+    hasher.updateValue(filenames.size());
+    for (const CString& filename: filenames)
+    {
+        const Array<cxbyte> content = loadDataFromFile(filename.c_str());
+        hasher.updateString(filename.c_str());
+        hasher.updateValue(content.size());
+        hasher.update(content.size(), content.data());
+    }
+    return hasher.finish();
+}
+
+static AsmCacheKey computeDataHash(size_t size, const cxbyte* data)
+{
+    AsmCacheHasher hasher;
+    hasher.update(size, data);
+    return hasher.finish();
+}
+
+// append little-endian value to entry content
+static void putEntryValue(std::vector<cxbyte>& content, uint64_t value, cxuint bytes)
+{
+    for (cxuint i = 0; i < bytes; i++)
+        content.push_back((value>>(i<<3))&0xff);
+}
+
+// read little-endian value from entry content, returns false if end of content
+static bool getEntryValue(const Array<cxbyte>& content, size_t& pos, uint64_t& value,
+            cxuint bytes)
+{
+    if (content.size()-pos < bytes)
+        return false;
+    value = 0;
+    for (cxuint i = 0; i < bytes; i++)
+        value |= uint64_t(content[pos+i])<<(i<<3);
+    pos += bytes;
+    return true;
+}
+
+// read stored hash and compare with hash
+static bool checkEntryHash(const Array<cxbyte>& content, size_t& pos,
+            const AsmCacheKey& hash)
+{
+    AsmCacheKey stored;
+    return getEntryValue(content, pos, stored.hash[0], 8) &&
+            getEntryValue(content, pos, stored.hash[1], 8) && stored == hash;
+}
+
+bool AsmBinaryCache::find(const AsmCacheKey& key, Array<cxbyte>& binary,
+            std::vector<CString>* depFiles, std::vector<CString>* failedPaths) const
+{
+    const std::string entryPath = getEntryPath(key);
+    if (!isFileExists(entryPath.c_str()))
+        return false;
+    Array<cxbyte> content;
+    try
+    { content = loadDataFromFile(entryPath.c_str()); }
+    catch(const Exception& ex)
+    { return false; } // entry removed by other process or unreadable
+    
+    size_t pos = sizeof(cacheEntryMagic);
+    if (content.size() < pos || ::memcmp(content.data(), cacheEntryMagic, pos) != 0)
+        return false;
+    if (!checkEntryHash(content, pos, key))
+        return false;
+    uint64_t depsNum = 0;
+    if (!getEntryValue(content, pos, depsNum, 4))
+        return false;
+    std::vector<CString> entryDepFiles, entryFailedPaths;
+    // check whether included files have not been changed
+    for (uint64_t i = 0; i < depsNum; i++)
+    {
+        uint64_t pathSize = 0, fileSize = 0;
+        if (!getEntryValue(content, pos, pathSize, 4) || content.size()-pos < pathSize)
+            return false;
+        const std::string path((const char*)content.data()+pos, pathSize);
+        pos += pathSize;
+        if (!getEntryValue(content, pos, fileSize, 8))
+            return false;
+        Array<cxbyte> depContent;
+        try
+        { depContent = loadDataFromFile(path.c_str()); }
+        catch(const Exception& ex)
+        { return false; }
+        if (depContent.size() != fileSize ||
+            !checkEntryHash(content, pos, computeDataHash(depContent.size(),
+                        depContent.data())))
+            return false;
+        entryDepFiles.push_back(path);
+    }
+    uint64_t failedPathsNum = 0;
+    if (!getEntryValue(content, pos, failedPathsNum, 4))
+        return false;
+    /* check whether files not found while searching included files are still missing,
+     * if such file exists, then assembler will include it instead of stored file */
+    for (uint64_t i = 0; i < failedPathsNum; i++)
+    {
+        uint64_t pathSize = 0;
+        if (!getEntryValue(content, pos, pathSize, 4) || content.size()-pos < pathSize)
+            return false;
+        const std::string path((const char*)content.data()+pos, pathSize);
+        pos += pathSize;
+        if (isFileExists(path.c_str()))
+            return false;
+        entryFailedPaths.push_back(path);
+    }
+    uint64_t binarySize = 0;
+    if (!getEntryValue(content, pos, binarySize, 8) || content.size()-pos < binarySize)
+        return false;
+    const cxbyte* binaryData = content.data()+pos;
+    pos += binarySize;
+    if (!checkEntryHash(content, pos, computeDataHash(binarySize, binaryData)))
+        return false; // corrupted entry
+    binary.assign(binaryData, binaryData+binarySize);
+    if (depFiles != nullptr)
+        *depFiles = std::move(entryDepFiles);
+    if (failedPaths != nullptr)
+        *failedPaths = std::move(entryFailedPaths);
+    // update modification time to keep recently used entries while eviction
+#ifdef HAVE_WINDOWS
+    _utime(entryPath.c_str(), nullptr);
+#else
+    ::utime(entryPath.c_str(), nullptr);
+#endif
+    return true;
+}
+
+void AsmBinaryCache::store(const AsmCacheKey& key, const Assembler& assembler,
+            const Array<cxbyte>& binary) const
+{
+    std::vector<cxbyte> content(cacheEntryMagic, cacheEntryMagic+sizeof(cacheEntryMagic));
+    putEntryValue(content, key.hash[0], 8);
+    putEntryValue(content, key.hash[1], 8);
+    const std::vector<CString>& depFiles = assembler.getDependencyFiles();
+    putEntryValue(content, depFiles.size(), 4);
+    for (const CString& depFile: depFiles)
+    {
+        const Array<cxbyte> depContent = loadDataFromFile(depFile.c_str());
+        const AsmCacheKey depHash = computeDataHash(depContent.size(), depContent.data());
+        putEntryValue(content, depFile.size(), 4);
+        content.insert(content.end(), depFile.begin(), depFile.begin()+depFile.size());
+        putEntryValue(content, depContent.size(), 8);
+        putEntryValue(content, depHash.hash[0], 8);
+        putEntryValue(content, depHash.hash[1], 8);
+    }
+    const std::vector<CString>& failedPaths = assembler.getFailedIncludePaths();
+    putEntryValue(content, failedPaths.size(), 4);
+    for (const CString& failedPath: failedPaths)
+    {
+        putEntryValue(content, failedPath.size(), 4);
+        content.insert(content.end(), failedPath.begin(),
+                    failedPath.begin()+failedPath.size());
+    }
+    putEntryValue(content, binary.size(), 8);
+    content.insert(content.end(), binary.begin(), binary.end());
+    const AsmCacheKey binaryHash = computeDataHash(binary.size(), binary.data());
+    putEntryValue(content, binaryHash.hash[0], 8);
+    putEntryValue(content, binaryHash.hash[1], 8);
+    
+    // write to unique temporary file and rename it to entry file
+    const std::string entryPath = getEntryPath(key);
+#ifdef HAVE_WINDOWS
+    const unsigned long pid = _getpid();
+#else
+    const unsigned long pid = ::getpid();
+#endif
+    const std::string tmpPath = entryPath + ".tmp" + std::to_string(pid) + "_" +
+                std::to_string(cacheTmpFileCounter.fetch_add(1));
+    {
+        std::ofstream ofs(tmpPath.c_str(), std::ios::binary);
+        if (!ofs)
+            throw Exception("Can't create cache entry file");
+        ofs.write((const char*)content.data(), content.size());
+        ofs.close();
+        if (!ofs)
+        {
+            std::remove(tmpPath.c_str());
+            throw Exception("Can't write cache entry file");
+        }
+    }
+#ifdef HAVE_WINDOWS
+    if (!MoveFileEx(tmpPath.c_str(), entryPath.c_str(), MOVEFILE_REPLACE_EXISTING))
+#else
+    if (::rename(tmpPath.c_str(), entryPath.c_str()) != 0)
+#endif
+    {
+        std::remove(tmpPath.c_str());
+        throw Exception("Can't rename cache entry file");
+    }
+    if (maxSize != 0)
+        evict();
+}
+
+struct CLRX_INTERNAL CacheFileInfo
+{
+    std::string path;
+    uint64_t size;
+    time_t mtime;
+};
+
+// list all entries and temporary files in cache directory
+static void listCacheFiles(const std::string& directory,
+            std::vector<CacheFileInfo>& entries, std::vector<CacheFileInfo>& tmpFiles)
+{
+    std::vector<std::string> names;
+#ifdef HAVE_WINDOWS
+    WIN32_FIND_DATA findData;
+    HANDLE handle = FindFirstFile(joinPaths(directory, "*").c_str(), &findData);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+    do {
+        names.push_back(findData.cFileName);
+    } while (FindNextFile(handle, &findData));
+    FindClose(handle);
+#else
+    DIR* dir = ::opendir(directory.c_str());
+    if (dir == nullptr)
+        return;
+    while (const struct dirent* dirEntry = ::readdir(dir))
+        names.push_back(dirEntry->d_name);
+    ::closedir(dir);
+#endif
+    const size_t extLen = ::strlen(cacheEntryExt);
+    for (const std::string& name: names)
+    {
+        const size_t extPos = name.find(cacheEntryExt);
+        if (extPos == std::string::npos)
+            continue;
+        const bool isEntry = (extPos+extLen == name.size());
+        if (!isEntry && name.compare(extPos+extLen, 4, ".tmp") != 0)
+            continue;
+        const std::string path = joinPaths(directory, name);
+        struct stat stBuf;
+        if (::stat(path.c_str(), &stBuf) != 0)
+            continue;   // removed by other process
+        (isEntry ? entries : tmpFiles).push_back(
+                    { path, uint64_t(stBuf.st_size), stBuf.st_mtime });
+    }
+}
+
+void AsmBinaryCache::evict() const
+{
+    std::vector<CacheFileInfo> entries, tmpFiles;
+    listCacheFiles(directory, entries, tmpFiles);
+    // remove temporary files abandoned by crashed processes
+    const time_t now = ::time(nullptr);
+    for (const CacheFileInfo& tmpFile: tmpFiles)
+        if (tmpFile.mtime + abandonedTmpFileAge < now)
+            std::remove(tmpFile.path.c_str());
+    
+    if (maxSize == 0)
+        return;
+    uint64_t totalSize = 0;
+    for (const CacheFileInfo& entry: entries)
+        totalSize += entry.size;
+    if (totalSize <= maxSize)
+        return;
+    // remove least recently used entries first
+    std::sort(entries.begin(), entries.end(),
+            [](const CacheFileInfo& a, const CacheFileInfo& b)
+            { return a.mtime < b.mtime; });
+    for (const CacheFileInfo& entry: entries)
+    {
+        if (totalSize <= maxSize)
+            break;
+        // ignore errors, other process can remove this entry
+        std::remove(entry.path.c_str());
+        totalSize -= entry.size;
+    }
+}
@@ -114,6 +114,70 @@ AsmExpression::~AsmExpression()
         good = false; \
     }
 
+// apply unary operator to absolute value
+static inline uint64_t applyUnaryOp(AsmExprOp op, uint64_t value)
+{
+    switch (op)
+    {
+        case AsmExprOp::NEGATE:
+            return -value;
+        case AsmExprOp::BIT_NOT:
+            return ~value;
+        case AsmExprOp::LOGICAL_NOT:
+            return !value;
+        default:
+            return value;
+    }
+}
+
+// apply binary operator that does not give any message to absolute values
+static inline uint64_t applyBinaryOp(AsmExprOp op, uint64_t value2, uint64_t value)
+{
+    switch (op)
+    {
+        case AsmExprOp::ADDITION:
+            return value2 + value;
+        case AsmExprOp::SUBTRACT:
+            return value2 - value;
+        case AsmExprOp::MULTIPLY:
+            return value2 * value;
+        case AsmExprOp::BIT_AND:
+            return value2 & value;
+        case AsmExprOp::BIT_OR:
+            return value2 | value;
+        case AsmExprOp::BIT_XOR:
+            return value2 ^ value;
+        case AsmExprOp::BIT_ORNOT:
+            return value2 | ~value;
+        case AsmExprOp::LOGICAL_AND:
+            return value2 && value;
+        case AsmExprOp::LOGICAL_OR:
+            return value2 || value;
+        case AsmExprOp::EQUAL:
+            return (value2 == value) ? UINT64_MAX : 0;
+        case AsmExprOp::NOT_EQUAL:
+            return (value2 != value) ? UINT64_MAX : 0;
+        case AsmExprOp::LESS:
+            return (int64_t(value2) < int64_t(value))? UINT64_MAX: 0;
+        case AsmExprOp::LESS_EQ:
+            return (int64_t(value2) <= int64_t(value)) ? UINT64_MAX : 0;
+        case AsmExprOp::GREATER:
+            return (int64_t(value2) > int64_t(value)) ? UINT64_MAX : 0;
+        case AsmExprOp::GREATER_EQ:
+            return (int64_t(value2) >= int64_t(value)) ? UINT64_MAX : 0;
+        case AsmExprOp::BELOW:
+            return (value2 < value)? UINT64_MAX: 0;
+        case AsmExprOp::BELOW_EQ:
+            return (value2 <= value) ? UINT64_MAX : 0;
+        case AsmExprOp::ABOVE:
+            return (value2 > value) ? UINT64_MAX : 0;
+        case AsmExprOp::ABOVE_EQ:
+            return (value2 >= value) ? UINT64_MAX : 0;
+        default:
+            return value;
+    }
+}
+
 // expression with relative symbols
 struct RelMultiply
 {
@@ -212,7 +276,16 @@ AsmTryStatus AsmExpression::tryEvaluate(Assembler& assembler, size_t opStart, si
     if (!relativeSymOccurs)
     {
         // all value is absolute
-        std::stack<uint64_t> stack;
+        // flat stack of values: depth is not greater than number of operators
+        uint64_t stackBuf[16];
+        std::unique_ptr<uint64_t[]> stackHeap;
+        uint64_t* stack = stackBuf;
+        if (opEnd-opStart > 16)
+        {
+            stackHeap.reset(new uint64_t[opEnd-opStart]);
+            stack = stackHeap.get();
+        }
+        size_t stackSize = 0;
         
         size_t argPos = 0;
         size_t opPos = 0;
@@ -233,45 +306,19 @@ AsmTryStatus AsmExpression::tryEvaluate(Assembler& assembler, size_t opStart, si
             if (op == AsmExprOp::ARG_VALUE)
             {
                 // push argument to stack
-                stack.push(args[argPos++].value);
+                stack[stackSize++] = args[argPos++].value;
                 continue;
             }
-            value = stack.top();
-            stack.pop();
+            value = stack[--stackSize];
             if (isUnaryOp(op))
-            {
                 // unary operator (-,~,!)
-                switch (op)
-                {
-                    case AsmExprOp::NEGATE:
-                        value = -value;
-                        break;
-                    case AsmExprOp::BIT_NOT:
-                        value = ~value;
-                        break;
-                    case AsmExprOp::LOGICAL_NOT:
-                        value = !value;
-                        break;
-                    default:
-                        break;
-                }
-            }
+                value = applyUnaryOp(op, value);
             else if (isBinaryOp(op))
             {
                 // get first argument (second in stack)
-                uint64_t value2 = stack.top();
-                stack.pop();
+                uint64_t value2 = stack[--stackSize];
                 switch (op)
                 {
-                    case AsmExprOp::ADDITION:
-                        value = value2 + value;
-                        break;
-                    case AsmExprOp::SUBTRACT:
-                        value = value2 - value;
-                        break;
-                    case AsmExprOp::MULTIPLY:
-                        value = value2 * value;
-                        break;
                     case AsmExprOp::DIVISION:
                         if (value != 0)
                             value = value2 / value;
@@ -316,18 +363,6 @@ AsmTryStatus AsmExpression::tryEvaluate(Assembler& assembler, size_t opStart, si
                         }
                         messagePosIndex++;
                         break;
-                    case AsmExprOp::BIT_AND:
-                        value = value2 & value;
-                        break;
-                    case AsmExprOp::BIT_OR:
-                        value = value2 | value;
-                        break;
-                    case AsmExprOp::BIT_XOR:
-                        value = value2 ^ value;
-                        break;
-                    case AsmExprOp::BIT_ORNOT:
-                        value = value2 | ~value;
-                        break;
                     case AsmExprOp::SHIFT_LEFT:
                         if (value < 64)
                             value = value2 << value;
@@ -361,60 +396,23 @@ AsmTryStatus AsmExpression::tryEvaluate(Assembler& assembler, size_t opStart, si
                         }
                         messagePosIndex++;
                         break;
-                    case AsmExprOp::LOGICAL_AND:
-                        value = value2 && value;
-                        break;
-                    case AsmExprOp::LOGICAL_OR:
-                        value = value2 || value;
-                        break;
-                    case AsmExprOp::EQUAL:
-                        value = (value2 == value) ? UINT64_MAX : 0;
-                        break;
-                    case AsmExprOp::NOT_EQUAL:
-                        value = (value2 != value) ? UINT64_MAX : 0;
-                        break;
-                    case AsmExprOp::LESS:
-                        value = (int64_t(value2) < int64_t(value))? UINT64_MAX: 0;
-                        break;
-                    case AsmExprOp::LESS_EQ:
-                        value = (int64_t(value2) <= int64_t(value)) ? UINT64_MAX : 0;
-                        break;
-                    case AsmExprOp::GREATER:
-                        value = (int64_t(value2) > int64_t(value)) ? UINT64_MAX : 0;
-                        break;
-                    case AsmExprOp::GREATER_EQ:
-                        value = (int64_t(value2) >= int64_t(value)) ? UINT64_MAX : 0;
-                        break;
-                    case AsmExprOp::BELOW:
-                        value = (value2 < value)? UINT64_MAX: 0;
-                        break;
-                    case AsmExprOp::BELOW_EQ:
-                        value = (value2 <= value) ? UINT64_MAX : 0;
-                        break;
-                    case AsmExprOp::ABOVE:
-                        value = (value2 > value) ? UINT64_MAX : 0;
-                        break;
-                    case AsmExprOp::ABOVE_EQ:
-                        value = (value2 >= value) ? UINT64_MAX : 0;
-                        break;
                     default:
+                        value = applyBinaryOp(op, value2, value);
                         break;
                 }
             }
             else if (op == AsmExprOp::CHOICE)
             {
                 // get second and first (second and third in stack)
-                const uint64_t value2 = stack.top();
-                stack.pop();
-                const uint64_t value3 = stack.top();
-                stack.pop();
+                const uint64_t value2 = stack[--stackSize];
+                const uint64_t value3 = stack[--stackSize];
                 value = value3 ? value2 : value;
             }
-            stack.push(value);
+            stack[stackSize++] = value;
         }
         
-        if (!stack.empty())
-            value = stack.top();
+        if (stackSize != 0)
+            value = stack[stackSize-1];
         sectionId = ASMSECT_ABS;
     }
     else
@@ -1164,6 +1162,7 @@ bool AsmExpression::makeSymbolSnapshot(Assembler& assembler,
                     {
                         args[argIndex].symbol->second.addOccurrenceInExpr(
                                         expr, argIndex, opIndex);
+                        assembler.addPendingSymbol(*args[argIndex].symbol);
                         expr->symOccursNum++;
                     }
                     
@@ -1346,6 +1345,73 @@ AsmExpression* AsmExpression::createExprToEvaluate(Assembler& assembler) const
     }
 }
 
+// constant folding: replace subexpressions that have only absolute values and
+// operators which do not give any message by their values
+static void foldConstSubExprs(std::vector<AsmExprOp>& ops, std::vector<AsmExprArg>& args)
+{
+    struct FoldEntry
+    {
+        size_t opPos;   // start of subexpression in new ops
+        size_t argPos;  // start of subexpression in new args
+        bool isConst;   // if subexpression is single absolute value
+    };
+    std::vector<FoldEntry> stack;
+    std::vector<AsmExprOp> newOps;
+    std::vector<AsmExprArg> newArgs;
+    newOps.reserve(ops.size());
+    newArgs.reserve(args.size());
+    size_t argPos = 0;
+    bool folded = false;
+    for (AsmExprOp op: ops)
+    {
+        if (AsmExpression::isArg(op))
+        {
+            const AsmExprArg& arg = args[argPos++];
+            stack.push_back({ newOps.size(), newArgs.size(),
+                    op==AsmExprOp::ARG_VALUE && arg.relValue.sectionId==ASMSECT_ABS });
+            newOps.push_back(op);
+            newArgs.push_back(arg);
+            continue;
+        }
+        const size_t operandsNum = AsmExpression::isUnaryOp(op) ? 1 :
+                    (AsmExpression::isBinaryOp(op) ? 2 : 3);
+        const FoldEntry* operands = stack.data() + stack.size() - operandsNum;
+        bool allConst = (operatorWithMessage & (1ULL<<int(op))) == 0;
+        for (size_t i = 0; i < operandsNum; i++)
+            allConst &= operands[i].isConst;
+        const FoldEntry first = operands[0];
+        stack.resize(stack.size() - operandsNum);
+        if (allConst)
+        {
+            // all operands are single values placed in new args
+            const AsmExprArg* vals = newArgs.data() + first.argPos;
+            uint64_t value;
+            if (operandsNum == 1)
+                value = applyUnaryOp(op, vals[0].value);
+            else if (operandsNum == 2)
+                value = applyBinaryOp(op, vals[0].value, vals[1].value);
+            else // choice
+                value = vals[0].value ? vals[1].value : vals[2].value;
+            newOps.resize(first.opPos);
+            newArgs.resize(first.argPos);
+            AsmExprArg arg;
+            arg.relValue.value = value;
+            arg.relValue.sectionId = ASMSECT_ABS;
+            newOps.push_back(AsmExprOp::ARG_VALUE);
+            newArgs.push_back(arg);
+            folded = true;
+        }
+        else
+            newOps.push_back(op);
+        stack.push_back({ first.opPos, first.argPos, allConst });
+    }
+    if (folded)
+    {
+        ops.swap(newOps);
+        args.swap(newArgs);
+    }
+}
+
 AsmExpression* AsmExpression::parse(Assembler& assembler, const char*& linePtr,
             bool makeBase, bool dontResolveSymbolsLater)
 {
@@ -1814,6 +1880,10 @@ AsmExpression* AsmExpression::parse(Assembler& assembler, const char*& linePtr,
     
     if (good)
     {
+        // fully defined expressions are evaluated once just after parsing,
+        // fold only expressions that will be kept for later evaluation
+        if (symOccursNum != 0)
+            foldConstSubExprs(ops, args);
         const size_t argsNum = args.size();
         // if good, we set symbol occurrences, operators, arguments ...
         expr->setParams(symOccursNum, relativeSymOccurs,
@@ -1827,6 +1897,7 @@ AsmExpression* AsmExpression::parse(Assembler& assembler, const char*& linePtr,
                 if (ops[i] == AsmExprOp::ARG_SYMBOL)
                 {
                     args[j].symbol->second.addOccurrenceInExpr(expr.get(), j, i);
+                    assembler.addPendingSymbol(*args[j].symbol);
                     j++;
                 }
                 else if (ops[i]==AsmExprOp::ARG_VALUE)
@@ -1845,6 +1916,8 @@ AsmExpression* AsmExpression::parse(Assembler& assembler, const char*& linePtr,
             }
         }
         symbolSnapshots.clear();
+        if (assembler.collectStats)
+            assembler.stats.exprsCreated++;
         return expr.release();
     }
     else
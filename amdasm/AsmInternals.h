@@ -26,6 +26,7 @@
 #include <unordered_set>
 #include <utility>
 #include <memory>
+#include <chrono>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/amdasm/Assembler.h>
 #include "GCNInternals.h"
@@ -33,6 +34,27 @@
 namespace CLRX
 {
 
+// scoped timer of assembler phase (do nothing if statistics are disabled)
+class CLRX_INTERNAL AsmPhaseTimer
+{
+private:
+    uint64_t* phaseNanos;
+    std::chrono::steady_clock::time_point start;
+public:
+    AsmPhaseTimer(AsmStats* stats, cxuint phase)
+        : phaseNanos(stats!=nullptr ? stats->phaseNanos+phase : nullptr)
+    {
+        if (phaseNanos!=nullptr)
+            start = std::chrono::steady_clock::now();
+    }
+    ~AsmPhaseTimer()
+    {
+        if (phaseNanos!=nullptr)
+            *phaseNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now()-start).count();
+    }
+};
+
 static inline void skipCharAndSpacesToEnd(const char*& string, const char* end)
 {
     ++string;
@@ -84,7 +84,7 @@ enum
 /// all main pseudo-ops (sorted by name)
 static const char* pseudoOpNamesTbl[] =
 {
-    "32bit", "64bit", "abort", "align", "altmacro",
+    "32bit", "64bit", "abort", "align", "alignopt", "altmacro",
     "amd", "amd3", "amdcl2", "arch", "ascii", "asciz",
     "balign", "balignl", "balignw", "buggyfplit", "byte",
     "cf_call", "cf_cjump", "cf_end",
@@ -111,13 +111,13 @@ static const char* pseudoOpNamesTbl[] =
     "ifne", "ifnes", "ifnfmt", "ifngpu", "ifnotdef", "incbin",
     "include", "int", "irp", "irpc", "kernel", "lflags",
     "line", "ln", "local", "long",
-    "macro", "macrocase", "main", "noaltmacro",
-    "nobuggyfplit", "nomacrocase", "nooldmodparam",
+    "macro", "macrocase", "main", "noalignopt", "noaltmacro",
+    "nobuggyfplit", "nomacrocase", "nooldmodparam", "noshrinkcode",
     "nowave32", "octa", "offset", "oldmodparam", "org",
     "p2align", "policy", "print", "purgem", "quad",
     "rawcode", "regvar", "rept", "rocm", "rodata",
     "rvlin", "rvlin_once", "sbttl", "scope", "section", "set",
-    "short", "single", "size", "skip",
+    "short", "shrinkcode", "single", "size", "skip",
     "space", "string", "string16", "string32",
     "string64", "struct", "text", "title",
     "undef", "unusing", "usereg", "using", "version",
@@ -127,7 +127,8 @@ static const char* pseudoOpNamesTbl[] =
 // enum for all pseudo-ops
 enum
 {
-    ASMOP_32BIT = 0, ASMOP_64BIT, ASMOP_ABORT, ASMOP_ALIGN, ASMOP_ALTMACRO,
+    ASMOP_32BIT = 0, ASMOP_64BIT, ASMOP_ABORT, ASMOP_ALIGN, ASMOP_ALIGNOPT,
+    ASMOP_ALTMACRO,
     ASMOP_AMD, ASMOP_AMD3, ASMOP_AMDCL2, ASMOP_ARCH, ASMOP_ASCII, ASMOP_ASCIZ,
     ASMOP_BALIGN, ASMOP_BALIGNL, ASMOP_BALIGNW, ASMOP_BUGGYFPLIT, ASMOP_BYTE,
     ASMOP_CF_CALL, ASMOP_CF_CJUMP, ASMOP_CF_END,
@@ -154,13 +155,13 @@ enum
     ASMOP_IFNE, ASMOP_IFNES, ASMOP_IFNFMT, ASMOP_IFNGPU, ASMOP_IFNOTDEF, ASMOP_INCBIN,
     ASMOP_INCLUDE, ASMOP_INT, ASMOP_IRP, ASMOP_IRPC, ASMOP_KERNEL, ASMOP_LFLAGS,
     ASMOP_LINE, ASMOP_LN, ASMOP_LOCAL, ASMOP_LONG,
-    ASMOP_MACRO, ASMOP_MACROCASE, ASMOP_MAIN, ASMOP_NOALTMACRO,
-    ASMOP_NOBUGGYFPLIT, ASMOP_NOMACROCASE, ASMOP_NOOLDMODPARAM,
+    ASMOP_MACRO, ASMOP_MACROCASE, ASMOP_MAIN, ASMOP_NOALIGNOPT, ASMOP_NOALTMACRO,
+    ASMOP_NOBUGGYFPLIT, ASMOP_NOMACROCASE, ASMOP_NOOLDMODPARAM, ASMOP_NOSHRINKCODE,
     ASMOP_NOWAVE32, ASMOP_OCTA, ASMOP_OFFSET, ASMOP_OLDMODPARAM, ASMOP_ORG,
     ASMOP_P2ALIGN, ASMOP_POLICY, ASMOP_PRINT, ASMOP_PURGEM, ASMOP_QUAD,
     ASMOP_RAWCODE, ASMOP_REGVAR, ASMOP_REPT, ASMOP_ROCM, ASMOP_RODATA,
     ASMOP_RVLIN, ASMOP_RVLIN_ONCE, ASMOP_SBTTL, ASMOP_SCOPE, ASMOP_SECTION, ASMOP_SET,
-    ASMOP_SHORT, ASMOP_SINGLE, ASMOP_SIZE, ASMOP_SKIP,
+    ASMOP_SHORT, ASMOP_SHRINKCODE, ASMOP_SINGLE, ASMOP_SIZE, ASMOP_SKIP,
     ASMOP_SPACE, ASMOP_STRING, ASMOP_STRING16, ASMOP_STRING32,
     ASMOP_STRING64, ASMOP_STRUCT, ASMOP_TEXT, ASMOP_TITLE,
     ASMOP_UNDEF, ASMOP_UNUSING, ASMOP_USEREG, ASMOP_USING, ASMOP_VERSION,
@@ -216,6 +217,10 @@ void Assembler::parsePseudoOps(const CString& firstName,
         case ASMOP_BALIGN:
             AsmPseudoOps::doAlign(*this, stmtPlace, linePtr);
             break;
+        case ASMOP_ALIGNOPT:
+            if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
+                alignOpt = true;
+            break;
         case ASMOP_ALTMACRO:
             if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
                 alternateMacro = true;
@@ -595,6 +600,10 @@ void Assembler::parsePseudoOps(const CString& firstName,
         case ASMOP_MAIN:
             AsmPseudoOps::goToMain(*this, stmtPlace, linePtr);
             break;
+        case ASMOP_NOALIGNOPT:
+            if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
+                alignOpt = false;
+            break;
         case ASMOP_NOALTMACRO:
             if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
                 alternateMacro = false;
@@ -611,6 +620,10 @@ void Assembler::parsePseudoOps(const CString& firstName,
             if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
                 oldModParam = false;
             break;
+        case ASMOP_NOSHRINKCODE:
+            if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
+                shrinkCode = false;
+            break;
         case ASMOP_NOWAVE32:
             if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
             {
@@ -671,6 +684,10 @@ void Assembler::parsePseudoOps(const CString& firstName,
         case ASMOP_SHORT:
             AsmPseudoOps::putIntegers<uint16_t>(*this, stmtPlace, linePtr);
             break;
+        case ASMOP_SHRINKCODE:
+            if (AsmPseudoOps::checkGarbagesAtEnd(*this, linePtr))
+                shrinkCode = true;
+            break;
         case ASMOP_SINGLE:
             AsmPseudoOps::putFloats<uint32_t>(*this, stmtPlace, linePtr);
             break;
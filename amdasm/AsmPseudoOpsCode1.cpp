@@ -396,23 +396,28 @@ void AsmPseudoOps::includeBinFile(Assembler& asmr, const char* pseudoOpPlace,
     std::ifstream ifs;
     sysfilename = filename;
     filesystemPath(sysfilename);
+    std::string openedPath = sysfilename;
     // try in this directory
     ifs.open(sysfilename.c_str(), std::ios::binary);
     if (!ifs)
     {
+        asmr.failedIncludePaths.push_back(sysfilename);
         // find in include paths
         for (const CString& incDir: asmr.includeDirs)
         {
             std::string incDirPath(incDir.c_str());
             filesystemPath(incDirPath);
-            ifs.open(joinPaths(incDirPath.c_str(), sysfilename).c_str(), std::ios::binary);
+            openedPath = joinPaths(incDirPath.c_str(), sysfilename);
+            ifs.open(openedPath.c_str(), std::ios::binary);
             if (ifs)
                 break;
+            asmr.failedIncludePaths.push_back(openedPath);
         }
     }
     if (!ifs)
         ASM_RETURN_BY_ERROR(namePlace, (std::string("Binary file '") + filename +
                     "' not found or unavailable in any directory").c_str())
+    asmr.dependencyFiles.push_back(openedPath);
     // exception for checking file seeking
     bool seekingIsWorking = true;
     ifs.exceptions(std::ios::badbit | std::ios::failbit); // exceptions
@@ -1796,8 +1801,13 @@ void AsmPseudoOps::doFor(Assembler& asmr, const char* pseudoOpPlace, const char*
             else // set value of symbol
                 asmr.setSymbol(*res.first, value, sectionId);
         }
-        else // set hasValue (by isResolvableSection
+        else
+        {
+            // set hasValue (by isResolvableSection
             res.first->second.hasValue = asmr.isResolvableSection(sectionId);
+            if (!res.first->second.hasValue)
+                asmr.addPendingSymbol(*res.first);
+        }
         iterSymbol = res.first;
     }
     
@@ -142,12 +142,14 @@ ISALinearDepHandler* ISALinearDepHandler::copy() const
  * Asm register allocator stuff
  */
 
-AsmRegAllocator::AsmRegAllocator(Assembler& _assembler) : assembler(_assembler)
+AsmRegAllocator::AsmRegAllocator(Assembler& _assembler) : assembler(_assembler),
+        regTypesNum(0)
 { }
 
 AsmRegAllocator::AsmRegAllocator(Assembler& _assembler,
         const std::vector<CodeBlock>& _codeBlocks, const SSAReplacesMap& _ssaReplacesMap)
-        : assembler(_assembler), codeBlocks(_codeBlocks), ssaReplacesMap(_ssaReplacesMap)
+        : assembler(_assembler), codeBlocks(_codeBlocks), ssaReplacesMap(_ssaReplacesMap),
+          regTypesNum(0)
 { }
 
 static inline bool codeBlockStartLess(const AsmRegAllocator::CodeBlock& c1,
@@ -593,34 +595,21 @@ void AsmRegAllocator::createInterferenceGraph()
         interGraph.resize(graphVregsCounts[regType]);
         std::set<LiveBlock>& liveBlockMap = liveBlockMaps[regType];
         
-        auto lit = liveBlockMap.begin();
-        size_t rangeStart = 0;
-        if (lit != liveBlockMap.end())
-            rangeStart = lit->start;
-        while (lit != liveBlockMap.end())
+        // sweep through live blocks ordered by start, keep active live blocks
+        // (key - end of live block, value - var index)
+        std::multimap<size_t, size_t> activeBlocks;
+        for (const LiveBlock& lblk: liveBlockMap)
         {
-            const size_t blkStart = lit->start;
-            const size_t blkEnd = lit->end;
-            size_t rangeEnd = blkEnd;
-            auto liStart = liveBlockMap.lower_bound({ rangeStart, 0, 0 });
-            auto liEnd = liveBlockMap.lower_bound({ rangeEnd, 0, 0 });
-            // collect from this range, variable indices
-            std::set<size_t> varIndices;
-            for (auto lit2 = liStart; lit2 != liEnd; ++lit2)
-                varIndices.insert(lit2->vidx);
-            // push to intergraph as full subgGraph
-            for (auto vit = varIndices.begin(); vit != varIndices.end(); ++vit)
-                for (auto vit2 = varIndices.begin(); vit2 != varIndices.end(); ++vit2)
-                    if (vit != vit2)
-                        interGraph[*vit].insert(*vit2);
-            // go to next live blocks
-            rangeStart = rangeEnd;
-            for (; lit != liveBlockMap.end(); ++lit)
-                if (lit->start != blkStart && lit->end != blkEnd)
-                    break;
-            if (lit == liveBlockMap.end())
-                break; // 
-            rangeStart = std::max(rangeStart, lit->start);
+            // remove live blocks that ends before this live block
+            while (!activeBlocks.empty() && activeBlocks.begin()->first <= lblk.start)
+                activeBlocks.erase(activeBlocks.begin());
+            for (const auto& active: activeBlocks)
+                if (active.second != lblk.vidx)
+                {
+                    interGraph[lblk.vidx].insert(active.second);
+                    interGraph[active.second].insert(lblk.vidx);
+                }
+            activeBlocks.insert(std::make_pair(lblk.end, lblk.vidx));
         }
     }
 }
@@ -654,20 +643,21 @@ void AsmRegAllocator::colorInterferenceGraph()
         
         SDOLDOCompare compare(interGraph, sdoCounts);
         std::set<size_t, SDOLDOCompare> nodeSet(compare);
-        for (size_t i = 0; i < nodesNum; i++)
-            nodeSet.insert(i);
         
         cxuint colorsNum = 0;
         // firstly, allocate real registers
         for (const auto& entry: vregIndexMap)
             if (entry.first.regVar == nullptr)
                 gcMap[entry.second[0]] = colorsNum++;
+        // only uncolored nodes are in nodeSet (their SDO counts can be changed)
+        for (size_t i = 0; i < nodesNum; i++)
+            if (gcMap[i] == UINT_MAX)
+                nodeSet.insert(i);
         
-        for (size_t colored = 0; colored < nodesNum; colored++)
+        while (!nodeSet.empty())
         {
             size_t node = *nodeSet.begin();
-            if (gcMap[node] != UINT_MAX)
-                continue; // already colored
+            nodeSet.erase(nodeSet.begin());
             size_t color = 0;
             
             for (color = 0; color <= colorsNum; color++)
@@ -706,7 +696,7 @@ void AsmRegAllocator::colorInterferenceGraph()
             {
                 colorExists = false;
                 for (size_t nb2: interGraph[nb])
-                    if (gcMap[nb2] == color)
+                    if (nb2 != node && gcMap[nb2] == color)
                     {
                         colorExists = true;
                         break;
@@ -463,9 +463,11 @@ struct CLRX_INTERNAL SDOLDOCompare
     
     bool operator()(size_t a, size_t b) const
     {
-        if (sdoCounts[a] > sdoCounts[b])
-            return true;
-        return interGraph[a].size() > interGraph[b].size();
+        if (sdoCounts[a] != sdoCounts[b])
+            return sdoCounts[a] > sdoCounts[b];
+        if (interGraph[a].size() != interGraph[b].size())
+            return interGraph[a].size() > interGraph[b].size();
+        return a < b; // strict ordering: do not merge nodes with equal degrees
     }
 };
 
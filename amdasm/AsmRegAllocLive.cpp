@@ -1205,7 +1205,7 @@ void AsmRegAllocator::createLivenesses(ISAUsageHandler& usageHandler,
     // construct var index maps
     cxuint regRanges[MAX_REGTYPES_NUM*2];
     std::fill(graphVregsCounts, graphVregsCounts+MAX_REGTYPES_NUM, size_t(0));
-    size_t regTypesNum;
+    // set regTypesNum also for later phases (interference graph, coloring)
     assembler.isaAssembler->getRegisterRanges(regTypesNum, regRanges);
     
     for (const CodeBlock& cblock: codeBlocks)
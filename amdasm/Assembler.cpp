@@ -20,6 +20,7 @@
 #include <CLRX/Config.h>
 #include <string>
 #include <cassert>
+#include <cstdio>
 #include <fstream>
 #include <vector>
 #include <stack>
@@ -28,6 +29,7 @@
 #include <algorithm>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/MemAccess.h>
+#include <CLRX/utils/InputOutput.h>
 #include <CLRX/utils/GPUId.h>
 #include <CLRX/amdasm/Assembler.h>
 #include "AsmInternals.h"
@@ -95,6 +97,39 @@ AsmSection& AsmSection::operator=(const AsmSection& section)
     return *this;
 }
 
+// move constructor - used while reallocating sections, does not copy section content
+AsmSection::AsmSection(AsmSection&& section) noexcept
+        : name(section.name), kernelId(section.kernelId), type(section.type),
+          flags(section.flags), alignment(section.alignment), size(section.size),
+          relSpace(section.relSpace), relAddress(section.relAddress),
+          content(std::move(section.content)),
+          usageHandler(std::move(section.usageHandler)),
+          linearDepHandler(std::move(section.linearDepHandler)),
+          waitHandler(std::move(section.waitHandler)),
+          codeFlow(std::move(section.codeFlow)),
+          sourcePosHandler(std::move(section.sourcePosHandler))
+{ }
+
+// move assignment
+AsmSection& AsmSection::operator=(AsmSection&& section) noexcept
+{
+    name = section.name;
+    kernelId = section.kernelId;
+    type = section.type;
+    flags = section.flags;
+    alignment = section.alignment;
+    size = section.size;
+    content = std::move(section.content);
+    relSpace = section.relSpace;
+    relAddress = section.relAddress;
+    usageHandler = std::move(section.usageHandler);
+    linearDepHandler = std::move(section.linearDepHandler);
+    waitHandler = std::move(section.waitHandler);
+    codeFlow = std::move(section.codeFlow);
+    sourcePosHandler = std::move(section.sourcePosHandler);
+    return *this;
+}
+
 // open code region - add new code region if needed
 // called when kernel label encountered or region for this kernel begins
 void AsmKernel::openCodeRegion(size_t offset)
@@ -613,8 +648,13 @@ void AsmParseUtils::setSymbolValue(Assembler& asmr, const char* linePtr,
         else // set value of symbol
             asmr.setSymbol(*res.first, value, sectionId);
     }
-    else // set hasValue (by isResolvableSection
+    else
+    {
+        // set hasValue (by isResolvableSection
         res.first->second.hasValue = asmr.isResolvableSection(sectionId);
+        if (!res.first->second.hasValue)
+            asmr.addPendingSymbol(*res.first);
+    }
 }
 
 
@@ -661,7 +701,10 @@ void AsmSymbol::undefine()
         delete expression;
         expression = nullptr;
     }
+    // keep information about membership in pending symbols
+    const bool oldPendingResolve = pendingResolve;
     *this = AsmSymbol();
+    pendingResolve = oldPendingResolve;
 }
 
 void Assembler::undefineSymbol(AsmSymbolEntry& symEntry)
@@ -780,6 +823,11 @@ Assembler::Assembler(const CString& filename, std::istream& input, Flags _flags,
     buggyFPLit = (flags & ASM_BUGGYFPLIT)!=0;
     macroCase = (flags & ASM_MACRONOCASE)==0;
     oldModParam = (flags & ASM_OLDMODPARAM)!=0;
+    alignOpt = (flags & ASM_ALIGNOPT)!=0;
+    alignOptPenaltyCycles = 0;
+    shrinkCode = (flags & ASM_SHRINKCODE)!=0;
+    shrinkCodeSavedBytes = 0;
+    collectStats = false;
     codeFlags = ((flags & ASM_WAVE32)!=0)?ASM_CODE_WAVE32:0;
     localCount = macroCount = inclusionLevel = 0;
     macroSubstLevel = repetitionLevel = 0;
@@ -823,6 +871,11 @@ Assembler::Assembler(const Array<CString>& _filenames, Flags _flags,
     buggyFPLit = (flags & ASM_BUGGYFPLIT)!=0;
     macroCase = (flags & ASM_MACRONOCASE)==0;
     oldModParam = (flags & ASM_OLDMODPARAM)!=0;
+    alignOpt = (flags & ASM_ALIGNOPT)!=0;
+    alignOptPenaltyCycles = 0;
+    shrinkCode = (flags & ASM_SHRINKCODE)!=0;
+    shrinkCodeSavedBytes = 0;
+    collectStats = false;
     codeFlags = ((flags & ASM_WAVE32)!=0)?ASM_CODE_WAVE32:0;
     localCount = macroCount = inclusionLevel = 0;
     macroSubstLevel = repetitionLevel = 0;
@@ -1546,6 +1599,9 @@ bool Assembler::setSymbol(AsmSymbolEntry& symEntry, uint64_t value, AsmSectionId
     symEntry.second.regRange = false;
     symEntry.second.base = false;
     symEntry.second.withUnevalExpr = false;
+    if (!isResolvableSection(sectionId))
+        // symbol from unresolvable section will be resolved at end of assembly
+        addPendingSymbol(symEntry);
     if (!symEntry.second.hasValue) // if not resolved we just return
         return true; // no error
     bool good = true;
@@ -1621,6 +1677,8 @@ bool Assembler::setSymbol(AsmSymbolEntry& symEntry, uint64_t value, AsmSectionId
                         curSymEntry.second.withUnevalExpr = false;
                         curSymEntry.second.hasValue =
                             isResolvableSection(sectionId) || resolvingRelocs;
+                        if (!isResolvableSection(sectionId))
+                            addPendingSymbol(curSymEntry);
                         symbolStack.push(std::make_pair(&curSymEntry, 0));
                         if (!curSymEntry.second.hasValue)
                             continue;
@@ -2165,6 +2223,8 @@ Assembler::ParseState Assembler::makeMacroSubstitution(const char* linePtr)
     asmInputFilters.push(macroFilter.release());
     currentInputFilter = asmInputFilters.top();
     macroSubstLevel++;
+    if (collectStats)
+        stats.macroSubsts++;
     return ParseState::PARSED;
 }
 
@@ -2445,6 +2505,7 @@ bool Assembler::popScope()
         tryToResolveSymbols(currentScope);
         printUnresolvedSymbols(currentScope);
         resolvingRelocs = oldResolvingRelocs;
+        detachScopeSymbols(currentScope);
         currentScope->deleteSymbolsRecursively();
         abandonedScopes.push_back(currentScope);
     }
@@ -2457,8 +2518,19 @@ bool Assembler::includeFile(const char* pseudoOpPlace, const std::string& filena
 {
     if (inclusionLevel == 500)
         THIS_FAIL_BY_ERROR(pseudoOpPlace, "Inclusion level is greater than 500")
-    std::unique_ptr<AsmInputFilter> newInputFilter(new AsmStreamInputFilter(
-                getSourcePos(pseudoOpPlace), filename));
+    std::unique_ptr<AsmInputFilter> newInputFilter;
+    try
+    {
+        newInputFilter.reset(new AsmStreamInputFilter(getSourcePos(pseudoOpPlace),
+                    filename));
+    }
+    catch(const Exception& ex)
+    {
+        // keep path to check later whether file appeared (for binary cache)
+        failedIncludePaths.push_back(filename);
+        throw;
+    }
+    dependencyFiles.push_back(filename);
     asmInputFilters.push(newInputFilter.release());
     currentInputFilter = asmInputFilters.top();
     inclusionLevel++;
@@ -2498,6 +2570,8 @@ bool Assembler::readLine()
                 line = currentInputFilter->readLine(*this, lineSize);
             } while (line==nullptr && filenameIndex<filenames.size());
             
+            if (collectStats && line!=nullptr)
+                stats.linesRead++;
             return (line!=nullptr);
         }
         else
@@ -2505,6 +2579,8 @@ bool Assembler::readLine()
         currentInputFilter = asmInputFilters.top();
         line = currentInputFilter->readLine(*this, lineSize);
     }
+    if (collectStats)
+        stats.linesRead++;
     return true;
 }
 
@@ -2536,6 +2612,21 @@ cxbyte* Assembler::reserveData(size_t size, cxbyte fillValue)
     }
 }
 
+// insert s_nop's before label in code section to avoid penalties while jumping
+void Assembler::alignCodeLabel(const AsmSymbol& label)
+{
+    if (!alignOpt || !isWriteableSection() ||
+        sections[currentSection].type != AsmSectionType::CODE)
+        return;
+    cxuint penaltyCycles = 0;
+    const size_t padding = isaAssembler->getCodeLabelPadding(currentOutPos, label,
+                penaltyCycles);
+    if (padding == 0)
+        return;
+    isaAssembler->fillAlignment(padding, reserveData(padding));
+    alignOptPenaltyCycles += penaltyCycles;
+}
+
 
 void Assembler::goToMain(const char* pseudoOpPlace)
 {
@@ -2783,8 +2874,18 @@ void Assembler::tryToResolveSymbol(AsmSymbolEntry& symEntry)
     }
 }
 
-// try to resolve symbols in scope (after closing temporary scope or
-// ending assembly for global scope)
+// add symbol to pending symbols that will be resolved at end of assembly
+void Assembler::addPendingSymbol(AsmSymbolEntry& symEntry)
+{
+    // snapshots and clones do not belong to any scope, they are resolved separately
+    if (symEntry.second.pendingResolve || symEntry.second.snapshot ||
+        symEntry.second.detached)
+        return;
+    symEntry.second.pendingResolve = true;
+    pendingSymbols.push_back(&symEntry);
+}
+
+// try to resolve symbols in scope (after closing temporary scope)
 void Assembler::tryToResolveSymbols(AsmScope* thisScope)
 {
     std::deque<ScopeStackElem> scopeStack;
@@ -2813,6 +2914,65 @@ void Assembler::tryToResolveSymbols(AsmScope* thisScope)
     }
 }
 
+/* prepare symbols of temporary scope to deletion: remove them from pending symbols
+ * (by membership in scope, because resolving can add again earlier symbol of scope)
+ * and delete their unresolved expressions that are still used by symbols
+ * outside scope */
+void Assembler::detachScopeSymbols(AsmScope* thisScope)
+{
+    std::vector<AsmSymbolEntry*> scopeSymbols;
+    std::stack<ScopeStackElem0> scopeStack;
+    scopeStack.push({ thisScope, thisScope->scopeMap.begin() });
+    
+    while (!scopeStack.empty())
+    {
+        ScopeStackElem0& entry = scopeStack.top();
+        if (entry.it == entry.scope->scopeMap.begin())
+            // first touch - collect symbols
+            for (AsmSymbolEntry& symEntry: entry.scope->symbolMap)
+                scopeSymbols.push_back(&symEntry);
+        
+        if (entry.it != entry.scope->scopeMap.end())
+        {
+            // next nested level
+            scopeStack.push({ entry.it->second, entry.it->second->scopeMap.begin() });
+            ++entry.it;
+        }
+        else
+            scopeStack.pop();
+    }
+    
+    for (AsmSymbolEntry* symEntry: scopeSymbols)
+    {
+        AsmSymbol& symbol = symEntry->second;
+        symbol.pendingResolve = false;
+        // expression of base symbol is deleted with symbol,
+        // unevaluated expression will be deleted later
+        if (symbol.expression != nullptr && !symbol.base && !symbol.regRange &&
+            !symbol.withUnevalExpr)
+        {
+            AsmExpression* expr = symbol.expression;
+            symbol.expression = nullptr;
+            delete expr; // removes occurrences of expression in symbols
+        }
+    }
+    std::sort(scopeSymbols.begin(), scopeSymbols.end());
+    pendingSymbols.resize(std::remove_if(pendingSymbols.begin(), pendingSymbols.end(),
+            [&scopeSymbols](const AsmSymbolEntry* symEntry)
+            { return std::binary_search(scopeSymbols.begin(), scopeSymbols.end(),
+                        symEntry); }) - pendingSymbols.begin());
+}
+
+/* try to resolve pending symbols at end of assembly: symbols used in expressions and
+ * symbols from unresolvable sections. Values of resolved symbols are propagated
+ * by setSymbol only to dependent expressions */
+void Assembler::tryToResolvePendingSymbols()
+{
+    // setSymbol can add new pending symbols while resolving
+    for (size_t i = 0; i < pendingSymbols.size(); i++)
+        tryToResolveSymbol(*pendingSymbols[i]);
+}
+
 // print unresolved symbols in global scope after assemblying
 // or when popping temporary scope
 void Assembler::printUnresolvedSymbols(AsmScope* thisScope)
@@ -2862,6 +3022,15 @@ void Assembler::printUnresolvedSymbols(AsmScope* thisScope)
     }
 }
 
+// count symbols in scope and its children
+static uint64_t countScopeSymbols(const AsmScope* scope)
+{
+    uint64_t count = scope->symbolMap.size();
+    for (const auto& child: scope->scopeMap)
+        count += countScopeSymbols(child.second);
+    return count;
+}
+
 bool Assembler::assemble()
 {
     resolvingRelocs = false;
@@ -2875,12 +3044,16 @@ bool Assembler::assemble()
             messageStream << "<command-line>: Warning: Definition for symbol '.' "
                     "was ignored" << std::endl;
     
+    collectStats = (flags & ASM_STATS)!=0;
+    stats.reset();
+    
     good = true;
     while (!endOfAssembly)
     {
         if (!lineAlreadyRead)
         {
             // read line
+            AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_READLINE);
             if (!readLine())
                 break;
         }
@@ -2936,6 +3109,7 @@ bool Assembler::assemble()
                 AsmSymbolEntry& nextLRes =
                         *globalScope.symbolMap.insert(std::make_pair(
                             std::string(firstName.c_str())+"f", AsmSymbol())).first;
+                alignCodeLabel(nextLRes.second);
                 /* resolve forward symbol of label now */
                 assert(setSymbol(nextLRes, currentOutPos, currentSection));
                 // move symbol value from next local label into previous local label
@@ -2943,6 +3117,8 @@ bool Assembler::assemble()
                 prevLRes.second.value = nextLRes.second.value;
                 prevLRes.second.hasValue = isResolvableSection();
                 prevLRes.second.sectionId = currentSection;
+                if (!prevLRes.second.hasValue)
+                    addPendingSymbol(prevLRes);
                 /// make forward symbol of label as undefined
                 nextLRes.second.hasValue = false;
             }
@@ -2986,6 +3162,7 @@ bool Assembler::assemble()
                     break;
                 }
                 
+                alignCodeLabel(res.first->second);
                 setSymbol(*res.first, currentOutPos, currentSection);
                 res.first->second.onceDefined = true;
                 res.first->second.sectionId = currentSection;
@@ -3027,14 +3204,22 @@ bool Assembler::assemble()
             sourcePos = getSourcePos(stmtPlace);
         
         if (firstName.size() >= 2 && firstName[0] == '.') // check for pseudo-op
+        {
+            AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_PSEUDOOPS);
             parsePseudoOps(firstName, stmtPlace, linePtr);
+        }
         else if (firstName.size() >= 1 && isDigit(firstName[0]))
             printError(stmtPlace, "Illegal number at statement begin");
         else
         {
             // try to parse processor instruction or macro substitution
-            if (makeMacroSubstitution(stmtPlace) == ParseState::MISSING)
-            {  
+            ParseState macroState;
+            {
+                AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_MACROSUBST);
+                macroState = makeMacroSubstitution(stmtPlace);
+            }
+            if (macroState == ParseState::MISSING)
+            {
                 if (firstName.empty()) // if name is empty
                 {
                     if (linePtr!=end) // error
@@ -3061,6 +3246,7 @@ bool Assembler::assemble()
                 if (sections[currentSection].waitHandler == nullptr)
                     sections[currentSection].waitHandler.reset(new ISAWaitHandler());
                 
+                AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_INSTRS);
                 isaAssembler->assemble(firstName, stmtPlace, linePtr, end,
                            sections[currentSection].content,
                            sections[currentSection].usageHandler.get(),
@@ -3105,19 +3291,24 @@ bool Assembler::assemble()
     
     if (withSectionDiffs())
     {
+        AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_SECTDIFFS);
         formatHandler->prepareSectionDiffsResolving();
         sectionDiffsPrepared = true;
     }
     
-    resolvingRelocs = true;
-    tryToResolveSymbols(&globalScope);
-    doNotRemoveFromSymbolClones = true;
-    for (AsmSymbolEntry* symEntry: symbolClones)
-        tryToResolveSymbol(*symEntry);
-    doNotRemoveFromSymbolClones = false;
+    {
+        AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_RESOLVESYMS);
+        resolvingRelocs = true;
+        tryToResolvePendingSymbols();
+        doNotRemoveFromSymbolClones = true;
+        for (AsmSymbolEntry* symEntry: symbolClones)
+            tryToResolveSymbol(*symEntry);
+        doNotRemoveFromSymbolClones = false;
+    }
     
     if (withSectionDiffs())
     {
+        AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_SECTDIFFS);
         resolvingRelocs = false;
         for (AsmExpression*& expr: unevalExpressions)
         {
@@ -3132,7 +3323,11 @@ bool Assembler::assemble()
         resolvingRelocs = true;
     }
     
-    printUnresolvedSymbols(&globalScope);
+    // only symbols used in expressions can be unresolved
+    if (std::any_of(pendingSymbols.begin(), pendingSymbols.end(),
+            [](const AsmSymbolEntry* symEntry)
+            { return !symEntry->second.occurrencesInExprs.empty(); }))
+        printUnresolvedSymbols(&globalScope);
     
     if (good && formatHandler!=nullptr)
     {
@@ -3151,8 +3346,16 @@ bool Assembler::assemble()
             kernels[i].closeCodeRegion(contentSize);
         }
         // prepare binary
+        AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_PREPAREBIN);
         formatHandler->prepareBinary();
     }
+    if (collectStats)
+    {
+        // sections content only grows while assembling, hence this is peak size
+        for (const AsmSection& section: sections)
+            stats.peakSectionBytes += section.content.size();
+        stats.symbolsNum = countScopeSymbols(&globalScope);
+    }
     return good;
 }
 
@@ -3163,9 +3366,16 @@ void Assembler::writeBinary(const char* filename) const
         const AsmFormatHandler* formatHandler = getFormatHandler();
         if (formatHandler!=nullptr)
         {
-            std::ofstream ofs(filename, std::ios::binary);
+            FileOStream ofs(filename);
             if (ofs)
+            {
+                AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_WRITEBIN);
                 formatHandler->writeBinary(ofs);
+                ofs.close();
+                if (!ofs)
+                    throw AsmException(std::string("Can't write output file '")+
+                                filename+"'");
+            }
             else
                 throw AsmException(std::string("Can't open output file '")+filename+"'");
         }
@@ -3182,7 +3392,10 @@ void Assembler::writeBinary(std::ostream& outStream) const
     {
         const AsmFormatHandler* formatHandler = getFormatHandler();
         if (formatHandler!=nullptr)
+        {
+            AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_WRITEBIN);
             formatHandler->writeBinary(outStream);
+        }
         else
             throw AsmException("No output binary");
     }
@@ -3196,10 +3409,48 @@ void Assembler::writeBinary(Array<cxbyte>& array) const
     {
         const AsmFormatHandler* formatHandler = getFormatHandler();
         if (formatHandler!=nullptr)
+        {
+            AsmPhaseTimer phaseTimer(getStatsIfEnabled(), ASMPHASE_WRITEBIN);
             formatHandler->writeBinary(array);
+        }
         else
             throw AsmException("No output binary");
     }
     else // failed
         throw AsmException("Assembler failed!");
 }
+
+static const char* asmPhaseNamesTable[ASMPHASE_MAX+1] =
+{
+    "readline", "macrosubst", "pseudoops", "instrs", "resolvesyms",
+    "sectdiffs", "preparebin", "writebin"
+};
+
+const char* CLRX::getAsmPhaseName(cxuint phase)
+{
+    if (phase > ASMPHASE_MAX)
+        throw AsmException("Unknown assembler phase");
+    return asmPhaseNamesTable[phase];
+}
+
+void Assembler::printStats(std::ostream& os) const
+{
+    os << "Assembler statistics:\n";
+    uint64_t totalNanos = 0;
+    for (cxuint i = 0; i <= ASMPHASE_MAX; i++)
+    {
+        char buf[64];
+        const uint64_t nanos = stats.phaseNanos[i];
+        ::snprintf(buf, 64, "  %-12s %10.3f ms\n", asmPhaseNamesTable[i], nanos*1e-6);
+        os << buf;
+        totalNanos += nanos;
+    }
+    char buf[64];
+    ::snprintf(buf, 64, "  %-12s %10.3f ms\n", "total", totalNanos*1e-6);
+    os << buf;
+    os << "  Lines read: " << stats.linesRead << "\n"
+        "  Macro substitutions: " << stats.macroSubsts << "\n"
+        "  Expressions created: " << stats.exprsCreated << "\n"
+        "  Symbols: " << stats.symbolsNum << "\n"
+        "  Peak section bytes: " << stats.peakSectionBytes << std::endl;
+}
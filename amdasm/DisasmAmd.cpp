@@ -107,7 +107,7 @@ static void getAmdDisasmKernelInputFromBinary(const AmdInnerGPUBinary32* innerBi
 // template for handling 32-bit and 64-bit bnaries
 template<typename AmdMainBinary>
 static AmdDisasmInput* getAmdDisasmInputFromBinary(const AmdMainBinary& binary,
-           Flags flags)
+           Flags flags, const std::vector<CString>& kernelNames)
 {
     std::unique_ptr<AmdDisasmInput> input(new AmdDisasmInput);
     input->is64BitMode = (binary.getHeader().e_ident[EI_CLASS] == ELFCLASS64);
@@ -121,15 +121,22 @@ static AmdDisasmInput* getAmdDisasmInputFromBinary(const AmdMainBinary& binary,
     const size_t kernelInfosNum = binary.getKernelInfosNum();
     const size_t kernelHeadersNum = binary.getKernelHeadersNum();
     const size_t innerBinariesNum = binary.getInnerBinariesNum();
-    input->kernels.resize(kernelInfosNum);
+    input->kernels.reserve(kernelInfosNum);
     
     const Flags innerFlags = flags |
         (((flags&DISASM_CONFIG)!=0) ? DISASM_METADATA|DISASM_CALNOTES : 0);
+    /* in lazy binary, inner binaries are found by name to parse only
+     * inner binaries of the selected kernels */
+    const bool innerBinByName = binary.isLazy() && binary.hasInnerBinaryMap();
     for (cxuint i = 0; i < kernelInfosNum; i++)
     {
+        // check kernel name before parsing kernel informations
+        if (!kernelNames.empty() &&
+            !isDisasmKernelSelected(kernelNames, binary.getKernelInfoName(i)))
+            continue; // skip not selected kernel
         const KernelInfo& kernelInfo = binary.getKernelInfo(i);
         const AmdInnerGPUBinary32* innerBin = nullptr;
-        if (i < innerBinariesNum)
+        if (i < innerBinariesNum && !innerBinByName)
             innerBin = &binary.getInnerBinary(i);
         if (innerBin == nullptr || innerBin->getKernelName() != kernelInfo.kernelName)
         {
@@ -139,7 +146,8 @@ static AmdDisasmInput* getAmdDisasmInputFromBinary(const AmdMainBinary& binary,
             catch(const Exception& ex)
             { innerBin = nullptr; }
         }
-        AmdDisasmKernelInput& kernelInput = input->kernels[i];
+        input->kernels.push_back(AmdDisasmKernelInput());
+        AmdDisasmKernelInput& kernelInput = input->kernels.back();
         // kernel metadata
         kernelInput.metadataSize = binary.getMetadataSize(i);
         kernelInput.metadata = binary.getMetadata(i);
@@ -173,15 +181,15 @@ static AmdDisasmInput* getAmdDisasmInputFromBinary(const AmdMainBinary& binary,
 }
 
 AmdDisasmInput* CLRX::getAmdDisasmInputFromBinary32(const AmdMainGPUBinary32& binary,
-                  Flags flags)
+                  Flags flags, const std::vector<CString>& kernelNames)
 {
-    return getAmdDisasmInputFromBinary(binary, flags);
+    return getAmdDisasmInputFromBinary(binary, flags, kernelNames);
 }
 
 AmdDisasmInput* CLRX::getAmdDisasmInputFromBinary64(const AmdMainGPUBinary64& binary,
-                  Flags flags)
+                  Flags flags, const std::vector<CString>& kernelNames)
 {
-    return getAmdDisasmInputFromBinary(binary, flags);
+    return getAmdDisasmInputFromBinary(binary, flags, kernelNames);
 }
 
 /* get AsmConfig */
@@ -1513,7 +1521,8 @@ static void dumpAmdKernelConfig(std::ostream& output, const AmdKernelConfig& con
 }
 
 void CLRX::disassembleAmd(std::ostream& output, const AmdDisasmInput* amdInput,
-       ISADisassembler* isaDisassembler, size_t& sectionCount, Flags flags)
+       ISADisassembler* isaDisassembler, size_t& sectionCount, Flags flags,
+       const std::vector<CString>& kernelNames)
 {
     if (amdInput->is64BitMode)
         output.write(".64bit\n", 7);
@@ -1541,11 +1550,14 @@ void CLRX::disassembleAmd(std::ostream& output, const AmdDisasmInput* amdInput,
     if (doDumpData && amdInput->globalData != nullptr && amdInput->globalDataSize != 0)
     {   //
         output.write(".globaldata\n", 12);
-        printDisasmData(amdInput->globalDataSize, amdInput->globalData, output);
+        isaDisassembler->getDisassembler().printDataBlock(amdInput->globalDataSize,
+                    amdInput->globalData);
     }
     
     for (const AmdDisasmKernelInput& kinput: amdInput->kernels)
     {
+        if (!isDisasmKernelSelected(kernelNames, kinput.kernelName))
+            continue;
         output.write(".kernel ", 8);
         output.write(kinput.kernelName.c_str(), kinput.kernelName.size());
         output.put('\n');
@@ -1558,6 +1570,8 @@ void CLRX::disassembleAmd(std::ostream& output, const AmdDisasmInput* amdInput,
                     kinput.metadata, kinput.calNotes, amdInput->driverInfo,
                     kinput.header, getGPUArchitectureFromDeviceType(amdInput->deviceType));
             dumpAmdKernelConfig(output, config);
+            isaDisassembler->addKernelResources({ kinput.kernelName,
+                    config.usedSGPRsNum, config.usedVGPRsNum, config.hwLocalSize });
         }
         
         if (doDumpCode && kinput.code != nullptr && kinput.codeSize != 0)
@@ -1565,6 +1579,7 @@ void CLRX::disassembleAmd(std::ostream& output, const AmdDisasmInput* amdInput,
             // input kernel code (main disassembly)
             output.write("    .text\n", 10);
             isaDisassembler->setInput(kinput.codeSize, kinput.code);
+            isaDisassembler->setCodeName(kinput.kernelName, sectionCount);
             isaDisassembler->beforeDisassemble();
             isaDisassembler->disassemble();
             sectionCount++;
@@ -58,7 +58,7 @@ struct CLRX_INTERNAL AmdCL2Types64: Elf64Types
 template<typename AmdCL2Types>
 static AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary(
             const typename AmdCL2Types::AmdCL2MainBinary& binary, cxuint driverVersion,
-            bool hsaLayout)
+            bool hsaLayout, const std::vector<CString>& kernelNames)
 {
     std::unique_ptr<AmdCL2DisasmInput> input(new AmdCL2DisasmInput);
     input->is64BitMode = (binary.getHeader().e_ident[EI_CLASS] == ELFCLASS64);
@@ -173,7 +173,7 @@ static AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary(
     else if (kernelInfosNum==0)
         return input.release();
     
-    input->kernels.resize(kernelInfosNum);
+    input->kernels.reserve(kernelInfosNum);
     auto sortedRelocIter = sortedRelocs.begin();
     if (isInnerNewBinary && hsaLayout)
     {
@@ -216,7 +216,10 @@ static AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary(
     for (cxuint i = 0; i < kernelInfosNum; i++)
     {
         const KernelInfo& kernelInfo = binary.getKernelInfo(i);
-        AmdCL2DisasmKernelInput& kinput = input->kernels[i];
+        if (!isDisasmKernelSelected(kernelNames, kernelInfo.kernelName))
+            continue; // skip not selected kernel
+        input->kernels.push_back(AmdCL2DisasmKernelInput());
+        AmdCL2DisasmKernelInput& kinput = input->kernels.back();
         kinput.kernelName = kernelInfo.kernelName;
         kinput.metadataSize = binary.getMetadataSize(i);
         kinput.metadata = binary.getMetadata(i);
@@ -287,7 +290,7 @@ static AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary(
     if (isInnerNewBinary && !hsaLayout)
     {
         // sort kernels by order before putting text relocations
-        Array<size_t> sortedKIndices(kernelInfosNum);
+        Array<size_t> sortedKIndices(input->kernels.size());
         for (size_t i = 0; i < sortedKIndices.size(); i++)
             sortedKIndices[i] = i;
         
@@ -298,7 +301,7 @@ static AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary(
                     { return input->kernels[a].setup < input->kernels[b].setup; });
         
         // put text relocations to kernels in offset order
-        for (cxuint i = 0; i < kernelInfosNum; i++)
+        for (cxuint i = 0; i < sortedKIndices.size(); i++)
         {
             AmdCL2DisasmKernelInput& kinput = input->kernels[sortedKIndices[i]];
             
@@ -353,23 +356,28 @@ static AmdCL2DisasmInput* getAmdCL2DisasmInputFromBinary(
         }
     }
     
-    if (sortedRelocIter != sortedRelocs.end())
+    // relocations of not selected kernels can be left
+    if (sortedRelocIter != sortedRelocs.end() && kernelNames.empty())
         throw DisasmException("Code relocation offset outside kernel code");
     return input.release();
 }
 
 // get AMD CL2 input from 32-bit binary
 AmdCL2DisasmInput* CLRX::getAmdCL2DisasmInputFromBinary32(
-        const AmdCL2MainGPUBinary32& binary, cxuint driverVersion, bool hsaLayout)
+        const AmdCL2MainGPUBinary32& binary, cxuint driverVersion, bool hsaLayout,
+        const std::vector<CString>& kernelNames)
 {
-    return getAmdCL2DisasmInputFromBinary<AmdCL2Types32>(binary, driverVersion, hsaLayout);
+    return getAmdCL2DisasmInputFromBinary<AmdCL2Types32>(binary, driverVersion, hsaLayout,
+                kernelNames);
 }
 
 // get AMD CL2 input from 64-bit binary
 AmdCL2DisasmInput* CLRX::getAmdCL2DisasmInputFromBinary64(
-        const AmdCL2MainGPUBinary64& binary, cxuint driverVersion, bool hsaLayout)
+        const AmdCL2MainGPUBinary64& binary, cxuint driverVersion, bool hsaLayout,
+        const std::vector<CString>& kernelNames)
 {
-    return getAmdCL2DisasmInputFromBinary<AmdCL2Types64>(binary, driverVersion, hsaLayout);
+    return getAmdCL2DisasmInputFromBinary<AmdCL2Types64>(binary, driverVersion, hsaLayout,
+                kernelNames);
 }
 
 // internal AMD OpenCL 2.0 Kernel setup (part of AMD HSA config)
@@ -898,7 +906,8 @@ static void dumpAmdCL2ArgsAndSamplers(std::ostream& output,
 }
 
 void CLRX::disassembleAmdCL2(std::ostream& output, const AmdCL2DisasmInput* amdCL2Input,
-       ISADisassembler* isaDisassembler, size_t& sectionCount, Flags flags)
+       ISADisassembler* isaDisassembler, size_t& sectionCount, Flags flags,
+       const std::vector<CString>& kernelNames)
 {
     const bool doMetadata = ((flags & DISASM_METADATA) != 0);
     const bool doDumpData = ((flags & DISASM_DUMPDATA) != 0);
@@ -971,7 +980,8 @@ void CLRX::disassembleAmdCL2(std::ostream& output, const AmdCL2DisasmInput* amdC
     {
         output.write(".globaldata\n", 12);
         output.write(".gdata:\n", 8); /// symbol used by text relocations
-        printDisasmData(amdCL2Input->globalDataSize, amdCL2Input->globalData, output);
+        isaDisassembler->getDisassembler().printDataBlock(amdCL2Input->globalDataSize,
+                    amdCL2Input->globalData);
         /// put sampler relocations at global data section
         for (auto v: amdCL2Input->samplerRelocs)
         {
@@ -990,7 +1000,8 @@ void CLRX::disassembleAmdCL2(std::ostream& output, const AmdCL2DisasmInput* amdC
     {
         output.write(".data\n", 6);
         output.write(".ddata:\n", 8); /// symbol used by text relocations
-        printDisasmData(amdCL2Input->rwDataSize, amdCL2Input->rwData, output);
+        isaDisassembler->getDisassembler().printDataBlock(amdCL2Input->rwDataSize,
+                    amdCL2Input->rwData);
     }
     
     if (doDumpData && amdCL2Input->bssSize)
@@ -1025,6 +1036,8 @@ void CLRX::disassembleAmdCL2(std::ostream& output, const AmdCL2DisasmInput* amdC
     
     for (const AmdCL2DisasmKernelInput& kinput: amdCL2Input->kernels)
     {
+        if (!isDisasmKernelSelected(kernelNames, kinput.kernelName))
+            continue;
         output.write(".kernel ", 8);
         output.write(kinput.kernelName.c_str(), kinput.kernelName.size());
         output.put('\n');
@@ -1082,10 +1095,18 @@ void CLRX::disassembleAmdCL2(std::ostream& output, const AmdCL2DisasmInput* amdC
             if (doHSAConfig)
             {
                 // print as HSA config
-                dumpAMDHSAConfig(output, maxSgprsNum, arch,
-                     *reinterpret_cast<const AmdHsaKernelConfig*>(kinput.setup));
+                const AmdHsaKernelConfig& hsaConfig =
+                        *reinterpret_cast<const AmdHsaKernelConfig*>(kinput.setup);
+                dumpAMDHSAConfig(output, maxSgprsNum, arch, hsaConfig);
                 output.write("    .hsaconfig\n", 15);
+                isaDisassembler->addKernelResources(getDisasmKernelResources(
+                        kinput.kernelName, arch, maxSgprsNum,
+                        ULEV(hsaConfig.computePgmRsrc1),
+                        ULEV(hsaConfig.workgroupGroupSegmentSize)));
             }
+            else
+                isaDisassembler->addKernelResources({ kinput.kernelName,
+                        config.usedSGPRsNum, config.usedVGPRsNum, config.localSize });
             
             dumpAmdCL2ArgsAndSamplers(output, config);
         }
@@ -1103,6 +1124,7 @@ void CLRX::disassembleAmdCL2(std::ostream& output, const AmdCL2DisasmInput* amdC
             
             output.write("    .text\n", 10);
             isaDisassembler->setInput(kinput.codeSize, kinput.code);
+            isaDisassembler->setCodeName(kinput.kernelName, sectionCount);
             isaDisassembler->beforeDisassemble();
             isaDisassembler->disassemble();
             sectionCount++;
@@ -1137,6 +1159,7 @@ void CLRX::disassembleAmdCL2(std::ostream& output, const AmdCL2DisasmInput* amdC
                 entry.type, cxuint(entry.symbol), entry.addend);
         
         disassembleAMDHSACode(output, regions, amdCL2Input->codeSize,
-                            amdCL2Input->code, isaDisassembler, flags);
+                    amdCL2Input->code, isaDisassembler, flags, false,
+                    std::vector<ROCmDisasmKernelDescInfo>(), kernelNames);
     }
 }
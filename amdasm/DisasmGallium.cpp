@@ -217,7 +217,7 @@ static void dumpKernelConfig(std::ostream& output, cxuint maxSgprsNum,
 
 void CLRX::disassembleGallium(std::ostream& output,
           const GalliumDisasmInput* galliumInput, ISADisassembler* isaDisassembler,
-          Flags flags)
+          Flags flags, const std::vector<CString>& kernelNames)
 {
     const bool doDumpData = ((flags & DISASM_DUMPDATA) != 0);
     const bool doMetadata = ((flags & (DISASM_METADATA|DISASM_CONFIG)) != 0);
@@ -233,7 +233,8 @@ void CLRX::disassembleGallium(std::ostream& output,
         galliumInput->globalDataSize != 0)
     {   //
         output.write(".rodata\n", 8);
-        printDisasmData(galliumInput->globalDataSize, galliumInput->globalData, output);
+        isaDisassembler->getDisassembler().printDataBlock(galliumInput->globalDataSize,
+                    galliumInput->globalData);
     }
     if (galliumInput->isMesa170)
         output.write(".driver_version 170000\n", 23);
@@ -252,6 +253,8 @@ void CLRX::disassembleGallium(std::ostream& output,
     for (cxuint i = 0; i < galliumInput->kernels.size(); i++)
     {
         const GalliumDisasmKernelInput& kinput = galliumInput->kernels[i];
+        if (!isDisasmKernelSelected(kernelNames, kinput.kernelName))
+            continue;
         {
             output.write(".kernel ", 8);
             output.write(kinput.kernelName.c_str(), kinput.kernelName.size());
@@ -332,6 +335,10 @@ void CLRX::disassembleGallium(std::ostream& output,
             {
                 dumpKernelConfig(output, maxSgprsNum, arch, kinput.progInfo,
                     galliumInput->isLLVM390);
+                const cxuint ldsShift = arch<GPUArchitecture::GCN1_1 ? 8 : 9;
+                isaDisassembler->addKernelResources(getDisasmKernelResources(
+                        kinput.kernelName, arch, maxSgprsNum, kinput.progInfo[0].value,
+                        ((kinput.progInfo[1].value>>15) & 0x1ff) << ldsShift));
                 if (galliumInput->isAMDHSA)
                     // print AMD HSA config with special prefix for some HSA values
                     dumpAMDHSAConfig(output, maxSgprsNum, arch,
@@ -354,7 +361,7 @@ void CLRX::disassembleGallium(std::ostream& output,
     if (doDumpCode && galliumInput->code != nullptr && galliumInput->codeSize != 0)
     {
         // print text
-        if (!galliumInput->isAMDHSA)
+        if (!galliumInput->isAMDHSA && kernelNames.empty())
         {
             // just disassembly code in simple way
             output.write(".text\n", 6);
@@ -362,6 +369,31 @@ void CLRX::disassembleGallium(std::ostream& output,
             isaDisassembler->beforeDisassemble();
             isaDisassembler->disassemble();
         }
+        else if (!galliumInput->isAMDHSA)
+        {
+            // disassembly only code of selected kernels
+            output.write(".text\n", 6);
+            std::vector<size_t> offsets;
+            for (const GalliumDisasmKernelInput& kinput: galliumInput->kernels)
+                offsets.push_back(kinput.offset);
+            std::sort(offsets.begin(), offsets.end());
+            for (const GalliumDisasmKernelInput& kinput: galliumInput->kernels)
+            {
+                if (!isDisasmKernelSelected(kernelNames, kinput.kernelName) ||
+                    kinput.offset >= galliumInput->codeSize)
+                    continue;
+                // kernel code ends at next kernel
+                auto nextIt = std::upper_bound(offsets.begin(), offsets.end(),
+                                size_t(kinput.offset));
+                const size_t end = (nextIt != offsets.end()) ? *nextIt :
+                                galliumInput->codeSize;
+                isaDisassembler->setInput(end - kinput.offset,
+                        galliumInput->code + kinput.offset, kinput.offset, kinput.offset);
+                isaDisassembler->beforeDisassemble();
+                isaDisassembler->setDontPrintLabels(true);
+                isaDisassembler->disassemble();
+            }
+        }
         else
         {
             // LLVM 4.0 - AMDHSA code
@@ -401,7 +433,8 @@ void CLRX::disassembleGallium(std::ostream& output,
             }
             
             disassembleAMDHSACode(output, regions, galliumInput->codeSize,
-                            galliumInput->code, isaDisassembler, flags);
+                    galliumInput->code, isaDisassembler, flags, false,
+                    std::vector<ROCmDisasmKernelDescInfo>(), kernelNames);
         }
     }
 }
@@ -25,6 +25,8 @@
 #include <string>
 #include <ostream>
 #include <utility>
+#include <vector>
+#include <algorithm>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/amdbin/AmdBinaries.h>
 #include <CLRX/amdbin/AmdCL2Binaries.h>
@@ -47,43 +49,64 @@ extern CLRX_INTERNAL void printDisasmDataU32(size_t size, const uint32_t* data,
 extern CLRX_INTERNAL void printDisasmLongString(size_t size, const char* data,
             std::ostream& output, bool secondAlign = false);
 
+// return true if kernel is in sorted kernelNames or if kernelNames is empty
+inline bool isDisasmKernelSelected(const std::vector<CString>& kernelNames,
+            const CString& kernelName)
+{
+    return kernelNames.empty() ||
+        std::binary_search(kernelNames.begin(), kernelNames.end(), kernelName);
+}
+
+/* kernelNames - sorted names of kernels to disassemble (empty - all kernels) */
+
 // disassemble Amd OpenCL 1.0 binary input
 extern CLRX_INTERNAL void disassembleAmd(std::ostream& output,
        const AmdDisasmInput* amdInput, ISADisassembler* isaDisassembler,
-       size_t& sectionCount, Flags flags);
+       size_t& sectionCount, Flags flags,
+       const std::vector<CString>& kernelNames = std::vector<CString>());
 
 // disassemble Amd OpenCL 2.0 binary input
 extern CLRX_INTERNAL void disassembleAmdCL2(std::ostream& output,
         const AmdCL2DisasmInput* amdCL2Input, ISADisassembler* isaDisassembler,
-        size_t& sectionCount, Flags flags);
+        size_t& sectionCount, Flags flags,
+        const std::vector<CString>& kernelNames = std::vector<CString>());
 
 // disassemble ROCm binary input
 extern CLRX_INTERNAL void disassembleROCm(std::ostream& output,
        const ROCmDisasmInput* rocmInput, ISADisassembler* isaDisassembler,
-       Flags flags);
+       Flags flags, const std::vector<CString>& kernelNames = std::vector<CString>());
 
 // dump AMDHSA configuration in assembler format
 // amdshaPrefix - add extra prefix for gallium HSA config params
 extern CLRX_INTERNAL void dumpAMDHSAConfig(std::ostream& output, cxuint maxSgprsNum,
              GPUArchitecture arch, const ROCmKernelConfig& config,
              bool amdhsaPrefix = false);
+// get kernel resources from PGM_RSRC1 (register numbers) and local size
+extern CLRX_INTERNAL DisasmKernelResources getDisasmKernelResources(const CString& name,
+             GPUArchitecture arch, cxuint maxSgprsNum, uint32_t pgmRsrc1,
+             size_t localSize);
 // disassemble code in AMDHSA layout (kernel config and kernel codes)
+// if kernelNames is not empty, then only code of selected kernels will be disassembled
 extern CLRX_INTERNAL void disassembleAMDHSACode(std::ostream& output,
             const std::vector<ROCmDisasmRegionInput>& regions,
             size_t codeSize, const cxbyte* code, ISADisassembler* isaDisassembler,
             Flags flags, bool llvm10BinFormat = false,
             const std::vector<ROCmDisasmKernelDescInfo>& kdescs =
-                std::vector<ROCmDisasmKernelDescInfo>());
+                std::vector<ROCmDisasmKernelDescInfo>(),
+            const std::vector<CString>& kernelNames = std::vector<CString>());
 
 // disassemble Gallium binary input
 extern CLRX_INTERNAL void disassembleGallium(std::ostream& output,
        const GalliumDisasmInput* galliumInput, ISADisassembler* isaDisassembler,
-       Flags flags);
+       Flags flags, const std::vector<CString>& kernelNames = std::vector<CString>());
 
 extern CLRX_INTERNAL const std::pair<const char*, KernelArgType> disasmArgTypeNameMap[74];
 
 extern CLRX_INTERNAL const KernelArgType disasmGpuArgTypeTable[];
 
+// names of code block end types (indexed by DisasmCFGEndType)
+extern CLRX_INTERNAL const char* disasmCFGEndTypeNames[7];
+
 // dump kernel arguments for  kernel in AMD binaries (cl20 - OpenCL 2.0 binaries)
 extern CLRX_INTERNAL void dumpAmdKernelArg(std::ostream& output,
            const AmdKernelArgInput& arg, bool cl20);
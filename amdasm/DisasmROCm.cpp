@@ -36,30 +36,32 @@
 
 using namespace CLRX;
 
-ROCmDisasmInput* CLRX::getROCmDisasmInputFromBinary(const ROCmBinary& binary)
+ROCmDisasmInput* CLRX::getROCmDisasmInputFromBinary(const ROCmBinary& binary,
+            const std::vector<CString>& kernelNames)
 {
     std::unique_ptr<ROCmDisasmInput> input(new ROCmDisasmInput);
     input->deviceType = binary.determineGPUDeviceType(input->archMinor,
                               input->archStepping);
     
     const size_t regionsNum = binary.getRegionsNum();
-    input->regions.resize(regionsNum);
+    input->regions.reserve(regionsNum);
     size_t codeOffset = binary.getCode()-binary.getBinaryCode();
+    const bool llvm10BinFormat = binary.isLLVM10BinaryFormat();
     // ger regions of code
     for (size_t i = 0; i < regionsNum; i++)
     {
         const ROCmRegion& region = binary.getRegion(i);
-        input->regions[i] = { region.regionName, size_t(region.size),
-            size_t(region.offset - codeOffset), region.type };
-    }
-    if (binary.isLLVM10BinaryFormat())
-    {
-        input->kernelDescs.resize(regionsNum, ROCmDisasmKernelDescInfo{});
-        for (size_t i = 0; i < regionsNum; i++)
+        // if kernels selected, then include only selected kernels
+        if (!kernelNames.empty() && (region.type == ROCmRegionType::DATA ||
+                !isDisasmKernelSelected(kernelNames, region.regionName)))
+            continue;
+        input->regions.push_back({ region.regionName, size_t(region.size),
+            size_t(region.offset - codeOffset), region.type });
+        if (llvm10BinFormat)
         {
-            input->kernelDescs[i].sectionOffset = reinterpret_cast<const cxbyte*>(
-                binary.getKernelDescriptor(i)) - binary.getGlobalData();
-            input->kernelDescs[i].desc = binary.getKernelDescriptor(i);
+            const ROCmKernelDescriptor* kdesc = binary.getKernelDescriptor(i);
+            input->kernelDescs.push_back({ size_t(reinterpret_cast<const cxbyte*>(
+                        kdesc) - binary.getGlobalData()), kdesc });
         }
     }
     
@@ -573,12 +575,103 @@ static void dumpKernelConfig(std::ostream& output, cxuint maxSgprsNum,
 }
 
 // routine to disassembly code in AMD HSA form (kernel with HSA config)
+// disassemble only code of selected kernels (without code between kernels and data)
+static void disassembleAMDHSAChoosenCode(std::ostream& output,
+            const std::vector<ROCmDisasmRegionInput>& regions,
+            size_t codeSize, const cxbyte* code, ISADisassembler* isaDisassembler,
+            Flags flags, bool llvm10BinFormat,
+            const std::vector<ROCmDisasmKernelDescInfo>& kernelDescs,
+            const std::vector<CString>& kernelNames)
+{
+    const bool doMetadata = ((flags & (DISASM_METADATA|DISASM_CONFIG)) != 0);
+    const bool doDumpCode = ((flags & DISASM_DUMPCODE) != 0);
+    const bool doDumpConfig = ((flags & DISASM_CONFIG) != 0);
+    const size_t kconfigSize = llvm10BinFormat ? 0 : 256;
+    
+    // selected kernel regions sorted by offset (offset, region index)
+    std::vector<std::pair<size_t, size_t> > sorted;
+    for (size_t i = 0; i < regions.size(); i++)
+        if (regions[i].type != ROCmRegionType::DATA &&
+            isDisasmKernelSelected(kernelNames, regions[i].regionName))
+        {
+            if (regions[i].offset+kconfigSize > codeSize)
+                throw DisasmException("Region Offset out of range");
+            sorted.push_back(std::make_pair(regions[i].offset, i));
+        }
+    mapSort(sorted.begin(), sorted.end());
+    
+    output.write(".text\n", 6);
+    isaDisassembler->clearNumberedLabels();
+    // analyze only code of selected kernels
+    for (const auto& entry: sorted)
+    {
+        const ROCmDisasmRegionInput& region = regions[entry.second];
+        const size_t regionSize = std::min(region.size, codeSize - region.offset);
+        if (doDumpCode && regionSize > kconfigSize)
+        {
+            isaDisassembler->setInput(regionSize-kconfigSize,
+                        code + region.offset+kconfigSize, region.offset+kconfigSize);
+            isaDisassembler->analyzeBeforeDisassemble();
+        }
+        isaDisassembler->addNamedLabel(region.offset, region.regionName);
+    }
+    isaDisassembler->prepareLabelsAndRelocations();
+    
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        const ROCmDisasmRegionInput& region = regions[sorted[i].second];
+        const size_t regionSize = std::min(region.size, codeSize - region.offset);
+        // write kernel label
+        isaDisassembler->setInput(0, code + region.offset, region.offset, region.offset);
+        ISADisassembler::LabelEventIter curEvent =
+                    isaDisassembler->findLabelEvent(region.offset);
+        isaDisassembler->writeLabelsToPosition(0, curEvent);
+        isaDisassembler->flushOutput();
+        
+        if (doMetadata && !llvm10BinFormat)
+        {
+            if (!doDumpConfig)
+                printDisasmData(0x100, code + region.offset, output, true);
+            else
+                // skip, config was dumped in kernel configuration
+                output.write(".skip 256\n", 10);
+        }
+        if (doDumpCode && regionSize >= kconfigSize)
+        {
+            isaDisassembler->setInput(regionSize-kconfigSize,
+                            code + region.offset+kconfigSize,
+                            region.offset+kconfigSize, region.offset+1);
+            if (llvm10BinFormat)
+            {
+                const ROCmKernelDescriptor* kdesc = kernelDescs[sorted[i].second].desc;
+                if (kdesc!=nullptr)
+                {
+                    Flags flags = isaDisassembler->getFlags() & ~DISASM_WAVE32;
+                    if (ULEV(kdesc->initialKernelExecState) & ROCMFLAG_USE_WAVE32)
+                        flags |= DISASM_WAVE32;
+                    isaDisassembler->setFlags(flags);
+                }
+            }
+            // labels after code belongs to next kernels
+            isaDisassembler->setDontPrintLabels(true);
+            isaDisassembler->disassemble();
+        }
+    }
+}
+
 void CLRX::disassembleAMDHSACode(std::ostream& output,
             const std::vector<ROCmDisasmRegionInput>& regions,
             size_t codeSize, const cxbyte* code, ISADisassembler* isaDisassembler,
             Flags flags, bool llvm10BinFormat,
-            const std::vector<ROCmDisasmKernelDescInfo>& kernelDescs)
+            const std::vector<ROCmDisasmKernelDescInfo>& kernelDescs,
+            const std::vector<CString>& kernelNames)
 {
+    if (!kernelNames.empty())
+    {
+        disassembleAMDHSAChoosenCode(output, regions, codeSize, code, isaDisassembler,
+                    flags, llvm10BinFormat, kernelDescs, kernelNames);
+        return;
+    }
     const bool doDumpData = ((flags & DISASM_DUMPDATA) != 0);
     const bool doMetadata = ((flags & (DISASM_METADATA|DISASM_CONFIG)) != 0);
     const bool doDumpCode = ((flags & DISASM_DUMPCODE) != 0);
@@ -624,10 +717,7 @@ void CLRX::disassembleAMDHSACode(std::ostream& output,
     }
     isaDisassembler->prepareLabelsAndRelocations();
     
-    ISADisassembler::LabelIter curLabel;
-    ISADisassembler::NamedLabelIter curNamedLabel;
-    const auto& labels = isaDisassembler->getLabels();
-    const auto& namedLabels = isaDisassembler->getNamedLabels();
+    ISADisassembler::LabelEventIter curEvent;
     
     // real disassemble
     // before first kernel
@@ -651,14 +741,9 @@ void CLRX::disassembleAMDHSACode(std::ostream& output,
         // set labelIters to previous position
         isaDisassembler->setInput(prevRegionPos, code + region.offset,
                                 region.offset, prevRegionPos);
-        curLabel = std::lower_bound(labels.begin(), labels.end(), prevRegionPos);
-        curNamedLabel = std::lower_bound(namedLabels.begin(), namedLabels.end(),
-            std::make_pair(prevRegionPos, CString()),
-                [](const std::pair<size_t,CString>& a,
-                                const std::pair<size_t, CString>& b)
-                { return a.first < b.first; });
+        curEvent = isaDisassembler->findLabelEvent(prevRegionPos);
         // write labels to current region position
-        isaDisassembler->writeLabelsToPosition(0, curLabel, curNamedLabel);
+        isaDisassembler->writeLabelsToPosition(0, curEvent);
         isaDisassembler->flushOutput();
         
         size_t dataSize = codeSize - region.offset;
@@ -718,16 +803,11 @@ void CLRX::disassembleAMDHSACode(std::ostream& output,
         // set labelIters to previous position
         isaDisassembler->setInput(prevRegionPos, code + region.offset+region.size,
                                 region.offset+region.size, prevRegionPos);
-        curLabel = std::lower_bound(labels.begin(), labels.end(), prevRegionPos);
-        curNamedLabel = std::lower_bound(namedLabels.begin(), namedLabels.end(),
-            std::make_pair(prevRegionPos, CString()),
-                [](const std::pair<size_t,CString>& a,
-                                const std::pair<size_t, CString>& b)
-                { return a.first < b.first; });
+        curEvent = isaDisassembler->findLabelEvent(prevRegionPos);
         // if last region is not kernel, then print labels after last region
-        isaDisassembler->writeLabelsToPosition(0, curLabel, curNamedLabel);
+        isaDisassembler->writeLabelsToPosition(0, curEvent);
         isaDisassembler->flushOutput();
-        isaDisassembler->writeLabelsToEnd(region.size, curLabel, curNamedLabel);
+        isaDisassembler->writeLabelsToEnd(region.size, curEvent);
         isaDisassembler->flushOutput();
     }
 }
@@ -963,7 +1043,8 @@ static void dumpKernelMetadataInfo(std::ostream& output, const ROCmKernelMetadat
 }
 
 void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInput,
-           ISADisassembler* isaDisassembler, Flags flags)
+           ISADisassembler* isaDisassembler, Flags flags,
+           const std::vector<CString>& kernelNames)
 {
     const bool doMetadata = ((flags & (DISASM_METADATA|DISASM_CONFIG)) != 0);
     const bool doDumpConfig = ((flags & DISASM_CONFIG) != 0);
@@ -1043,7 +1124,8 @@ void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInpu
         output.write(".globaldata\n", 12);
         output.write(".gdata:\n", 8); /// symbol used by text relocations
         if (!rocmInput->llvm10BinFormat || !doDumpConfig)
-            printDisasmData(rocmInput->globalDataSize, rocmInput->globalData, output);
+            isaDisassembler->getDisassembler().printDataBlock(rocmInput->globalDataSize,
+                    rocmInput->globalData);
         else
         {
             Array<size_t> kdescOffsets(rocmInput->kernelDescs.size());
@@ -1058,7 +1140,8 @@ void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInpu
                         *kdit : rocmInput->globalDataSize;
                 if (kdit == kdescOffsets.end() || p < *kdit)
                 {
-                    printDisasmData(end-p, rocmInput->globalData+p, output);
+                    isaDisassembler->getDisassembler().printDataBlock(end-p,
+                            rocmInput->globalData+p);
                     p = end;
                 }
                 if (kdit != kdescOffsets.end() && p == *kdit)
@@ -1116,7 +1199,8 @@ void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInpu
     for (size_t i = 0; i < rocmInput->regions.size(); i++)
     {
         const ROCmDisasmRegionInput& rinput = rocmInput->regions[i];
-        if (rinput.type != ROCmRegionType::DATA)
+        if (rinput.type != ROCmRegionType::DATA &&
+            isDisasmKernelSelected(kernelNames, rinput.regionName))
         {
             output.write(".kernel ", 8);
             output.write(rinput.regionName.c_str(), rinput.regionName.size());
@@ -1126,12 +1210,24 @@ void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInpu
             if (doDumpConfig)
             {
                 if (!rocmInput->llvm10BinFormat)
-                    dumpKernelConfig(output, maxSgprsNum, arch,
+                {
+                    const ROCmKernelConfig& config =
                         *reinterpret_cast<const ROCmKernelConfig*>(
-                                rocmInput->code + rinput.offset));
+                                rocmInput->code + rinput.offset);
+                    dumpKernelConfig(output, maxSgprsNum, arch, config);
+                    isaDisassembler->addKernelResources(getDisasmKernelResources(
+                            rinput.regionName, arch, maxSgprsNum,
+                            ULEV(config.computePgmRsrc1),
+                            ULEV(config.workgroupGroupSegmentSize)));
+                }
                 else if (rocmInput->kernelDescs[i].desc!=nullptr)
-                    dumpKernelDescriptor(output, maxSgprsNum, arch,
-                                *(rocmInput->kernelDescs[i].desc));
+                {
+                    const ROCmKernelDescriptor& kdesc = *(rocmInput->kernelDescs[i].desc);
+                    dumpKernelDescriptor(output, maxSgprsNum, arch, kdesc);
+                    isaDisassembler->addKernelResources(getDisasmKernelResources(
+                            rinput.regionName, arch, maxSgprsNum, ULEV(kdesc.pgmRsrc1),
+                            ULEV(kdesc.groupSegmentFixedSize)));
+                }
                 
                 if (!haveMetadataInfo)
                     continue; // no metatadata info
@@ -1149,5 +1245,6 @@ void CLRX::disassembleROCm(std::ostream& output, const ROCmDisasmInput* rocmInpu
     if (rocmInput->code != nullptr && rocmInput->codeSize != 0)
         disassembleAMDHSACode(output, rocmInput->regions,
                     rocmInput->codeSize, rocmInput->code, isaDisassembler,
-                    flags, rocmInput->llvm10BinFormat, rocmInput->kernelDescs);
+                    flags, rocmInput->llvm10BinFormat, rocmInput->kernelDescs,
+                    kernelNames);
 }
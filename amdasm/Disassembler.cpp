@@ -18,14 +18,21 @@
  */
 
 #include <CLRX/Config.h>
+#include <cstdio>
 #include <string>
 #include <cstring>
 #include <ostream>
+#include <fstream>
 #include <cstring>
 #include <memory>
 #include <vector>
 #include <utility>
 #include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/amdbin/GalliumBinaries.h>
 #include <CLRX/utils/MemAccess.h>
@@ -40,167 +47,241 @@ DisasmException::DisasmException(const std::string& message) : Exception(message
 
 ISADisassembler::ISADisassembler(Disassembler& _disassembler, cxuint outBufSize)
         : disassembler(_disassembler), startOffset(0), labelStartOffset(0),
-          dontPrintLabelsAfterCode(false), output(outBufSize, _disassembler.getOutput())
+          dontPrintLabelsAfterCode(false),
+          labelEvents({ LabelEvent{ SIZE_MAX, LABELEVENT_END, 0 } }), codeIndex(0),
+          output(outBufSize, _disassembler.getOutput())
 { }
 
 ISADisassembler::~ISADisassembler()
 { }
 
-void ISADisassembler::writeLabelsToPosition(size_t pos, LabelIter& labelIter,
-              NamedLabelIter& namedLabelIter)
+void ISADisassembler::writeLabelEvents(size_t pos, LabelEventIter& eventIter)
 {
     pos += startOffset; // fix
-    if ((namedLabelIter != namedLabels.end() && namedLabelIter->first <= pos) ||
-            (labelIter != labels.end() && *labelIter <= pos))
+    for (; eventIter->offset <= pos; ++eventIter)
     {
-        size_t curPos = SIZE_MAX;
-        // set current position (from first label)
-        if (labelIter != labels.end())
-            curPos = *labelIter;
-        if (namedLabelIter != namedLabels.end())
-            curPos = std::min(curPos, namedLabelIter->first);
-        
-        bool haveLabel;
-        do {
-            haveLabel = false;
-            const bool haveNumberedLabel =
-                    labelIter != labels.end() && *labelIter <= pos;
-            const bool haveNamedLabel =
-                    (namedLabelIter != namedLabels.end() && namedLabelIter->first <= pos);
-            
-            size_t namedPos = SIZE_MAX;
-            size_t numberedPos = SIZE_MAX;
-            if (haveNumberedLabel)
-                numberedPos = *labelIter;
-            if (haveNamedLabel)
-                namedPos = namedLabelIter->first;
-            
+        if (eventIter->type == LABELEVENT_RELOC)
+            continue; // relocations are handled by writeRelocation
+        const size_t curPos = eventIter->offset;
+        if (eventIter->type == LABELEVENT_LABEL)
+        {
             /// print numbered (not named) label in form .L[position]_[sectionCount]
-            if (numberedPos <= namedPos && haveNumberedLabel)
-            {
-                curPos = *labelIter;
-                char* buf = output.reserve(70);
-                size_t bufPos = 0;
-                // numbered label in form: '.L[POS]_[SECTION]'
-                buf[bufPos++] = '.';
-                buf[bufPos++] = 'L';
-                bufPos += itocstrCStyle(*labelIter, buf+bufPos, 22, 10, 0, false);
-                buf[bufPos++] = '_';
-                bufPos += itocstrCStyle(disassembler.sectionCount,
-                                buf+bufPos, 22, 10, 0, false);
-                if (curPos != pos)
-                {
-                    // if label shifted back by some bytes before encoded instruction
-                    buf[bufPos++] = '=';
-                    buf[bufPos++] = '.';
-                    buf[bufPos++] = '-';
-                    bufPos += itocstrCStyle((pos-curPos), buf+bufPos, 22, 10, 0, false);
-                    buf[bufPos++] = '\n';
-                }
-                else
-                {
-                    // just in this place: add ':'
-                    buf[bufPos++] = ':';
-                    buf[bufPos++] = '\n';
-                }
-                output.forward(bufPos);
-                ++labelIter;
-                haveLabel = true;
-            }
-            
+            char* buf = output.reserve(50);
+            size_t bufPos = 0;
+            buf[bufPos++] = '.';
+            buf[bufPos++] = 'L';
+            bufPos += itocstrCStyle(curPos, buf+bufPos, 22, 10, 0, false);
+            buf[bufPos++] = '_';
+            bufPos += itocstrCStyle(disassembler.sectionCount,
+                            buf+bufPos, 22, 10, 0, false);
+            output.forward(bufPos);
+        }
+        else
+        {
             /// print named label
-            if(namedPos <= numberedPos && haveNamedLabel)
-            {
-                curPos = namedLabelIter->first;
-                output.write(namedLabelIter->second.size(),
-                       namedLabelIter->second.c_str());
-                char* buf = output.reserve(50);
-                size_t bufPos = 0;
-                if (curPos != pos)
-                {
-                    // if label shifted back by some bytes before encoded instruction
-                    buf[bufPos++] = '=';
-                    buf[bufPos++] = '.';
-                    buf[bufPos++] = '-';
-                    bufPos += itocstrCStyle((pos-curPos), buf+bufPos, 22, 10, 0, false);
-                    buf[bufPos++] = '\n';
-                }
-                else
-                {
-                    // just in this place: add ':'
-                    buf[bufPos++] = ':';
-                    buf[bufPos++] = '\n';
-                }
-                output.forward(bufPos);
-                ++namedLabelIter;
-                haveLabel = true;
-            }
-            
-        } while(haveLabel);
+            const CString& name = namedLabels[eventIter->index].second;
+            output.write(name.size(), name.c_str());
+        }
+        char* buf = output.reserve(30);
+        size_t bufPos = 0;
+        if (curPos != pos)
+        {
+            // if label shifted back by some bytes before encoded instruction
+            buf[bufPos++] = '=';
+            buf[bufPos++] = '.';
+            buf[bufPos++] = '-';
+            bufPos += itocstrCStyle((pos-curPos), buf+bufPos, 22, 10, 0, false);
+            buf[bufPos++] = '\n';
+        }
+        else
+        {
+            // just in this place: add ':'
+            buf[bufPos++] = ':';
+            buf[bufPos++] = '\n';
+        }
+        output.forward(bufPos);
     }
 }
 
-void ISADisassembler::writeLabelsToEnd(size_t start, LabelIter labelIter,
-                   NamedLabelIter namedLabelIter)
+void ISADisassembler::writeLabelsToEnd(size_t start, LabelEventIter eventIter)
 {
     size_t pos = startOffset + start;
-    while (namedLabelIter != namedLabels.end() || labelIter != labels.end())
+    for (; eventIter->type != LABELEVENT_END; ++eventIter)
     {
-        size_t namedPos = SIZE_MAX;
-        size_t numberedPos = SIZE_MAX;
-        if (labelIter != labels.end())
-            numberedPos = *labelIter;
-        if (namedLabelIter != namedLabels.end())
-            namedPos = namedLabelIter->first;
-        // print numbered label if it before named label
-        if (numberedPos <= namedPos && labelIter != labels.end())
+        if (eventIter->type == LABELEVENT_RELOC)
+            continue;
+        if (pos != eventIter->offset)
+        {
+            // print shift position to label (.org pseudo-op)
+            char* buf = output.reserve(30);
+            size_t bufPos = 0;
+            memcpy(buf+bufPos, ".org ", 5);
+            bufPos += 5;
+            bufPos += itocstrCStyle(eventIter->offset, buf+bufPos, 20, 16);
+            buf[bufPos++] = '\n';
+            output.forward(bufPos);
+        }
+        if (eventIter->type == LABELEVENT_LABEL)
         {
-            if (pos != *labelIter)
-            {
-                // print shift position to label (.org pseudo-op)
-                char* buf = output.reserve(30);
-                size_t bufPos = 0;
-                memcpy(buf+bufPos, ".org ", 5);
-                bufPos += 5;
-                bufPos += itocstrCStyle(*labelIter, buf+bufPos, 20, 16);
-                buf[bufPos++] = '\n';
-                output.forward(bufPos);
-            }
             char* buf = output.reserve(50);
             size_t bufPos = 0;
             // numbered label in form: '.L[POS]_[SECTION]'
             buf[bufPos++] = '.';
             buf[bufPos++] = 'L';
-            bufPos += itocstrCStyle(*labelIter, buf+bufPos, 22, 10, 0, false);
+            bufPos += itocstrCStyle(eventIter->offset, buf+bufPos, 22, 10, 0, false);
             buf[bufPos++] = '_';
             bufPos += itocstrCStyle(disassembler.sectionCount,
                             buf+bufPos, 22, 10, 0, false);
             buf[bufPos++] = ':';
             buf[bufPos++] = '\n';
             output.forward(bufPos);
-            pos = *labelIter;
-            ++labelIter;
         }
-        // this same for named label
-        if (namedPos <= numberedPos && namedLabelIter != namedLabels.end())
+        else
+        {
+            // this same for named label
+            const CString& name = namedLabels[eventIter->index].second;
+            output.write(name.size(), name.c_str());
+        }
+        pos = eventIter->offset;
+    }
+}
+
+ISADisassembler::LabelEventIter ISADisassembler::findLabelEvent(size_t offset) const
+{
+    return std::lower_bound(labelEvents.begin(), labelEvents.end(), offset,
+            [](const LabelEvent& a, size_t b)
+            { return a.offset < b; });
+}
+
+// get offset of first label from old label iterators (SIZE_MAX if no labels)
+static size_t getFirstLabelOffset(const std::vector<size_t>& labels,
+            const std::vector<std::pair<size_t, CString> >& namedLabels,
+            ISADisassembler::LabelIter labelIter,
+            ISADisassembler::NamedLabelIter namedLabelIter)
+{
+    size_t offset = SIZE_MAX;
+    if (labelIter != labels.end())
+        offset = *labelIter;
+    if (namedLabelIter != namedLabels.end())
+        offset = std::min(offset, namedLabelIter->first);
+    return offset;
+}
+
+void ISADisassembler::writeLabelsToPosition(size_t pos, LabelIter& labelIter,
+              NamedLabelIter& namedLabelIter)
+{
+    const size_t offset = getFirstLabelOffset(labels, namedLabels,
+                labelIter, namedLabelIter);
+    if (offset == SIZE_MAX)
+        return;
+    LabelEventIter eventIter = findLabelEvent(offset);
+    writeLabelsToPosition(pos, eventIter);
+    // skip written labels
+    labelIter = std::upper_bound(labelIter, labels.cend(), pos+startOffset);
+    namedLabelIter = std::upper_bound(namedLabelIter, namedLabels.cend(), pos+startOffset,
+            [](size_t a, const std::pair<size_t, CString>& b)
+            { return a < b.first; });
+}
+
+void ISADisassembler::writeLabelsToEnd(size_t start, LabelIter labelIter,
+                   NamedLabelIter namedLabelIter)
+{
+    const size_t offset = getFirstLabelOffset(labels, namedLabels,
+                labelIter, namedLabelIter);
+    if (offset != SIZE_MAX)
+        writeLabelsToEnd(start, findLabelEvent(offset));
+}
+
+// add edges of blocks of single graph and put it to disassembler
+static void finishDisasmCFG(std::vector<DisasmCFG>& cfgs, DisasmCFG& cfg,
+            const std::vector<size_t>& targets)
+{
+    const size_t blocksNum = cfg.blocks.size();
+    for (size_t i = 0; i < blocksNum; i++)
+    {
+        const DisasmCFGBlock& block = cfg.blocks[i];
+        const bool hasNext = (i+1 < blocksNum);
+        switch(block.endType)
+        {
+            case DisasmCFGEndType::JUMP:
+            case DisasmCFGEndType::CJUMP:
+                cfg.edges.push_back({ block.offset, targets[i], DisasmCFGEdgeType::JUMP });
+                break;
+            case DisasmCFGEndType::CALL:
+                cfg.edges.push_back({ block.offset, targets[i], DisasmCFGEdgeType::CALL });
+                break;
+            default:
+                break;
+        }
+        // blocks which can continue at next block
+        if (hasNext && block.endType != DisasmCFGEndType::JUMP &&
+            block.endType != DisasmCFGEndType::SETPC &&
+            block.endType != DisasmCFGEndType::END)
+            cfg.edges.push_back({ block.offset, cfg.blocks[i+1].offset,
+                        DisasmCFGEdgeType::NEXT });
+    }
+    cfgs.push_back(std::move(cfg));
+    cfg = DisasmCFG{ CString(), cfg.codeIndex, {}, {}, {} };
+}
+
+void ISADisassembler::buildCFG(const std::vector<DisasmCFGInstr>& instrs,
+              const std::vector<CFGInstr>& cfInstrs)
+{
+    if (instrs.empty())
+        return;
+    DisasmCFG cfg{ codeName, codeIndex, {}, {}, {} };
+    // find last named label before code (kernel name in Gallium and ROCm)
+    LabelEventIter evIt = findLabelEvent(startOffset+1);
+    while (evIt != labelEvents.begin())
+    {
+        --evIt;
+        if (evIt->type == LABELEVENT_NAMED)
         {
-            if (pos != namedLabelIter->first)
+            cfg.name = namedLabels[evIt->index].second;
+            break;
+        }
+    }
+    
+    std::vector<size_t> targets;
+    auto cfIt = cfInstrs.begin();
+    evIt = findLabelEvent(startOffset);
+    bool afterCF = true;
+    for (const DisasmCFGInstr& instr: instrs)
+    {
+        const size_t offset = startOffset + instr.offset;
+        bool leader = afterCF;
+        // labels between previous and this instruction begin new block
+        for (; evIt->offset <= offset; ++evIt)
+            if (evIt->type == LABELEVENT_LABEL)
+                leader = true;
+            else if (evIt->type == LABELEVENT_NAMED)
             {
-                // print shift position to label (.org pseudo-op)
-                char* buf = output.reserve(30);
-                size_t bufPos = 0;
-                memcpy(buf+bufPos, ".org ", 5);
-                bufPos += 5;
-                bufPos += itocstrCStyle(namedLabelIter->first, buf+bufPos, 20, 16);
-                buf[bufPos++] = '\n';
-                output.forward(bufPos);
+                // named label begins new graph
+                if (!cfg.blocks.empty())
+                    finishDisasmCFG(disassembler.cfgs, cfg, targets);
+                targets.clear();
+                cfg.name = namedLabels[evIt->index].second;
+                leader = true;
             }
-            output.write(namedLabelIter->second.size(),
-                        namedLabelIter->second.c_str());
-            pos = namedLabelIter->first;
-            ++namedLabelIter;
+        if (leader)
+        {
+            cfg.blocks.push_back({ offset, 0, 0, DisasmCFGEndType::FALLTHROUGH });
+            targets.push_back(0);
+        }
+        DisasmCFGBlock& block = cfg.blocks.back();
+        block.instrsNum++;
+        block.size = offset + instr.size - block.offset;
+        cfg.instrs.push_back(instr);
+        cfg.instrs.back().offset = offset;
+        afterCF = (cfIt != cfInstrs.end() && cfIt->offset == instr.offset);
+        if (afterCF)
+        {
+            block.endType = cfIt->type;
+            targets.back() = cfIt->target;
+            ++cfIt;
         }
     }
+    finishDisasmCFG(disassembler.cfgs, cfg, targets);
 }
 
 void ISADisassembler::writeLocation(size_t pos)
@@ -225,11 +306,13 @@ void ISADisassembler::writeLocation(size_t pos)
 
 bool ISADisassembler::writeRelocation(size_t pos, RelocIter& relocIter)
 {
-    while (relocIter != relocations.end() && relocIter->first < pos)
-        relocIter++;
-    if (relocIter == relocations.end() || relocIter->first != pos)
+    // labels before relocation will be written by writeLabelsToPosition
+    RelocIter it = relocIter;
+    while (it->offset < pos || (it->offset == pos && it->type < LABELEVENT_RELOC))
+        ++it;
+    if (it->offset != pos || it->type != LABELEVENT_RELOC)
         return false;
-    const Relocation& reloc = relocIter->second;
+    const Relocation& reloc = relocations[it->index].second;
     // put relocation symbol in parenthesis
     if (reloc.addend != 0 && 
         (reloc.type==RELTYPE_LOW_32BIT || reloc.type==RELTYPE_HIGH_32BIT))
@@ -259,7 +342,6 @@ bool ISADisassembler::writeRelocation(size_t pos, RelocIter& relocIter)
         bufPos += 4;
     }
     output.forward(bufPos);
-    ++relocIter;
     return true;
 }
 
@@ -275,6 +357,26 @@ void ISADisassembler::prepareLabelsAndRelocations()
     labels.resize(newEnd-labels.begin());
     mapSort(namedLabels.begin(), namedLabels.end());
     mapSort(relocations.begin(), relocations.end());
+    
+    // merge all sorted lists into one event list
+    labelEvents.clear();
+    labelEvents.reserve(labels.size() + namedLabels.size() + relocations.size() + 1);
+    for (size_t label: labels)
+        labelEvents.push_back(LabelEvent{ label, LABELEVENT_LABEL, 0 });
+    const size_t namedStart = labelEvents.size();
+    for (size_t i = 0; i < namedLabels.size(); i++)
+        labelEvents.push_back(LabelEvent{ namedLabels[i].first, LABELEVENT_NAMED, i });
+    const size_t relocStart = labelEvents.size();
+    for (size_t i = 0; i < relocations.size(); i++)
+        labelEvents.push_back(LabelEvent{ relocations[i].first, LABELEVENT_RELOC, i });
+    // at this same offset: numbered label, named labels, relocations
+    auto eventLess = [](const LabelEvent& a, const LabelEvent& b)
+            { return a.offset < b.offset || (a.offset == b.offset && a.type < b.type); };
+    std::inplace_merge(labelEvents.begin(), labelEvents.begin()+namedStart,
+                labelEvents.begin()+relocStart, eventLess);
+    std::inplace_merge(labelEvents.begin(), labelEvents.begin()+relocStart,
+                labelEvents.end(), eventLess);
+    labelEvents.push_back(LabelEvent{ SIZE_MAX, LABELEVENT_END, 0 });
 }
 
 void ISADisassembler::beforeDisassemble()
@@ -285,56 +387,72 @@ void ISADisassembler::beforeDisassemble()
 }
 
 Disassembler::Disassembler(const AmdMainGPUBinary32& binary, std::ostream& _output,
-            Flags _flags) : fromBinary(true), binaryFormat(BinaryFormat::AMD),
-            amdInput(nullptr), output(_output), flags(_flags), sectionCount(0)
+            Flags _flags, const std::vector<CString>& _kernelNames)
+            : fromBinary(true), binaryFormat(BinaryFormat::AMD),
+            amdInput(nullptr), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
-    amdInput = getAmdDisasmInputFromBinary32(binary, flags);
+    setKernelNames(_kernelNames);
+    amdInput = getAmdDisasmInputFromBinary32(binary, flags, kernelNames);
 }
 
 Disassembler::Disassembler(const AmdMainGPUBinary64& binary, std::ostream& _output,
-            Flags _flags) : fromBinary(true), binaryFormat(BinaryFormat::AMD),
-            amdInput(nullptr), output(_output), flags(_flags), sectionCount(0)
+            Flags _flags, const std::vector<CString>& _kernelNames)
+            : fromBinary(true), binaryFormat(BinaryFormat::AMD),
+            amdInput(nullptr), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
-    amdInput = getAmdDisasmInputFromBinary64(binary, flags);
+    setKernelNames(_kernelNames);
+    amdInput = getAmdDisasmInputFromBinary64(binary, flags, kernelNames);
 }
 
 Disassembler::Disassembler(const AmdCL2MainGPUBinary32& binary, std::ostream& _output,
-           Flags _flags, cxuint driverVersion) : fromBinary(true),
-            binaryFormat(BinaryFormat::AMDCL2), amdCL2Input(nullptr), output(_output),
-            flags(_flags), sectionCount(0)
+           Flags _flags, cxuint driverVersion, const std::vector<CString>& _kernelNames)
+           : fromBinary(true), binaryFormat(BinaryFormat::AMDCL2),
+            amdCL2Input(nullptr), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
+    setKernelNames(_kernelNames);
     amdCL2Input = getAmdCL2DisasmInputFromBinary32(binary, driverVersion,
-                (flags & DISASM_HSALAYOUT) != 0);
+                (flags & DISASM_HSALAYOUT) != 0, kernelNames);
 }
 
 Disassembler::Disassembler(const AmdCL2MainGPUBinary64& binary, std::ostream& _output,
-           Flags _flags, cxuint driverVersion) : fromBinary(true),
-            binaryFormat(BinaryFormat::AMDCL2), amdCL2Input(nullptr), output(_output),
-            flags(_flags), sectionCount(0)
+           Flags _flags, cxuint driverVersion, const std::vector<CString>& _kernelNames)
+           : fromBinary(true), binaryFormat(BinaryFormat::AMDCL2),
+            amdCL2Input(nullptr), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
+    setKernelNames(_kernelNames);
     amdCL2Input = getAmdCL2DisasmInputFromBinary64(binary, driverVersion,
-                (flags & DISASM_HSALAYOUT) != 0);
+                (flags & DISASM_HSALAYOUT) != 0, kernelNames);
 }
 
-Disassembler::Disassembler(const ROCmBinary& binary, std::ostream& _output, Flags _flags)
+Disassembler::Disassembler(const ROCmBinary& binary, std::ostream& _output, Flags _flags,
+           const std::vector<CString>& _kernelNames)
          : fromBinary(true), binaryFormat(BinaryFormat::ROCM),
-           rocmInput(nullptr), output(_output), flags(_flags), sectionCount(0)
+           rocmInput(nullptr), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
-    rocmInput = getROCmDisasmInputFromBinary(binary);
+    setKernelNames(_kernelNames);
+    rocmInput = getROCmDisasmInputFromBinary(binary, kernelNames);
 }
 
 Disassembler::Disassembler(const ROCmBinary& binary, std::ostream& _output,
-                bool hasGPUDeviceType, GPUDeviceType deviceType, Flags _flags)
+                bool hasGPUDeviceType, GPUDeviceType deviceType, Flags _flags,
+                const std::vector<CString>& _kernelNames)
          : fromBinary(true), binaryFormat(BinaryFormat::ROCM),
-           rocmInput(nullptr), output(_output), flags(_flags), sectionCount(0)
+           rocmInput(nullptr), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
-    ROCmDisasmInput* _rocmInput = getROCmDisasmInputFromBinary(binary);
+    setKernelNames(_kernelNames);
+    ROCmDisasmInput* _rocmInput = getROCmDisasmInputFromBinary(binary, kernelNames);
     if (hasGPUDeviceType && _rocmInput->llvm10BinFormat)
     {
         _rocmInput->deviceType = deviceType;
@@ -346,21 +464,24 @@ Disassembler::Disassembler(const ROCmBinary& binary, std::ostream& _output,
 
 Disassembler::Disassembler(const AmdDisasmInput* disasmInput, std::ostream& _output,
             Flags _flags) : fromBinary(false), binaryFormat(BinaryFormat::AMD),
-            amdInput(disasmInput), output(_output), flags(_flags), sectionCount(0)
+            amdInput(disasmInput), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
 }
 
 Disassembler::Disassembler(const AmdCL2DisasmInput* disasmInput, std::ostream& _output,
             Flags _flags) : fromBinary(false), binaryFormat(BinaryFormat::AMDCL2),
-            amdCL2Input(disasmInput), output(_output), flags(_flags), sectionCount(0)
+            amdCL2Input(disasmInput), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
 }
 
 Disassembler::Disassembler(const ROCmDisasmInput* disasmInput, std::ostream& _output,
                  Flags _flags) : fromBinary(false), binaryFormat(BinaryFormat::ROCM),
-            rocmInput(disasmInput), output(_output), flags(_flags), sectionCount(0)
+            rocmInput(disasmInput), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
 }
@@ -368,7 +489,8 @@ Disassembler::Disassembler(const ROCmDisasmInput* disasmInput, std::ostream& _ou
 Disassembler::Disassembler(GPUDeviceType deviceType, const GalliumBinary& binary,
            std::ostream& _output, Flags _flags, cxuint llvmVersion) :
            fromBinary(true), binaryFormat(BinaryFormat::GALLIUM),
-           galliumInput(nullptr), output(_output), flags(_flags), sectionCount(0)
+           galliumInput(nullptr), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
     galliumInput = getGalliumDisasmInputFromBinary(deviceType, binary, llvmVersion);
@@ -376,7 +498,8 @@ Disassembler::Disassembler(GPUDeviceType deviceType, const GalliumBinary& binary
 
 Disassembler::Disassembler(const GalliumDisasmInput* disasmInput, std::ostream& _output,
              Flags _flags) : fromBinary(false), binaryFormat(BinaryFormat::GALLIUM),
-            galliumInput(disasmInput), output(_output), flags(_flags), sectionCount(0)
+            galliumInput(disasmInput), output(_output), flags(_flags), sectionCount(0),
+            dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
 }
@@ -384,7 +507,7 @@ Disassembler::Disassembler(const GalliumDisasmInput* disasmInput, std::ostream&
 Disassembler::Disassembler(GPUDeviceType deviceType, size_t rawCodeSize,
            const cxbyte* rawCode, std::ostream& _output, Flags _flags)
        : fromBinary(true), binaryFormat(BinaryFormat::RAWCODE),
-         output(_output), flags(_flags), sectionCount(0)
+         output(_output), flags(_flags), sectionCount(0), dataFileMinSize(0)
 {
     isaDisassembler.reset(new GCNDisassembler(*this));
     rawInput = new RawCodeInput{ deviceType, rawCodeSize, rawCode };
@@ -432,10 +555,92 @@ GPUDeviceType Disassembler::getDeviceType() const
     }
 }
 
+void Disassembler::setKernelNames(const std::vector<CString>& _kernelNames)
+{
+    kernelNames = _kernelNames;
+    // sort names to fast finding
+    std::sort(kernelNames.begin(), kernelNames.end());
+    kernelNames.resize(std::unique(kernelNames.begin(), kernelNames.end()) -
+                kernelNames.begin());
+}
+
+void Disassembler::setOutputBufferSize(cxuint bufSize)
+{
+    // instructions are printed to reserved space of buffer (up to 250 bytes)
+    if (bufSize < minOutputBufferSize)
+        throw DisasmException("Output buffer size is too small");
+    // buffer is created with ISA disassembler (before disassembling)
+    isaDisassembler.reset(new GCNDisassembler(*this, bufSize));
+}
+
+bool Disassembler::isKernelSelected(const CString& kernelName) const
+{
+    return isDisasmKernelSelected(kernelNames, kernelName);
+}
+
+// convert 8 bytes to 16 hexadecimal digits (lower case, high nibble first)
+static inline void hexDigitsFromBytes8(const cxbyte* data, char* out)
+{
+#ifdef __SSE2__
+    const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+    const __m128i mask = _mm_set1_epi8(0xf);
+    const __m128i nibs = _mm_unpacklo_epi8(_mm_and_si128(_mm_srli_epi16(v, 4), mask),
+                _mm_and_si128(v, mask));
+    // add '0' for digits, add 'a'-10 for letters
+    const __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(nibs, _mm_set1_epi8(9)),
+                _mm_set1_epi8('a'-'0'-10));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                _mm_add_epi8(nibs, _mm_add_epi8(letters, _mm_set1_epi8('0'))));
+#else
+    for (cxuint i = 0; i < 8; i++)
+    {
+        const cxuint hi = data[i]>>4, lo = data[i]&15;
+        out[i<<1] = (hi < 10) ? '0'+hi : 'a'+hi-10;
+        out[(i<<1)+1] = (lo < 10) ? '0'+lo : 'a'+lo-10;
+    }
+#endif
+}
+
+// convert 16 bytes to 32 hexadecimal digits (lower case, high nibble first)
+static inline void hexDigitsFromBytes16(const cxbyte* data, char* out)
+{
+#ifdef __AVX2__
+    // expand bytes to words and put high nibble to first byte, low nibble to second
+    const __m256i w = _mm256_cvtepu8_epi16(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+    const __m256i nibs = _mm256_or_si256(_mm256_srli_epi16(w, 4),
+                _mm256_slli_epi16(_mm256_and_si256(w, _mm256_set1_epi16(15)), 8));
+    const __m256i letters = _mm256_and_si256(
+                _mm256_cmpgt_epi8(nibs, _mm256_set1_epi8(9)),
+                _mm256_set1_epi8('a'-'0'-10));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                _mm256_add_epi8(nibs, _mm256_add_epi8(letters, _mm256_set1_epi8('0'))));
+#else
+    hexDigitsFromBytes8(data, out);
+    hexDigitsFromBytes8(data+8, out+16);
+#endif
+}
+
+// size of buffer for printed lines (lines are written to output in big chunks)
+static const size_t dataPrintBufSize = 4096;
+// max size of single printed line
+static const size_t dataPrintMaxLineSize = 100;
+
+DisasmKernelResources CLRX::getDisasmKernelResources(const CString& name,
+             GPUArchitecture arch, cxuint maxSgprsNum, uint32_t pgmRsrc1,
+             size_t localSize)
+{
+    // register granularity: 8 SGPRs, 4 VGPRs (8 VGPRs for GCN 1.5)
+    const cxuint sgprsNum = std::min((((pgmRsrc1>>6) & 0xf)<<3)+8, maxSgprsNum);
+    const cxuint vgprsNum = arch < GPUArchitecture::GCN1_5 ? ((pgmRsrc1 & 0x3f)<<2)+4 :
+                ((pgmRsrc1 & 0x3f)<<3)+8;
+    return DisasmKernelResources{ name, sgprsNum, vgprsNum, localSize };
+}
+
 void CLRX::printDisasmData(size_t size, const cxbyte* data, std::ostream& output,
                 bool secondAlign)
 {
-    char buf[68];
+    char buf[dataPrintBufSize];
     /// const strings for .byte and fill pseudo-ops
     const char* linePrefix = "    .byte ";
     const char* fillPrefix = "    .fill ";
@@ -447,9 +652,15 @@ void CLRX::printDisasmData(size_t size, const cxbyte* data, std::ostream& output
         fillPrefix = "        .fill ";
         prefixSize += 4;
     }
-    ::memcpy(buf, linePrefix, prefixSize);
+    size_t bufPos = 0;
     for (size_t p = 0; p < size;)
     {
+        if (bufPos > dataPrintBufSize - dataPrintMaxLineSize)
+        {
+            // flush buffer
+            output.write(buf, bufPos);
+            bufPos = 0;
+        }
         size_t fillEnd;
         // find max repetition of this element
         for (fillEnd = p+1; fillEnd < size && data[fillEnd]==data[p]; fillEnd++);
@@ -457,56 +668,54 @@ void CLRX::printDisasmData(size_t size, const cxbyte* data, std::ostream& output
         {
             // if element repeated for least 1 line
             // print .fill pseudo-op: .fill SIZE, 1, VALUE
-            ::memcpy(buf, fillPrefix, prefixSize);
+            ::memcpy(buf+bufPos, fillPrefix, prefixSize);
             const size_t oldP = p;
             p = (fillEnd != size) ? fillEnd&~size_t(7) : fillEnd;
-            size_t bufPos = prefixSize;
+            bufPos += prefixSize;
             bufPos += itocstrCStyle(p-oldP, buf+bufPos, 22, 10);
             memcpy(buf+bufPos, ", 1, ", 5);
             bufPos += 5;
             // value to fill
             bufPos += itocstrCStyle(data[oldP], buf+bufPos, 6, 16, 2);
             buf[bufPos++] = '\n';
-            output.write(buf, bufPos);
-            ::memcpy(buf, linePrefix, prefixSize);
             continue;
         }
         
-        const size_t lineEnd = std::min(p+8, size);
-        size_t bufPos = prefixSize;
+        const size_t lineSize = std::min(size_t(8), size-p);
+        char digits[16];
+        if (lineSize == 8)
+            hexDigitsFromBytes8(data+p, digits);
+        else
+        {
+            // last line (do not read after end of data)
+            cxbyte lastData[8] = { };
+            ::memcpy(lastData, data+p, lineSize);
+            hexDigitsFromBytes8(lastData, digits);
+        }
+        p += lineSize;
+        ::memcpy(buf+bufPos, linePrefix, prefixSize);
+        bufPos += prefixSize;
         // print 8 or less (if end of data) bytes
-        for (; p < lineEnd; p++)
+        for (size_t i = 0; i < lineSize; i++)
         {
-            buf[bufPos++] = '0';
-            buf[bufPos++] = 'x';
-            {
-                // inline byte in hexadecimal
-                cxuint digit = data[p]>>4;
-                if (digit < 10)
-                    buf[bufPos++] = '0'+digit;
-                else
-                    buf[bufPos++] = 'a'+digit-10;
-                digit = data[p]&0xf;
-                if (digit < 10)
-                    buf[bufPos++] = '0'+digit;
-                else
-                    buf[bufPos++] = 'a'+digit-10;
-            }
-            if (p+1 < lineEnd)
-            {
-                buf[bufPos++] = ',';
-                buf[bufPos++] = ' ';
-            }
+            buf[bufPos] = '0';
+            buf[bufPos+1] = 'x';
+            buf[bufPos+2] = digits[i<<1];
+            buf[bufPos+3] = digits[(i<<1)+1];
+            buf[bufPos+4] = ',';
+            buf[bufPos+5] = ' ';
+            bufPos += 6;
         }
-        buf[bufPos++] = '\n';
-        output.write(buf, bufPos);
+        buf[bufPos-2] = '\n';
+        bufPos--;
     }
+    output.write(buf, bufPos);
 }
 
 void CLRX::printDisasmDataU32(size_t size, const uint32_t* data, std::ostream& output,
                 bool secondAlign)
 {
-    char buf[68];
+    char buf[dataPrintBufSize];
     /// const strings for .byte and fill pseudo-ops
     const char* linePrefix = "    .int ";
     const char* fillPrefix = "    .fill ";
@@ -519,9 +728,15 @@ void CLRX::printDisasmDataU32(size_t size, const uint32_t* data, std::ostream& o
         fillPrefixSize += 4;
     }
     const size_t intPrefixSize = fillPrefixSize-1;
-    ::memcpy(buf, linePrefix, intPrefixSize);
+    size_t bufPos = 0;
     for (size_t p = 0; p < size;)
     {
+        if (bufPos > dataPrintBufSize - dataPrintMaxLineSize)
+        {
+            // flush buffer
+            output.write(buf, bufPos);
+            bufPos = 0;
+        }
         size_t fillEnd;
         // find max repetition of this char
         for (fillEnd = p+1; fillEnd < size && ULEV(data[fillEnd])==ULEV(data[p]);
@@ -530,36 +745,56 @@ void CLRX::printDisasmDataU32(size_t size, const uint32_t* data, std::ostream& o
         {
             // if element repeated for least 1 line
             // print .fill pseudo-op
-            ::memcpy(buf, fillPrefix, fillPrefixSize);
+            ::memcpy(buf+bufPos, fillPrefix, fillPrefixSize);
             const size_t oldP = p;
             p = (fillEnd != size) ? fillEnd&~size_t(3) : fillEnd;
-            size_t bufPos = fillPrefixSize;
+            bufPos += fillPrefixSize;
             bufPos += itocstrCStyle(p-oldP, buf+bufPos, 22, 10);
             memcpy(buf+bufPos, ", 4, ", 5);
             bufPos += 5;
             // print fill value
             bufPos += itocstrCStyle(ULEV(data[oldP]), buf+bufPos, 12, 16, 8);
             buf[bufPos++] = '\n';
-            output.write(buf, bufPos);
-            ::memcpy(buf, linePrefix, fillPrefixSize);
             continue;
         }
         
-        const size_t lineEnd = std::min(p+4, size);
-        size_t bufPos = intPrefixSize;
+        const size_t lineSize = std::min(size_t(4), size-p);
+        // data in little endian: digits of byte 3 of dword at first place
+        char digits[32];
+        if (lineSize == 4)
+            hexDigitsFromBytes16(reinterpret_cast<const cxbyte*>(data+p), digits);
+        else
+        {
+            // last line (do not read after end of data)
+            cxbyte lastData[16] = { };
+            ::memcpy(lastData, data+p, lineSize<<2);
+            hexDigitsFromBytes16(lastData, digits);
+        }
+        p += lineSize;
+        ::memcpy(buf+bufPos, linePrefix, intPrefixSize);
+        bufPos += intPrefixSize;
         // print four or less (if end of data) dwords
-        for (; p < lineEnd; p++)
+        for (size_t i = 0; i < lineSize; i++)
         {
-            bufPos += itocstrCStyle(ULEV(data[p]), buf+bufPos, 12, 16, 8);
-            if (p+1 < lineEnd)
-            {
-                buf[bufPos++] = ',';
-                buf[bufPos++] = ' ';
-            }
+            const char* d = digits + (i<<3);
+            buf[bufPos] = '0';
+            buf[bufPos+1] = 'x';
+            buf[bufPos+2] = d[6];
+            buf[bufPos+3] = d[7];
+            buf[bufPos+4] = d[4];
+            buf[bufPos+5] = d[5];
+            buf[bufPos+6] = d[2];
+            buf[bufPos+7] = d[3];
+            buf[bufPos+8] = d[0];
+            buf[bufPos+9] = d[1];
+            buf[bufPos+10] = ',';
+            buf[bufPos+11] = ' ';
+            bufPos += 12;
         }
-        buf[bufPos++] = '\n';
-        output.write(buf, bufPos);
+        buf[bufPos-2] = '\n';
+        bufPos--;
     }
+    output.write(buf, bufPos);
 }
 
 void CLRX::printDisasmLongString(size_t size, const char* data, std::ostream& output,
@@ -572,25 +807,61 @@ void CLRX::printDisasmLongString(size_t size, const char* data, std::ostream& ou
         linePrefix = "        .ascii \"";
         prefixSize += 4;
     }
-    // we need 96 bytes
-    char buffer[96];
-    ::memcpy(buffer, linePrefix, prefixSize);
+    // we need 96 bytes per line
+    char buffer[dataPrintBufSize];
+    size_t bufPos = 0;
     
     for (size_t pos = 0; pos < size; )
     {
+        if (bufPos > dataPrintBufSize - dataPrintMaxLineSize)
+        {
+            // flush buffer
+            output.write(buffer, bufPos);
+            bufPos = 0;
+        }
         const size_t end = std::min(pos+72, size);
         const size_t oldPos = pos;
         // go to end of data, or newline
-        while (pos < end && data[pos] != '\n') pos++;
-        if (pos < end && data[pos] == '\n') pos++; // embrace newline
+        const char* nl = reinterpret_cast<const char*>(::memchr(data+pos, '\n', end-pos));
+        pos = (nl != nullptr) ? nl-data+1 : end; // embrace newline
         size_t escapeSize;
         // escape this part
+        ::memcpy(buffer+bufPos, linePrefix, prefixSize);
+        bufPos += prefixSize;
         pos = oldPos + escapeStringCStyle(pos-oldPos, data+oldPos, 76,
-                      buffer+prefixSize, escapeSize);
-        buffer[prefixSize+escapeSize] = '\"';
-        buffer[prefixSize+escapeSize+1] = '\n';
-        output.write(buffer, prefixSize+escapeSize+2);
+                      buffer+bufPos, escapeSize);
+        bufPos += escapeSize;
+        buffer[bufPos] = '\"';
+        buffer[bufPos+1] = '\n';
+        bufPos += 2;
+    }
+    output.write(buffer, bufPos);
+}
+
+void Disassembler::printDataBlock(size_t size, const cxbyte* data)
+{
+    if (!dataFile || size < dataFileMinSize || size == 0)
+    {
+        printDisasmData(size, data, output);
+        return;
     }
+    // write raw data to data file and include it by '.incbin'
+    dataFile->write(reinterpret_cast<const char*>(data), size);
+    const std::string escapedName = escapeStringCStyle(dataFileName);
+    output.write("    .incbin \"", 13);
+    output.write(escapedName.c_str(), escapedName.size());
+    char buf[64];
+    buf[0] = '\"';
+    buf[1] = ',';
+    buf[2] = ' ';
+    size_t bufPos = 3;
+    bufPos += itocstrCStyle(dataFileSize, buf+bufPos, 22, 10);
+    buf[bufPos++] = ',';
+    buf[bufPos++] = ' ';
+    bufPos += itocstrCStyle(size, buf+bufPos, 22, 10);
+    buf[bufPos++] = '\n';
+    output.write(buf, bufPos);
+    dataFileSize += size;
 }
 
 static void disassembleRawCode(std::ostream& output, const RawCodeInput* rawInput,
@@ -612,6 +883,21 @@ void Disassembler::disassemble()
     try
     {
     sectionCount = 0;
+    cfgs.clear();
+    kernelResources.clear();
+    isaDisassembler->setCodeName(CString(), 0);
+    if (!dataFileName.empty())
+    {
+        // open data file for raw data blocks
+        std::unique_ptr<std::ofstream> dfile(new std::ofstream(dataFileName.c_str(),
+                    std::ios::binary));
+        if (!*dfile)
+            throw DisasmException(std::string("Can't open data file '") +
+                        dataFileName.c_str() + "'");
+        dfile->exceptions(std::ios::failbit | std::ios::badbit);
+        dataFile.reset(dfile.release());
+        dataFileSize = 0;
+    }
     // write pseudo to set binary format
     switch(binaryFormat)
     {
@@ -644,27 +930,116 @@ void Disassembler::disassemble()
     switch(binaryFormat)
     {
         case BinaryFormat::AMD:
-            disassembleAmd(output, amdInput, isaDisassembler.get(), sectionCount, flags);
+            disassembleAmd(output, amdInput, isaDisassembler.get(), sectionCount, flags,
+                           kernelNames);
             break;
         case BinaryFormat::AMDCL2:
             disassembleAmdCL2(output, amdCL2Input, isaDisassembler.get(),
-                              sectionCount, flags);
+                              sectionCount, flags, kernelNames);
             break;
         case BinaryFormat::ROCM:
-            disassembleROCm(output, rocmInput, isaDisassembler.get(), flags);
+            disassembleROCm(output, rocmInput, isaDisassembler.get(), flags, kernelNames);
             break;
         case BinaryFormat::GALLIUM: // Gallium
-            disassembleGallium(output, galliumInput, isaDisassembler.get(), flags);
+            disassembleGallium(output, galliumInput, isaDisassembler.get(), flags,
+                               kernelNames);
             break;
         default:
             disassembleRawCode(output, rawInput, isaDisassembler.get(), flags);
     }
     output.flush();
+    if (dataFile)
+        dataFile->flush();
+    dataFile.reset();
     } /* try catch */
     catch(...)
     {
+        dataFile.reset();
         output.exceptions(oldExceptions);
         throw;
     }
     output.exceptions(oldExceptions);
 }
+
+const char* CLRX::disasmCFGEndTypeNames[7] =
+{ "fallthrough", "jump", "cjump", "call", "setpc", "swappc", "end" };
+
+static const char* disasmCFGEdgeTypeNames[] = { "next", "jump", "call" };
+
+// write string with escaping (for DOT and JSON strings)
+static void writeCFGString(std::ostream& os, const CString& str)
+{
+    os.put('"');
+    for (const char* p = str.c_str(); *p != 0; p++)
+    {
+        const char c = *p;
+        if (c == '"' || c == '\\')
+        {
+            os.put('\\');
+            os.put(c);
+        }
+        else if (cxbyte(c) < 0x20)
+        {
+            char buf[8];
+            ::snprintf(buf, 8, "\\u%04x", cxuint(cxbyte(c)));
+            os.write(buf, 6);
+        }
+        else
+            os.put(c);
+    }
+    os.put('"');
+}
+
+void CLRX::writeDisasmCFG(std::ostream& os, const std::vector<DisasmCFG>& cfgs,
+            DisasmCFGFormat format)
+{
+    if (format == DisasmCFGFormat::JSON)
+    {
+        os << "{\"kernels\":[";
+        for (size_t i = 0; i < cfgs.size(); i++)
+        {
+            const DisasmCFG& cfg = cfgs[i];
+            os << (i!=0 ? ",\n" : "\n") << "{\"name\":";
+            writeCFGString(os, cfg.name);
+            os << ",\"code\":" << cfg.codeIndex << ",\"blocks\":[";
+            for (size_t j = 0; j < cfg.blocks.size(); j++)
+            {
+                const DisasmCFGBlock& block = cfg.blocks[j];
+                os << (j!=0 ? ",\n" : "\n") << "{\"offset\":" << block.offset <<
+                    ",\"size\":" << block.size << ",\"instrs\":" << block.instrsNum <<
+                    ",\"end\":\"" << disasmCFGEndTypeNames[cxuint(block.endType)] << "\"}";
+            }
+            os << "],\"edges\":[";
+            for (size_t j = 0; j < cfg.edges.size(); j++)
+            {
+                const DisasmCFGEdge& edge = cfg.edges[j];
+                os << (j!=0 ? ",\n" : "\n") << "{\"from\":" << edge.from <<
+                    ",\"to\":" << edge.to << ",\"type\":\"" <<
+                    disasmCFGEdgeTypeNames[cxuint(edge.type)] << "\"}";
+            }
+            os << "]}";
+        }
+        os << "]}\n";
+        return;
+    }
+    // Graphviz DOT (node names: code index and block offset)
+    os << "digraph cfg {\n    node [shape=box];\n";
+    for (size_t i = 0; i < cfgs.size(); i++)
+    {
+        const DisasmCFG& cfg = cfgs[i];
+        os << "    subgraph cluster" << i << " {\n        label=";
+        writeCFGString(os, cfg.name);
+        os << ";\n";
+        for (const DisasmCFGBlock& block: cfg.blocks)
+            os << "        c" << cfg.codeIndex << "_" << block.offset << " [label=\"" <<
+                std::hex << "0x" << block.offset << std::dec << "\\n" <<
+                block.instrsNum << " instrs, " << block.size << " bytes\\n" <<
+                disasmCFGEndTypeNames[cxuint(block.endType)] << "\"];\n";
+        os << "    }\n";
+        for (const DisasmCFGEdge& edge: cfg.edges)
+            os << "    c" << cfg.codeIndex << "_" << edge.from << " -> c" <<
+                cfg.codeIndex << "_" << edge.to << " [label=\"" <<
+                disasmCFGEdgeTypeNames[cxuint(edge.type)] << "\"];\n";
+    }
+    os << "}\n";
+}
@@ -0,0 +1,493 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/GPUId.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include <CLRX/amdasm/GCNAnalyzer.h>
+#include "GCNInternals.h"
+#include "DisasmInternals.h"
+
+using namespace CLRX;
+
+enum : cxbyte
+{
+    GCNTIMING_DP = 1,   // cycles multiplied by DPFACTOR
+    GCNTIMING_FMA,      // 4 cycles if DP speed is not lower than 1/8, otherwise 16
+    GCNTIMING_GLC1,     // additional cycle if GLC is set
+    GCNTIMING_GLC2      // additional 2 cycles if GLC is set
+};
+
+struct GCNInstrTiming
+{
+    const char* mnemonic;
+    cxbyte cycles;
+    cxbyte mode;
+};
+
+// timings of instructions that take other than 4 cycles (from doc/GcnTimings.md),
+// sorted by mnemonic
+static const GCNInstrTiming gcnInstrTimingsTable[] =
+{
+    { "buffer_atomic_add", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_add_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_and", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_and_x2", 16, 0 },
+    { "buffer_atomic_cmpswap", 32, 0 },
+    { "buffer_atomic_cmpswap_x2", 32, 0 },
+    { "buffer_atomic_dec", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_dec_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_fcmpswap", 32, 0 },
+    { "buffer_atomic_fcmpswap_x2", 32, 0 },
+    { "buffer_atomic_fmax", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_fmax_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_fmin", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_fmin_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_inc", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_inc_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_or", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_or_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_rsub", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_rsub_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_smax", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_smax_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_smin", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_smin_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_sub", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_sub_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_swap", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_swap_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_umax", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_umax_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_umin", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_umin_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_atomic_xor", 16, GCNTIMING_GLC1 },
+    { "buffer_atomic_xor_x2", 16, GCNTIMING_GLC2 },
+    { "buffer_load_dword", 8, 0 },
+    { "buffer_load_dwordx2", 18, 0 },
+    { "buffer_load_dwordx3", 16, 0 },
+    { "buffer_load_dwordx4", 16, 0 },
+    { "buffer_load_format_x", 8, 0 },
+    { "buffer_load_format_xy", 18, 0 },
+    { "buffer_load_format_xyz", 16, 0 },
+    { "buffer_load_format_xyzw", 16, 0 },
+    { "buffer_load_sbyte", 8, 0 },
+    { "buffer_load_sshort", 8, 0 },
+    { "buffer_load_ubyte", 8, 0 },
+    { "buffer_load_ushort", 8, 0 },
+    { "buffer_store_byte", 16, 0 },
+    { "buffer_store_dword", 16, 0 },
+    { "buffer_store_dwordx2", 16, 0 },
+    { "buffer_store_dwordx3", 16, 0 },
+    { "buffer_store_dwordx4", 16, 0 },
+    { "buffer_store_format_x", 16, 0 },
+    { "buffer_store_format_xy", 16, 0 },
+    { "buffer_store_format_xyz", 16, 0 },
+    { "buffer_store_format_xyzw", 16, 0 },
+    { "buffer_store_short", 16, 0 },
+    { "ds_add_rtn_u32", 8, 0 },
+    { "ds_add_rtn_u64", 12, 0 },
+    { "ds_add_src2_u64", 8, 0 },
+    { "ds_add_u32", 8, 0 },
+    { "ds_add_u64", 12, 0 },
+    { "ds_and_b32", 8, 0 },
+    { "ds_and_b64", 12, 0 },
+    { "ds_and_rtn_b32", 8, 0 },
+    { "ds_and_rtn_b64", 12, 0 },
+    { "ds_and_src2_b64", 8, 0 },
+    { "ds_cmpst_b32", 12, 0 },
+    { "ds_cmpst_b64", 20, 0 },
+    { "ds_cmpst_f32", 12, 0 },
+    { "ds_cmpst_f64", 20, 0 },
+    { "ds_cmpst_rtn_b32", 12, 0 },
+    { "ds_cmpst_rtn_b64", 20, 0 },
+    { "ds_cmpst_rtn_f32", 12, 0 },
+    { "ds_cmpst_rtn_f64", 20, 0 },
+    { "ds_dec_rtn_u32", 8, 0 },
+    { "ds_dec_rtn_u64", 12, 0 },
+    { "ds_dec_src2_u64", 8, 0 },
+    { "ds_dec_u32", 8, 0 },
+    { "ds_dec_u64", 12, 0 },
+    { "ds_inc_rtn_u32", 8, 0 },
+    { "ds_inc_rtn_u64", 12, 0 },
+    { "ds_inc_src2_u64", 8, 0 },
+    { "ds_inc_u32", 8, 0 },
+    { "ds_inc_u64", 12, 0 },
+    { "ds_max_f32", 8, 0 },
+    { "ds_max_f64", 12, 0 },
+    { "ds_max_i32", 8, 0 },
+    { "ds_max_i64", 12, 0 },
+    { "ds_max_rtn_f32", 8, 0 },
+    { "ds_max_rtn_f64", 12, 0 },
+    { "ds_max_rtn_i32", 8, 0 },
+    { "ds_max_rtn_i64", 12, 0 },
+    { "ds_max_rtn_u32", 8, 0 },
+    { "ds_max_rtn_u64", 12, 0 },
+    { "ds_max_src2_f64", 8, 0 },
+    { "ds_max_src2_i64", 8, 0 },
+    { "ds_max_src2_u64", 8, 0 },
+    { "ds_max_u32", 8, 0 },
+    { "ds_max_u64", 12, 0 },
+    { "ds_min_f32", 8, 0 },
+    { "ds_min_f64", 12, 0 },
+    { "ds_min_i32", 8, 0 },
+    { "ds_min_i64", 12, 0 },
+    { "ds_min_rtn_f32", 8, 0 },
+    { "ds_min_rtn_f64", 12, 0 },
+    { "ds_min_rtn_i32", 8, 0 },
+    { "ds_min_rtn_i64", 12, 0 },
+    { "ds_min_rtn_u32", 8, 0 },
+    { "ds_min_rtn_u64", 12, 0 },
+    { "ds_min_src2_f64", 8, 0 },
+    { "ds_min_src2_i64", 8, 0 },
+    { "ds_min_src2_u64", 8, 0 },
+    { "ds_min_u32", 8, 0 },
+    { "ds_min_u64", 12, 0 },
+    { "ds_mskor_b32", 12, 0 },
+    { "ds_mskor_b64", 20, 0 },
+    { "ds_mskor_rtn_b32", 12, 0 },
+    { "ds_mskor_rtn_b64", 20, 0 },
+    { "ds_or_b32", 8, 0 },
+    { "ds_or_b64", 12, 0 },
+    { "ds_or_rtn_b32", 8, 0 },
+    { "ds_or_rtn_b64", 12, 0 },
+    { "ds_or_src2_b64", 8, 0 },
+    { "ds_read2_b32", 8, 0 },
+    { "ds_read2_b64", 16, 0 },
+    { "ds_read2st64_b32", 8, 0 },
+    { "ds_read2st64_b64", 16, 0 },
+    { "ds_read_b128", 16, 0 },
+    { "ds_read_b64", 8, 0 },
+    { "ds_read_b96", 16, 0 },
+    { "ds_rsub_rtn_u32", 8, 0 },
+    { "ds_rsub_rtn_u64", 12, 0 },
+    { "ds_rsub_src2_u64", 8, 0 },
+    { "ds_rsub_u32", 8, 0 },
+    { "ds_rsub_u64", 12, 0 },
+    { "ds_sub_rtn_u32", 8, 0 },
+    { "ds_sub_rtn_u64", 12, 0 },
+    { "ds_sub_src2_u64", 8, 0 },
+    { "ds_sub_u32", 8, 0 },
+    { "ds_sub_u64", 12, 0 },
+    { "ds_write2_b32", 12, 0 },
+    { "ds_write2_b64", 20, 0 },
+    { "ds_write2st64_b32", 12, 0 },
+    { "ds_write2st64_b64", 20, 0 },
+    { "ds_write_b128", 20, 0 },
+    { "ds_write_b16", 8, 0 },
+    { "ds_write_b32", 8, 0 },
+    { "ds_write_b64", 12, 0 },
+    { "ds_write_b8", 8, 0 },
+    { "ds_write_b96", 16, 0 },
+    { "ds_write_src2_b32", 12, 0 },
+    { "ds_write_src2_b64", 20, 0 },
+    { "ds_wrxchg2_rtn_b32", 12, 0 },
+    { "ds_wrxchg2_rtn_b64", 20, 0 },
+    { "ds_wrxchg2st64_rtn_b32", 12, 0 },
+    { "ds_wrxchg2st64_rtn_b64", 20, 0 },
+    { "ds_wrxchg_rtn_b32", 8, 0 },
+    { "ds_wrxchg_rtn_b64", 12, 0 },
+    { "ds_xor_b32", 8, 0 },
+    { "ds_xor_b64", 12, 0 },
+    { "ds_xor_rtn_b32", 8, 0 },
+    { "ds_xor_rtn_b64", 12, 0 },
+    { "ds_xor_src2_b64", 8, 0 },
+    { "s_branch", 20, 0 },
+    { "s_buffer_load_dwordx16", 16, 0 },
+    { "s_buffer_load_dwordx8", 8, 0 },
+    { "s_load_dwordx16", 16, 0 },
+    { "s_load_dwordx8", 8, 0 },
+    { "s_setreg_b32", 8, 0 },
+    { "s_setreg_imm32_b32", 8, 0 },
+    { "v_add_f64", 4, GCNTIMING_DP },
+    { "v_ashr_i64", 4, GCNTIMING_DP },
+    { "v_ashrrev_i64", 4, GCNTIMING_DP },
+    { "v_ceil_f64", 4, GCNTIMING_DP },
+    { "v_cos_f16", 16, 0 },
+    { "v_cos_f32", 16, 0 },
+    { "v_cvt_f32_f64", 4, GCNTIMING_DP },
+    { "v_cvt_f64_f32", 4, GCNTIMING_DP },
+    { "v_cvt_f64_i32", 4, GCNTIMING_DP },
+    { "v_cvt_f64_u32", 4, GCNTIMING_DP },
+    { "v_cvt_i32_f64", 4, GCNTIMING_DP },
+    { "v_cvt_u32_f64", 4, GCNTIMING_DP },
+    { "v_div_fixup_f32", 16, 0 },
+    { "v_div_fixup_f64", 4, GCNTIMING_DP },
+    { "v_div_fmas_f32", 16, 0 },
+    { "v_div_fmas_f64", 8, GCNTIMING_DP },
+    { "v_div_scale_f32", 16, 0 },
+    { "v_div_scale_f64", 4, GCNTIMING_DP },
+    { "v_exp_f16", 16, 0 },
+    { "v_exp_f32", 16, 0 },
+    { "v_exp_legacy_f32", 16, 0 },
+    { "v_floor_f64", 4, GCNTIMING_DP },
+    { "v_fma_f32", 16, GCNTIMING_FMA },
+    { "v_fma_f64", 8, GCNTIMING_DP },
+    { "v_fract_f64", 4, GCNTIMING_DP },
+    { "v_frexp_exp_i32_f64", 4, GCNTIMING_DP },
+    { "v_frexp_mant_f64", 4, GCNTIMING_DP },
+    { "v_ldexp_f64", 4, GCNTIMING_DP },
+    { "v_log_clamp_f32", 16, 0 },
+    { "v_log_f16", 16, 0 },
+    { "v_log_f32", 16, 0 },
+    { "v_log_legacy_f32", 16, 0 },
+    { "v_lshl_b64", 4, GCNTIMING_DP },
+    { "v_lshlrev_b64", 4, GCNTIMING_DP },
+    { "v_lshr_b64", 4, GCNTIMING_DP },
+    { "v_lshrrev_b64", 4, GCNTIMING_DP },
+    { "v_mad_i64_i32", 16, 0 },
+    { "v_mad_u64_u32", 16, 0 },
+    { "v_max_f64", 4, GCNTIMING_DP },
+    { "v_min_f64", 4, GCNTIMING_DP },
+    { "v_mqsad_pk_u16_u8", 16, 0 },
+    { "v_mqsad_u32_u8", 16, 0 },
+    { "v_mqsad_u8", 16, 0 },
+    { "v_mul_f64", 8, GCNTIMING_DP },
+    { "v_mul_hi_i32", 16, 0 },
+    { "v_mul_hi_u32", 16, 0 },
+    { "v_mul_lo_i32", 16, 0 },
+    { "v_mul_lo_u32", 16, 0 },
+    { "v_qsad_pk_u16_u8", 16, 0 },
+    { "v_qsad_u8", 16, 0 },
+    { "v_rcp_clamp_f32", 16, 0 },
+    { "v_rcp_clamp_f64", 8, GCNTIMING_DP },
+    { "v_rcp_f16", 16, 0 },
+    { "v_rcp_f32", 16, 0 },
+    { "v_rcp_f64", 8, GCNTIMING_DP },
+    { "v_rcp_iflag_f32", 16, 0 },
+    { "v_rcp_legacy_f32", 16, 0 },
+    { "v_rndne_f64", 4, GCNTIMING_DP },
+    { "v_rsq_clamp_f32", 16, 0 },
+    { "v_rsq_clamp_f64", 8, GCNTIMING_DP },
+    { "v_rsq_f16", 16, 0 },
+    { "v_rsq_f32", 16, 0 },
+    { "v_rsq_f64", 8, GCNTIMING_DP },
+    { "v_rsq_legacy_f32", 16, 0 },
+    { "v_sin_f16", 16, 0 },
+    { "v_sin_f32", 16, 0 },
+    { "v_sqrt_f16", 16, 0 },
+    { "v_sqrt_f32", 16, 0 },
+    { "v_sqrt_f64", 8, GCNTIMING_DP },
+    { "v_swap_b32", 8, 0 },
+    { "v_trig_preop_f64", 8, GCNTIMING_DP },
+    { "v_trunc_f64", 4, GCNTIMING_DP },
+};
+
+static const size_t gcnInstrTimingsNum =
+        sizeof(gcnInstrTimingsTable)/sizeof(GCNInstrTiming);
+
+GCNCodeAnalyzer::GCNCodeAnalyzer(GPUDeviceType deviceType, cxuint _dpFactor)
+        : arch(getGPUArchitectureFromDeviceType(deviceType)), dpFactor(_dpFactor)
+{
+    if (dpFactor == 0)
+        // highend Tahiti (1/4), highend Hawaii (1/8), other GPU's (1/16)
+        dpFactor = (deviceType == GPUDeviceType::TAHITI) ? 2 :
+                (deviceType == GPUDeviceType::HAWAII) ? 4 : 8;
+}
+
+// return true if instruction operates on 64-bit values (compare instructions)
+static bool isGCN64BitCompare(const char* mnemonic)
+{
+    if (::strncmp(mnemonic, "v_cmp", 5) != 0)
+        return false;
+    const size_t len = ::strlen(mnemonic);
+    return len > 4 && (::strcmp(mnemonic+len-4, "_f64") == 0 ||
+            ::strcmp(mnemonic+len-4, "_i64") == 0 || ::strcmp(mnemonic+len-4, "_u64") == 0);
+}
+
+cxuint GCNCodeAnalyzer::getInstrCycles(const DisasmCFGInstr& instr) const
+{
+    if (instr.mnemonic == nullptr)
+        return 4; // illegal instruction
+    const char* mnemonic = instr.mnemonic;
+    // MTBUF instructions have this same timings as MUBUF format instructions
+    if (instr.encoding == GCNENC_MTBUF && mnemonic[0] == 't')
+        mnemonic++;
+    
+    const GCNInstrTiming* timing = std::lower_bound(gcnInstrTimingsTable,
+                gcnInstrTimingsTable + gcnInstrTimingsNum, mnemonic,
+                [](const GCNInstrTiming& a, const char* b)
+                { return ::strcmp(a.mnemonic, b) < 0; });
+    if (timing != gcnInstrTimingsTable + gcnInstrTimingsNum &&
+        ::strcmp(timing->mnemonic, mnemonic) == 0)
+    {
+        // GLC bit in MUBUF/MTBUF encoding
+        const bool glc = (instr.code & 0x4000U) != 0;
+        switch(timing->mode)
+        {
+            case GCNTIMING_DP:
+                return timing->cycles*dpFactor;
+            case GCNTIMING_FMA:
+                return dpFactor <= 4 ? 4 : 16;
+            case GCNTIMING_GLC1:
+                return timing->cycles + (glc ? 1 : 0);
+            case GCNTIMING_GLC2:
+                return timing->cycles + (glc ? 2 : 0);
+            default:
+                return timing->cycles;
+        }
+    }
+    if (instr.encoding == GCNENC_SOP1 && ::strstr(mnemonic, "_saveexec_") != nullptr)
+        return 8;
+    if (isGCN64BitCompare(mnemonic))
+        return 4*dpFactor;
+    return 4;
+}
+
+cxuint GCNCodeAnalyzer::getOccupancy(cxuint sgprsNum, cxuint vgprsNum,
+                size_t localSize, cxuint groupWaves) const
+{
+    // kernel does not fit in SIMD or compute unit
+    if (vgprsNum > 256)
+        throw DisasmException("VGPRs number out of range (max 256)");
+    if (localSize > 65536)
+        throw DisasmException("Local size out of range (max 65536)");
+    const bool isGCN15 = (arch >= GPUArchitecture::GCN1_5);
+    cxuint waves = isGCN15 ? 20 : 10;
+    // VGPRs: 256 per lane (GCN 1.5: 1024 in wave32 mode), allocated by 4 (GCN 1.5: 8)
+    if (vgprsNum != 0)
+        waves = isGCN15 ? std::min(waves, 1024U / ((vgprsNum+7) & ~7U)) :
+                std::min(waves, 256U / ((vgprsNum+3) & ~3U));
+    // SGPRs: 512 per SIMD allocated by 8 (GCN 1.2/1.4: 800 allocated by 16)
+    if (sgprsNum != 0 && !isGCN15)
+        waves = arch < GPUArchitecture::GCN1_2 ?
+                std::min(waves, 512U / ((sgprsNum+7) & ~7U)) :
+                std::min(waves, 800U / ((sgprsNum+15) & ~15U));
+    // LDS: 64 KB per compute unit (4 SIMDs)
+    if (localSize != 0)
+    {
+        // waves of groups are distributed between SIMDs (round up)
+        const size_t groups = 65536 / localSize;
+        waves = std::min(size_t(waves), (groups * std::max(groupWaves, 1U) + 3) / 4);
+    }
+    return waves;
+}
+
+GCNKernelTiming GCNCodeAnalyzer::analyzeKernel(const DisasmCFG& cfg) const
+{
+    GCNKernelTiming timing{ cfg.name, {}, 0, 0, 0, false, 0, 0, 0, 0 };
+    // alignment penalties only for GCN 1.0/1.1 (GCN 1.2 fetches 2-dword instrs fast)
+    const bool alignPenalties = (arch < GPUArchitecture::GCN1_2);
+    
+    // find blocks which are targets of forward jumps
+    std::vector<size_t> jumpTargets;
+    for (const DisasmCFGEdge& edge: cfg.edges)
+        if (edge.type == DisasmCFGEdgeType::JUMP && edge.from < edge.to)
+            jumpTargets.push_back(edge.to);
+    std::sort(jumpTargets.begin(), jumpTargets.end());
+    
+    auto instrIt = cfg.instrs.begin();
+    for (const DisasmCFGBlock& block: cfg.blocks)
+    {
+        GCNBlockTiming btiming{ block.offset, block.size, block.instrsNum, 0, 0,
+                    block.endType };
+        if (alignPenalties)
+        {
+            // best place to jump is first 5 dwords in 32-byte block
+            const cxuint dword = (block.offset>>2) & 7;
+            if (dword >= 5 && std::binary_search(jumpTargets.begin(),
+                        jumpTargets.end(), block.offset))
+                btiming.alignPenalties += dword-4;
+        }
+        cxuint freeDwords = 0;
+        for (size_t i = 0; i < block.instrsNum; i++, ++instrIt)
+        {
+            const DisasmCFGInstr& instr = *instrIt;
+            const cxuint cycles = getInstrCycles(instr);
+            btiming.cycles += cycles;
+            if (!alignPenalties)
+                continue;
+            const cxuint dword = (instr.offset>>2) & 7;
+            // only first 3 dwords in 32-byte block are free for 2-dword instructions,
+            // next dwords are free if previous instruction was longer than 4 cycles
+            if (instr.size == 8 && dword >= 3 && freeDwords == 0)
+                btiming.alignPenalties++;
+            freeDwords = (cycles > 4) ? cycles/4 - 1 :
+                    (freeDwords > instr.size/4 ? freeDwords - instr.size/4 : 0);
+            // conditional jump should be in first half of 32-byte block
+            if (i+1 == block.instrsNum && block.endType == DisasmCFGEndType::CJUMP &&
+                dword >= 4)
+                btiming.alignPenalties += dword-3;
+        }
+        timing.instrsNum += btiming.instrsNum;
+        timing.cycles += btiming.cycles;
+        timing.penaltyCycles += btiming.alignPenalties*4;
+        timing.blocks.push_back(btiming);
+    }
+    return timing;
+}
+
+std::vector<GCNKernelTiming> GCNCodeAnalyzer::analyze(const std::vector<DisasmCFG>& cfgs,
+                const std::vector<DisasmKernelResources>& resources,
+                cxuint groupWaves) const
+{
+    std::vector<GCNKernelTiming> timings;
+    for (const DisasmCFG& cfg: cfgs)
+    {
+        GCNKernelTiming timing = analyzeKernel(cfg);
+        auto resIt = std::find_if(resources.begin(), resources.end(),
+                [&cfg](const DisasmKernelResources& res)
+                { return res.name == cfg.name; });
+        if (resIt != resources.end())
+        {
+            timing.hasResources = true;
+            timing.sgprsNum = resIt->sgprsNum;
+            timing.vgprsNum = resIt->vgprsNum;
+            timing.localSize = resIt->localSize;
+            timing.waves = getOccupancy(resIt->sgprsNum, resIt->vgprsNum,
+                        resIt->localSize, groupWaves);
+        }
+        timings.push_back(std::move(timing));
+    }
+    return timings;
+}
+
+void CLRX::writeGCNTimingReport(std::ostream& os,
+            const std::vector<GCNKernelTiming>& timings, bool printBlocks)
+{
+    for (const GCNKernelTiming& timing: timings)
+    {
+        os << "kernel " << (timing.name.empty() ? "(unnamed)" : timing.name.c_str()) <<
+            ": blocks " << timing.blocks.size() << ", instrs " << timing.instrsNum <<
+            ", cycles " << timing.cycles << ", penalty cycles " <<
+            timing.penaltyCycles << "\n";
+        if (timing.hasResources)
+            os << "    SGPRs " << timing.sgprsNum << ", VGPRs " << timing.vgprsNum <<
+                ", local size " << timing.localSize << ", occupancy " <<
+                timing.waves << " waves/SIMD\n";
+        else
+            os << "    occupancy unknown (no kernel configuration)\n";
+        if (!printBlocks)
+            continue;
+        for (const GCNBlockTiming& block: timing.blocks)
+        {
+            char buf[40];
+            itocstrCStyle(block.offset, buf, 40, 16, 8);
+            os << "    block " << buf << ": instrs " << block.instrsNum <<
+                ", bytes " << block.size << ", cycles " << block.cycles <<
+                ", penalties " << block.alignPenalties << ", end " <<
+                disasmCFGEndTypeNames[cxuint(block.endType)] << "\n";
+        }
+    }
+}
@@ -848,7 +848,9 @@ bool GCNAsmUtils::parseSOPPEncoding(Assembler& asmr, const GCNAsmInstruction& gc
                     good &= parseImm(asmr, linePtr, gsopIndex, nullptr, 3, WS_UNSIGNED);
                 }
                 
-                if (gsopIndex!=0)
+                skipSpacesToEnd(linePtr, end);
+                // STREAMID is optional for NOP GSOP
+                if (gsopIndex!=0 || (linePtr!=end && *linePtr==','))
                 {
                     if (!skipRequiredComma(asmr, linePtr))
                         return false;
@@ -1466,7 +1468,9 @@ bool GCNAsmUtils::parseVOP2Encoding(Assembler& asmr, const GCNAsmInstruction& gc
     
     extraMods.needSDWA |= ((src0Op.vopMods | src1Op.vopMods) & VOPOP_SEXT) != 0;
     // determine whether VOP3 encoding is needed
-    bool vop3 = /* src1=sgprs and not (DS1_SGPR|src1_SGPR) */
+    auto needVOP3 = [&]() -> bool
+    {
+        return /* src1=sgprs and not (DS1_SGPR|src1_SGPR) */
         //((src1Op.range.start<256) ^ sgprRegInSrc1) ||
         ((!isGCN14 || !extraMods.needSDWA) &&
                 (src1Op.range.isNonVGPR() ^ sgprRegInSrc1)) ||
@@ -1478,6 +1482,39 @@ bool GCNAsmUtils::parseVOP2Encoding(Assembler& asmr, const GCNAsmInstruction& gc
         //(haveDstCC && dstCCReg.start!=106) || (haveSrcCC && srcCCReg.start!=106) ||
         (haveDstCC && !dstCCReg.isVal(106)) || (haveSrcCC && !srcCCReg.isVal(106)) ||
         ((opMods.opselMod & 15) != 0) || (gcnEncSize==GCNEncSize::BIT64);
+    };
+    bool vop3 = needVOP3();
+    
+    uint16_t code1 = gcnInsn.code1;
+    // code shrinking: swap source operands if only VGPR in SRC0 forces VOP3 encoding
+    if (vop3 && asmr.shrinkCode && !sgprRegInSrc1 && mode1 != GCN_ARG1_IMM &&
+        mode1 != GCN_ARG2_IMM && gcnVOPEnc==GCNVOPEnc::NORMAL && !extraMods.needSDWA &&
+        !extraMods.needDPP && !extraMods.needDPP8 && src0Op.range.isVGPR() &&
+        src1Op.range.isNonVGPR())
+    {
+        const GCNAsmInstruction* swappedInsn = findSwappedVOPInstruction(gcnInsn, arch);
+        if (swappedInsn != nullptr)
+        {
+            std::swap(src0Op, src1Op);
+            if (!needVOP3())
+            {
+                vop3 = false;
+                code1 = swappedInsn->code1;
+                std::swap(src0OpExpr, src1OpExpr);
+                AsmRegVarUsage* rvus = gcnAsm->instrRVUs;
+                std::swap(rvus[2], rvus[3]);
+                if (rvus[2].regField != ASMFIELD_NONE)
+                    rvus[2].regField = GCNFIELD_VOP_SRC0;
+                if (rvus[3].regField != ASMFIELD_NONE)
+                    rvus[3].regField = GCNFIELD_VOP_VSRC1;
+                if (!src0Op.range.isVal(255))
+                    // VOP3 without literal replaced by VOP2
+                    asmr.shrinkCodeSavedBytes += 4;
+            }
+            else // revert
+                std::swap(src0Op, src1Op);
+        }
+    }
     
     if ((src0Op.range.isVal(255) || src1Op.range.isVal(255)) &&
         (src0Op.range.isSGPR() || src0Op.range.isVal(124) ||
@@ -1584,7 +1621,7 @@ bool GCNAsmUtils::parseVOP2Encoding(Assembler& asmr, const GCNAsmInstruction& gc
     uint32_t words[2];
     if (!vop3)
         // VOP2 encoding
-        encodeVOPWords((uint32_t(gcnInsn.code1)<<25) |
+        encodeVOPWords((uint32_t(code1)<<25) |
                 (uint32_t(src1Op.range.bstart()&0xff)<<9) |
                 (uint32_t(dstReg.bstart()&0xff)<<17),
                 modifiers, extraMods, src0Op, src1Op, immValue, mode1,
@@ -1848,7 +1885,9 @@ bool GCNAsmUtils::parseVOPCEncoding(Assembler& asmr, const GCNAsmInstruction& gc
     const cxuint vccCode = ((gcnInsn.mode & GCN_VOPC_NOVCC) == 0) ? 106 : 0;
     // determine whether SDWA is needed or VOP3 encoding needed
     extraMods.needSDWA |= ((src0Op.vopMods | src1Op.vopMods) & VOPOP_SEXT) != 0;
-    bool vop3 = //(dstReg.start!=106) || (src1Op.range.start<256) ||
+    auto needVOP3 = [&]() -> bool
+    {
+        return //(dstReg.start!=106) || (src1Op.range.start<256) ||
         ((!isGCN14 || !extraMods.needSDWA) && !dstReg.isVal(vccCode)) ||
         ((!isGCN14 || !extraMods.needSDWA) && src1Op.range.isNonVGPR()) ||
         (!isGCN12 && (src0Op.vopMods!=0 || src1Op.vopMods!=0)) ||
@@ -1856,6 +1895,39 @@ bool GCNAsmUtils::parseVOPCEncoding(Assembler& asmr, const GCNAsmInstruction& gc
             /* exclude OMOD if RXVEGA and SDWA used */
             ((isGCN14 && extraMods.needSDWA) ? 3 : 0)))!=0 ||
         ((opMods.opselMod & 15) != 0) || (gcnEncSize==GCNEncSize::BIT64);
+    };
+    bool vop3 = needVOP3();
+    
+    uint16_t code1 = gcnInsn.code1;
+    // code shrinking: swap source operands (and condition) if only VGPR in SRC0
+    // forces VOP3 encoding
+    if (vop3 && asmr.shrinkCode && gcnVOPEnc==GCNVOPEnc::NORMAL &&
+        !extraMods.needSDWA && !extraMods.needDPP && !extraMods.needDPP8 &&
+        src0Op.range.isVGPR() && src1Op.range.isNonVGPR())
+    {
+        const GCNAsmInstruction* swappedInsn = findSwappedVOPInstruction(gcnInsn, arch);
+        if (swappedInsn != nullptr)
+        {
+            std::swap(src0Op, src1Op);
+            if (!needVOP3())
+            {
+                vop3 = false;
+                code1 = swappedInsn->code1;
+                std::swap(src0OpExpr, src1OpExpr);
+                AsmRegVarUsage* rvus = gcnAsm->instrRVUs;
+                std::swap(rvus[1], rvus[2]);
+                if (rvus[1].regField != ASMFIELD_NONE)
+                    rvus[1].regField = GCNFIELD_VOP_SRC0;
+                if (rvus[2].regField != ASMFIELD_NONE)
+                    rvus[2].regField = GCNFIELD_VOP_VSRC1;
+                if (!src0Op.range.isVal(255))
+                    // VOP3 without literal replaced by VOPC
+                    asmr.shrinkCodeSavedBytes += 4;
+            }
+            else // revert
+                std::swap(src0Op, src1Op);
+        }
+    }
     
     if ((src0Op.range.isVal(255) || src1Op.range.isVal(255)) &&
         (src0Op.range.isSGPR() || src0Op.range.isVal(124) ||
@@ -1933,7 +2005,7 @@ bool GCNAsmUtils::parseVOPCEncoding(Assembler& asmr, const GCNAsmInstruction& gc
         const uint32_t dstMods = (isGCN14 ? 0x10000 : 0) |
                 ((isGCN14 && !dstReg.isVal(106)) ? ((dstReg.bstart()|0x80)<<8) : 0);
         
-        encodeVOPWords(0x7c000000U | (uint32_t(gcnInsn.code1)<<17) |
+        encodeVOPWords(0x7c000000U | (uint32_t(code1)<<17) |
                 (uint32_t(src1Op.range.bstart()&0xff)<<9),
                 modifiers, extraMods, src0Op, src1Op, 0, 0,
                 dstMods, wordsNum, words);
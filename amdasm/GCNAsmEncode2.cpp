@@ -1311,7 +1311,7 @@ bool GCNAsmUtils::parseFLATEncoding(Assembler& asmr, const GCNAsmInstruction& gc
     }
     
     if (haveLds && flatMode == GCN_FLAT_FLAT)
-        ASM_NOTGOOD_BY_ERROR(vdstPlace,
+        ASM_NOTGOOD_BY_ERROR(instrPlace,
                         "LDS is allowed only for SCRATCH and GLOBAL instructions")
     
     if (!good || !checkGarbagesAtEnd(asmr, linePtr))
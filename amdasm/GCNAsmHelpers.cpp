@@ -1255,6 +1255,39 @@ static const size_t ssourceNamesGCN14TblSize = sizeof(ssourceNamesGCN14Tbl) /
         sizeof(std::pair<const char*, uint16_t>);
 
 // main routine to parse operand
+/* get constant immediate for literal value (used by code shrinking),
+ * integer values are folded only if they are negative 32-bit values,
+ * return zero if value can not be folded */
+static cxuint getFoldedConstImm(uint64_t value, Flags opType, bool isGCN12)
+{
+    static const uint32_t floatConstImmsTbl[9] =
+    {
+        0x3f000000, 0xbf000000, 0x3f800000, 0xbf800000,
+        0x40000000, 0xc0000000, 0x40800000, 0xc0800000, 0x3e22f983
+    };
+    static const uint16_t halfConstImmsTbl[9] =
+    {
+        0x3800, 0xb800, 0x3c00, 0xbc00, 0x4000, 0xc000, 0x4400, 0xc400, 0x3118
+    };
+    const cxuint constImmsNum = isGCN12 ? 9 : 8;
+    if (opType == INSTROP_F16)
+    {
+        for (cxuint i = 0; i < constImmsNum; i++)
+            if (value == halfConstImmsTbl[i])
+                return 240+i;
+        return 0;
+    }
+    if (opType != INSTROP_INT && opType != INSTROP_FLOAT)
+        return 0;
+    if (value >= 0xfffffff0U && value <= 0xffffffffU)
+        return 192 + (0x100000000ULL-value);
+    if (opType == INSTROP_FLOAT)
+        for (cxuint i = 0; i < constImmsNum; i++)
+            if (value == floatConstImmsTbl[i])
+                return 240+i;
+    return 0;
+}
+
 bool GCNAsmUtils::parseOperand(Assembler& asmr, const char*& linePtr, GCNOperand& operand,
              std::unique_ptr<AsmExpression>* outTargetExpr, GPUArchMask arch,
              cxuint regsNum, Flags instrOpMask, AsmRegField regField)
@@ -1776,6 +1809,18 @@ bool GCNAsmUtils::parseOperand(Assembler& asmr, const char*& linePtr, GCNOperand
                     operand.range = { 192-value, 0 };
                     return true;
                 }
+                else if (asmr.shrinkCode && regsNum<=1)
+                {
+                    // code shrinking: fold literal to constant immediate
+                    const cxuint constImm = getFoldedConstImm(value,
+                                instrOpMask & INSTROP_TYPE_MASK, isGCN12);
+                    if (constImm != 0)
+                    {
+                        operand.range = { constImm, 0 };
+                        asmr.shrinkCodeSavedBytes += 4;
+                        return true;
+                    }
+                }
             }
         }
         if (encodeAsLiteral)
@@ -320,6 +320,11 @@ struct CLRX_INTERNAL GCNAsmUtils: AsmParseUtils
                  const GCNOperand& src0Op, VOPExtraModifiers& extraMods,
                  bool absNegFlags, const char* instrPlace);
     
+    /* find VOP2/VOPC instruction with swapped source operands (for code shrinking),
+     * return null if not found */
+    static const GCNAsmInstruction* findSwappedVOPInstruction(
+                const GCNAsmInstruction& gcnInsn, GPUArchMask arch);
+    
     // routines to parse GCN encodings
     static bool parseSOP2Encoding(Assembler& asmr, const GCNAsmInstruction& gcnInsn,
                       const char* instrPlace, const char* linePtr, GPUArchMask arch,
@@ -519,6 +519,98 @@ bool GCNAssembler::checkMnemonic(const CString& inMnemonic) const
                { return ::strcmp(instr1.mnemonic, instr2.mnemonic)<0; });
 }
 
+// VOP2 instructions with commutative source operands (sorted)
+static const char* gcnVOP2CommutativeTable[] =
+{
+    "v_add_co_ci_u32", "v_add_co_u32", "v_add_f16", "v_add_f32", "v_add_i32",
+    "v_add_nc_u32", "v_add_u16", "v_add_u32", "v_addc_co_u32", "v_addc_u32",
+    "v_and_b32", "v_fmac_f16", "v_fmac_f32", "v_mac_f16", "v_mac_f32",
+    "v_mac_legacy_f32", "v_max_f16", "v_max_f32", "v_max_i16", "v_max_i32",
+    "v_max_u16", "v_max_u32", "v_min_f16", "v_min_f32", "v_min_i16", "v_min_i32",
+    "v_min_u16", "v_min_u32", "v_mul_f16", "v_mul_f32", "v_mul_hi_i32_i24",
+    "v_mul_hi_u32_u24", "v_mul_i32_i24", "v_mul_legacy_f32", "v_mul_lo_u16",
+    "v_mul_u32_u24", "v_or_b32", "v_xnor_b32", "v_xor_b32"
+};
+
+// VOP2 instructions and their variants with reversed source operands
+static const std::pair<const char*, const char*> gcnVOP2RevTable[] =
+{
+    { "v_ashr_i32", "v_ashrrev_i32" },
+    { "v_lshl_b32", "v_lshlrev_b32" },
+    { "v_lshr_b32", "v_lshrrev_b32" },
+    { "v_sub_co_ci_u32", "v_subrev_co_ci_u32" },
+    { "v_sub_co_u32", "v_subrev_co_u32" },
+    { "v_sub_f16", "v_subrev_f16" },
+    { "v_sub_f32", "v_subrev_f32" },
+    { "v_sub_i32", "v_subrev_i32" },
+    { "v_sub_nc_u32", "v_subrev_nc_u32" },
+    { "v_sub_u16", "v_subrev_u16" },
+    { "v_sub_u32", "v_subrev_u32" },
+    { "v_subb_co_u32", "v_subbrev_co_u32" },
+    { "v_subb_u32", "v_subbrev_u32" }
+};
+
+// VOPC conditions and conditions for swapped operands (sorted)
+static const std::pair<const char*, const char*> gcnVOPCSwapCondTable[] =
+{
+    { "eq", "eq" }, { "f", "f" }, { "ge", "le" }, { "gt", "lt" }, { "le", "ge" },
+    { "lg", "lg" }, { "lt", "gt" }, { "ne", "ne" }, { "neq", "neq" }, { "nge", "nle" },
+    { "ngt", "nlt" }, { "nle", "nge" }, { "nlg", "nlg" }, { "nlt", "ngt" },
+    { "o", "o" }, { "t", "t" }, { "tru", "tru" }, { "u", "u" }
+};
+
+const GCNAsmInstruction* GCNAsmUtils::findSwappedVOPInstruction(
+            const GCNAsmInstruction& gcnInsn, GPUArchMask arch)
+{
+    const char* mnemonic = gcnInsn.mnemonic;
+    std::string swapped;
+    if (gcnInsn.encoding == GCNENC_VOP2)
+    {
+        if (std::binary_search(gcnVOP2CommutativeTable, gcnVOP2CommutativeTable +
+                    sizeof(gcnVOP2CommutativeTable)/sizeof(const char*), mnemonic,
+                    CStringLess()))
+            return &gcnInsn;
+        for (const auto& entry: gcnVOP2RevTable)
+            if (::strcmp(entry.first, mnemonic)==0)
+                swapped = entry.second;
+            else if (::strcmp(entry.second, mnemonic)==0)
+                swapped = entry.first;
+    }
+    else if (gcnInsn.encoding == GCNENC_VOPC)
+    {
+        // V_CMP{X|S|SX}_COND_TYPE
+        const char* condStart = ::strchr(mnemonic+2, '_');
+        const char* condEnd = (condStart!=nullptr) ? ::strchr(condStart+1, '_') : nullptr;
+        if (::strncmp(mnemonic, "v_cmp", 5)!=0 || condEnd==nullptr)
+            return nullptr;
+        condStart++;
+        const std::string cond(condStart, condEnd);
+        auto it = binaryMapFind(gcnVOPCSwapCondTable, gcnVOPCSwapCondTable +
+                    sizeof(gcnVOPCSwapCondTable)/sizeof(gcnVOPCSwapCondTable[0]),
+                    cond.c_str(), CStringLess());
+        if (it == gcnVOPCSwapCondTable + sizeof(gcnVOPCSwapCondTable) /
+                    sizeof(gcnVOPCSwapCondTable[0]))
+            return nullptr;
+        if (::strcmp(it->first, it->second)==0)
+            return &gcnInsn;
+        swapped = std::string(mnemonic, condStart) + it->second + condEnd;
+    }
+    if (swapped.empty())
+        return nullptr;
+    
+    // find instruction for this architecture
+    auto it = binaryFind(gcnInstrSortedTable.begin(), gcnInstrSortedTable.end(),
+               GCNAsmInstruction{swapped.c_str()},
+               [](const GCNAsmInstruction& instr1, const GCNAsmInstruction& instr2)
+               { return ::strcmp(instr1.mnemonic, instr2.mnemonic)<0; });
+    for (; it != gcnInstrSortedTable.end() && ::strcmp(it->mnemonic, swapped.c_str())==0;
+                ++it)
+        if ((it->archMask & arch)!=0 && it->encoding == gcnInsn.encoding &&
+            it->mode == gcnInsn.mode)
+            return it;
+    return nullptr;
+}
+
 void GCNAssembler::setAllocatedRegisters(const cxuint* inRegs, Flags inRegFlags)
 {
     if (inRegs==nullptr)
@@ -566,6 +658,27 @@ void GCNAssembler::fillAlignment(size_t size, cxbyte* output)
     std::fill((uint32_t*)output, ((uint32_t*)output) + (size>>2), value);
 }
 
+/* GCN 1.0/1.1: jump to dword N (N>=5) in 32-byte block costs N-4 penalties (4 cycles),
+ * hence align label to next 32-byte block by s_nop's (at most 3 dwords).
+ * Only jump targets are aligned: labels used by pending (forward) SOPP jumps,
+ * because labels are resolved in single pass */
+size_t GCNAssembler::getCodeLabelPadding(uint64_t offset, const AsmSymbol& label,
+            cxuint& penaltyCycles) const
+{
+    penaltyCycles = 0;
+    if ((curArchMask & ARCH_GCN_1_0_1)==0 || (offset&3)!=0)
+        return 0;
+    if (std::none_of(label.occurrencesInExprs.begin(), label.occurrencesInExprs.end(),
+            [](const AsmExprSymbolOccurrence& occur)
+            { return occur.expression->getTarget().type == GCNTGT_SOPJMP; }))
+        return 0; // not jump target
+    const cxuint dword = (offset>>2)&7;
+    if (dword < 5)
+        return 0;
+    penaltyCycles = (dword-4)<<2;
+    return (8-dword)<<2;
+}
+
 bool GCNAssembler::parseRegisterRange(const char*& linePtr, cxuint& regStart,
           cxuint& regEnd, const AsmRegVar*& regVar)
 {
@@ -58,10 +58,10 @@ static size_t addSpacesOld(char* bufPtr, cxuint spacesToAdd)
 }
 
 // encoding names table
-static const char* gcnEncodingNames[GCNENC_MAXVAL+1] =
+static const char* gcnEncodingNames[GCNENC_VOP3P+1] =
 {
     "NONE", "SOPC", "SOPP", "SOP1", "SOP2", "SOPK", "SMRD", "VOPC", "VOP1", "VOP2",
-    "VOP3A", "VOP3B", "VINTRP", "DS", "MUBUF", "MTBUF", "MIMG", "EXP", "FLAT"
+    "VOP3A", "VOP3B", "VINTRP", "DS", "MUBUF", "MTBUF", "MIMG", "EXP", "FLAT", "VOP3P"
 };
 
 // table hold of GNC encoding regions in main instruction list
@@ -232,8 +232,8 @@ static void initializeGCNDisassembler()
     }
 }
 
-GCNDisassembler::GCNDisassembler(Disassembler& disassembler)
-        : ISADisassembler(disassembler), instrOutOfCode(false)
+GCNDisassembler::GCNDisassembler(Disassembler& disassembler, cxuint outBufSize)
+        : ISADisassembler(disassembler, outBufSize), instrOutOfCode(false)
 {
     callOnce(clrxGCNDisasmOnceFlag, initializeGCNDisassembler);
 }
@@ -365,7 +365,7 @@ void GCNDisassembler::analyzeBeforeDisassemble()
                         // SOPK
                         const cxuint opcode = (insnCode>>23)&0x1f;
                         if ((!isGCN12 && opcode == 17) ||
-                            (isGCN12 && opcode == 16) || // if branch fork
+                            (isGCN12 && !isGCN15 && opcode == 16) || // if branch fork
                             (isGCN14 && opcode == 21) || // if s_call_b64
                             (isGCN15 && (opcode == 22 ||
                                 opcode == 27 || opcode == 28))) // if s_subvector_loop_*
@@ -596,20 +596,45 @@ static const GCNEncodingOpcodeBits gcnEncodingOpcode15Table[GCNENC_MAXVAL+2] =
     { 16, 7 } /* GCNENC_VOP3P, opcode = (7bit)<<16 */
 };
 
+// get control flow type of instruction (for CFG)
+static DisasmCFGEndType getGCNControlFlowType(cxbyte encoding, cxuint opcode,
+            bool isGCN124, bool isGCN15)
+{
+    const bool isGCN124Only = isGCN124 && !isGCN15;
+    if (encoding == GCNENC_SOPP)
+    {
+        if (opcode == 1 || opcode == 27 || opcode == 30)
+            return DisasmCFGEndType::END; // s_endpgm*
+        if (opcode == 2)
+            return DisasmCFGEndType::JUMP;
+        if ((opcode >= 4 && opcode <= 9) || (opcode >= 23 && opcode <= 26))
+            return DisasmCFGEndType::CJUMP;
+    }
+    else if (encoding == GCNENC_SOPK)
+    {
+        if ((!isGCN124 && opcode == 17) || (isGCN124Only && opcode == 16) ||
+            (isGCN15 && (opcode == 27 || opcode == 28)))
+            return DisasmCFGEndType::CJUMP; // i_fork, s_subvector_loop_*
+        if ((isGCN124Only && opcode == 21) || (isGCN15 && opcode == 22))
+            return DisasmCFGEndType::CALL;
+    }
+    else if (encoding == GCNENC_SOP1)
+    {
+        if (opcode == (isGCN124Only ? 29U : 32U))
+            return DisasmCFGEndType::SETPC;
+        if (opcode == (isGCN124Only ? 30U : 33U))
+            return DisasmCFGEndType::SWAPPC;
+    }
+    return DisasmCFGEndType::FALLTHROUGH;
+}
+
 /* main routine */
 
 void GCNDisassembler::disassemble()
 {
-    // select current label and reloc to first
-    LabelIter curLabel = std::lower_bound(labels.begin(), labels.end(), labelStartOffset);
-    RelocIter curReloc = std::lower_bound(relocations.begin(), relocations.end(),
-        std::make_pair(startOffset, Relocation()),
-          [](const std::pair<size_t,Relocation>& a, const std::pair<size_t, Relocation>& b)
-          { return a.first < b.first; });
-    NamedLabelIter curNamedLabel = std::lower_bound(namedLabels.begin(), namedLabels.end(),
-        std::make_pair(labelStartOffset, CString()),
-          [](const std::pair<size_t,CString>& a, const std::pair<size_t, CString>& b)
-          { return a.first < b.first; });
+    // select current label event (labels and relocations) to first
+    // relocations before startOffset will be skipped by writeLabelsToPosition
+    LabelEventIter curEvent = findLabelEvent(labelStartOffset);
     
     const uint32_t* codeWords = reinterpret_cast<const uint32_t*>(input);
 
@@ -632,10 +657,15 @@ void GCNDisassembler::disassemble()
     
     bool prevIsTwoWord = false;
     
+    // control flow graph collected while decoding
+    const bool doBuildCFG = (disassembler.getFlags() & DISASM_CFG) != 0;
+    std::vector<DisasmCFGInstr> cfgInstrs;
+    std::vector<CFGInstr> cfgCFInstrs;
+    
     size_t pos = 0;
     while (true)
     {
-        writeLabelsToPosition(pos<<2, curLabel, curNamedLabel);
+        writeLabelsToPosition(pos<<2, curEvent);
         if (pos >= codeWordsNum)
             break;
         
@@ -748,8 +778,8 @@ void GCNDisassembler::disassemble()
                     if (isGCN15 && (encPart==3 || encPart==5))
                     {
                         // include VOP3 literal
-                        if ((insnCode2 & 0x1ff) == 0xff || ((insnCode2>>9) & 0x1ff) == 0xff ||
-                            ((insnCode2>>18) & 0x1ff) == 0xff)
+                        if (((insnCode2 & 0x1ff) == 0xff || ((insnCode2>>9) & 0x1ff) == 0xff ||
+                            ((insnCode2>>18) & 0x1ff) == 0xff) && pos < codeWordsNum)
                             insnCode3 = ULEV(codeWords[pos++]);
                     }
                 }
@@ -886,7 +916,7 @@ void GCNDisassembler::disassemble()
         {
             // unknown encoding
             gcnEncoding = GCNENC_NONE;
-            pos--;
+            pos = oldPos+1;
         }
         
         if (gcnEncoding == GCNENC_NONE)
@@ -973,6 +1003,9 @@ void GCNDisassembler::disassemble()
                         (curArchMask & gcnInsn->archMask) == 0)
                     isIllegal = true; // illegal
             }
+            else if ((isGCN14 || isGCN15) && gcnEncoding == GCNENC_FLAT &&
+                ((insnCode>>14)&3)==3)
+                isIllegal = true; // reserved FLAT segment
             else if (isGCN14 && gcnEncoding == GCNENC_FLAT && ((insnCode>>14)&3)!=0)
             {
                 // GLOBAL_/SCRATCH_* instructions
@@ -1036,7 +1069,7 @@ void GCNDisassembler::disassemble()
             switch(gcnEncoding)
             {
                 case GCNENC_SOPC:
-                    GCNDisasmUtils::decodeSOPCEncoding(*this, pos, curReloc,
+                    GCNDisasmUtils::decodeSOPCEncoding(*this, pos, curEvent,
                                spacesToAdd, curArchMask, *gcnInsn, insnCode, insnCode2);
                     break;
                 case GCNENC_SOPP:
@@ -1044,15 +1077,15 @@ void GCNDisassembler::disassemble()
                                  *gcnInsn, insnCode, insnCode2, pos);
                     break;
                 case GCNENC_SOP1:
-                    GCNDisasmUtils::decodeSOP1Encoding(*this, pos, curReloc,
+                    GCNDisasmUtils::decodeSOP1Encoding(*this, pos, curEvent,
                                spacesToAdd, curArchMask, *gcnInsn, insnCode, insnCode2);
                     break;
                 case GCNENC_SOP2:
-                    GCNDisasmUtils::decodeSOP2Encoding(*this, pos, curReloc,
+                    GCNDisasmUtils::decodeSOP2Encoding(*this, pos, curEvent,
                                spacesToAdd, curArchMask, *gcnInsn, insnCode, insnCode2);
                     break;
                 case GCNENC_SOPK:
-                    GCNDisasmUtils::decodeSOPKEncoding(*this, pos, curReloc,
+                    GCNDisasmUtils::decodeSOPKEncoding(*this, pos, curEvent,
                                spacesToAdd, curArchMask, *gcnInsn, insnCode, insnCode2);
                     break;
                 case GCNENC_SMRD:
@@ -1060,25 +1093,25 @@ void GCNDisassembler::disassemble()
                         GCNDisasmUtils::decodeSMEMEncoding(*this, spacesToAdd, curArchMask,
                                   *gcnInsn, insnCode, insnCode2);
                     else
-                        GCNDisasmUtils::decodeSMRDEncoding(*this, pos, curReloc,
+                        GCNDisasmUtils::decodeSMRDEncoding(*this, pos, curEvent,
                                 spacesToAdd, curArchMask, *gcnInsn, insnCode, insnCode2);
                     break;
                 case GCNENC_VOPC:
-                    GCNDisasmUtils::decodeVOPCEncoding(*this, pos, curReloc, spacesToAdd,
+                    GCNDisasmUtils::decodeVOPCEncoding(*this, pos, curEvent, spacesToAdd,
                            curArchMask, *gcnInsn, insnCode, insnCode2, displayFloatLits,
                            disassembler.getFlags());
                     break;
                 case GCNENC_VOP1:
-                    GCNDisasmUtils::decodeVOP1Encoding(*this, pos, curReloc, spacesToAdd,
+                    GCNDisasmUtils::decodeVOP1Encoding(*this, pos, curEvent, spacesToAdd,
                            curArchMask, *gcnInsn, insnCode, insnCode2, displayFloatLits);
                     break;
                 case GCNENC_VOP2:
-                    GCNDisasmUtils::decodeVOP2Encoding(*this, pos, curReloc, spacesToAdd,
+                    GCNDisasmUtils::decodeVOP2Encoding(*this, pos, curEvent, spacesToAdd,
                            curArchMask, *gcnInsn, insnCode, insnCode2, displayFloatLits,
                            disassembler.getFlags());
                     break;
                 case GCNENC_VOP3A:
-                    GCNDisasmUtils::decodeVOP3Encoding(*this, pos, curReloc,
+                    GCNDisasmUtils::decodeVOP3Encoding(*this, pos, curEvent,
                             spacesToAdd, curArchMask, *gcnInsn, insnCode, insnCode2,
                             insnCode3, displayFloatLits, disassembler.getFlags());
                     break;
@@ -1086,7 +1119,7 @@ void GCNDisassembler::disassemble()
                     GCNInstruction newInsn = *gcnInsn;
                     newInsn.encoding = GCNENC_VOP3A;
                     newInsn.mode |= GCN_VOP3_VOP3P;
-                    GCNDisasmUtils::decodeVOP3Encoding(*this, pos, curReloc,
+                    GCNDisasmUtils::decodeVOP3Encoding(*this, pos, curEvent,
                             spacesToAdd, curArchMask, newInsn, insnCode, insnCode2,
                             insnCode3, displayFloatLits, disassembler.getFlags());
                     break;
@@ -1127,11 +1160,26 @@ void GCNDisassembler::disassemble()
                 default:
                     break;
             }
+            if (doBuildCFG && !isIllegal)
+            {
+                cfgInstrs.push_back({ oldPos<<2, gcnInsn->mnemonic, gcnEncoding,
+                        cxbyte((std::min(pos, codeWordsNum)-oldPos)<<2), insnCode });
+                const DisasmCFGEndType cfType = getGCNControlFlowType(gcnEncoding,
+                            opcode, isGCN124, isGCN15);
+                if (cfType != DisasmCFGEndType::FALLTHROUGH)
+                    cfgCFInstrs.push_back({ oldPos<<2, cfType, startOffset +
+                            ((oldPos+int16_t(insnCode&0xffff)+1)<<2) });
+            }
+            else if (doBuildCFG)
+                cfgInstrs.push_back({ oldPos<<2, nullptr, gcnEncoding,
+                        cxbyte((std::min(pos, codeWordsNum)-oldPos)<<2), insnCode });
         }
         output.put('\n');
     }
+    if (doBuildCFG)
+        buildCFG(cfgInstrs, cfgCFInstrs);
     if (!dontPrintLabelsAfterCode)
-        writeLabelsToEnd(codeWordsNum<<2, curLabel, curNamedLabel);
+        writeLabelsToEnd(codeWordsNum<<2, curEvent);
     output.flush();
     disassembler.getOutput().flush();
 }
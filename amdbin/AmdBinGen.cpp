@@ -19,6 +19,7 @@
 
 #include <CLRX/Config.h>
 #include <cassert>
+#include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <cstdint>
@@ -1592,8 +1593,8 @@ static std::vector<cxuint> collectUniqueIdsAndFunctionIds(const AmdInput* input)
  * this routine keep original structure of GPU binary (section order, alignment etc)
  */
 
-void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr) const
+void AmdGPUBinGenerator::generateBinary(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* templateOut) const
 {
     const size_t kernelsNum = input->kernels.size();
     CString driverInfo;
@@ -1833,29 +1834,34 @@ void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    // size of binary is known, so binary is written directly to array or vector
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-            new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize,
+                    reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
-    else // from argument
+    else
+    {
+        // from argument
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(4096, *os));
+    }
+    FastOutputBuffer& fob = *outBufHolder;
     
-    const std::ios::iostate oldExceptions = os->exceptions();
-    FastOutputBuffer fob(256, *os);
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-        os->exceptions(std::ios::failbit | std::ios::badbit);
+        if (os != nullptr)
+            os->exceptions(std::ios::failbit | std::ios::badbit);
         if (input->is64Bit)
             elfBinGen64->generate(fob);
         else
@@ -1863,27 +1869,161 @@ void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
     assert(fob.getWritten() == binarySize);
+    
+    if (templateOut != nullptr)
+        // code is in '.text' (6th region) of inner binaries
+        for (size_t i = 0; i < kernelsNum; i++)
+        {
+            const ElfBinaryGen32& kelfBinGen = tempAmdKernelDatas[i].elfBinGen;
+            templateOut->addCodePlace(i, 0, kelfBinGen.getRegionOutputOffset(5),
+                    input->kernels[i].codeSize);
+            templateOut->addSizePlace(i, kelfBinGen.getSectionHeaderOutputOffset(5) +
+                    offsetof(Elf32_Shdr, sh_size), 4);
+        }
+}
+
+// compute key of template from non-code input
+static uint64_t getAmdInputKey(const AmdInput& input)
+{
+    BinaryTemplate::KeyHasher hasher;
+    hasher.updateValue(input.is64Bit);
+    hasher.updateValue(input.deviceType);
+    hasher.updateData(input.globalDataSize, input.globalData);
+    hasher.updateValue(input.driverVersion);
+    hasher.updateString(input.compileOptions);
+    hasher.updateString(input.driverInfo);
+    hasher.updateValue(uint64_t(input.kernels.size()));
+    for (const AmdKernelInput& kernel: input.kernels)
+    {
+        hasher.updateString(kernel.kernelName);
+        hasher.updateData(kernel.dataSize, kernel.data);
+        hasher.updateData(kernel.headerSize, kernel.header);
+        hasher.updateData(kernel.metadataSize, kernel.metadata);
+        hasher.updateValue(uint64_t(kernel.calNotes.size()));
+        for (const CALNoteInput& calNote: kernel.calNotes)
+        {
+            hasher.updateValue(calNote.header);
+            hasher.updateData(calNote.header.descSize, calNote.data);
+        }
+        hasher.updateValue(kernel.useConfig);
+        if (kernel.useConfig)
+        {
+            const AmdKernelConfig& config = kernel.config;
+            hasher.updateValue(uint64_t(config.args.size()));
+            for (const AmdKernelArgInput& arg: config.args)
+            {
+                hasher.updateString(arg.argName);
+                hasher.updateString(arg.typeName);
+                hasher.updateValue(arg.argType);
+                hasher.updateValue(arg.pointerType);
+                hasher.updateValue(arg.ptrSpace);
+                hasher.updateValue(arg.ptrAccess);
+                hasher.updateValue(arg.structSize);
+                hasher.updateValue(uint64_t(arg.constSpaceSize));
+                hasher.updateValue(arg.resId);
+                hasher.updateValue(arg.used);
+            }
+            hasher.updateData(config.samplers.size()*sizeof(cxuint),
+                        config.samplers.data());
+            hasher.updateValue(config.dimMask);
+            hasher.updateValue(config.reqdWorkGroupSize);
+            hasher.updateValue(config.usedVGPRsNum);
+            hasher.updateValue(config.usedSGPRsNum);
+            hasher.updateValue(config.pgmRSRC2);
+            hasher.updateValue(config.floatMode);
+            hasher.updateValue(uint64_t(config.hwLocalSize));
+            hasher.updateValue(config.hwRegion);
+            hasher.updateValue(config.scratchBufferSize);
+            hasher.updateValue(config.uavPrivate);
+            hasher.updateValue(config.uavId);
+            hasher.updateValue(config.constBufferId);
+            hasher.updateValue(config.printfId);
+            hasher.updateValue(config.privateId);
+            hasher.updateValue(config.earlyExit);
+            hasher.updateValue(config.condOut);
+            hasher.updateValue(config.ieeeMode);
+            hasher.updateValue(config.exceptions);
+            hasher.updateValue(config.tgSize);
+            hasher.updateValue(config.usePrintf);
+            hasher.updateValue(config.useConstantData);
+            hasher.updateValue(uint64_t(config.userDatas.size()));
+            for (const AmdUserData& userData: config.userDatas)
+                hasher.updateValue(userData);
+        }
+        hasher.updateSections(kernel.extraSections);
+        hasher.updateSymbols(kernel.extraSymbols);
+    }
+    hasher.updateSections(input.extraSections);
+    hasher.updateSymbols(input.extraSymbols);
+    return hasher.getKey();
+}
+
+void AmdGPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* binTemplate) const
+{
+    if (binTemplate == nullptr)
+    {
+        generateBinary(osPtr, vPtr, aPtr, nullptr);
+        return;
+    }
+    std::vector<BinaryTemplate::Code> codes(input->kernels.size());
+    for (size_t i = 0; i < codes.size(); i++)
+        codes[i] = { input->kernels[i].codeSize, input->kernels[i].code };
+    const uint64_t key = getAmdInputKey(*input);
+    if (!binTemplate->matches(key, codes))
+    {
+        // generate new template from input with codes padded to their capacities
+        binTemplate->prepare(key, codes);
+        AmdInput paddedInput = *input;
+        for (size_t i = 0; i < codes.size(); i++)
+        {
+            paddedInput.kernels[i].codeSize = binTemplate->getCodeCapacity(i);
+            paddedInput.kernels[i].code = binTemplate->getPaddedCode(i);
+        }
+        AmdGPUBinGenerator(&paddedInput).generateBinary(nullptr, nullptr,
+                    &binTemplate->getBinary(), binTemplate);
+        binTemplate->setPrepared();
+    }
+    binTemplate->write(codes, osPtr, vPtr, aPtr);
 }
 
 
 void AmdGPUBinGenerator::generate(Array<cxbyte>& array) const
 {
-    generateInternal(nullptr, nullptr, &array);
+    generateInternal(nullptr, nullptr, &array, nullptr);
 }
 
 void AmdGPUBinGenerator::generate(std::ostream& os) const
 {
-    generateInternal(&os, nullptr, nullptr);
+    generateInternal(&os, nullptr, nullptr, nullptr);
 }
 
 void AmdGPUBinGenerator::generate(std::vector<char>& vector) const
 {
-    generateInternal(nullptr, &vector, nullptr);
+    generateInternal(nullptr, &vector, nullptr, nullptr);
+}
+
+void AmdGPUBinGenerator::generate(Array<cxbyte>& array, BinaryTemplate& binTemplate) const
+{
+    generateInternal(nullptr, nullptr, &array, &binTemplate);
+}
+
+void AmdGPUBinGenerator::generate(std::ostream& os, BinaryTemplate& binTemplate) const
+{
+    generateInternal(&os, nullptr, nullptr, &binTemplate);
+}
+
+void AmdGPUBinGenerator::generate(std::vector<char>& vector,
+            BinaryTemplate& binTemplate) const
+{
+    generateInternal(nullptr, &vector, nullptr, &binTemplate);
 }
 
 static const char* amdOclMagicString = "AMD-APP";
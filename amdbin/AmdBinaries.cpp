@@ -616,13 +616,22 @@ AmdMainBinaryBase::AmdMainBinaryBase(AmdMainType _type) : type(_type)
 AmdMainBinaryBase::~AmdMainBinaryBase()
 { }
 
+void AmdMainBinaryBase::parseKernelInfo(size_t index) const
+{ }
+
+void AmdMainBinaryBase::initKernelInfo(size_t index) const
+{
+    callOnce(kernelInfoOnceFlags[index], [this, index]()
+            { parseKernelInfo(index); });
+}
+
 const KernelInfo& AmdMainBinaryBase::getKernelInfo(const char* name) const
 {
     KernelInfoMap::const_iterator it = binaryMapFind(
         kernelInfosMap.begin(), kernelInfosMap.end(), name);
     if (it == kernelInfosMap.end())
         throw BinException("Can't find kernel name");
-    return kernelInfos[it->second];
+    return getKernelInfo(it->second);
 }
 
 static const cxuint vectorIdTable[17] =
@@ -1110,9 +1119,42 @@ struct CLRX_INTERNAL AmdGPU64Types: Elf64Types
 };
 
 AmdMainGPUBinaryBase::AmdMainGPUBinaryBase(AmdMainType type)
-        : AmdMainBinaryBase(type), metadatas(nullptr), globalDataSize(0), globalData(0)
+        : AmdMainBinaryBase(type), innerCreationFlags(0), metadatas(nullptr),
+          globalDataSize(0), globalData(0)
 { }
 
+// get kernel name from inner binary symbol name ('__OpenCL_' + name + '_kernel')
+static inline CString getInnerBinaryKernelName(const char* symName)
+{ return CString(symName+9, ::strlen(symName)-16); }
+
+// get kernel name from metadata symbol name ('__OpenCL_' + name + '_metadata')
+static inline CString getMetadataKernelName(const char* symName)
+{ return CString(symName+9, ::strlen(symName)-18); }
+
+CString AmdMainGPUBinaryBase::getKernelInfoName(size_t index) const
+{
+    if (kernelInfoOnceFlags)
+        return getMetadataKernelName(lazyMetadataSymNames[index]);
+    return kernelInfos[index].kernelName;
+}
+
+void AmdMainGPUBinaryBase::parseKernelInfo(size_t index) const
+{
+    parseAmdGpuKernelMetadata(lazyMetadataSymNames[index], metadatas[index].size,
+                metadatas[index].data, kernelInfos[index]);
+}
+
+void AmdMainGPUBinaryBase::initInnerBinary(size_t index) const
+{
+    callOnce(innerBinaryOnceFlags[index], [this, index]()
+    {
+        const LazyEntry& entry = lazyInnerBinaries[index];
+        innerBinaries[index] = AmdInnerGPUBinary32(
+                getInnerBinaryKernelName(entry.symName), entry.size, entry.data,
+                innerCreationFlags);
+    });
+}
+
 template<typename Types>
 void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
 {
@@ -1131,6 +1173,7 @@ void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
     const bool doKernelHeaders = (creationFlags & AMDBIN_CREATE_KERNELHEADERS) != 0;
     const bool doKernelInfo = (creationFlags & AMDBIN_CREATE_KERNELINFO) != 0;
     const bool doInfoStrings = (creationFlags & AMDBIN_CREATE_INFOSTRINGS) != 0;
+    const bool lazy = (creationFlags & AMDBIN_CREATE_LAZY) != 0;
     size_t compileOptionsEnd = 0;
     uint16_t compileOptionShIndex = SHN_UNDEF;
     
@@ -1206,18 +1249,24 @@ void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
     }
     
     innerBinaries.resize(choosenSyms.size());
+    innerCreationFlags = (creationFlags >> AMDBIN_INNER_SHIFT) &
+                AMDBIN_INNER_INT_CREATE_ALL;
     
     if (textIndex != SHN_UNDEF) /* if have ".text" */
     {
         const typename Types::Shdr& textHdr = mainElf.getSectionHeader(textIndex);
         cxbyte* textContent = mainElf.getBinaryCode() + ULEV(textHdr.sh_offset);
         
+        if (lazy)
+        {
+            lazyInnerBinaries.resize(choosenSyms.size());
+            innerBinaryOnceFlags.reset(new OnceFlag[choosenSyms.size()]);
+        }
         /* create table of innerBinaries */
         size_t ki = 0;
         for (auto it: choosenSyms)
         {
             const char* symName = mainElf.getSymbolName(it);
-            size_t len = ::strlen(symName);
             const typename Types::Sym& sym = mainElf.getSymbol(it);
             
             const typename Types::Word symvalue = ULEV(sym.st_value);
@@ -1227,15 +1276,21 @@ void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
             if (usumGt(symvalue, symsize, ULEV(textHdr.sh_size)))
                 throw BinException("Inner binary offset+size out of range!");
             
-            innerBinaries[ki++] = AmdInnerGPUBinary32(CString(symName+9, len-16),
-                symsize, textContent+symvalue,
-                (creationFlags >> AMDBIN_INNER_SHIFT) & AMDBIN_INNER_INT_CREATE_ALL);
+            if (lazy)
+                // inner binary will be parsed at first access
+                lazyInnerBinaries[ki++] = { symName, symsize, textContent+symvalue };
+            else
+                innerBinaries[ki++] = AmdInnerGPUBinary32(
+                        getInnerBinaryKernelName(symName), symsize, textContent+symvalue,
+                        innerCreationFlags);
         }
         if ((creationFlags & AMDBIN_CREATE_INNERBINMAP) != 0)
         {
             innerBinaryMap.resize(innerBinaries.size());
             for (size_t i = 0; i < innerBinaries.size(); i++)
-                innerBinaryMap[i] = std::make_pair(innerBinaries[i].getKernelName(), i);
+                innerBinaryMap[i] = std::make_pair(lazy ?
+                        getInnerBinaryKernelName(lazyInnerBinaries[i].symName) :
+                        innerBinaries[i].getKernelName(), i);
             mapSort(innerBinaryMap.begin(), innerBinaryMap.end());
         }
     }
@@ -1244,6 +1299,11 @@ void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
     {
         kernelInfos.resize(choosenSymsMetadata.size());
         metadatas.reset(new AmdGPUKernelMetadata[kernelInfos.size()]);
+        if (lazy)
+        {
+            lazyMetadataSymNames.resize(kernelInfos.size());
+            kernelInfoOnceFlags.reset(new OnceFlag[kernelInfos.size()]);
+        }
         
         typename Types::Size ki = 0;
         for (typename Types::Size it: choosenSymsMetadata)
@@ -1265,10 +1325,14 @@ void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
             if (usumGt(symvalue, symsize, ULEV(rodataHdr.sh_size)))
                 throw BinException("Metadata offset+size out of range");
             
-            // parse AMDGPU kernel metadata
-            parseAmdGpuKernelMetadata(symName, symsize,
-                  reinterpret_cast<const char*>(secContent + symvalue),
-                  kernelInfos[ki]);
+            if (lazy)
+                // kernel metadata will be parsed at first access
+                lazyMetadataSymNames[ki] = symName;
+            else
+                // parse AMDGPU kernel metadata
+                parseAmdGpuKernelMetadata(symName, symsize,
+                      reinterpret_cast<const char*>(secContent + symvalue),
+                      kernelInfos[ki]);
             metadatas[ki].size = symsize;
             metadatas[ki].data = reinterpret_cast<char*>(secContent + symvalue);
             ki++;
@@ -1278,7 +1342,9 @@ void AmdMainGPUBinaryBase::initMainGPUBinary(typename Types::ElfBinary& mainElf)
         {
             kernelInfosMap.resize(kernelInfos.size());
             for (size_t i = 0; i < kernelInfos.size(); i++)
-                kernelInfosMap[i] = std::make_pair(kernelInfos[i].kernelName, i);
+                kernelInfosMap[i] = std::make_pair(lazy ?
+                        getMetadataKernelName(lazyMetadataSymNames[i]) :
+                        kernelInfos[i].kernelName, i);
             mapSort(kernelInfosMap.begin(), kernelInfosMap.end());
         }
     }
@@ -1330,7 +1396,7 @@ const AmdInnerGPUBinary32& AmdMainGPUBinaryBase::getInnerBinary(const char* name
                   innerBinaryMap.end(), name);
     if (it == innerBinaryMap.end())
         throw BinException("Can't find inner binary");
-    return innerBinaries[it->second];
+    return getInnerBinary(it->second);
 }
 
 const AmdGPUKernelHeader& AmdMainGPUBinaryBase::getKernelHeaderEntry(
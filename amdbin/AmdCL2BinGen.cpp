@@ -18,6 +18,7 @@
  */
 
 #include <CLRX/Config.h>
+#include <cstddef>
 #include <cstring>
 #include <cstdint>
 #include <cassert>
@@ -949,14 +950,15 @@ private:
     const CString& aclVersion;
     const uint16_t* mainSectTable;
     ElfBinSectId extraSectionIndex;
+    BinaryTemplate* templateOut;
 public:
     CL2MainSymTabGen(const AmdCL2Input* _input,
              const Array<TempAmdCL2KernelData>& _tempDatas,
              const CString& _aclVersion, const uint16_t* _mainSectTable,
-             ElfBinSectId _extraSectionIndex)
+             ElfBinSectId _extraSectionIndex, BinaryTemplate* _templateOut)
              : input(_input), withBrig(false), tempDatas(_tempDatas),
                aclVersion(_aclVersion), mainSectTable(_mainSectTable),
-               extraSectionIndex(_extraSectionIndex)
+               extraSectionIndex(_extraSectionIndex), templateOut(_templateOut)
     {
         for (brigIndex = 0; brigIndex < input->extraSections.size(); brigIndex++)
         {
@@ -1042,6 +1044,10 @@ public:
                 sym.st_other = 0;
                 nameOffset += 16 + kernel.kernelName.size() + 15;
                 textPos += tempData.stubSize+tempData.setupSize+tempData.codeSize;
+                if (templateOut != nullptr)
+                    // size of kernel binary depends on code size
+                    templateOut->addSizePlace(i, fob.getWritten() +
+                            offsetof(typename Types::Sym, st_size), sizeof(sym.st_size));
                 fob.writeObject(sym);
                 // put ISA metadata symbol
                 SLEV(sym.st_name, nameOffset);
@@ -1939,11 +1945,13 @@ private:
     const AmdCL2Input* input;
     const Array<TempAmdCL2KernelData>& tempDatas;
     ElfBinaryGen64* innerBinGen;
+    BinaryTemplate* templateOut;
 public:
     explicit CL2MainTextGen(const AmdCL2Input* _input,
             const Array<TempAmdCL2KernelData>& _tempDatas,
-            ElfBinaryGen64* _innerBinGen) : input(_input), tempDatas(_tempDatas),
-            innerBinGen(_innerBinGen)
+            ElfBinaryGen64* _innerBinGen, BinaryTemplate* _templateOut)
+            : input(_input), tempDatas(_tempDatas), innerBinGen(_innerBinGen),
+              templateOut(_templateOut)
     { }
     
     size_t size() const
@@ -1982,6 +1990,8 @@ public:
                     generateKernelSetup(arch, kernel.config, fob, false,
                                 tempData.useLocals, tempData.pipesUsed!=0, input->is64Bit,
                                 input->driverVersion);
+                if (templateOut != nullptr)
+                    templateOut->addCodePlace(i, 0, fob.getWritten(), kernel.codeSize);
                 fob.writeArray(kernel.codeSize, kernel.code);
             }
         }
@@ -1993,12 +2003,22 @@ class CLRX_INTERNAL CL2InnerTextGen: public ElfRegionContent
 private:
     const AmdCL2Input* input;
     const Array<TempAmdCL2KernelData>& tempDatas;
+    BinaryTemplate* templateOut;
 public:
     explicit CL2InnerTextGen(const AmdCL2Input* _input,
-                const Array<TempAmdCL2KernelData>& _tempDatas) : input(_input),
-                tempDatas(_tempDatas)
+                const Array<TempAmdCL2KernelData>& _tempDatas,
+                BinaryTemplate* _templateOut) : input(_input),
+                tempDatas(_tempDatas), templateOut(_templateOut)
     { }
     
+    // add place of part of main code (id of main code is kernels number)
+    void addMainCodePlace(FastOutputBuffer& fob, size_t codeOffset, size_t size) const
+    {
+        if (templateOut != nullptr)
+            templateOut->addCodePlace(input->kernels.size(), codeOffset,
+                        fob.getWritten(), size);
+    }
+    
     size_t size() const
     {
         if (input->code != nullptr)
@@ -2036,6 +2056,7 @@ public:
                 const size_t kindex = sortedKIndices[ki];
                 const AmdCL2KernelInput& kernel = input->kernels[kindex];
                 const TempAmdCL2KernelData& tempData = tempDatas[kindex];
+                addMainCodePlace(fob, curOffset, kernel.offset - curOffset);
                 fob.writeArray(kernel.offset - curOffset, input->code + curOffset);
                 
                 // write kernel setup
@@ -2044,8 +2065,11 @@ public:
                     if (kernel.setup != nullptr)
                         fob.writeArray(tempData.setupSize, kernel.setup);
                     else
+                    {
                         // no changes if no setup supplied
+                        addMainCodePlace(fob, kernel.offset, tempData.setupSize);
                         fob.writeArray(tempData.setupSize, input->code + kernel.offset);
+                    }
                 }
                 else
                     generateKernelSetup(arch, kernel.config, fob, true, tempData.useLocals,
@@ -2053,6 +2077,7 @@ public:
                 curOffset = kernel.offset + tempData.setupSize;
             }
             // if HSA layout (code is set)
+            addMainCodePlace(fob, curOffset, input->codeSize - curOffset);
             fob.writeArray(input->codeSize - curOffset, input->code + curOffset);
             return;
         }
@@ -2073,6 +2098,8 @@ public:
             else
                 generateKernelSetup(arch, kernel.config, fob, true, tempData.useLocals,
                             tempData.pipesUsed!=0, input->is64Bit, input->driverVersion);
+            if (templateOut != nullptr)
+                templateOut->addCodePlace(i, 0, fob.getWritten(), tempData.codeSize);
             fob.writeArray(tempData.codeSize, kernel.code);
             outSize += tempData.setupSize + tempData.codeSize;
         }
@@ -2330,7 +2357,7 @@ static CString constructName(size_t prefixSize, const char* prefix, const CStrin
 static void putInnerSymbols(ElfBinaryGen64& innerBinGen, const AmdCL2Input* input,
         const Array<TempAmdCL2KernelData>& tempDatas, const uint16_t* builtinSectionTable,
         ElfBinSectId extraSeciontIndex, std::vector<CString>& stringPool,
-        size_t dataSymbolsNum)
+        size_t dataSymbolsNum, std::vector<size_t>& kernelSymIndices)
 {
     const size_t samplersNum = (input->samplerConfig) ? input->samplers.size() :
                 (input->samplerInitSize>>3);
@@ -2346,6 +2373,8 @@ static void putInnerSymbols(ElfBinaryGen64& innerBinGen, const AmdCL2Input* inpu
                 AMDCL2SECTID_SAMPLERINIT-ELFSECTID_START];
     const uint16_t bssSectId = builtinSectionTable[ELFSECTID_BSS-ELFSECTID_START];
     stringPool.resize(input->kernels.size() + samplersNum + dataSymbolsNum);
+    kernelSymIndices.resize(input->kernels.size());
+    // nameIdx is also index of next symbol
     size_t nameIdx = 0;
     
     /* put data symbols */
@@ -2395,6 +2424,7 @@ static void putInnerSymbols(ElfBinaryGen64& innerBinGen, const AmdCL2Input* inpu
         // put kernel symbol
         stringPool[nameIdx] = constructName(10, "&__OpenCL_", kernel.kernelName,
                         7, "_kernel");
+        kernelSymIndices[i] = nameIdx;
         
         innerBinGen.addSymbol(ElfSymbol64(stringPool[nameIdx].c_str(), textSectId,
                   ELF64_ST_INFO(STB_GLOBAL, 10), 0, false, codePos, 
@@ -2444,8 +2474,8 @@ static void putInnerSymbols(ElfBinaryGen64& innerBinGen, const AmdCL2Input* inpu
 }
 
 /// main routine to generate OpenCL 2.0 binary
-void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr) const
+void AmdCL2GPUBinGenerator::generateBinary(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* templateOut) const
 {
     const size_t kernelsNum = input->kernels.size();
     const bool newBinaries = input->driverVersion >= 191205;
@@ -2560,13 +2590,13 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
     // initializing content generators
     CL2MainStrTabGen mainStrTabGen(input);
     CL2MainSymTabGen<Elf32Types> mainSymTabGen32(input, tempDatas, aclVersion,
-                     mainSectTable, mainExtraSectionIndex);
+                     mainSectTable, mainExtraSectionIndex, templateOut);
     CL2MainSymTabGen<Elf64Types> mainSymTabGen64(input, tempDatas, aclVersion,
-                     mainSectTable, mainExtraSectionIndex);
+                     mainSectTable, mainExtraSectionIndex, templateOut);
     CL2MainCommentGen mainCommentGen(input, aclVersion);
     CL2MainRodataGen<AmdCL2Types32> mainRodataGen32(input, tempDatas);
     CL2MainRodataGen<AmdCL2Types64> mainRodataGen64(input, tempDatas);
-    CL2InnerTextGen innerTextGen(input, tempDatas);
+    CL2InnerTextGen innerTextGen(input, tempDatas, templateOut);
     CL2InnerGlobalDataGen innerGDataGen(input);
     CL2InnerSamplerInitGen innerSamplerInitGen(input);
     CL2InnerTextRelsGen innerTextRelsGen(input, tempDatas, dataSymbolsNum);
@@ -2603,6 +2633,8 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
     }
     
     std::unique_ptr<ElfBinaryGen64> innerBinGen;
+    cxuint innerTextRegion = 0;
+    std::vector<size_t> innerKernelSymIndices;
     std::vector<CString> symbolNamePool;
     std::unique_ptr<cxbyte[]> noteBuf;
     if (newBinaries)
@@ -2803,7 +2835,8 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
         
         if (kernelsNum != 0)
             putInnerSymbols(*innerBinGen, input, tempDatas, innerBinSectionTable,
-                        extraSectionIndex, symbolNamePool, dataSymbolsNum);
+                        extraSectionIndex, symbolNamePool, dataSymbolsNum,
+                        innerKernelSymIndices);
         
         for (const BinSection& section: input->innerExtraSections)
             innerBinGen->addRegion(ElfRegion64(section, innerBinSectionTable,
@@ -2843,10 +2876,11 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
             uint32_t phFlags = (is16_3Ver) ? (PF_X|PF_R) : (PF_R|PF_W);
             innerBinGen->addProgramHeader({ PT_LOOS+3, phFlags, textSectionReg, 1,
                     true, 0, Elf64Types::nobase, 0 });
+            innerTextRegion = textSectionReg;
         }
     }
     
-    CL2MainTextGen mainTextGen(input, tempDatas, innerBinGen.get());
+    CL2MainTextGen mainTextGen(input, tempDatas, innerBinGen.get(), templateOut);
     uint64_t binarySize;
     if (input->is64Bit)
     {
@@ -2884,54 +2918,269 @@ void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<ch
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    // size of binary is known, so binary is written directly to array or vector
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-            new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize,
+                    reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
-    else // from argument
+    else
+    {
+        // from argument
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(4096, *os));
+    }
+    FastOutputBuffer& fob = *outBufHolder;
     
-    const std::ios::iostate oldExceptions = os->exceptions();
-    FastOutputBuffer fob(256, *os);
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-        os->exceptions(std::ios::failbit | std::ios::badbit);
+        if (os != nullptr)
+            os->exceptions(std::ios::failbit | std::ios::badbit);
         if (input->is64Bit)
             elfBinGen64->generate(fob);
         else
             elfBinGen32->generate(fob);
+        if (templateOut != nullptr && kernelsNum != 0)
+        {
+            // code size of last kernel (or main code) determines size of text
+            const size_t lastCodeId = (newBinaries && input->code != nullptr) ?
+                        kernelsNum : kernelsNum-1;
+            if (newBinaries)
+            {
+                templateOut->addSizePlace(lastCodeId,
+                        innerBinGen->getSectionHeaderOutputOffset(innerTextRegion) +
+                        offsetof(Elf64_Shdr, sh_size), 8);
+                for (size_t i = 0; i < kernelsNum; i++)
+                    templateOut->addSizePlace(i, innerBinGen->getSymbolOutputOffset(
+                            innerKernelSymIndices[i]) + offsetof(Elf64_Sym, st_size), 8);
+            }
+            // old binaries: main '.text' (after '.rodata') holds kernel codes
+            else if (input->is64Bit)
+                templateOut->addSizePlace(lastCodeId,
+                        elfBinGen64->getSectionHeaderOutputOffset(5) +
+                        offsetof(Elf64_Shdr, sh_size), 8);
+            else
+                templateOut->addSizePlace(lastCodeId,
+                        elfBinGen32->getSectionHeaderOutputOffset(5) +
+                        offsetof(Elf32_Shdr, sh_size), 4);
+        }
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
     assert(fob.getWritten() == binarySize);
 }
 
+// compute key of template from non-code input
+static uint64_t getAmdCL2InputKey(const AmdCL2Input& input)
+{
+    BinaryTemplate::KeyHasher hasher;
+    hasher.updateValue(input.is64Bit);
+    hasher.updateValue(input.deviceType);
+    hasher.updateValue(input.archMinor);
+    hasher.updateValue(input.archStepping);
+    hasher.updateData(input.globalDataSize, input.globalData);
+    hasher.updateData(input.rwDataSize, input.rwData);
+    // layout depends on presence of main code (HSA layout)
+    hasher.updateValue(cxbyte(input.code != nullptr));
+    hasher.updateValue(uint64_t(input.relocations.size()));
+    for (const AmdCL2RelInput& rel: input.relocations)
+    {
+        hasher.updateValue(uint64_t(rel.offset));
+        hasher.updateValue(rel.type);
+        hasher.updateValue(rel.symbol);
+        hasher.updateValue(uint64_t(rel.addend));
+    }
+    hasher.updateValue(uint64_t(input.bssAlignment));
+    hasher.updateValue(uint64_t(input.bssSize));
+    hasher.updateData(input.samplerInitSize, input.samplerInit);
+    hasher.updateValue(input.samplerConfig);
+    hasher.updateData(input.samplers.size()*sizeof(uint32_t), input.samplers.data());
+    hasher.updateValue(uint64_t(input.samplerOffsets.size()));
+    for (size_t offset: input.samplerOffsets)
+        hasher.updateValue(uint64_t(offset));
+    hasher.updateValue(input.driverVersion);
+    hasher.updateString(input.compileOptions);
+    hasher.updateString(input.aclVersion);
+    hasher.updateValue(uint64_t(input.kernels.size()));
+    for (const AmdCL2KernelInput& kernel: input.kernels)
+    {
+        hasher.updateString(kernel.kernelName);
+        hasher.updateData(kernel.stubSize, kernel.stub);
+        hasher.updateData(kernel.setupSize, kernel.setup);
+        hasher.updateData(kernel.metadataSize, kernel.metadata);
+        hasher.updateData(kernel.isaMetadataSize, kernel.isaMetadata);
+        hasher.updateValue(kernel.useConfig);
+        hasher.updateValue(kernel.hsaConfig);
+        if (kernel.useConfig)
+        {
+            const AmdCL2KernelConfig& config = kernel.config;
+            hasher.updateValue(uint64_t(config.args.size()));
+            for (const AmdKernelArgInput& arg: config.args)
+            {
+                hasher.updateString(arg.argName);
+                hasher.updateString(arg.typeName);
+                hasher.updateValue(arg.argType);
+                hasher.updateValue(arg.pointerType);
+                hasher.updateValue(arg.ptrSpace);
+                hasher.updateValue(arg.ptrAccess);
+                hasher.updateValue(arg.structSize);
+                hasher.updateValue(uint64_t(arg.constSpaceSize));
+                hasher.updateValue(arg.resId);
+                hasher.updateValue(arg.used);
+            }
+            hasher.updateData(config.samplers.size()*sizeof(cxuint),
+                        config.samplers.data());
+            hasher.updateValue(config.dimMask);
+            hasher.updateValue(config.reqdWorkGroupSize);
+            hasher.updateValue(config.usedVGPRsNum);
+            hasher.updateValue(config.usedSGPRsNum);
+            hasher.updateValue(config.pgmRSRC1);
+            hasher.updateValue(config.pgmRSRC2);
+            hasher.updateValue(config.floatMode);
+            hasher.updateValue(config.priority);
+            hasher.updateValue(uint64_t(config.localSize));
+            hasher.updateValue(config.gdsSize);
+            hasher.updateValue(config.scratchBufferSize);
+            hasher.updateValue(config.ieeeMode);
+            hasher.updateValue(config.exceptions);
+            hasher.updateValue(config.tgSize);
+            hasher.updateValue(config.debugMode);
+            hasher.updateValue(config.privilegedMode);
+            hasher.updateValue(config.dx10Clamp);
+            hasher.updateValue(config.useSetup);
+            hasher.updateValue(config.useArgs);
+            hasher.updateValue(config.useEnqueue);
+            hasher.updateValue(config.useGeneric);
+            hasher.updateString(config.vecTypeHint);
+            hasher.updateValue(config.workGroupSizeHint);
+        }
+        hasher.updateValue(uint64_t(kernel.relocations.size()));
+        for (const AmdCL2RelInput& rel: kernel.relocations)
+        {
+            hasher.updateValue(uint64_t(rel.offset));
+            hasher.updateValue(rel.type);
+            hasher.updateValue(rel.symbol);
+            hasher.updateValue(uint64_t(rel.addend));
+        }
+        hasher.updateValue(uint64_t(kernel.offset));
+    }
+    hasher.updateSections(input.extraSections);
+    hasher.updateSymbols(input.extraSymbols);
+    hasher.updateSections(input.innerExtraSections);
+    hasher.updateSymbols(input.innerExtraSymbols);
+    return hasher.getKey();
+}
+
+// check offsets that depend on code sizes (template is generated for padded codes)
+static void checkAmdCL2CodeOffsets(const AmdCL2Input* input)
+{
+    if (input->driverVersion < 191205)
+        return;
+    for (const AmdCL2KernelInput& kernel: input->kernels)
+        for (const AmdCL2RelInput& rel: kernel.relocations)
+            if (rel.offset+4 > kernel.codeSize)
+                throw BinGenException("Relocation offset outside code size");
+    if (input->code != nullptr)
+    {
+        for (const AmdCL2KernelInput& kernel: input->kernels)
+            if (kernel.offset >= input->codeSize)
+                throw BinGenException("Kernel offset outside code size");
+        for (const AmdCL2RelInput& rel: input->relocations)
+            if (rel.offset+4 > input->codeSize)
+                throw BinGenException("Relocation offset outside code size");
+    }
+}
+
+void AmdCL2GPUBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* binTemplate) const
+{
+    bool codeInStubs = false;
+    if (input->driverVersion < 191205)
+        for (const AmdCL2KernelInput& kernel: input->kernels)
+            if (kernel.useConfig)
+                codeInStubs = true;
+    // template can not be used if stubs are generated from code (old binaries)
+    if (binTemplate == nullptr || codeInStubs)
+    {
+        generateBinary(osPtr, vPtr, aPtr, nullptr);
+        return;
+    }
+    checkAmdCL2CodeOffsets(input);
+    /* code of kernels and main code (for HSA layout). In HSA layout, kernel codes
+     * have only sizes (symbol sizes) */
+    const size_t kernelsNum = input->kernels.size();
+    std::vector<BinaryTemplate::Code> codes(kernelsNum+1);
+    for (size_t i = 0; i < kernelsNum; i++)
+        codes[i] = { input->kernels[i].codeSize, input->kernels[i].code };
+    codes.back() = { input->codeSize, input->code };
+    const uint64_t key = getAmdCL2InputKey(*input);
+    if (!binTemplate->matches(key, codes))
+    {
+        // generate new template from input with codes padded to their capacities
+        binTemplate->prepare(key, codes);
+        AmdCL2Input paddedInput = *input;
+        for (size_t i = 0; i < kernelsNum; i++)
+        {
+            paddedInput.kernels[i].codeSize = binTemplate->getCodeCapacity(i);
+            if (input->kernels[i].code != nullptr)
+                paddedInput.kernels[i].code = binTemplate->getPaddedCode(i);
+        }
+        if (input->code != nullptr)
+        {
+            paddedInput.codeSize = binTemplate->getCodeCapacity(kernelsNum);
+            paddedInput.code = binTemplate->getPaddedCode(kernelsNum);
+        }
+        AmdCL2GPUBinGenerator(&paddedInput).generateBinary(nullptr, nullptr,
+                    &binTemplate->getBinary(), binTemplate);
+        binTemplate->setPrepared();
+    }
+    binTemplate->write(codes, osPtr, vPtr, aPtr);
+}
+
 void AmdCL2GPUBinGenerator::generate(Array<cxbyte>& array) const
 {
-    generateInternal(nullptr, nullptr, &array);
+    generateInternal(nullptr, nullptr, &array, nullptr);
 }
 
 void AmdCL2GPUBinGenerator::generate(std::ostream& os) const
 {
-    generateInternal(&os, nullptr, nullptr);
+    generateInternal(&os, nullptr, nullptr, nullptr);
 }
 
 void AmdCL2GPUBinGenerator::generate(std::vector<char>& vector) const
 {
-    generateInternal(nullptr, &vector, nullptr);
+    generateInternal(nullptr, &vector, nullptr, nullptr);
+}
+
+void AmdCL2GPUBinGenerator::generate(Array<cxbyte>& array,
+            BinaryTemplate& binTemplate) const
+{
+    generateInternal(nullptr, nullptr, &array, &binTemplate);
+}
+
+void AmdCL2GPUBinGenerator::generate(std::ostream& os, BinaryTemplate& binTemplate) const
+{
+    generateInternal(&os, nullptr, nullptr, &binTemplate);
+}
+
+void AmdCL2GPUBinGenerator::generate(std::vector<char>& vector,
+            BinaryTemplate& binTemplate) const
+{
+    generateInternal(nullptr, &vector, nullptr, &binTemplate);
 }
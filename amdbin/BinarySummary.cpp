@@ -0,0 +1,446 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/GPUId.h>
+#include <CLRX/amdbin/AmdBinaries.h>
+#include <CLRX/amdbin/AmdCL2Binaries.h>
+#include <CLRX/amdbin/ROCmBinaries.h>
+#include <CLRX/amdbin/GalliumBinaries.h>
+#include <CLRX/amdbin/BinarySummary.h>
+
+using namespace CLRX;
+
+// set SGPRs and VGPRs number from PGM_RSRC1 (with register granularity)
+static void setRegistersFromPgmRsrc1(KernelSummary& kernel, GPUArchitecture arch,
+            uint32_t pgmRsrc1)
+{
+    const cxuint maxSgprsNum = getGPUMaxRegistersNum(arch, REGTYPE_SGPR, 0);
+    kernel.sgprsNum = std::min((((pgmRsrc1>>6) & 0xf)<<3)+8, maxSgprsNum);
+    kernel.vgprsNum = arch < GPUArchitecture::GCN1_5 ? ((pgmRsrc1 & 0x3f)<<2)+4 :
+                ((pgmRsrc1 & 0x3f)<<3)+8;
+}
+
+static inline bool lineStartsWith(const char* line, const char* lineEnd,
+            const char* prefix, size_t prefixLen)
+{ return size_t(lineEnd-line) >= prefixLen && ::memcmp(line, prefix, prefixLen)==0; }
+
+/*
+ * AMD Catalyst binaries
+ */
+
+// returns true if metadata is metadata of specified kernel (';ARGSTART:' line)
+static bool isAmdMetadataOfKernel(size_t metadataSize, const char* metadata,
+            const CString& kernelName)
+{
+    const size_t nameLen = kernelName.size();
+    return metadataSize >= 26+nameLen &&
+        ::memcmp(metadata, ";ARGSTART:__OpenCL_", 19)==0 &&
+        ::memcmp(metadata+19, kernelName.c_str(), nameLen)==0 &&
+        ::memcmp(metadata+19+nameLen, "_kernel", 7)==0;
+}
+
+// get local size and reqd_work_group_size from AMD kernel metadata
+static void getAmdMetadataSummary(size_t metadataSize, const char* metadata,
+            KernelSummary& kernel)
+{
+    const char* linePtr = metadata;
+    const char* mtEnd = metadata + metadataSize;
+    while (linePtr != mtEnd)
+    {
+        const char* lineEnd = linePtr;
+        while (lineEnd!=mtEnd && *lineEnd!='\n') lineEnd++;
+        const char* outEnd;
+        if (lineStartsWith(linePtr, lineEnd, ";memory:hwlocal:", 16))
+            kernel.localSize = cstrtovCStyle<size_t>(linePtr+16, lineEnd, outEnd);
+        else if (lineStartsWith(linePtr, lineEnd, ";cws:", 5))
+        {
+            // cws (reqd_work_group_size): ';cws:X:Y:Z'
+            outEnd = linePtr+4;
+            for (cxuint k = 0; k < 3; k++)
+            {
+                if (outEnd==lineEnd || *outEnd!=':')
+                    throw BinException("Can't parse CWS in kernel metadata");
+                kernel.reqdWorkGroupSize[k] = cstrtovCStyle<uint32_t>(
+                            outEnd+1, lineEnd, outEnd);
+            }
+        }
+        else if (lineStartsWith(linePtr, lineEnd, ";ARGEND:", 8))
+            break;
+        linePtr = (lineEnd!=mtEnd) ? lineEnd+1 : mtEnd;
+    }
+}
+
+template<typename AmdMainBinary>
+static void getAmdBinarySummary(const AmdMainBinary& binary, BinarySummary& summary)
+{
+    summary.deviceType = binary.determineGPUDeviceType();
+    const cxbyte* binaryCode = binary.getBinaryCode();
+    const size_t kernelsNum = binary.getInnerBinariesNum();
+    // metadatas are not parsed (binary is lazy)
+    const size_t metadatasNum = binary.getKernelInfosNum();
+    summary.kernels.resize(kernelsNum);
+    for (size_t i = 0; i < kernelsNum; i++)
+    {
+        const AmdInnerGPUBinary32& innerBin = binary.getInnerBinary(i);
+        KernelSummary& kernel = summary.kernels[i];
+        kernel.kernelName = innerBin.getKernelName();
+        
+        const cxuint encIndex = innerBin.findCALEncodingEntryIndex(summary.deviceType);
+        const CALEncodingEntry& encEntry = innerBin.getCALEncodingEntry(encIndex);
+        const size_t encEntryOffset = ULEV(encEntry.offset);
+        const size_t encEntrySize = ULEV(encEntry.size);
+        // find '.text' section in choosen encoding
+        for (cxuint j = 0; j < innerBin.getSectionHeadersNum(); j++)
+        {
+            const Elf32_Shdr& shdr = innerBin.getSectionHeader(j);
+            const size_t secOffset = ULEV(shdr.sh_offset);
+            const size_t secSize = ULEV(shdr.sh_size);
+            if (secOffset < encEntryOffset ||
+                    usumGt(secOffset, secSize, encEntryOffset+encEntrySize))
+                continue; // skip this section (not in choosen encoding)
+            if (::strcmp(innerBin.getSectionName(j), ".text") == 0)
+            {
+                kernel.codeOffset = innerBin.getSectionContent(j) - binaryCode;
+                kernel.codeSize = secSize;
+                break;
+            }
+        }
+        
+        // get registers and scratch buffer size from ATI CAL notes
+        for (const CALNote& calNote: innerBin.getCALNotes(encIndex))
+        {
+            const uint32_t descSize = ULEV(calNote.header->descSize);
+            const uint32_t type = ULEV(calNote.header->type);
+            if (type == CALNOTE_ATI_SCRATCH_BUFFERS && descSize >= 4)
+                kernel.scratchSize = ULEV(*reinterpret_cast<const uint32_t*>(
+                            calNote.data))<<2;
+            else if (type == CALNOTE_ATI_PROGINFO)
+            {
+                const CALProgramInfoEntry* piEntry =
+                        reinterpret_cast<const CALProgramInfoEntry*>(calNote.data);
+                const cxuint piEntriesNum = descSize/sizeof(CALProgramInfoEntry);
+                for (cxuint k = 0; k < piEntriesNum; k++)
+                {
+                    const uint32_t address = ULEV(piEntry[k].address);
+                    if (address == 0x80001041)
+                        kernel.vgprsNum = ULEV(piEntry[k].value);
+                    else if (address == 0x80001042)
+                        kernel.sgprsNum = ULEV(piEntry[k].value);
+                }
+            }
+        }
+        
+        // find kernel metadata (usually with same index as inner binary)
+        size_t mtIndex = i;
+        if (mtIndex >= metadatasNum || !isAmdMetadataOfKernel(binary.getMetadataSize(i),
+                    binary.getMetadata(i), kernel.kernelName))
+            for (mtIndex = 0; mtIndex < metadatasNum; mtIndex++)
+                if (isAmdMetadataOfKernel(binary.getMetadataSize(mtIndex),
+                            binary.getMetadata(mtIndex), kernel.kernelName))
+                    break;
+        if (mtIndex < metadatasNum)
+            getAmdMetadataSummary(binary.getMetadataSize(mtIndex),
+                        binary.getMetadata(mtIndex), kernel);
+    }
+}
+
+/*
+ * AMD OpenCL 2.0 binaries
+ */
+
+// internal AMD OpenCL 2.0 Kernel setup (part of AMD HSA config)
+struct CLRX_INTERNAL IntAmdCL2SetupData
+{
+    uint32_t pgmRSRC1;
+    uint32_t pgmRSRC2;
+    uint16_t setup1;
+    uint16_t archInd;
+    uint32_t scratchBufferSize;
+    uint32_t localSize; // in bytes
+    uint32_t gdsSize;   // in bytes
+    uint32_t kernelArgsSize;
+    uint32_t zeroes[2];
+    // really is, reserved Xgprs, but filled by driver
+    uint16_t sgprsNumAll;
+    uint16_t vgprsNum16;
+    uint32_t vgprsNum;
+    uint32_t sgprsNum;
+};
+
+template<typename Types, typename MetadataHeader, typename AmdCL2MainBinary>
+static void getAmdCL2BinarySummary(const AmdCL2MainBinary& binary, BinarySummary& summary)
+{
+    uint32_t archMinor, archStepping;
+    summary.deviceType = binary.determineGPUDeviceType(archMinor, archStepping);
+    const cxbyte* binaryCode = binary.getBinaryCode();
+    
+    // find kernel metadatas ('__OpenCL_&__OpenCL_[name]_kernel_metadata')
+    std::vector<std::pair<CString, const MetadataHeader*> > metadataHeaders;
+    const size_t symbolsNum = binary.getSymbolsNum();
+    for (size_t i = 0; i < symbolsNum; i++)
+    {
+        const char* symName = binary.getSymbolName(i);
+        const size_t len = ::strlen(symName);
+        if (len < 35 || ::strncmp(symName, "__OpenCL_&__OpenCL_", 19) != 0 ||
+                ::strcmp(symName+len-16, "_kernel_metadata") != 0)
+            continue;
+        const typename Types::Sym& sym = binary.getSymbol(i);
+        if (ULEV(sym.st_shndx) >= binary.getSectionHeadersNum())
+            throw BinException("Kernel Metadata section header out of range");
+        const typename Types::Shdr& shdr = binary.getSectionHeader(ULEV(sym.st_shndx));
+        const size_t mtOffset = ULEV(sym.st_value);
+        const size_t mtSize = ULEV(sym.st_size);
+        if (usumGt(mtOffset, mtSize, ULEV(shdr.sh_size)))
+            throw BinException("Kernel Metadata offset and size out of range");
+        if (mtSize < sizeof(MetadataHeader))
+            continue; // too short, no reqd_work_group_size
+        metadataHeaders.push_back(std::make_pair(CString(symName+19, symName+len-16),
+                reinterpret_cast<const MetadataHeader*>(binaryCode +
+                        ULEV(shdr.sh_offset) + mtOffset)));
+    }
+    mapSort(metadataHeaders.begin(), metadataHeaders.end());
+    
+    if (!binary.hasInnerBinary())
+        return;
+    const AmdCL2InnerGPUBinaryBase& innerBin = binary.getInnerBinaryBase();
+    summary.kernels.resize(innerBin.getKernelsNum());
+    for (size_t i = 0; i < innerBin.getKernelsNum(); i++)
+    {
+        const AmdCL2GPUKernel& kernelData = innerBin.getKernelData(i);
+        KernelSummary& kernel = summary.kernels[i];
+        kernel.kernelName = kernelData.kernelName;
+        kernel.codeOffset = kernelData.code - binaryCode;
+        kernel.codeSize = kernelData.codeSize;
+        if (kernelData.setup != nullptr &&
+            kernelData.setupSize >= 48 + sizeof(IntAmdCL2SetupData))
+        {
+            const IntAmdCL2SetupData* setupData =
+                    reinterpret_cast<const IntAmdCL2SetupData*>(kernelData.setup + 48);
+            kernel.sgprsNum = ULEV(setupData->sgprsNum);
+            kernel.vgprsNum = ULEV(setupData->vgprsNum);
+            kernel.localSize = ULEV(setupData->localSize);
+            kernel.scratchSize = ULEV(setupData->scratchBufferSize);
+        }
+        auto mit = binaryMapFind(metadataHeaders.begin(), metadataHeaders.end(),
+                        kernel.kernelName);
+        if (mit != metadataHeaders.end())
+            for (cxuint k = 0; k < 3; k++)
+                kernel.reqdWorkGroupSize[k] = ULEV(mit->second->reqdWorkGroupSize[k]);
+    }
+}
+
+/*
+ * ROCm binaries
+ */
+
+static void getROCmBinarySummary(const ROCmBinary& binary, BinarySummary& summary)
+{
+    uint32_t archMinor, archStepping;
+    summary.deviceType = binary.determineGPUDeviceType(archMinor, archStepping);
+    const GPUArchitecture arch = getGPUArchitectureFromDeviceType(summary.deviceType);
+    const bool llvm10BinFormat = binary.isLLVM10BinaryFormat();
+    
+    // parse metadata (only source of reqd_work_group_size)
+    ROCmMetadata metadata;
+    std::vector<std::pair<const char*, size_t> > metadataMap;
+    if (binary.getMetadata() != nullptr && binary.getMetadataSize() != 0)
+    {
+        if (!binary.isMetadataV3Format())
+            metadata.parse(binary.getMetadataSize(), binary.getMetadata());
+        else
+            metadata.parseMsgPack(binary.getMetadataSize(),
+                        reinterpret_cast<const cxbyte*>(binary.getMetadata()));
+        metadataMap.resize(metadata.kernels.size());
+        for (size_t i = 0; i < metadata.kernels.size(); i++)
+            metadataMap[i] = std::make_pair(metadata.kernels[i].name.c_str(), i);
+        mapSort(metadataMap.begin(), metadataMap.end(), CStringLess());
+    }
+    
+    const cxbyte* binaryCode = binary.getBinaryCode();
+    for (size_t i = 0; i < binary.getRegionsNum(); i++)
+    {
+        const ROCmRegion& region = binary.getRegion(i);
+        if (region.type != ROCmRegionType::KERNEL)
+            continue;
+        summary.kernels.push_back(KernelSummary{});
+        KernelSummary& kernel = summary.kernels.back();
+        kernel.kernelName = region.regionName;
+        
+        const ROCmKernelMetadata* kmetadata = nullptr;
+        auto mit = binaryMapFind(metadataMap.begin(), metadataMap.end(),
+                    region.regionName.c_str(), CStringLess());
+        if (mit != metadataMap.end())
+        {
+            kmetadata = &metadata.kernels[mit->second];
+            std::copy(kmetadata->reqdWorkGroupSize, kmetadata->reqdWorkGroupSize+3,
+                      kernel.reqdWorkGroupSize);
+        }
+        
+        if (!llvm10BinFormat)
+        {
+            // kernel code preceded by AMD HSA kernel config
+            if (region.size < 0x100)
+                throw BinException("Kernel region is too small for kernel config");
+            const AmdHsaKernelConfig* config = reinterpret_cast<const AmdHsaKernelConfig*>(
+                        binaryCode + region.offset);
+            kernel.codeOffset = region.offset + 0x100;
+            kernel.codeSize = region.size - 0x100;
+            kernel.sgprsNum = ULEV(config->wavefrontSgprCount);
+            kernel.vgprsNum = ULEV(config->workitemVgprCount);
+            if (kernel.sgprsNum == 0 && kernel.vgprsNum == 0)
+                setRegistersFromPgmRsrc1(kernel, arch, ULEV(config->computePgmRsrc1));
+            kernel.localSize = ULEV(config->workgroupGroupSegmentSize);
+            kernel.scratchSize = ULEV(config->workitemPrivateSegmentSize);
+            continue;
+        }
+        
+        kernel.codeOffset = region.offset;
+        kernel.codeSize = region.size;
+        const ROCmKernelDescriptor* kdesc = binary.getKernelDescriptor(i);
+        if (kdesc != nullptr)
+        {
+            setRegistersFromPgmRsrc1(kernel, arch, ULEV(kdesc->pgmRsrc1));
+            kernel.localSize = ULEV(kdesc->groupSegmentFixedSize);
+            kernel.scratchSize = ULEV(kdesc->privateSegmentFixedSize);
+        }
+        // metadata holds real numbers of used registers
+        if (kmetadata != nullptr && kmetadata->sgprsNum != BINGEN_NOTSUPPLIED &&
+            kmetadata->vgprsNum != BINGEN_NOTSUPPLIED)
+        {
+            kernel.sgprsNum = kmetadata->sgprsNum;
+            kernel.vgprsNum = kmetadata->vgprsNum;
+        }
+    }
+}
+
+/*
+ * GalliumCompute binaries
+ */
+
+template<typename GalliumElfBinary>
+static void getGalliumBinarySummary(const GalliumBinary& binary,
+            const GalliumElfBinary& elfBin, BinarySummary& summary)
+{
+    const GPUArchitecture arch = getGPUArchitectureFromDeviceType(summary.deviceType);
+    const cxuint ldsShift = arch<GPUArchitecture::GCN1_1 ? 8 : 9;
+    const uint16_t textIndex = elfBin.getSectionIndex(".text");
+    const size_t textOffset = elfBin.getSectionContent(textIndex) -
+                binary.getBinaryCode();
+    const size_t textSize = ULEV(elfBin.getSectionHeader(textIndex).sh_size);
+    const size_t kernelsNum = binary.getKernelsNum();
+    if (elfBin.getProgramInfosNum() < kernelsNum)
+        throw BinException("Number of program infos doesn't match kernels number");
+    
+    // kernel code ends at next kernel code (sorted offsets)
+    std::vector<size_t> offsets(kernelsNum);
+    for (size_t i = 0; i < kernelsNum; i++)
+        offsets[i] = binary.getKernel(i).offset;
+    std::sort(offsets.begin(), offsets.end());
+    
+    summary.kernels.resize(kernelsNum);
+    for (size_t i = 0; i < kernelsNum; i++)
+    {
+        const GalliumKernel& gkernel = binary.getKernel(i);
+        if (gkernel.offset > textSize)
+            throw BinException("Kernel offset out of range");
+        KernelSummary& kernel = summary.kernels[i];
+        kernel.kernelName = gkernel.kernelName;
+        kernel.codeOffset = textOffset + gkernel.offset;
+        auto nextIt = std::upper_bound(offsets.begin(), offsets.end(),
+                    size_t(gkernel.offset));
+        kernel.codeSize = ((nextIt != offsets.end()) ? *nextIt : textSize) -
+                    gkernel.offset;
+        // program info: PGM_RSRC1, PGM_RSRC2, SCRATCH (TMPRING_SIZE)
+        const GalliumProgInfoEntry* progInfo = elfBin.getProgramInfo(uint32_t(i));
+        setRegistersFromPgmRsrc1(kernel, arch, ULEV(progInfo[0].value));
+        kernel.localSize = ((ULEV(progInfo[1].value)>>15) & 0x1ff) << ldsShift;
+        kernel.scratchSize = ((ULEV(progInfo[2].value) >> 12) << 10) >> 6;
+    }
+}
+
+void CLRX::getBinarySummary(size_t binarySize, const cxbyte* binary,
+            BinarySummary& summary, GPUDeviceType galliumDeviceType)
+{
+    summary.kernels.clear();
+    summary.is64Bit = false;
+    // binary objects only read content
+    cxbyte* binaryCode = const_cast<cxbyte*>(binary);
+    if (isAmdBinary(binarySize, binary))
+    {
+        summary.format = SummaryBinaryFormat::AMD;
+        /* inner binaries (with CAL notes) are parsed lazily,
+         * metadatas are only scanned for local size and CWS */
+        const Flags flags = AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_LAZY |
+                    AMDBIN_INNER_CREATE_CALNOTES;
+        std::unique_ptr<AmdMainBinaryBase> amdBin(createAmdBinaryFromCode(
+                    binarySize, binaryCode, flags));
+        if (amdBin->getType() == AmdMainType::GPU_BINARY)
+            getAmdBinarySummary(*static_cast<AmdMainGPUBinary32*>(amdBin.get()), summary);
+        else if (amdBin->getType() == AmdMainType::GPU_64_BINARY)
+        {
+            summary.is64Bit = true;
+            getAmdBinarySummary(*static_cast<AmdMainGPUBinary64*>(amdBin.get()), summary);
+        }
+        else
+            throw BinException("This is not AMD GPU binary");
+    }
+    else if (isAmdCL2Binary(binarySize, binary))
+    {
+        summary.format = SummaryBinaryFormat::AMDCL2;
+        // only kernel setups and codes, without kernel informations
+        const Flags flags = AMDCL2BIN_INNER_CREATE_KERNELDATA;
+        if (binary[EI_CLASS] == ELFCLASS32)
+            getAmdCL2BinarySummary<Elf32Types, AmdCL2GPUMetadataHeader32>(
+                    AmdCL2MainGPUBinary32(binarySize, binaryCode, flags), summary);
+        else
+        {
+            summary.is64Bit = true;
+            getAmdCL2BinarySummary<Elf64Types, AmdCL2GPUMetadataHeader64>(
+                    AmdCL2MainGPUBinary64(binarySize, binaryCode, flags), summary);
+        }
+    }
+    else if (isROCmBinary(binarySize, binary))
+    {
+        summary.format = SummaryBinaryFormat::ROCM;
+        summary.is64Bit = true;
+        getROCmBinarySummary(ROCmBinary(binarySize, binaryCode, 0), summary);
+    }
+    else
+    {
+        // if not other, then GalliumCompute binary
+        summary.format = SummaryBinaryFormat::GALLIUM;
+        summary.deviceType = galliumDeviceType;
+        GalliumBinary galliumBin(binarySize, binaryCode, 0);
+        summary.is64Bit = galliumBin.is64BitElfBinary();
+        if (!summary.is64Bit)
+            getGalliumBinarySummary(galliumBin, galliumBin.getElfBinary32(), summary);
+        else
+            getGalliumBinarySummary(galliumBin, galliumBin.getElfBinary64(), summary);
+    }
+}
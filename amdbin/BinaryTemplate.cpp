@@ -0,0 +1,241 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <algorithm>
+#include <cstring>
+#include <ios>
+#include <ostream>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdbin/BinaryTemplate.h>
+
+using namespace CLRX;
+
+void BinaryTemplate::KeyHasher::update(size_t size, const void* data)
+{
+    // FNV-1a hash
+    const cxbyte* bytes = reinterpret_cast<const cxbyte*>(data);
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * UINT64_C(0x100000001b3);
+}
+
+void BinaryTemplate::KeyHasher::updateData(size_t size, const void* data)
+{
+    const uint64_t hsize = size;
+    updateValue(hsize);
+    updateValue(cxbyte(data != nullptr));
+    if (data != nullptr)
+        update(size, data);
+}
+
+void BinaryTemplate::KeyHasher::updateSections(const std::vector<BinSection>& sections)
+{
+    updateValue(uint64_t(sections.size()));
+    for (const BinSection& section: sections)
+    {
+        updateString(section.name);
+        updateData(section.size, section.data);
+        updateValue(section.align);
+        updateValue(section.type);
+        updateValue(section.flags);
+        updateValue(section.linkId);
+        updateValue(section.info);
+        updateValue(uint64_t(section.entSize));
+    }
+}
+
+void BinaryTemplate::KeyHasher::updateSymbols(const std::vector<BinSymbol>& symbols)
+{
+    updateValue(uint64_t(symbols.size()));
+    for (const BinSymbol& symbol: symbols)
+    {
+        updateString(symbol.name);
+        updateValue(symbol.value);
+        updateValue(symbol.size);
+        updateValue(symbol.sectionId);
+        updateValue(symbol.valueIsAddr);
+        updateValue(symbol.info);
+        updateValue(symbol.other);
+    }
+}
+
+void BinaryTemplate::reset()
+{
+    prepared = false;
+    key = 0;
+    binary.clear();
+    codeCapacities.clear();
+    paddedCodes.clear();
+    codePlaces.clear();
+    sizePlaces.clear();
+}
+
+bool BinaryTemplate::matches(uint64_t inKey, const std::vector<Code>& codes) const
+{
+    if (!prepared || inKey != key || codes.size() != codeCapacities.size())
+        return false;
+    for (size_t i = 0; i < codes.size(); i++)
+        if (codes[i].size > codeCapacities[i])
+            return false;
+    return true;
+}
+
+void BinaryTemplate::prepare(uint64_t inKey, const std::vector<Code>& codes)
+{
+    reset();
+    key = inKey;
+    codeCapacities.resize(codes.size());
+    paddedCodes.resize(codes.size());
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        // reserve quarter of code size for growth, capacity is aligned to 256 bytes
+        const size_t size = codes[i].size;
+        const size_t capacity = (size != 0) ? (size + (size>>2) + 255) & ~size_t(255) : 0;
+        codeCapacities[i] = capacity;
+        if (codes[i].data == nullptr)
+            continue;
+        paddedCodes[i].resize(capacity);
+        std::copy(codes[i].data, codes[i].data + size, paddedCodes[i].begin());
+        std::fill(paddedCodes[i].begin() + size, paddedCodes[i].end(), cxbyte(0));
+    }
+}
+
+void BinaryTemplate::addCodePlace(size_t codeId, size_t codeOffset, size_t offset,
+            size_t size)
+{
+    if (size != 0)
+        codePlaces.push_back({ codeId, codeOffset, offset, size });
+}
+
+void BinaryTemplate::addSizePlace(size_t codeId, size_t offset, cxuint fieldSize)
+{
+    sizePlaces.push_back({ codeId, offset, fieldSize, 0 });
+}
+
+void BinaryTemplate::setPrepared()
+{
+    std::sort(codePlaces.begin(), codePlaces.end(),
+            [](const CodePlace& a, const CodePlace& b)
+            { return a.offset < b.offset; });
+    std::sort(sizePlaces.begin(), sizePlaces.end(),
+            [](const SizePlace& a, const SizePlace& b)
+            { return a.offset < b.offset; });
+    // get base of size fields (value for padded code minus code capacity)
+    for (SizePlace& place: sizePlaces)
+    {
+        const uint64_t value = (place.fieldSize == 8) ?
+                ULEV(*reinterpret_cast<const uint64_t*>(binary.data() + place.offset)) :
+                ULEV(*reinterpret_cast<const uint32_t*>(binary.data() + place.offset));
+        place.base = value - codeCapacities[place.codeId];
+    }
+    // clear code places (code shorter than capacity is padded by zeroes)
+    for (const CodePlace& place: codePlaces)
+        std::fill(binary.begin() + place.offset, binary.begin() + place.offset +
+                    place.size, cxbyte(0));
+    // padded codes are no longer needed
+    paddedCodes.clear();
+    prepared = true;
+}
+
+// put size field value (base + code size) to buffer
+static void putSizeField(const BinaryTemplate::SizePlace& place, size_t codeSize,
+            cxbyte* out)
+{
+    if (place.fieldSize == 8)
+        SULEV(*reinterpret_cast<uint64_t*>(out), place.base + codeSize);
+    else
+        SULEV(*reinterpret_cast<uint32_t*>(out), uint32_t(place.base + codeSize));
+}
+
+void BinaryTemplate::write(const std::vector<Code>& codes, std::ostream* osPtr,
+               std::vector<char>* vPtr, Array<cxbyte>* aPtr) const
+{
+    if (osPtr != nullptr)
+    {
+        const std::ios::iostate oldExceptions = osPtr->exceptions();
+        try
+        {
+            osPtr->exceptions(std::ios::failbit | std::ios::badbit);
+            /* write parts of template between code places and size places
+             * (places are sorted by offset and they do not overlap) */
+            size_t offset = 0;
+            auto codeIt = codePlaces.begin();
+            auto sizeIt = sizePlaces.begin();
+            while (codeIt != codePlaces.end() || sizeIt != sizePlaces.end())
+            {
+                if (sizeIt == sizePlaces.end() ||
+                    (codeIt != codePlaces.end() && codeIt->offset < sizeIt->offset))
+                {
+                    const CodePlace& place = *codeIt++;
+                    const Code& code = codes[place.codeId];
+                    // rest of place (to code capacity) is filled by zeroes in template
+                    const size_t toCopy = (code.size > place.codeOffset) ?
+                            std::min(place.size, code.size - place.codeOffset) : 0;
+                    osPtr->write((const char*)binary.data() + offset,
+                                 place.offset - offset);
+                    osPtr->write((const char*)code.data + place.codeOffset, toCopy);
+                    offset = place.offset + toCopy;
+                }
+                else
+                {
+                    const SizePlace& place = *sizeIt++;
+                    cxbyte field[8];
+                    putSizeField(place, codes[place.codeId].size, field);
+                    osPtr->write((const char*)binary.data() + offset,
+                                 place.offset - offset);
+                    osPtr->write((const char*)field, place.fieldSize);
+                    offset = place.offset + place.fieldSize;
+                }
+            }
+            osPtr->write((const char*)binary.data() + offset, binary.size() - offset);
+        }
+        catch(...)
+        {
+            osPtr->exceptions(oldExceptions);
+            throw;
+        }
+        osPtr->exceptions(oldExceptions);
+        return;
+    }
+    cxbyte* out = nullptr;
+    if (aPtr != nullptr)
+    {
+        aPtr->assign(binary.begin(), binary.end());
+        out = aPtr->data();
+    }
+    else
+    {
+        vPtr->assign(binary.begin(), binary.end());
+        out = (cxbyte*)vPtr->data();
+    }
+    // put current code to binary
+    for (const CodePlace& place: codePlaces)
+    {
+        const Code& code = codes[place.codeId];
+        if (code.size > place.codeOffset)
+            ::memcpy(out + place.offset, code.data + place.codeOffset,
+                     std::min(place.size, code.size - place.codeOffset));
+    }
+    // patch size fields
+    for (const SizePlace& place: sizePlaces)
+        putSizeField(place, codes[place.codeId].size, out + place.offset);
+}
@@ -60,6 +60,98 @@ static size_t unfinishedRegionOfStringTable(const cxbyte* table, size_t size)
     return (table[k]==0)?k+1:k;
 }
 
+// SysV ELF hash of name (used by .hash sections)
+static inline uint32_t elfHashName(const char* nameStr)
+{
+    uint32_t h = 0, g;
+    const cxbyte* name = reinterpret_cast<const cxbyte*>(nameStr);
+    while(*name!=0)
+    {
+        h = (h<<4) + *name++;
+        g = h & 0xf0000000U;
+        if (g) h ^= g>>24;
+        h &= ~g;
+    }
+    return h;
+}
+
+/* check whether hash table (.hash) is consistent and match to symbol table,
+ * if not, then lookup by hash table can not be used */
+static bool checkElfHashTable(const cxbyte* hashTable, size_t hashSize, size_t symbolsNum)
+{
+    if (hashSize < 8)
+        return false;
+    const uint32_t* ht = reinterpret_cast<const uint32_t*>(hashTable);
+    const uint64_t bucketsNum = ULEV(ht[0]);
+    const uint64_t chainsNum = ULEV(ht[1]);
+    return bucketsNum != 0 && chainsNum == symbolsNum &&
+            ((bucketsNum + chainsNum + 2)<<2) <= hashSize;
+}
+
+/* find name in hash table (.hash). returns SIZE_MAX if not found */
+template<typename GetName>
+static size_t findInElfHashTable(const cxbyte* hashTable, const char* name,
+            GetName getName)
+{
+    const uint32_t* ht = reinterpret_cast<const uint32_t*>(hashTable);
+    const uint32_t bucketsNum = ULEV(ht[0]);
+    const uint32_t chainsNum = ULEV(ht[1]);
+    const uint32_t* chains = ht + bucketsNum + 2;
+    uint32_t i = ULEV(ht[2 + elfHashName(name) % bucketsNum]);
+    // steps limit protects against cycles in broken chains
+    for (uint32_t steps = 0; i != STN_UNDEF && i < chainsNum && steps < chainsNum;
+                steps++, i = ULEV(chains[i]))
+        if (::strcmp(getName(i), name) == 0)
+            return i;
+    // first entry can not be reached by chains (zero is end of chain)
+    if (chainsNum != 0 && ::strcmp(getName(0), name) == 0)
+        return 0;
+    return SIZE_MAX;
+}
+
+// hash for open-addressing name index (FNV-1a)
+static inline size_t nameIndexHash(const char* nameStr)
+{
+    uint32_t h = 2166136261U;
+    for (const cxbyte* name = reinterpret_cast<const cxbyte*>(nameStr); *name!=0; name++)
+        h = (h ^ *name) * 16777619U;
+    return h ^ (h>>16);
+}
+
+/* build open-addressing name index (linear probing, size is power of two,
+ * SIZE_MAX is empty entry) */
+template<typename GetName>
+static void buildNameIndex(size_t namesNum, Array<size_t>& index, GetName getName)
+{
+    size_t indexSize = 16;
+    while (indexSize < (namesNum<<1))
+        indexSize <<= 1;
+    index.resize(indexSize);
+    std::fill(index.begin(), index.end(), SIZE_MAX);
+    const size_t mask = indexSize-1;
+    for (size_t i = 0; i < namesNum; i++)
+    {
+        size_t pos = nameIndexHash(getName(i)) & mask;
+        // first occurrence of name will be found first
+        while (index[pos] != SIZE_MAX)
+            pos = (pos+1) & mask;
+        index[pos] = i;
+    }
+}
+
+/* find name in open-addressing name index. returns SIZE_MAX if not found */
+template<typename GetName>
+static size_t findInNameIndex(const Array<size_t>& index, const char* name,
+            GetName getName)
+{
+    const size_t mask = index.size()-1;
+    for (size_t pos = nameIndexHash(name) & mask; index[pos] != SIZE_MAX;
+                pos = (pos+1) & mask)
+        if (::strcmp(getName(index[pos]), name) == 0)
+            return index[pos];
+    return SIZE_MAX;
+}
+
 /* elf32 types */
 
 const cxbyte CLRX::Elf32Types::ELFCLASS = ELFCLASS32;
@@ -78,7 +170,8 @@ template<typename Types>
 ElfBinaryTemplate<Types>::ElfBinaryTemplate() : binaryCodeSize(0), binaryCode(nullptr),
         sectionStringTable(nullptr), symbolStringTable(nullptr),
         symbolTable(nullptr), dynSymStringTable(nullptr), dynSymTable(nullptr),
-        noteTable(nullptr), symbolsNum(0), dynSymbolsNum(0),
+        noteTable(nullptr), symHashTable(nullptr), dynSymHashTable(nullptr),
+        symbolsNum(0), dynSymbolsNum(0),
         noteTableSize(0), dynamicsNum(0), symbolEntSize(0), dynSymEntSize(0),
         dynamicEntSize(0)
 { }
@@ -93,7 +186,8 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
         binaryCodeSize(_binaryCodeSize), binaryCode(_binaryCode),
         sectionStringTable(nullptr), symbolStringTable(nullptr),
         symbolTable(nullptr), dynSymStringTable(nullptr), dynSymTable(nullptr),
-        noteTable(nullptr), symbolsNum(0), dynSymbolsNum(0),
+        noteTable(nullptr), symHashTable(nullptr), dynSymHashTable(nullptr),
+        symbolsNum(0), dynSymbolsNum(0),
         noteTableSize(0), dynamicsNum(0), symbolEntSize(0), dynSymEntSize(0),
         dynamicEntSize(0)     
 {
@@ -158,6 +252,7 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
         const typename Types::Shdr* dynSymTableHdr = nullptr;
         const typename Types::Shdr* noteTableHdr = nullptr;
         const typename Types::Shdr* dynamicTableHdr = nullptr;
+        const typename Types::Shdr* hashTableHdr = nullptr;
         
         cxuint shnum = ULEV(ehdr->e_shnum);
         if ((creationFlags & ELF_CREATE_SECTIONMAP) != 0)
@@ -195,6 +290,8 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
                 noteTableHdr = &shdr;
             if (ULEV(shdr.sh_type) == SHT_DYNAMIC)
                 dynamicTableHdr = &shdr;
+            if (ULEV(shdr.sh_type) == SHT_HASH && hashTableHdr == nullptr)
+                hashTableHdr = &shdr;
         }
         // sort section's map (really is array of sections)
         if ((creationFlags & ELF_CREATE_SECTIONMAP) != 0)
@@ -284,6 +381,25 @@ ElfBinaryTemplate<Types>::ElfBinaryTemplate(size_t _binaryCodeSize, cxbyte* _bin
             if ((creationFlags & ELF_CREATE_DYNSYMMAP) != 0)
                 mapSort(dynSymIndexMap.begin(), dynSymIndexMap.end(), CStringLess());
         }
+        if (hashTableHdr != nullptr)
+        {
+            /* use hash table to lookup symbols if it is consistent
+             * (only 4-byte entries, like in original SysV) */
+            const typename Types::Shdr& linkedHdr =
+                    getSectionHeader(ULEV(hashTableHdr->sh_link));
+            cxbyte* hashTable = binaryCode + ULEV(hashTableHdr->sh_offset);
+            const typename Types::Size entSize = ULEV(hashTableHdr->sh_entsize);
+            const typename Types::Size hashSize = ULEV(hashTableHdr->sh_size);
+            if (entSize == 0 || entSize == 4)
+            {
+                if (&linkedHdr == symTableHdr &&
+                    checkElfHashTable(hashTable, hashSize, symbolsNum))
+                    symHashTable = hashTable;
+                else if (&linkedHdr == dynSymTableHdr &&
+                    checkElfHashTable(hashTable, hashSize, dynSymbolsNum))
+                    dynSymHashTable = hashTable;
+            }
+        }
         if (noteTableHdr != nullptr)
         {
             noteTable = binaryCode + ULEV(noteTableHdr->sh_offset);
@@ -318,34 +434,73 @@ uint16_t ElfBinaryTemplate<Types>::getSectionIndex(const char* name) const
     }
     else
     {
-        // find in section headers (fallback)
-        for (cxuint i = 0; i < getSectionHeadersNum(); i++)
-        {
-            if (::strcmp(getSectionName(i), name) == 0)
-                return i;
-        }
-        throw BinException(std::string("Can't find Elf")+Types::bitName+" Section");
+        if (sectionStringTable == nullptr)
+            throw BinException(std::string("Can't find Elf")+Types::bitName+" Section");
+        // find in section name index (built at first usage)
+        auto getName = [this](size_t i) { return getSectionName(i); };
+        callOnce(nameIndexOnceFlags[0], [this, &getName]()
+            { buildNameIndex(getSectionHeadersNum(), sectionNameIndex, getName); });
+        const size_t index = findInNameIndex(sectionNameIndex, name, getName);
+        if (index == SIZE_MAX)
+            throw BinException(std::string("Can't find Elf")+Types::bitName+" Section");
+        return index;
     }
 }
 
 template<typename Types>
 typename Types::Size ElfBinaryTemplate<Types>::getSymbolIndex(const char* name) const
 {
-    SymbolIndexMap::const_iterator it = binaryMapFind(
+    if (hasSymbolMap())
+    {
+        SymbolIndexMap::const_iterator it = binaryMapFind(
                     symbolIndexMap.begin(), symbolIndexMap.end(), name, CStringLess());
-    if (it == symbolIndexMap.end())
+        if (it == symbolIndexMap.end())
+            throw BinException(std::string("Can't find Elf")+Types::bitName+" Symbol");
+        return it->second;
+    }
+    auto getName = [this](size_t i) { return getSymbolName(i); };
+    size_t index;
+    if (symHashTable != nullptr)
+        // find in hash table from binary
+        index = findInElfHashTable(symHashTable, name, getName);
+    else
+    {
+        // find in symbol name index (built at first usage)
+        callOnce(nameIndexOnceFlags[1], [this, &getName]()
+            { buildNameIndex(symbolsNum, symbolNameIndex, getName); });
+        index = findInNameIndex(symbolNameIndex, name, getName);
+    }
+    if (index == SIZE_MAX)
         throw BinException(std::string("Can't find Elf")+Types::bitName+" Symbol");
-    return it->second;
+    return index;
 }
 
 template<typename Types>
 typename Types::Size ElfBinaryTemplate<Types>::getDynSymbolIndex(const char* name) const
 {
-    SymbolIndexMap::const_iterator it = binaryMapFind(
+    if (hasDynSymbolMap())
+    {
+        SymbolIndexMap::const_iterator it = binaryMapFind(
                     dynSymIndexMap.begin(), dynSymIndexMap.end(), name, CStringLess());
-    if (it == dynSymIndexMap.end())
+        if (it == dynSymIndexMap.end())
+            throw BinException(std::string("Can't find Elf")+Types::bitName+" DynSymbol");
+        return it->second;
+    }
+    auto getName = [this](size_t i) { return getDynSymbolName(i); };
+    size_t index;
+    if (dynSymHashTable != nullptr)
+        // find in hash table from binary
+        index = findInElfHashTable(dynSymHashTable, name, getName);
+    else
+    {
+        // find in dynamic symbol name index (built at first usage)
+        callOnce(nameIndexOnceFlags[2], [this, &getName]()
+            { buildNameIndex(dynSymbolsNum, dynSymNameIndex, getName); });
+        index = findInNameIndex(dynSymNameIndex, name, getName);
+    }
+    if (index == SIZE_MAX)
         throw BinException(std::string("Can't find Elf")+Types::bitName+" DynSymbol");
-    return it->second;
+    return index;
 }
 
 template class CLRX::ElfBinaryTemplate<CLRX::Elf32Types>;
@@ -408,17 +563,7 @@ static std::unique_ptr<uint32_t[]> calculateHashValuesForSymbols(bool addNullSym
         hashCodes[0] = 0;
     for (size_t i = 0; i < symbols.size(); i++)
     {
-        // main routine of hash
-        uint32_t h = 0, g;
-        const cxbyte* name = reinterpret_cast<const cxbyte*>(symbols[i].name);
-        while(*name!=0)
-        {
-            h = (h<<4) + *name++;
-            g = h & 0xf0000000U;
-            if (g) h ^= g>>24;
-            h &= ~g;
-        }
-        hashCodes[i+addNullSymbol] = h;
+        hashCodes[i+addNullSymbol] = elfHashName(symbols[i].name);
     }
     return hashCodes;
 }
@@ -459,7 +604,7 @@ template<typename Types>
 ElfBinaryGenTemplate<Types>::ElfBinaryGenTemplate()
         : sizeComputed(false), addNullSym(true), addNullDynSym(true), addNullSection(true),
           addrStartRegion(0), shStrTab(0), strTab(0), dynStr(0), shdrTabRegion(0),
-          phdrTabRegion(0), bucketsNum(0), isHashDynSym(false)
+          phdrTabRegion(0), bucketsNum(0), isHashDynSym(false), outputOffset(0)
 { }
 
 template<typename Types>
@@ -469,7 +614,7 @@ ElfBinaryGenTemplate<Types>::ElfBinaryGenTemplate(const ElfHeaderTemplate<Types>
         : sizeComputed(false), addNullSym(_addNullSym), addNullDynSym(_addNullDynSym),
           addNullSection(_addNullSection),  addrStartRegion(addrCountingFromRegion),
           shStrTab(0), strTab(0), dynStr(0), shdrTabRegion(0), phdrTabRegion(0),
-          header(_header), bucketsNum(0), isHashDynSym(false)
+          header(_header), bucketsNum(0), isHashDynSym(false), outputOffset(0)
 { }
 
 template<typename Types>
@@ -815,11 +960,41 @@ static void createHashTable(uint32_t bucketsNum, uint32_t hashNum, bool skipFirs
     }
 }
 
+template<typename Types>
+uint64_t ElfBinaryGenTemplate<Types>::getSectionHeaderOutputOffset(
+            cxuint regionIndex) const
+{
+    // section headers are written in order of section regions
+    uint64_t sectionIndex = addNullSection;
+    for (cxuint i = 0; i < regionIndex; i++)
+        if (regions[i].type == ElfRegionType::SECTION)
+            sectionIndex++;
+    return outputOffset + regionOffsets[shdrTabRegion] +
+            sectionIndex*sizeof(typename Types::Shdr);
+}
+
+template<typename Types>
+uint64_t ElfBinaryGenTemplate<Types>::getSymbolOutputOffset(size_t symbolIndex,
+            bool dynamic) const
+{
+    const uint32_t symTabType = dynamic ? SHT_DYNSYM : SHT_SYMTAB;
+    for (cxuint i = 0; i < regions.size(); i++)
+    {
+        const auto& region = regions[i];
+        if (region.type == ElfRegionType::SECTION && region.data == nullptr &&
+            region.section.type == symTabType)
+            return outputOffset + regionOffsets[i] + (uint64_t(symbolIndex) +
+                    (dynamic ? addNullDynSym : addNullSym))*sizeof(typename Types::Sym);
+    }
+    throw BinGenException(dynamic ? "No dynamic symbol table" : "No symbol table");
+}
+
 template<typename Types>
 void ElfBinaryGenTemplate<Types>::generate(FastOutputBuffer& fob)
 {
     computeSize();
     const uint64_t startOffset = fob.getWritten();
+    outputOffset = startOffset;
     /* write elf header */
     {
         typename Types::Ehdr ehdr;
@@ -1241,7 +1416,8 @@ void ElfBinaryGenTemplate<Types>::generate(FastOutputBuffer& fob)
         }
     }
     fob.flush();
-    fob.getOStream().flush();
+    if (!fob.isMemoryOutput())
+        fob.getOStream().flush();
     assert(size == fob.getWritten()-startOffset);
 }
 
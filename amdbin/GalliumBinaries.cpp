@@ -20,6 +20,8 @@
 #include <CLRX/Config.h>
 #include <cassert>
 #include <climits>
+#include <cstddef>
+#include <cstring>
 #include <algorithm>
 #include <cstdint>
 #include <utility>
@@ -168,7 +170,7 @@ GalliumElfBinary32::~GalliumElfBinary32()
 
 GalliumElfBinary32::GalliumElfBinary32(size_t binaryCodeSize, cxbyte* binaryCode,
            Flags creationFlags, size_t kernelsNum) :
-           ElfBinary32(binaryCodeSize, binaryCode, creationFlags|ELF_CREATE_SYMBOLMAP),
+           ElfBinary32(binaryCodeSize, binaryCode, creationFlags),
            textRelsNum(0), textRelEntrySize(0), textRel(nullptr)
 {
     loadFromElf(static_cast<const ElfBinary32&>(*this), kernelsNum);
@@ -198,7 +200,7 @@ GalliumElfBinary64::~GalliumElfBinary64()
 
 GalliumElfBinary64::GalliumElfBinary64(size_t binaryCodeSize, cxbyte* binaryCode,
            Flags creationFlags, size_t kernelsNum) :
-           ElfBinary64(binaryCodeSize, binaryCode, creationFlags|ELF_CREATE_SYMBOLMAP),
+           ElfBinary64(binaryCodeSize, binaryCode, creationFlags),
            textRelsNum(0), textRelEntrySize(0), textRel(nullptr)
 {
     loadFromElf(static_cast<const ElfBinary64&>(*this), kernelsNum);
@@ -772,8 +774,22 @@ static void putSectionsAndSymbols(ElfBinaryGenTemplate<Types>& elfBinGen,
                          GALLIUMSECTID_MAX, startSectionIndex));
 }
 
-void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr) const
+// add places of code and code size fields to binary template
+template<typename Types>
+static void addTemplatePlaces(const ElfBinaryGenTemplate<Types>& elfBinGen,
+            size_t codeSize, BinaryTemplate& templateOut)
+{
+    // code is in first region (.text)
+    templateOut.addCodePlace(0, 0, elfBinGen.getRegionOutputOffset(0), codeSize);
+    templateOut.addSizePlace(0, elfBinGen.getSectionHeaderOutputOffset(0) +
+            offsetof(typename Types::Shdr, sh_size), sizeof(typename Types::Word));
+    // value of EndOfTextLabel (first symbol) is code size
+    templateOut.addSizePlace(0, elfBinGen.getSymbolOutputOffset(0) +
+            offsetof(typename Types::Sym, st_value), sizeof(typename Types::Word));
+}
+
+void GalliumBinGenerator::generateBinary(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* templateOut) const
 {
     const uint32_t kernelsNum = input->kernels.size();
     /* compute size of binary */
@@ -859,32 +875,37 @@ void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    // size of binary is known, so binary is written directly to array or vector
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-                new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize,
+                    reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
-    else // from argument
+    else
+    {
+        // from argument
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(4096, *os));
+    }
+    FastOutputBuffer& bos = *outBufHolder;
     
-    const std::ios::iostate oldExceptions = os->exceptions();
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-    os->exceptions(std::ios::failbit | std::ios::badbit);
+    if (os != nullptr)
+        os->exceptions(std::ios::failbit | std::ios::badbit);
     /****
      * write binary to output
      ****/
-    FastOutputBuffer bos(256, *os);
     bos.writeObject<uint32_t>(LEV(kernelsNum));
     // write Gallium kernel info
     for (uint32_t korder: kernelsOrder)
@@ -917,32 +938,151 @@ void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char
         bos.writeArray(6, section);
     }
     if (!input->is64BitElf)
+    {
         elfBinGen32->generate(bos);
+        if (templateOut != nullptr)
+            addTemplatePlaces(*elfBinGen32, input->codeSize, *templateOut);
+    }
     else // 64-bit
+    {
         elfBinGen64->generate(bos);
+        if (templateOut != nullptr)
+            addTemplatePlaces(*elfBinGen64, input->codeSize, *templateOut);
+    }
     assert(bos.getWritten() == binarySize);
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
+}
+
+// compute key of template from non-code input
+static uint64_t getGalliumInputKey(const GalliumInput& input)
+{
+    BinaryTemplate::KeyHasher hasher;
+    hasher.updateValue(input.is64BitElf);
+    hasher.updateValue(input.isLLVM390);
+    hasher.updateValue(input.isMesa170);
+    hasher.updateValue(input.deviceType);
+    hasher.updateData(input.globalDataSize, input.globalData);
+    hasher.updateValue(uint64_t(input.kernels.size()));
+    for (const GalliumKernelInput& kernel: input.kernels)
+    {
+        hasher.updateString(kernel.kernelName);
+        hasher.updateValue(kernel.progInfo);
+        hasher.updateValue(kernel.useConfig);
+        if (kernel.useConfig)
+        {
+            const GalliumKernelConfig& config = kernel.config;
+            hasher.updateValue(config.dimMask);
+            hasher.updateValue(config.usedVGPRsNum);
+            hasher.updateValue(config.usedSGPRsNum);
+            hasher.updateValue(config.pgmRSRC1);
+            hasher.updateValue(config.pgmRSRC2);
+            hasher.updateValue(config.userDataNum);
+            hasher.updateValue(config.ieeeMode);
+            hasher.updateValue(config.floatMode);
+            hasher.updateValue(config.priority);
+            hasher.updateValue(config.exceptions);
+            hasher.updateValue(config.tgSize);
+            hasher.updateValue(config.debugMode);
+            hasher.updateValue(config.privilegedMode);
+            hasher.updateValue(config.dx10Clamp);
+            hasher.updateValue(uint64_t(config.localSize));
+            hasher.updateValue(config.scratchBufferSize);
+            hasher.updateValue(config.spilledVGPRs);
+            hasher.updateValue(config.spilledSGPRs);
+        }
+        hasher.updateValue(kernel.offset);
+        hasher.updateValue(uint64_t(kernel.argInfos.size()));
+        for (const GalliumArgInfo& arg: kernel.argInfos)
+        {
+            hasher.updateValue(arg.type);
+            hasher.updateValue(arg.signExtended);
+            hasher.updateValue(arg.semantic);
+            hasher.updateValue(arg.size);
+            hasher.updateValue(arg.targetSize);
+            hasher.updateValue(arg.targetAlign);
+        }
+    }
+    if (input.comment != nullptr)
+        hasher.updateData((input.commentSize != 0) ? input.commentSize :
+                    ::strlen(input.comment), input.comment);
+    else
+        hasher.updateData(0, nullptr);
+    hasher.updateSections(input.extraSections);
+    hasher.updateSymbols(input.extraSymbols);
+    hasher.updateValue(uint64_t(input.scratchRelocs.size()));
+    for (const GalliumScratchReloc& reloc: input.scratchRelocs)
+    {
+        hasher.updateValue(uint64_t(reloc.offset));
+        hasher.updateValue(reloc.type);
+    }
+    return hasher.getKey();
+}
+
+void GalliumBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* binTemplate) const
+{
+    if (binTemplate == nullptr)
+    {
+        generateBinary(osPtr, vPtr, aPtr, nullptr);
+        return;
+    }
+    // template is generated for padded code, so check kernel offsets here
+    for (const GalliumKernelInput& kernel: input->kernels)
+        if (kernel.offset >= input->codeSize)
+            throw BinGenException("Kernel offset out of range");
+    const std::vector<BinaryTemplate::Code> codes{ { input->codeSize, input->code } };
+    const uint64_t key = getGalliumInputKey(*input);
+    if (!binTemplate->matches(key, codes))
+    {
+        // generate new template from input with code padded to its capacity
+        binTemplate->prepare(key, codes);
+        GalliumInput paddedInput = *input;
+        paddedInput.codeSize = binTemplate->getCodeCapacity(0);
+        paddedInput.code = binTemplate->getPaddedCode(0);
+        GalliumBinGenerator(&paddedInput).generateBinary(nullptr, nullptr,
+                    &binTemplate->getBinary(), binTemplate);
+        binTemplate->setPrepared();
+    }
+    binTemplate->write(codes, osPtr, vPtr, aPtr);
 }
 
 void GalliumBinGenerator::generate(Array<cxbyte>& array) const
 {
-    generateInternal(nullptr, nullptr, &array);
+    generateInternal(nullptr, nullptr, &array, nullptr);
 }
 
 void GalliumBinGenerator::generate(std::ostream& os) const
 {
-    generateInternal(&os, nullptr, nullptr);
+    generateInternal(&os, nullptr, nullptr, nullptr);
 }
 
 void GalliumBinGenerator::generate(std::vector<char>& v) const
 {
-    generateInternal(nullptr, &v, nullptr);
+    generateInternal(nullptr, &v, nullptr, nullptr);
+}
+
+void GalliumBinGenerator::generate(Array<cxbyte>& array,
+            BinaryTemplate& binTemplate) const
+{
+    generateInternal(nullptr, nullptr, &array, &binTemplate);
+}
+
+void GalliumBinGenerator::generate(std::ostream& os, BinaryTemplate& binTemplate) const
+{
+    generateInternal(&os, nullptr, nullptr, &binTemplate);
+}
+
+void GalliumBinGenerator::generate(std::vector<char>& v, BinaryTemplate& binTemplate) const
+{
+    generateInternal(nullptr, &v, nullptr, &binTemplate);
 }
 
 static const char* mesaOclMagicString = "OpenCL 1.1 MESA";
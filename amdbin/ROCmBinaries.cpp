@@ -19,6 +19,7 @@
 
 #include <CLRX/Config.h>
 #include <cassert>
+#include <cstddef>
 #include <cstdio>
 #include <cstring>
 #include <cstdint>
@@ -792,6 +793,8 @@ void ROCmBinGenerator::prepareBinaryGen()
                 if (sym.type == ROCmRegionType::KERNEL)
                     koffsets.push_back(sym.offset);
             }
+            if (rocmLLVMGDataGen != nullptr) // if prepared again
+                delete (ROCmLLVM10GlobalDataGen*)rocmLLVMGDataGen;
             ROCmLLVM10GlobalDataGen* sgen = new ROCmLLVM10GlobalDataGen(input->globalDataSize,
                         input->globalData, *elfBinGen64.get(),
                         mainBuiltinSectTable[ELFSECTID_RODATA-ELFSECTID_START],
@@ -802,6 +805,8 @@ void ROCmBinGenerator::prepareBinaryGen()
         }
     if (!input->gotSymbols.empty())
     {
+        if (rocmRelaDynGen != nullptr) // if prepared again
+            delete (ROCmRelaDynGen*)rocmRelaDynGen;
         ROCmRelaDynGen* sgen = new ROCmRelaDynGen(input);
         rocmRelaDynGen = (void*)sgen;
         elfBinGen64->addRegion(ElfRegion64(input->gotSymbols.size()*sizeof(Elf64_Rela),
@@ -819,6 +824,8 @@ void ROCmBinGenerator::prepareBinaryGen()
                 Elf64Types::nobase, 0, false, 8));
     if (!input->gotSymbols.empty())
     {
+        if (rocmGotGen != nullptr) // if prepared again
+            delete (ROCmGotGen*)rocmGotGen;
         ROCmGotGen* sgen = new ROCmGotGen(input);
         rocmGotGen = (void*)sgen;
         elfBinGen64->addRegion(ElfRegion64(input->gotSymbols.size()*8, sgen,
@@ -920,73 +927,217 @@ void ROCmBinGenerator::updateSymbols()
     }
 }
 
-void ROCmBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
-             Array<cxbyte>* aPtr)
+void ROCmBinGenerator::generateBinary(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* templateOut)
 {
     if (elfBinGen64 == nullptr)
         prepareBinaryGen();
     /****
      * prepare for write binary to output
      ****/
-    std::unique_ptr<std::ostream> outStreamHolder;
+    // size of binary is known, so binary is written directly to array or vector
+    std::unique_ptr<FastOutputBuffer> outBufHolder;
     std::ostream* os = nullptr;
     if (aPtr != nullptr)
     {
         aPtr->resize(binarySize);
-        outStreamHolder.reset(
-                new ArrayOStream(binarySize, reinterpret_cast<char*>(aPtr->data())));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize,
+                    reinterpret_cast<char*>(aPtr->data())));
     }
     else if (vPtr != nullptr)
     {
         vPtr->resize(binarySize);
-        outStreamHolder.reset(new VectorOStream(*vPtr));
-        os = outStreamHolder.get();
+        outBufHolder.reset(new FastOutputBuffer(binarySize, vPtr->data()));
     }
-    else // from argument
+    else
+    {
+        // from argument
         os = osPtr;
+        outBufHolder.reset(new FastOutputBuffer(4096, *os));
+    }
+    FastOutputBuffer& bos = *outBufHolder;
     
-    const std::ios::iostate oldExceptions = os->exceptions();
+    const std::ios::iostate oldExceptions = (os != nullptr) ?
+                os->exceptions() : std::ios::goodbit;
     try
     {
-    os->exceptions(std::ios::failbit | std::ios::badbit);
+    if (os != nullptr)
+        os->exceptions(std::ios::failbit | std::ios::badbit);
     /****
      * write binary to output
      ****/
-    FastOutputBuffer bos(256, *os);
     elfBinGen64->generate(bos);
     assert(bos.getWritten() == binarySize);
-    
-    if (rocmGotGen != nullptr)
+    if (templateOut != nullptr)
     {
-        delete (ROCmGotGen*)rocmGotGen;
-        rocmGotGen = nullptr;
-    }
-    if (rocmRelaDynGen != nullptr)
-    {
-        delete (ROCmGotGen*)rocmRelaDynGen;
-        rocmRelaDynGen = nullptr;
+        const cxuint textRegion = mainBuiltinSectTable[ELFSECTID_TEXT-ELFSECTID_START];
+        templateOut->addCodePlace(0, 0, elfBinGen64->getRegionOutputOffset(textRegion),
+                    input->codeSize);
+        templateOut->addSizePlace(0, elfBinGen64->getSectionHeaderOutputOffset(
+                    textRegion) + offsetof(Elf64_Shdr, sh_size), 8);
     }
     }
     catch(...)
     {
-        os->exceptions(oldExceptions);
+        if (os != nullptr)
+            os->exceptions(oldExceptions);
         throw;
     }
-    os->exceptions(oldExceptions);
+    if (os != nullptr)
+        os->exceptions(oldExceptions);
+}
+
+// compute key of template from non-code input
+static uint64_t getROCmInputKey(const ROCmInput& input)
+{
+    BinaryTemplate::KeyHasher hasher;
+    hasher.updateValue(input.deviceType);
+    hasher.updateValue(input.archMinor);
+    hasher.updateValue(input.archStepping);
+    hasher.updateValue(input.eflags);
+    hasher.updateValue(input.newBinFormat);
+    hasher.updateValue(input.llvm10BinFormat);
+    hasher.updateValue(input.metadataV3Format);
+    hasher.updateData(input.globalDataSize, input.globalData);
+    hasher.updateValue(uint64_t(input.symbols.size()));
+    for (const ROCmSymbolInput& symbol: input.symbols)
+    {
+        hasher.updateString(symbol.symbolName);
+        hasher.updateValue(uint64_t(symbol.offset));
+        hasher.updateValue(uint64_t(symbol.size));
+        hasher.updateValue(symbol.type);
+    }
+    if (input.comment != nullptr)
+        hasher.updateData((input.commentSize != 0) ? input.commentSize :
+                    ::strlen(input.comment), input.comment);
+    else
+        hasher.updateData(0, nullptr);
+    hasher.updateString(input.target);
+    hasher.updateString(input.targetTripple);
+    hasher.updateValue(input.useMetadataInfo);
+    if (!input.useMetadataInfo)
+        hasher.updateData(input.metadataSize, input.metadata);
+    else
+    {
+        const ROCmMetadata& mdInfo = input.metadataInfo;
+        hasher.updateValue(mdInfo.version);
+        hasher.updateValue(uint64_t(mdInfo.printfInfos.size()));
+        for (const ROCmPrintfInfo& printfInfo: mdInfo.printfInfos)
+        {
+            hasher.updateValue(printfInfo.id);
+            hasher.updateData(printfInfo.argSizes.size()*sizeof(uint32_t),
+                        printfInfo.argSizes.data());
+            hasher.updateString(printfInfo.format);
+        }
+        hasher.updateValue(uint64_t(mdInfo.kernels.size()));
+        for (const ROCmKernelMetadata& kernel: mdInfo.kernels)
+        {
+            hasher.updateString(kernel.name);
+            hasher.updateString(kernel.symbolName);
+            hasher.updateValue(uint64_t(kernel.argInfos.size()));
+            for (const ROCmKernelArgInfo& arg: kernel.argInfos)
+            {
+                hasher.updateString(arg.name);
+                hasher.updateString(arg.typeName);
+                hasher.updateValue(arg.size);
+                hasher.updateValue(arg.align);
+                hasher.updateValue(arg.pointeeAlign);
+                hasher.updateValue(arg.valueKind);
+                hasher.updateValue(arg.valueType);
+                hasher.updateValue(arg.addressSpace);
+                hasher.updateValue(arg.accessQual);
+                hasher.updateValue(arg.actualAccessQual);
+                hasher.updateValue(arg.isConst);
+                hasher.updateValue(arg.isRestrict);
+                hasher.updateValue(arg.isVolatile);
+                hasher.updateValue(arg.isPipe);
+            }
+            hasher.updateString(kernel.language);
+            hasher.updateValue(kernel.langVersion);
+            hasher.updateValue(kernel.reqdWorkGroupSize);
+            hasher.updateValue(kernel.workGroupSizeHint);
+            hasher.updateString(kernel.vecTypeHint);
+            hasher.updateString(kernel.runtimeHandle);
+            hasher.updateValue(kernel.kernargSegmentSize);
+            hasher.updateValue(kernel.groupSegmentFixedSize);
+            hasher.updateValue(kernel.privateSegmentFixedSize);
+            hasher.updateValue(kernel.kernargSegmentAlign);
+            hasher.updateValue(kernel.wavefrontSize);
+            hasher.updateValue(kernel.sgprsNum);
+            hasher.updateValue(kernel.vgprsNum);
+            hasher.updateValue(kernel.maxFlatWorkGroupSize);
+            hasher.updateValue(kernel.fixedWorkGroupSize);
+            hasher.updateValue(kernel.spilledSgprs);
+            hasher.updateValue(kernel.spilledVgprs);
+            hasher.updateString(kernel.deviceEnqueueSymbol);
+        }
+    }
+    hasher.updateValue(uint64_t(input.gotSymbols.size()));
+    for (size_t symIndex: input.gotSymbols)
+        hasher.updateValue(uint64_t(symIndex));
+    hasher.updateSections(input.extraSections);
+    hasher.updateSymbols(input.extraSymbols);
+    return hasher.getKey();
+}
+
+void ROCmBinGenerator::generateInternal(std::ostream* osPtr, std::vector<char>* vPtr,
+             Array<cxbyte>* aPtr, BinaryTemplate* binTemplate)
+{
+    if (binTemplate == nullptr)
+    {
+        generateBinary(osPtr, vPtr, aPtr, nullptr);
+        return;
+    }
+    // template can not be used if metadata is generated from kernel configs in code
+    if (input->useMetadataInfo && !input->metadataV3Format)
+    {
+        // full generation (with preparing)
+        prepareBinaryGen();
+        generateBinary(osPtr, vPtr, aPtr, nullptr);
+        return;
+    }
+    const std::vector<BinaryTemplate::Code> codes{ { input->codeSize, input->code } };
+    const uint64_t key = getROCmInputKey(*input);
+    if (!binTemplate->matches(key, codes))
+    {
+        // generate new template from input with code padded to its capacity
+        binTemplate->prepare(key, codes);
+        ROCmInput paddedInput = *input;
+        paddedInput.codeSize = binTemplate->getCodeCapacity(0);
+        paddedInput.code = binTemplate->getPaddedCode(0);
+        ROCmBinGenerator(&paddedInput).generateBinary(nullptr, nullptr,
+                    &binTemplate->getBinary(), binTemplate);
+        binTemplate->setPrepared();
+    }
+    binTemplate->write(codes, osPtr, vPtr, aPtr);
 }
 
 void ROCmBinGenerator::generate(Array<cxbyte>& array)
 {
-    generateInternal(nullptr, nullptr, &array);
+    generateInternal(nullptr, nullptr, &array, nullptr);
 }
 
 void ROCmBinGenerator::generate(std::ostream& os)
 {
-    generateInternal(&os, nullptr, nullptr);
+    generateInternal(&os, nullptr, nullptr, nullptr);
 }
 
 void ROCmBinGenerator::generate(std::vector<char>& v)
 {
-    generateInternal(nullptr, &v, nullptr);
+    generateInternal(nullptr, &v, nullptr, nullptr);
+}
+
+void ROCmBinGenerator::generate(Array<cxbyte>& array, BinaryTemplate& binTemplate)
+{
+    generateInternal(nullptr, nullptr, &array, &binTemplate);
+}
+
+void ROCmBinGenerator::generate(std::ostream& os, BinaryTemplate& binTemplate)
+{
+    generateInternal(&os, nullptr, nullptr, &binTemplate);
+}
+
+void ROCmBinGenerator::generate(std::vector<char>& v, BinaryTemplate& binTemplate)
+{
+    generateInternal(nullptr, &v, nullptr, &binTemplate);
 }
@@ -18,6 +18,7 @@
  */
 
 #include <CLRX/Config.h>
+#include <cctype>
 #include <cstring>
 #include <cstdint>
 #include <string>
@@ -114,6 +115,56 @@ static void skipSpacesToNextLine(const char*& ptr, const char* end, size_t& line
     }
 }
 
+/// reference to string in metadata or in decoded string buffer
+struct CLRX_INTERNAL YAMLStrRef
+{
+    const char* begin;  ///< start of string
+    const char* end;    ///< end of string
+};
+
+// compare C-string with string reference (like strcmp or strcasecmp)
+// string reference can have null characters, hence C-string is checked per character
+static int compareStrRef(const char* str, YAMLStrRef ref, bool ignoreCase = false)
+{
+    const size_t len = ref.end - ref.begin;
+    for (size_t i = 0; i < len; i++)
+    {
+        int c1 = cxbyte(str[i]);
+        int c2 = cxbyte(ref.begin[i]);
+        if (c1 == 0)
+            return -1; // end of C-string
+        if (ignoreCase)
+        {
+            c1 = ::tolower(c1);
+            c2 = ::tolower(c2);
+        }
+        if (c1 != c2)
+            return c1 - c2;
+    }
+    return (str[len] != 0) ? 1 : 0;
+}
+
+// find string reference in sorted table, return index or tableSize if not found
+template<typename T, typename GetName>
+static size_t findStrRef(const T* table, size_t tableSize, YAMLStrRef ref,
+                GetName getName)
+{
+    const T* it = std::lower_bound(table, table+tableSize, ref,
+            [&getName](const T& elem, YAMLStrRef r)
+            { return compareStrRef(getName(elem), r) < 0; });
+    if (it == table+tableSize || compareStrRef(getName(*it), ref) != 0)
+        return tableSize;
+    return it - table;
+}
+
+// returns true if C-string is equal to string reference (ignore case)
+static inline bool equalStrRefIgnoreCase(const char* str, YAMLStrRef ref)
+{ return compareStrRef(str, ref, true) == 0; }
+
+// copy string reference to destination string
+static inline void assignStrRef(CString& dest, YAMLStrRef ref)
+{ dest.assign(ref.begin, ref.end); }
+
 enum class YAMLValType
 {
     NONE,
@@ -180,10 +231,8 @@ static size_t parseYAMLKey(const char*& ptr, const char* end, size_t lineNo,
     if (afterColon == ptr && ptr != end && *ptr!='\n')
         // only if not immediate newline
         throw ParseException(lineNo, "After key and colon must be space");
-    CString keyword(keyPtr, keyEnd);
-    const size_t index = binaryFind(keywords, keywords+keywordsNum,
-                        keyword.c_str(), CStringLess()) - keywords;
-    return index;
+    return findStrRef(keywords, keywordsNum, { keyPtr, keyEnd },
+                [](const char* k) { return k; });
 }
 
 // parse YAML integer value
@@ -238,12 +287,12 @@ static bool parseYAMLBoolValue(const char*& ptr, const char* end, size_t& lineNo
     
     const char* wordPtr = ptr;
     while(ptr != end && isAlnum(*ptr)) ptr++;
-    CString word(wordPtr, ptr);
+    const YAMLStrRef word = { wordPtr, ptr };
     
     bool value = false;
     bool isSet = false;
     for (const char* v: { "1", "true", "t", "on", "yes", "y"})
-        if (::strcasecmp(word.c_str(), v) == 0)
+        if (equalStrRefIgnoreCase(v, word))
         {
             isSet = true;
             value = true;
@@ -251,7 +300,7 @@ static bool parseYAMLBoolValue(const char*& ptr, const char* end, size_t& lineNo
         }
     if (!isSet)
         for (const char* v: { "0", "false", "f", "off", "no", "n"})
-            if (::strcasecmp(word.c_str(), v) == 0)
+            if (equalStrRefIgnoreCase(v, word))
             {
                 isSet = true;
                 value = false;
@@ -266,21 +315,18 @@ static bool parseYAMLBoolValue(const char*& ptr, const char* end, size_t& lineNo
 }
 
 // trim spaces (remove spaces from start and end)
-static std::string trimStrSpaces(const std::string& str)
+static YAMLStrRef trimStrSpaces(YAMLStrRef str)
 {
-    size_t i = 0;
-    const size_t sz = str.size();
-    while (i!=sz && isSpace(str[i])) i++;
-    if (i == sz) return "";
-    size_t j = sz-1;
-    while (j>i && isSpace(str[j])) j--;
-    return str.substr(i, j-i+1);
+    while (str.begin != str.end && isSpace(*str.begin)) str.begin++;
+    while (str.end != str.begin && isSpace(str.end[-1])) str.end--;
+    return str;
 }
 
-static std::string parseYAMLString(const char*& linePtr, const char* end,
-            size_t& lineNo)
+/* parse quoted string. if string has no escapes then returns reference to
+ * the metadata content, otherwise decodes string into strBuf */
+static YAMLStrRef parseYAMLString(const char*& linePtr, const char* end,
+            size_t& lineNo, std::string& strBuf)
 {
-    std::string strarray;
     if (linePtr == end || (*linePtr != '"' && *linePtr != '\''))
     {
         while (linePtr != end && !isSpace(*linePtr) && *linePtr != ',') linePtr++;
@@ -289,6 +335,19 @@ static std::string parseYAMLString(const char*& linePtr, const char* end,
     const char termChar = *linePtr;
     linePtr++;
     
+    // fast path: find end of string or first escape
+    const char* strStart = linePtr;
+    while (linePtr != end && *linePtr != termChar && *linePtr != '\\')
+    {
+        if (*linePtr=='\n')
+            lineNo++;
+        linePtr++;
+    }
+    if (linePtr != end && *linePtr == termChar)
+        return { strStart, linePtr++ };
+    
+    std::string& strarray = strBuf;
+    strarray.assign(strStart, linePtr);
     // main loop, where is character parsing
     while (linePtr != end && *linePtr != termChar)
     {
@@ -390,15 +449,18 @@ static std::string parseYAMLString(const char*& linePtr, const char* end,
     if (linePtr == end)
         throw ParseException(lineNo, "Unterminated string");
     linePtr++;
-    return strarray;
+    return { strarray.data(), strarray.data() + strarray.size() };
 }
 
-static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_t& lineNo,
-                    cxuint prevIndent, bool singleValue = false, bool blockAccept = true)
+/* parse string value. returns reference to the metadata content (if possible)
+ * or to strBuf that holds decoded string (valid until next parsing) */
+static YAMLStrRef parseYAMLStringValue(const char*& ptr, const char* end, size_t& lineNo,
+            cxuint prevIndent, std::string& strBuf, bool singleValue = false,
+            bool blockAccept = true)
 {
     skipSpacesToLineEnd(ptr, end);
     if (ptr == end)
-        return "";
+        return { ptr, ptr };
     
     // skip !!str
     YAMLValType valType = parseYAMLType(ptr, end, lineNo);
@@ -406,14 +468,14 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
     {   // if 
         skipSpacesToLineEnd(ptr, end);
         if (ptr == end)
-            return "";
+            return { ptr, ptr };
     }
     else if (valType != YAMLValType::NONE)
         throw ParseException(lineNo, "Expected value of string type");
     
-    std::string buf;
+    YAMLStrRef strRef;
     if (*ptr=='"' || *ptr== '\'')
-        buf = parseYAMLString(ptr, end, lineNo);
+        strRef = parseYAMLString(ptr, end, lineNo, strBuf);
     // otherwise parse stream
     else if (*ptr == '|' || *ptr == '>')
     {
@@ -426,7 +488,7 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
         if (ptr!=end && *ptr!='\n')
             throw ParseException(lineNo, "Garbages at string block");
         if (ptr == end)
-            return ""; // end
+            return { ptr, ptr }; // end
         lineNo++;
         ptr++; // skip newline
         const char* lineStart = ptr;
@@ -435,7 +497,8 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
         if (indent <= prevIndent)
             throw ParseException(lineNo, "Unindented string block");
         
-        std::string buf;
+        std::string& buf = strBuf;
+        buf.clear();
         while(ptr != end)
         {
             const char* strStart = ptr;
@@ -472,7 +535,7 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
                     buf.append("\n"); // always add newline at last line
                     if (ptr != end)
                         ptr = lineStart;
-                    return buf;
+                    return { buf.data(), buf.data() + buf.size() };
                 }
                 else // if this same and not end of line
                     break;
@@ -485,7 +548,7 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
             // to indent
             ptr = lineStart + indent;
         }
-        return buf;
+        return { buf.data(), buf.data() + buf.size() };
     }
     else
     {
@@ -502,12 +565,12 @@ static std::string parseYAMLStringValue(const char*& ptr, const char* end, size_
         if (strEnd != end && !isSpace(*strEnd))
             strEnd++;
         
-        buf.assign(strStart, strEnd);
+        strRef = { strStart, strEnd };
     }
     
     if (singleValue)
         skipSpacesToNextLine(ptr, end, lineNo);
-    return buf;
+    return strRef;
 }
 
 /// element consumer class
@@ -671,6 +734,7 @@ class CLRX_INTERNAL YAMLPrintfVectorConsumer: public YAMLElemConsumer
 {
 private:
     std::unordered_set<cxuint> printfIds;
+    std::string strBuf;
 public:
     std::vector<ROCmPrintfInfo>& printfInfos;
     
@@ -682,16 +746,15 @@ public:
                 cxuint prevIndent, bool singleValue, bool blockAccept)
     {
         const size_t oldLineNo = lineNo;
-        std::string str = parseYAMLStringValue(ptr, end, lineNo, prevIndent,
-                                singleValue, blockAccept);
+        const YAMLStrRef str = parseYAMLStringValue(ptr, end, lineNo, prevIndent,
+                                strBuf, singleValue, blockAccept);
         // parse printf string
         ROCmPrintfInfo printfInfo{};
         
-        const char* ptr2 = str.c_str();
-        const char* end2 = str.c_str() + str.size();
-        parsePrintfInfoString(ptr2, end2, oldLineNo, lineNo, printfInfo, printfIds);
+        const char* ptr2 = str.begin;
+        parsePrintfInfoString(ptr2, str.end, oldLineNo, lineNo, printfInfo, printfIds);
         
-        printfInfos.push_back(printfInfo);
+        printfInfos.push_back(std::move(printfInfo));
     }
 };
 
@@ -944,6 +1007,8 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
     metadataInfo.version[0] = metadataInfo.version[1] = 0;
     
     std::vector<ROCmKernelMetadata>& kernels = metadataInfo.kernels;
+    // buffer for decoded strings (quoted with escapes and block strings)
+    std::string strBuf;
     
     cxuint levels[6] = { UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX, UINT_MAX };
     cxuint curLevel = 0;
@@ -1112,7 +1177,8 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                     canToNextLevel = true;
                     break;
                 case ROCMMT_KERNEL_LANGUAGE:
-                    kernel.language = parseYAMLStringValue(ptr, end, lineNo, level, true);
+                    assignStrRef(kernel.language, parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
                     break;
                 case ROCMMT_KERNEL_LANGUAGE_VERSION:
                 {
@@ -1121,10 +1187,12 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                     break;
                 }
                 case ROCMMT_KERNEL_NAME:
-                    kernel.name = parseYAMLStringValue(ptr, end, lineNo, level, true);
+                    assignStrRef(kernel.name, parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
                     break;
                 case ROCMMT_KERNEL_SYMBOLNAME:
-                    kernel.symbolName = parseYAMLStringValue(ptr, end, lineNo, level, true);
+                    assignStrRef(kernel.symbolName, parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
                     break;
                 default:
                     skipYAMLValue(ptr, end, lineNo, level);
@@ -1148,12 +1216,12 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                     break;
                 }
                 case ROCMMT_ATTRS_RUNTIME_HANDLE:
-                    kernel.runtimeHandle = parseYAMLStringValue(
-                                ptr, end, lineNo, level, true);
+                    assignStrRef(kernel.runtimeHandle, parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
                     break;
                 case ROCMMT_ATTRS_VECTYPEHINT:
-                    kernel.vecTypeHint = parseYAMLStringValue(
-                                ptr, end, lineNo, level, true);
+                    assignStrRef(kernel.vecTypeHint, parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
                     break;
                 case ROCMMT_ATTRS_WORK_GROUP_SIZE_HINT:
                 {
@@ -1255,11 +1323,11 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                 case ROCMMT_ARGS_ACCQUAL:
                 case ROCMMT_ARGS_ACTUALACCQUAL:
                 {
-                    const std::string acc = trimStrSpaces(parseYAMLStringValue(
-                                    ptr, end, lineNo, level, true));
+                    const YAMLStrRef acc = trimStrSpaces(parseYAMLStringValue(
+                                    ptr, end, lineNo, level, strBuf, true));
                     size_t accIndex = 0;
                     for (; accIndex < 4; accIndex++)
-                        if (::strcmp(rocmAccessQualifierTbl[accIndex], acc.c_str())==0)
+                        if (compareStrRef(rocmAccessQualifierTbl[accIndex], acc)==0)
                             break;
                     if (accIndex == 4)
                         throw ParseException(lineNo, "Wrong access qualifier");
@@ -1271,12 +1339,12 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                 }
                 case ROCMMT_ARGS_ADDRSPACEQUAL:
                 {
-                    const std::string aspace = trimStrSpaces(parseYAMLStringValue(
-                                    ptr, end, lineNo, level, true));
+                    const YAMLStrRef aspace = trimStrSpaces(parseYAMLStringValue(
+                                    ptr, end, lineNo, level, strBuf, true));
                     size_t aspaceIndex = 0;
                     for (; aspaceIndex < 6; aspaceIndex++)
-                        if (::strcasecmp(rocmAddrSpaceTypesTbl[aspaceIndex],
-                                    aspace.c_str())==0)
+                        if (equalStrRefIgnoreCase(rocmAddrSpaceTypesTbl[aspaceIndex],
+                                    aspace))
                             break;
                     if (aspaceIndex == 6)
                         throw ParseException(valLineNo, "Wrong address space");
@@ -1299,7 +1367,8 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                     kernelArg.isVolatile = parseYAMLBoolValue(ptr, end, lineNo, true);
                     break;
                 case ROCMMT_ARGS_NAME:
-                    kernelArg.name = parseYAMLStringValue(ptr, end, lineNo, level, true);
+                    assignStrRef(kernelArg.name, parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
                     break;
                 case ROCMMT_ARGS_POINTEE_ALIGN:
                     kernelArg.pointeeAlign =
@@ -1309,16 +1378,17 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                     kernelArg.size = parseYAMLIntValue<uint64_t>(ptr, end, lineNo);
                     break;
                 case ROCMMT_ARGS_TYPENAME:
-                    kernelArg.typeName =
-                                parseYAMLStringValue(ptr, end, lineNo, level, true);
+                    assignStrRef(kernelArg.typeName, parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
                     break;
                 case ROCMMT_ARGS_VALUEKIND:
                 {
-                    const std::string vkind = trimStrSpaces(parseYAMLStringValue(
-                                ptr, end, lineNo, level, true));
-                    const size_t vkindIndex = binaryMapFind(rocmValueKindNamesMap,
-                            rocmValueKindNamesMap + rocmValueKindNamesNum, vkind.c_str(),
-                            CStringLess()) - rocmValueKindNamesMap;
+                    const YAMLStrRef vkind = trimStrSpaces(parseYAMLStringValue(
+                                ptr, end, lineNo, level, strBuf, true));
+                    const size_t vkindIndex = findStrRef(rocmValueKindNamesMap,
+                            rocmValueKindNamesNum, vkind,
+                            [](const std::pair<const char*, ROCmValueKind>& e)
+                            { return e.first; });
                     // if unknown kind
                     if (vkindIndex == rocmValueKindNamesNum)
                         throw ParseException(valLineNo, "Wrong argument value kind");
@@ -1327,11 +1397,12 @@ void CLRX::parseROCmMetadata(size_t metadataSize, const char* metadata,
                 }
                 case ROCMMT_ARGS_VALUETYPE:
                 {
-                    const std::string vtype = trimStrSpaces(parseYAMLStringValue(
-                                    ptr, end, lineNo, level, true));
-                    const size_t vtypeIndex = binaryMapFind(rocmValueTypeNamesMap,
-                            rocmValueTypeNamesMap + rocmValueTypeNamesNum, vtype.c_str(),
-                            CStringLess()) - rocmValueTypeNamesMap;
+                    const YAMLStrRef vtype = trimStrSpaces(parseYAMLStringValue(
+                                    ptr, end, lineNo, level, strBuf, true));
+                    const size_t vtypeIndex = findStrRef(rocmValueTypeNamesMap,
+                            rocmValueTypeNamesNum, vtype,
+                            [](const std::pair<const char*, ROCmValueType>& e)
+                            { return e.first; });
                     // if unknown type
                     if (vtypeIndex == rocmValueTypeNamesNum)
                         throw ParseException(valLineNo, "Wrong argument value type");
@@ -18,6 +18,7 @@
  */
 
 #include <CLRX/Config.h>
+#include <cctype>
 #include <cstring>
 #include <cstdint>
 #include <string>
@@ -39,17 +40,71 @@ void parsePrintfInfoString(const char* ptr2, const char* end2, size_t oldLineNo,
 using namespace CLRX;
 
 // trim spaces (remove spaces from start and end)
-static std::string trimStrSpaces(const std::string& str)
+static MsgPackStringRef trimStrSpaces(MsgPackStringRef str)
 {
-    size_t i = 0;
-    const size_t sz = str.size();
-    while (i!=sz && isSpace(str[i])) i++;
-    if (i == sz) return "";
-    size_t j = sz-1;
-    while (j>i && isSpace(str[j])) j--;
-    return str.substr(i, j-i+1);
+    while (str.size != 0 && isSpace(*str.ptr))
+    {
+        str.ptr++;
+        str.size--;
+    }
+    while (str.size != 0 && isSpace(str.ptr[str.size-1])) str.size--;
+    return str;
+}
+
+// compare C-string with string reference (like strcmp or strcasecmp)
+static int compareStrRef(const char* str, const MsgPackStringRef& ref,
+                bool ignoreCase = false)
+{
+    for (size_t i = 0; i < ref.size; i++)
+    {
+        int c1 = cxbyte(str[i]);
+        int c2 = cxbyte(ref.ptr[i]);
+        if (c1 == 0)
+            return -1; // end of C-string
+        if (ignoreCase)
+        {
+            c1 = ::tolower(c1);
+            c2 = ::tolower(c2);
+        }
+        if (c1 != c2)
+            return c1 - c2;
+    }
+    return (str[ref.size] != 0) ? 1 : 0;
+}
+
+// find string reference in sorted table, return index or tableSize if not found
+template<typename T, typename GetName>
+static size_t findStrRef(const T* table, size_t tableSize, const MsgPackStringRef& ref,
+                GetName getName, bool ignoreCase = false)
+{
+    const T* it = std::lower_bound(table, table+tableSize, ref,
+            [&getName, ignoreCase](const T& elem, const MsgPackStringRef& r)
+            { return compareStrRef(getName(elem), r, ignoreCase) < 0; });
+    if (it == table+tableSize || compareStrRef(getName(*it), ref, ignoreCase) != 0)
+        return tableSize;
+    return it - table;
+}
+
+static inline const char* getTableName(const char* name)
+{ return name; }
+
+template<typename T>
+static inline const char* getTableName(const std::pair<const char*, T>& elem)
+{ return elem.first; }
+
+// find string reference in sorted table of names or pairs (name, value)
+template<typename T>
+static size_t findStrRef(const T* table, size_t tableSize, const MsgPackStringRef& ref,
+                bool ignoreCase = false)
+{
+    return findStrRef(table, tableSize, ref,
+                [](const T& elem) { return getTableName(elem); }, ignoreCase);
 }
 
+// copy string reference to destination string
+static inline void assignStrRef(CString& dest, const MsgPackStringRef& ref)
+{ dest.assign(ref.begin(), ref.end()); }
+
 /*
  * ROCm metadata MsgPack parser
  */
@@ -170,7 +225,8 @@ static double parseMsgPackFloat(const cxbyte*& dataPtr, const cxbyte* dataEnd)
         throw ParseException("MsgPack: Can't parse float value");
 }
 
-static std::string parseMsgPackString(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+static MsgPackStringRef parseMsgPackStringRef(const cxbyte*& dataPtr,
+                const cxbyte* dataEnd)
 {
     if (dataPtr>=dataEnd)
         throw ParseException("MsgPack: Can't parse string");
@@ -205,14 +261,17 @@ static std::string parseMsgPackString(const cxbyte*& dataPtr, const cxbyte* data
         }
     }
     
-    if (dataPtr+size > dataEnd)
+    if (size > size_t(dataEnd - dataPtr))
         throw ParseException("MsgPack: Can't parse string");
-    const char* strData = reinterpret_cast<const char*>(dataPtr);
-    std::string out(strData, strData + size);
+    const MsgPackStringRef out = { reinterpret_cast<const char*>(dataPtr), size };
     dataPtr += size;
     return out;
 }
 
+static inline std::string parseMsgPackString(const cxbyte*& dataPtr,
+                const cxbyte* dataEnd)
+{ return parseMsgPackStringRef(dataPtr, dataEnd).toString(); }
+
 static Array<cxbyte> parseMsgPackData(const cxbyte*& dataPtr, const cxbyte* dataEnd)
 {
     if (dataPtr>=dataEnd)
@@ -249,112 +308,99 @@ static Array<cxbyte> parseMsgPackData(const cxbyte*& dataPtr, const cxbyte* data
     return out;
 }
 
-static void skipMsgPackObject(const cxbyte*& dataPtr, const cxbyte* dataEnd)
+// read big-endian size of MsgPack object (bytesNum - number of bytes of size)
+static inline size_t readMsgPackSkipSize(const cxbyte*& dataPtr, const cxbyte* dataEnd,
+                cxuint bytesNum)
 {
-    if (dataPtr>=dataEnd)
+    if (size_t(dataEnd - dataPtr) < bytesNum)
         throw ParseException("MsgPack: Can't skip object");
-    if (*dataPtr==0xc0 || *dataPtr==0xc2 || *dataPtr==0xc3 ||
-        *dataPtr < 0x80 || *dataPtr >= 0xe0)
-        dataPtr++;
-    else if (*dataPtr==0xcc || *dataPtr==0xd0)
-    {
-        if (dataPtr+1>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        dataPtr += 2;
-    }
-    else if (*dataPtr==0xcd || *dataPtr==0xd1)
-    {
-        if (dataPtr+2>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        dataPtr += 3;
-    }
-    else if (*dataPtr==0xce || *dataPtr==0xd2 || *dataPtr==0xca)
-    {
-        if (dataPtr+4>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        dataPtr += 5;
-    }
-    else if (*dataPtr==0xcf || *dataPtr==0xd3 || *dataPtr==0xcb)
-    {
-        if (dataPtr+8>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        dataPtr += 9;
-    }
-    else if(((*dataPtr)&0xe0)==0xa0)
-    {
-        const size_t size = *dataPtr&0x1f;
-        if (dataPtr+size>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        dataPtr += size+1;
-    }
-    else if (*dataPtr == 0xc4 || *dataPtr == 0xd9)
+    size_t size = 0;
+    for (cxuint i = 0; i < bytesNum; i++)
+        size = (size<<8) | *dataPtr++;
+    return size;
+}
+
+/* skip objects without recursion: elements of the nested arrays and maps
+ * are added to number of objects to skip */
+static void skipMsgPackObjects(const cxbyte*& dataPtr, const cxbyte* dataEnd,
+                size_t objectsNum)
+{
+    while (objectsNum != 0)
     {
-        dataPtr++;
         if (dataPtr>=dataEnd)
             throw ParseException("MsgPack: Can't skip object");
-        const size_t size = *dataPtr++;
-        if (dataPtr+size>dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        dataPtr += size;
-    }
-    else if (*dataPtr == 0xc5 || *dataPtr == 0xda)
-    {
-        dataPtr++;
-        if (dataPtr+1>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        size_t size = uint16_t(*dataPtr++)<<8;
-        size |= *dataPtr++;
-        if (dataPtr+size>dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        dataPtr += size;
-    }
-    else if (*dataPtr == 0xc6 || *dataPtr == 0xdb)
-    {
-        dataPtr++;
-        if (dataPtr+1>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        size_t size = 0;
-        for (cxint i = 24; i >= 0; i-=8)
-            size |= uint32_t(*dataPtr++)<<i;
-        if (dataPtr+size>dataEnd)
+        objectsNum--;
+        const cxbyte code = *dataPtr++;
+        size_t size = 0; // size of data
+        size_t elemsNum = 0; // number of nested objects
+        if (code < 0x80 || code >= 0xe0 || code==0xc0 || code==0xc2 || code==0xc3)
+            continue;
+        else if ((code&0xe0)==0xa0)
+            size = code&0x1f;
+        else if ((code&0xf0) == 0x90)
+            elemsNum = code&15;
+        else if ((code&0xf0) == 0x80)
+            elemsNum = size_t(code&15)<<1;
+        else
+            switch(code)
+            {
+                case 0xcc:
+                case 0xd0:
+                    size = 1;
+                    break;
+                case 0xcd:
+                case 0xd1:
+                    size = 2;
+                    break;
+                case 0xce:
+                case 0xd2:
+                case 0xca:
+                    size = 4;
+                    break;
+                case 0xcf:
+                case 0xd3:
+                case 0xcb:
+                    size = 8;
+                    break;
+                case 0xc4:
+                case 0xd9:
+                    size = readMsgPackSkipSize(dataPtr, dataEnd, 1);
+                    break;
+                case 0xc5:
+                case 0xda:
+                    size = readMsgPackSkipSize(dataPtr, dataEnd, 2);
+                    break;
+                case 0xc6:
+                case 0xdb:
+                    size = readMsgPackSkipSize(dataPtr, dataEnd, 4);
+                    break;
+                case 0xdc:
+                    elemsNum = readMsgPackSkipSize(dataPtr, dataEnd, 2);
+                    break;
+                case 0xdd:
+                    elemsNum = readMsgPackSkipSize(dataPtr, dataEnd, 4);
+                    break;
+                case 0xde:
+                    elemsNum = readMsgPackSkipSize(dataPtr, dataEnd, 2)<<1;
+                    break;
+                case 0xdf:
+                    elemsNum = readMsgPackSkipSize(dataPtr, dataEnd, 4)<<1;
+                    break;
+                default:
+                    throw ParseException("MsgPack: Can't skip object");
+            }
+        
+        if (size > size_t(dataEnd - dataPtr))
             throw ParseException("MsgPack: Can't skip object");
         dataPtr += size;
-    }
-    else if ((*dataPtr&0xf0) == 0x90 || (*dataPtr&0xf0) == 0x80)
-    {
-        const bool isMap = (*dataPtr<0x90);
-        size_t size = (*dataPtr++)&15;
-        if (isMap)
-            size <<= 1;
-        for (size_t i = 0; i < size; i++)
-            skipMsgPackObject(dataPtr, dataEnd);
-    }
-    else if (*dataPtr == 0xdc || *dataPtr==0xde)
-    {
-        const bool isMap = (*dataPtr==0xde);
-        dataPtr++;
-        if (dataPtr>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        size_t size = uint16_t(*dataPtr++)<<8;
-        size |= *dataPtr++;
-        if (isMap)
-            size<<=1;
-        for (size_t i = 0; i < size; i++)
-            skipMsgPackObject(dataPtr, dataEnd);
-    }
-    else if (*dataPtr == 0xdd || *dataPtr==0xdf)
-    {
-        const bool isMap = (*dataPtr==0xdf);
-        dataPtr++;
-        if (dataPtr>=dataEnd)
-            throw ParseException("MsgPack: Can't skip object");
-        size_t size = 0;
-        for (cxint i = 24; i >= 0; i-=8)
-            size |= (*dataPtr++)<<i;
-        if (isMap)
-            size<<=1;
-        for (size_t i = 0; i < size; i++)
-            skipMsgPackObject(dataPtr, dataEnd);
+        if (elemsNum != 0)
+        {
+            // any object has at least one byte
+            const size_t remaining = dataEnd - dataPtr;
+            if (objectsNum > remaining || elemsNum > remaining - objectsNum)
+                throw ParseException("MsgPack: Can't skip object");
+            objectsNum += elemsNum;
+        }
     }
 }
 
@@ -434,6 +480,14 @@ std::string MsgPackArrayParser::parseString()
     return v;
 }
 
+MsgPackStringRef MsgPackArrayParser::parseStringRef()
+{
+    handleErrors();
+    auto v = parseMsgPackStringRef(dataPtr, dataEnd);
+    count--;
+    return v;
+}
+
 Array<cxbyte> MsgPackArrayParser::parseData()
 {
     handleErrors();
@@ -458,10 +512,16 @@ MsgPackMapParser MsgPackArrayParser::parseMap()
     return v;
 }
 
+void MsgPackArrayParser::skipElement()
+{
+    handleErrors();
+    skipMsgPackObjects(dataPtr, dataEnd, 1);
+    count--;
+}
+
 size_t MsgPackArrayParser::end()
 {
-    for (size_t i = 0; i < count; i++)
-        skipMsgPackObject(dataPtr, dataEnd);
+    skipMsgPackObjects(dataPtr, dataEnd, count);
     return count;
 }
 
@@ -537,6 +597,14 @@ std::string MsgPackMapParser::parseKeyString()
     return v;
 }
 
+MsgPackStringRef MsgPackMapParser::parseKeyStringRef()
+{
+    handleErrors(true);
+    auto v = parseMsgPackStringRef(dataPtr, dataEnd);
+    keyLeft = false;
+    return v;
+}
+
 Array<cxbyte> MsgPackMapParser::parseKeyData()
 {
     handleErrors(true);
@@ -596,6 +664,15 @@ std::string MsgPackMapParser::parseValueString()
     return v;
 }
 
+MsgPackStringRef MsgPackMapParser::parseValueStringRef()
+{
+    handleErrors(false);
+    auto v = parseMsgPackStringRef(dataPtr, dataEnd);
+    keyLeft = true;
+    count--;
+    return v;
+}
+
 Array<cxbyte> MsgPackMapParser::parseValueData()
 {
     handleErrors(false);
@@ -626,7 +703,7 @@ MsgPackMapParser MsgPackMapParser::parseValueMap()
 void MsgPackMapParser::skipValue()
 {
     handleErrors(false);
-    skipMsgPackObject(dataPtr, dataEnd);
+    skipMsgPackObjects(dataPtr, dataEnd, 1);
     keyLeft = true;
     count--;
 }
@@ -634,12 +711,13 @@ void MsgPackMapParser::skipValue()
 size_t MsgPackMapParser::end()
 {
     if (!keyLeft)
-        skipMsgPackObject(dataPtr, dataEnd);
-    for (size_t i = 0; i < count; i++)
     {
-        skipMsgPackObject(dataPtr, dataEnd);
-        skipMsgPackObject(dataPtr, dataEnd);
+        // skip value of already parsed key
+        skipMsgPackObjects(dataPtr, dataEnd, 1);
+        keyLeft = true;
+        count--;
     }
+    skipMsgPackObjects(dataPtr, dataEnd, count<<1);
     return count;
 }
 
@@ -724,19 +802,17 @@ static void parseROCmMetadataKernelArgMsgPack(MsgPackArrayParser& argsParser,
     MsgPackMapParser aParser = argsParser.parseMap();
     while (aParser.haveElements())
     {
-        const std::string name = aParser.parseKeyString();
-        const size_t index = binaryFind(rocmMetadataMPKernelArgNames,
-                    rocmMetadataMPKernelArgNames + rocmMetadataMPKernelArgNamesSize,
-                    name.c_str(), CStringLess()) - rocmMetadataMPKernelArgNames;
+        const size_t index = findStrRef(rocmMetadataMPKernelArgNames,
+                    rocmMetadataMPKernelArgNamesSize, aParser.parseKeyStringRef());
         switch(index)
         {
             case ROCMMP_ARG_ACCESS:
             case ROCMMP_ARG_ACTUAL_ACCESS:
             {
-                const std::string acc = trimStrSpaces(aParser.parseValueString());
+                const MsgPackStringRef acc = trimStrSpaces(aParser.parseValueStringRef());
                 size_t accIndex = 0;
                 for (; accIndex < 3; accIndex++)
-                    if (::strcmp(rocmMPAccessQualifierTbl[accIndex], acc.c_str())==0)
+                    if (acc == rocmMPAccessQualifierTbl[accIndex])
                         break;
                 if (accIndex == 3)
                     throw ParseException("Wrong access qualifier");
@@ -748,11 +824,12 @@ static void parseROCmMetadataKernelArgMsgPack(MsgPackArrayParser& argsParser,
             }
             case ROCMMP_ARG_ADDRESS_SPACE:
             {
-                const std::string aspace = trimStrSpaces(aParser.parseValueString());
+                const MsgPackStringRef aspace =
+                            trimStrSpaces(aParser.parseValueStringRef());
                 size_t aspaceIndex = 0;
                 for (; aspaceIndex < 6; aspaceIndex++)
-                    if (::strcasecmp(rocmMPAddrSpaceTypesTbl[aspaceIndex],
-                                aspace.c_str())==0)
+                    if (compareStrRef(rocmMPAddrSpaceTypesTbl[aspaceIndex],
+                                aspace, true)==0)
                         break;
                 if (aspaceIndex == 6)
                     throw ParseException("Wrong address space");
@@ -772,7 +849,7 @@ static void parseROCmMetadataKernelArgMsgPack(MsgPackArrayParser& argsParser,
                 argInfo.isVolatile = aParser.parseValueBool();
                 break;
             case ROCMMP_ARG_NAME:
-                argInfo.name = aParser.parseValueString();
+                assignStrRef(argInfo.name, aParser.parseValueStringRef());
                 break;
             case ROCMMP_ARG_OFFSET:
                 argInfo.offset = aParser.parseValueInteger(MSGPACK_WS_UNSIGNED);
@@ -784,14 +861,13 @@ static void parseROCmMetadataKernelArgMsgPack(MsgPackArrayParser& argsParser,
                 argInfo.size = aParser.parseValueInteger(MSGPACK_WS_UNSIGNED);
                 break;
             case ROCMMP_ARG_TYPE_NAME:
-                argInfo.typeName = aParser.parseValueString();
+                assignStrRef(argInfo.typeName, aParser.parseValueStringRef());
                 break;
             case ROCMMP_ARG_VALUE_KIND:
             {
-                const std::string vkind = trimStrSpaces(aParser.parseValueString());
-                const size_t vkindIndex = binaryMapFind(rocmMPValueKindNamesMap,
-                            rocmMPValueKindNamesMap + rocmMPValueKindNamesNum, vkind.c_str(),
-                            CStringLess()) - rocmMPValueKindNamesMap;
+                const MsgPackStringRef vkind = trimStrSpaces(aParser.parseValueStringRef());
+                const size_t vkindIndex = findStrRef(rocmMPValueKindNamesMap,
+                            rocmMPValueKindNamesNum, vkind);
                     // if unknown kind
                     if (vkindIndex == rocmMPValueKindNamesNum)
                         throw ParseException("Wrong argument value kind");
@@ -800,10 +876,9 @@ static void parseROCmMetadataKernelArgMsgPack(MsgPackArrayParser& argsParser,
             }
             case ROCMMP_ARG_VALUE_TYPE:
             {
-                const std::string vtype = trimStrSpaces(aParser.parseValueString());
-                const size_t vtypeIndex = binaryMapFind(rocmValueTypeNamesMap,
-                        rocmValueTypeNamesMap + rocmValueTypeNamesNum, vtype.c_str(),
-                        CStringCaseLess()) - rocmValueTypeNamesMap;
+                const MsgPackStringRef vtype = trimStrSpaces(aParser.parseValueStringRef());
+                const size_t vtypeIndex = findStrRef(rocmValueTypeNamesMap,
+                        rocmValueTypeNamesNum, vtype, true);
                 // if unknown type
                 if (vtypeIndex == rocmValueTypeNamesNum)
                     throw ParseException("Wrong argument value type");
@@ -842,16 +917,13 @@ static const char* rocmMetadataMPKernelNames[] =
 static const size_t rocmMetadataMPKernelNamesSize = sizeof(rocmMetadataMPKernelNames) /
                     sizeof(const char*);
 
-static void parseROCmMetadataKernelMsgPack(MsgPackArrayParser& kernelsParser,
+static void parseROCmMetadataKernelMsgPack(MsgPackMapParser& kParser,
                         ROCmKernelMetadata& kernel)
 {
-    MsgPackMapParser kParser = kernelsParser.parseMap();
     while (kParser.haveElements())
     {
-        const std::string name = kParser.parseKeyString();
-        const size_t index = binaryFind(rocmMetadataMPKernelNames,
-                    rocmMetadataMPKernelNames + rocmMetadataMPKernelNamesSize,
-                    name.c_str(), CStringLess()) - rocmMetadataMPKernelNames;
+        const size_t index = findStrRef(rocmMetadataMPKernelNames,
+                    rocmMetadataMPKernelNamesSize, kParser.parseKeyStringRef());
         
         switch(index)
         {
@@ -860,14 +932,13 @@ static void parseROCmMetadataKernelMsgPack(MsgPackArrayParser& kernelsParser,
                 MsgPackArrayParser argsParser = kParser.parseValueArray();
                 while (argsParser.haveElements())
                 {
-                    ROCmKernelArgInfo arg{};
-                    parseROCmMetadataKernelArgMsgPack(argsParser, arg);
-                    kernel.argInfos.push_back(arg);
+                    kernel.argInfos.push_back(ROCmKernelArgInfo{});
+                    parseROCmMetadataKernelArgMsgPack(argsParser, kernel.argInfos.back());
                 }
                 break;
             }
             case ROCMMP_KERNEL_DEVICE_ENQUEUE_SYMBOL:
-                kernel.deviceEnqueueSymbol = kParser.parseValueString();
+                assignStrRef(kernel.deviceEnqueueSymbol, kParser.parseValueStringRef());
                 break;
             case ROCMMP_KERNEL_GROUP_SEGMENT_FIXED_SIZE:
                 kernel.groupSegmentFixedSize = kParser.
@@ -882,7 +953,7 @@ static void parseROCmMetadataKernelMsgPack(MsgPackArrayParser& kernelsParser,
                                     parseValueInteger(MSGPACK_WS_UNSIGNED);
                 break;
             case ROCMMP_KERNEL_LANGUAGE:
-                kernel.language = kParser.parseValueString();
+                assignStrRef(kernel.language, kParser.parseValueStringRef());
                 break;
             case ROCMMP_KERNEL_LANGUAGE_VERSION:
                 parseMsgPackValueTypedArrayForMap(kParser, kernel.langVersion,
@@ -893,7 +964,7 @@ static void parseROCmMetadataKernelMsgPack(MsgPackArrayParser& kernelsParser,
                                     parseValueInteger(MSGPACK_WS_UNSIGNED);
                 break;
             case ROCMMP_KERNEL_NAME:
-                kernel.name = kParser.parseValueString();
+                assignStrRef(kernel.name, kParser.parseValueStringRef());
                 break;
             case ROCMMP_KERNEL_PRIVATE_SEGMENT_FIXED_SIZE:
                 kernel.privateSegmentFixedSize = kParser.
@@ -910,10 +981,10 @@ static void parseROCmMetadataKernelMsgPack(MsgPackArrayParser& kernelsParser,
                 kernel.spilledSgprs = kParser.parseValueInteger(MSGPACK_WS_UNSIGNED);
                 break;
             case ROCMMP_KERNEL_SYMBOL:
-                kernel.symbolName = kParser.parseValueString();
+                assignStrRef(kernel.symbolName, kParser.parseValueStringRef());
                 break;
             case ROCMMP_KERNEL_VEC_TYPE_HINT:
-                kernel.vecTypeHint = kParser.parseValueString();
+                assignStrRef(kernel.vecTypeHint, kParser.parseValueStringRef());
                 break;
             case ROCMMP_KERNEL_VGPR_COUNT:
                 kernel.vgprsNum = kParser.parseValueInteger(MSGPACK_WS_UNSIGNED);
@@ -948,7 +1019,7 @@ void CLRX::parseROCmMetadataMsgPack(size_t metadataSize, const cxbyte* metadata,
     MsgPackMapParser mainMap(metadata, metadata+metadataSize);
     while (mainMap.haveElements())
     {
-        const CString name = mainMap.parseKeyString();
+        const MsgPackStringRef name = mainMap.parseKeyStringRef();
         if (name == "amdhsa.version")
             parseMsgPackValueTypedArrayForMap(mainMap, metadataInfo.version,
                                         2, MSGPACK_WS_UNSIGNED);
@@ -957,10 +1028,11 @@ void CLRX::parseROCmMetadataMsgPack(size_t metadataSize, const cxbyte* metadata,
             MsgPackArrayParser kernelsParser = mainMap.parseValueArray();
             while (kernelsParser.haveElements())
             {
-                ROCmKernelMetadata kernel{};
+                kernels.push_back(ROCmKernelMetadata{});
+                ROCmKernelMetadata& kernel = kernels.back();
                 kernel.initialize();
-                parseROCmMetadataKernelMsgPack(kernelsParser, kernel);
-                kernels.push_back(kernel);
+                MsgPackMapParser kParser = kernelsParser.parseMap();
+                parseROCmMetadataKernelMsgPack(kParser, kernel);
             }
         }
         else if (name == "amdhsa.printf")
@@ -970,10 +1042,10 @@ void CLRX::parseROCmMetadataMsgPack(size_t metadataSize, const cxbyte* metadata,
             while (printfsParser.haveElements())
             {
                 ROCmPrintfInfo printfInfo{};
-                std::string pistr = printfsParser.parseString();
-                parsePrintfInfoString(pistr.c_str(), pistr.c_str() + pistr.size(),
+                const MsgPackStringRef pistr = printfsParser.parseStringRef();
+                parsePrintfInfoString(pistr.begin(), pistr.end(),
                                 0, 0, printfInfo, printfIds);
-                metadataInfo.printfInfos.push_back(printfInfo);
+                metadataInfo.printfInfos.push_back(std::move(printfInfo));
             }
         }
         else
@@ -986,6 +1058,55 @@ void ROCmMetadata::parseMsgPack(size_t metadataSize, const cxbyte* metadata)
     parseROCmMetadataMsgPack(metadataSize, metadata, *this);
 }
 
+bool CLRX::parseROCmKernelMetadataMsgPack(size_t metadataSize, const cxbyte* metadata,
+                const char* kernelName, ROCmKernelMetadata& kernelMetadata)
+{
+    const cxbyte* dataPtr = metadata;
+    const cxbyte* dataEnd = metadata + metadataSize;
+    MsgPackMapParser mainMap(dataPtr, dataEnd);
+    while (mainMap.haveElements())
+    {
+        if (mainMap.parseKeyStringRef() != "amdhsa.kernels")
+        {
+            mainMap.skipValue();
+            continue;
+        }
+        MsgPackArrayParser kernelsParser = mainMap.parseValueArray();
+        while (kernelsParser.haveElements())
+        {
+            const cxbyte* kernelPtr = dataPtr;
+            bool found = false;
+            {
+                // find kernel name, skip other values
+                MsgPackMapParser kParser = kernelsParser.parseMap();
+                while (kParser.haveElements())
+                {
+                    if (kParser.parseKeyStringRef() == ".name")
+                    {
+                        found = (kParser.parseValueStringRef() == kernelName);
+                        break;
+                    }
+                    kParser.skipValue();
+                }
+                if (!found)
+                {
+                    // skip rest of kernel metadata
+                    kParser.end();
+                    continue;
+                }
+            }
+            // parse kernel metadata from start
+            dataPtr = kernelPtr;
+            kernelMetadata = ROCmKernelMetadata{};
+            kernelMetadata.initialize();
+            MsgPackMapParser kParser(dataPtr, dataEnd);
+            parseROCmMetadataKernelMsgPack(kParser, kernelMetadata);
+            return true;
+        }
+    }
+    return false;
+}
+
 static void msgPackWriteString(const char* str, std::vector<cxbyte>& output)
 {
     const size_t len = ::strlen(str);
@@ -0,0 +1,126 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* assembler throughput benchmark: lines per second for Assembler::assemble()
+ * for synthetic sources (plain code, macro-heavy, rept-heavy and symbol-heavy) */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "BenchUtils.h"
+
+using namespace CLRX;
+
+// macro-heavy: every macro call expands to 4 instructions
+static std::string generateMacro(size_t linesNum)
+{
+    std::ostringstream oss;
+    oss << ".macro addmul dst, a, b, c\n"
+        "    v_add_f32 \\dst, \\a, \\b\n"
+        "    v_mul_f32 \\dst, \\dst, \\c\n"
+        "    .if \\c\n"
+        "    s_nop 1\n"
+        "    .endif\n"
+        ".endm\n";
+    for (size_t i = 0; i < linesNum; i += 4)
+        oss << "addmul v" << ((i*7)&63) << ", v" << ((i*3+1)&63) << ", v" <<
+                ((i*5+2)&63) << ", " << (i&1) << "\n";
+    return oss.str();
+}
+
+// rept-heavy: nested repetitions with counter expressions
+static std::string generateRept(size_t linesNum)
+{
+    std::ostringstream oss;
+    const size_t outer = (linesNum + 63) / 64;
+    oss << "cnt = 0\n"
+        ".rept " << outer << "\n"
+        "  .rept 16\n"
+        "    s_add_u32 s[cnt&63], s[(cnt+1)&63], cnt\n"
+        "    v_mov_b32 v[cnt&63], cnt*3\n"
+        "    v_add_f32 v[(cnt+2)&63], v[cnt&63], v[(cnt+1)&63]\n"
+        "    cnt = cnt+1\n"
+        "  .endr\n"
+        ".endr\n";
+    return oss.str();
+}
+
+// symbol-heavy: many labels, forward references and symbol assignments
+static std::string generateSymbols(size_t linesNum)
+{
+    std::ostringstream oss;
+    for (size_t i = 0; i < linesNum; i += 4)
+    {
+        oss << "sym" << i << " = (L" << (i+4) << " - .) + sym_base*" << (i&15) << "\n";
+        oss << "L" << i << ":\n";
+        oss << "s_branch L" << (i+4) << "\n";
+        oss << "s_mov_b32 s" << ((i*3)&63) << ", L" << (i+4) << "-L" << i << "\n";
+    }
+    oss << "L" << ((linesNum+3)&~size_t(3)) << ":\n"
+        "sym_base = 3\n";
+    return oss.str();
+}
+
+static uint64_t assembleSource(const std::string& source, GPUDeviceType deviceType,
+            BinaryFormat format = BinaryFormat::RAWCODE)
+{
+    std::istringstream iss(source);
+    std::ostringstream errorStream;
+    const BenchClock::time_point start = BenchClock::now();
+    Assembler assembler("bench.s", iss, ASM_ALL&~(ASM_ALTMACRO|ASM_WAVE32),
+                    format, deviceType, errorStream);
+    if (!assembler.assemble())
+        throw Exception("Assembler failed: " + errorStream.str());
+    return benchNanos(start, BenchClock::now());
+}
+
+int main(int argc, const char** argv)
+try
+{
+    BenchSession session("assembler", argc, argv);
+    const size_t linesNum = size_t(session.getScale()) * 20000;
+    
+    std::string source = generateGCNCode(linesNum);
+    session.run("plain", "lines", linesNum, [&source]()
+        { return assembleSource(source, GPUDeviceType::PITCAIRN); });
+    source = generateGCNCode(linesNum);
+    session.run("plain-gcn1.2", "lines", linesNum, [&source]()
+        { return assembleSource(source, GPUDeviceType::FIJI); });
+    source = generateMacro(linesNum);
+    // macro body has 5 lines (with conditional)
+    session.run("macro", "lines", (linesNum/4)*5, [&source]()
+        { return assembleSource(source, GPUDeviceType::PITCAIRN); });
+    source = generateRept(linesNum);
+    session.run("rept", "lines", ((linesNum+63)/64)*64, [&source]()
+        { return assembleSource(source, GPUDeviceType::PITCAIRN); });
+    source = generateSymbols(linesNum);
+    session.run("symbols", "lines", linesNum, [&source]()
+        { return assembleSource(source, GPUDeviceType::PITCAIRN); });
+    
+    session.writeJSON(std::cout);
+    return 0;
+}
+catch(const std::exception& ex)
+{
+    std::cerr << ex.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,171 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __CLRXBENCH_BENCHUTILS_H__
+#define __CLRXBENCH_BENCHUTILS_H__
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <CLRX/utils/Utilities.h>
+
+using namespace CLRX;
+
+/* common utilities for benchmarks: time measurement and JSON output.
+ * every benchmark program accepts optional arguments: [SCALE [REPEATS]]
+ * SCALE - scale factor of the synthetic input,
+ * REPEATS - number of repetitions (best time is chosen) */
+
+typedef std::chrono::steady_clock BenchClock;
+
+static inline uint64_t benchNanos(const BenchClock::time_point& start,
+            const BenchClock::time_point& end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+}
+
+/// single result of benchmark
+struct BenchResult
+{
+    std::string name;   ///< name of benchmark
+    std::string unit;   ///< unit of items (lines, instrs, bytes...)
+    uint64_t items;     ///< processed items in single run
+    uint64_t bestNanos; ///< best time of run in nanoseconds
+    uint64_t totalNanos;    ///< total time of all runs
+    cxuint runs;        ///< number of runs
+};
+
+/// benchmark session: holds parameters and collects results
+class BenchSession
+{
+private:
+    std::string suite;
+    cxuint scale;
+    cxuint repeats;
+    std::vector<BenchResult> results;
+public:
+    BenchSession(const char* _suite, int argc, const char** argv,
+            cxuint defScale = 1, cxuint defRepeats = 5)
+        : suite(_suite), scale(defScale), repeats(defRepeats)
+    {
+        if (argc >= 2)
+            scale = std::max(1, atoi(argv[1]));
+        if (argc >= 3)
+            repeats = std::max(1, atoi(argv[2]));
+    }
+    
+    cxuint getScale() const
+    { return scale; }
+    cxuint getRepeats() const
+    { return repeats; }
+    
+    /// add result from nanoseconds of the all runs
+    void addResult(const std::string& name, const std::string& unit, uint64_t items,
+            const std::vector<uint64_t>& runNanos)
+    {
+        BenchResult result{ name, unit, items, UINT64_MAX, 0, cxuint(runNanos.size()) };
+        for (uint64_t nanos: runNanos)
+        {
+            result.bestNanos = std::min(result.bestNanos, nanos);
+            result.totalNanos += nanos;
+        }
+        results.push_back(result);
+        // progress to standard error, JSON goes to standard output
+        std::cerr << suite << ": " << name << ": " << items << " " << unit <<
+                ", best " << (result.bestNanos/1000) << " us" << std::endl;
+    }
+    
+    /// run function 'repeats' times, func returns number of nanoseconds of the run
+    template<typename F>
+    void run(const std::string& name, const std::string& unit, uint64_t items, F func)
+    {
+        std::vector<uint64_t> runNanos(repeats);
+        for (cxuint i = 0; i < repeats; i++)
+            runNanos[i] = func();
+        addResult(name, unit, items, runNanos);
+    }
+    
+    /// print results as JSON document
+    void writeJSON(std::ostream& os) const
+    {
+        os << "{\n  \"suite\": \"" << suite << "\",\n"
+            "  \"scale\": " << scale << ",\n"
+            "  \"repeats\": " << repeats << ",\n"
+            "  \"results\": [";
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const BenchResult& r = results[i];
+            const double perSec = (r.bestNanos != 0) ?
+                    double(r.items)*1e9 / double(r.bestNanos) : 0.0;
+            os << (i!=0 ? ",\n" : "\n") <<
+                "    { \"name\": \"" << escapeStringCStyle(r.name) << "\", "
+                "\"unit\": \"" << r.unit << "\", \"items\": " << r.items << ",\n"
+                "      \"best_ns\": " << r.bestNanos << ", \"mean_ns\": " <<
+                (r.runs!=0 ? r.totalNanos / r.runs : 0) << ", \"" << r.unit << "_per_sec\": " <<
+                uint64_t(perSec) << " }";
+        }
+        os << "\n  ]\n}" << std::endl;
+    }
+};
+
+// GCN instructions used by synthetic code generator (valid for GCN 1.0-1.5)
+static const char* const benchGCNInstrs[8] =
+{
+    "s_mov_b32 s{0}, s{1}",
+    "s_add_u32 s{0}, s{1}, 0x{2}",
+    "v_add_f32 v{0}, v{1}, v{2}",
+    "v_mul_lo_u32 v{0}, v{1}, s{2}",
+    "v_mad_f32 v{0}, v{1}, v{2}, v{0}",
+    "buffer_load_dword v{0}, v{1}, s[4:7], 0 offen offset:{2}",
+    "s_waitcnt vmcnt(0) & lgkmcnt(0)",
+    "v_cndmask_b32 v{0}, v{1}, v{2}, vcc"
+};
+
+// substitute {0},{1},{2} by register numbers/values
+inline void putBenchGCNInstr(std::ostream& os, size_t i)
+{
+    const char* p = benchGCNInstrs[i&7];
+    const cxuint r0 = (i*7)&63, r1 = (i*13+5)&63, r2 = (i*17+3)&63;
+    for (; *p != 0; p++)
+        if (*p == '{' && p[1] >= '0' && p[1] <= '2' && p[2] == '}')
+        {
+            os << (p[1]=='0' ? r0 : (p[1]=='1' ? r1 : r2));
+            p += 2;
+        }
+        else
+            os.put(*p);
+    os.put('\n');
+}
+
+/// generate GCN source code with given number of lines (instructions)
+inline std::string generateGCNCode(size_t linesNum)
+{
+    std::ostringstream oss;
+    for (size_t i = 0; i < linesNum; i++)
+        putBenchGCNInstr(oss, i);
+    return oss.str();
+}
+
+#endif
@@ -0,0 +1,247 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* binary generation benchmark: time of the generating ELF binaries
+ * (AMD Catalyst, AMD OpenCL 2.0, GalliumCompute and ROCm) for many kernels.
+ * source is assembled once, then binary is written many times.
+ * writing big binary to file is measured through file stream and through
+ * preallocated file (positional writes and writable mapping) */
+
+#include <CLRX/Config.h>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#ifndef HAVE_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "BenchUtils.h"
+
+using namespace CLRX;
+
+static const size_t kernelInstrsNum = 64;
+
+static std::string generateAmdSource(size_t kernelsNum)
+{
+    std::ostringstream oss;
+    oss << ".amd\n.gpu Pitcairn\n";
+    for (size_t k = 0; k < kernelsNum; k++)
+    {
+        oss << ".kernel kernel" << k << "\n"
+            "    .config\n"
+            "        .dims x\n"
+            "        .arg n, uint\n"
+            "        .arg out, uint*, global\n"
+            "    .text\n";
+        for (size_t i = 0; i < kernelInstrsNum; i++)
+            putBenchGCNInstr(oss, k*kernelInstrsNum + i);
+        oss << "        s_endpgm\n";
+    }
+    return oss.str();
+}
+
+static std::string generateAmdCL2Source(size_t kernelsNum)
+{
+    std::ostringstream oss;
+    oss << ".amdcl2\n.gpu Bonaire\n.64bit\n.driver_version 191205\n";
+    for (size_t k = 0; k < kernelsNum; k++)
+    {
+        oss << ".kernel kernel" << k << "\n"
+            "    .config\n"
+            "        .dims x\n"
+            "        .setupargs\n"
+            "        .arg n, uint\n"
+            "        .arg out, uint*, global\n"
+            "    .text\n";
+        for (size_t i = 0; i < kernelInstrsNum; i++)
+            putBenchGCNInstr(oss, k*kernelInstrsNum + i);
+        oss << "        s_endpgm\n";
+    }
+    return oss.str();
+}
+
+static std::string generateGalliumSource(size_t kernelsNum)
+{
+    std::ostringstream oss;
+    oss << ".gallium\n.gpu Pitcairn\n";
+    for (size_t k = 0; k < kernelsNum; k++)
+        oss << ".kernel kernel" << k << "\n"
+            "    .args\n"
+            "    .arg scalar, 4\n"
+            "    .arg global, 8\n"
+            "    .config\n"
+            "        .dims x\n";
+    oss << ".text\n";
+    for (size_t k = 0; k < kernelsNum; k++)
+    {
+        oss << "kernel" << k << ":\n";
+        for (size_t i = 0; i < kernelInstrsNum; i++)
+            putBenchGCNInstr(oss, k*kernelInstrsNum + i);
+        oss << "        s_endpgm\n";
+    }
+    return oss.str();
+}
+
+static std::string generateROCmSource(size_t kernelsNum)
+{
+    std::ostringstream oss;
+    oss << ".rocm\n.gpu Fiji\n";
+    for (size_t k = 0; k < kernelsNum; k++)
+        oss << ".kernel kernel" << k << "\n"
+            "    .config\n"
+            "        .dims x\n";
+    oss << ".text\n";
+    for (size_t k = 0; k < kernelsNum; k++)
+    {
+        oss << ".p2align 8\nkernel" << k << ":\n        .skip 256\n";
+        for (size_t i = 0; i < kernelInstrsNum; i++)
+            putBenchGCNInstr(oss, k*kernelInstrsNum + i);
+        oss << "        s_endpgm\n";
+    }
+    return oss.str();
+}
+
+static void benchFormat(BenchSession& session, const char* name, BinaryFormat format,
+            const std::string& source, size_t kernelsNum)
+{
+    std::istringstream iss(source);
+    std::ostringstream errorStream;
+    Assembler assembler("bench.s", iss, ASM_ALL&~(ASM_ALTMACRO|ASM_WAVE32),
+                    format, GPUDeviceType::CAPE_VERDE, errorStream);
+    if (!assembler.assemble())
+        throw Exception(std::string("Assembler failed for ") + name + ": " +
+                    errorStream.str());
+    session.run(name, "kernels", kernelsNum, [&assembler]()
+        {
+            Array<cxbyte> output;
+            const BenchClock::time_point start = BenchClock::now();
+            assembler.writeBinary(output);
+            return benchNanos(start, BenchClock::now());
+        });
+}
+
+static std::string generateBigROCmSource(size_t kernelsNum)
+{
+    std::ostringstream oss;
+    oss << ".rocm\n.gpu Fiji\n";
+    for (size_t k = 0; k < kernelsNum; k++)
+        oss << ".kernel kernel" << k << "\n"
+            "    .config\n"
+            "        .dims x\n";
+    oss << ".text\n";
+    // big code (64 KB per kernel)
+    for (size_t k = 0; k < kernelsNum; k++)
+        oss << ".p2align 8\nkernel" << k << ":\n        .skip 256\n"
+            "        .fill 16320, 4, 0xbf800000\n        s_endpgm\n";
+    return oss.str();
+}
+
+static void benchFileWrite(BenchSession& session, const std::string& source)
+{
+    std::istringstream iss(source);
+    std::ostringstream errorStream;
+    Assembler assembler("bench.s", iss, ASM_ALL&~(ASM_ALTMACRO|ASM_WAVE32),
+                    BinaryFormat::ROCM, GPUDeviceType::CAPE_VERDE, errorStream);
+    if (!assembler.assemble())
+        throw Exception("Assembler failed for rocm-file: " + errorStream.str());
+    const char* filename = "bingenbench.bin";
+    Array<cxbyte> binary;
+    assembler.writeBinary(binary);
+    const size_t binarySize = binary.size();
+    binary.clear();
+    
+    // file stream (FileOStream: big section contents are written without copying)
+    session.run("rocm-file-stream", "bytes", binarySize, [&assembler, filename]()
+        {
+            const BenchClock::time_point start = BenchClock::now();
+            assembler.writeBinary(filename);
+            return benchNanos(start, BenchClock::now());
+        });
+#ifndef HAVE_WINDOWS
+    // binary generated to memory, written to preallocated file by positional writes
+    session.run("rocm-file-pwrite", "bytes", binarySize, [&assembler, filename]()
+        {
+            const BenchClock::time_point start = BenchClock::now();
+            Array<cxbyte> output;
+            assembler.writeBinary(output);
+            const int fd = ::open(filename, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+            if (fd < 0 || ::ftruncate(fd, output.size()) != 0)
+                throw Exception("Can't create file");
+            for (size_t pos = 0; pos < output.size(); )
+            {
+                const ssize_t ret = ::pwrite(fd, output.data() + pos,
+                            output.size() - pos, pos);
+                if (ret <= 0)
+                    throw Exception("Can't write file");
+                pos += ret;
+            }
+            ::close(fd);
+            return benchNanos(start, BenchClock::now());
+        });
+    /* only copying of generated binary to writable mapping of preallocated file.
+     * it is lower bound of the generating binary directly to mapped file */
+    assembler.writeBinary(binary);
+    session.run("rocm-file-mmapcopy", "bytes", binarySize, [&binary, filename]()
+        {
+            const BenchClock::time_point start = BenchClock::now();
+            const int fd = ::open(filename, O_RDWR|O_CREAT|O_TRUNC, 0644);
+            if (fd < 0 || ::ftruncate(fd, binary.size()) != 0)
+                throw Exception("Can't create file");
+            void* mem = ::mmap(nullptr, binary.size(), PROT_READ|PROT_WRITE,
+                        MAP_SHARED, fd, 0);
+            if (mem == MAP_FAILED)
+                throw Exception("Can't map file");
+            ::memcpy(mem, binary.data(), binary.size());
+            ::munmap(mem, binary.size());
+            ::close(fd);
+            return benchNanos(start, BenchClock::now());
+        });
+#endif
+    ::remove(filename);
+}
+
+int main(int argc, const char** argv)
+try
+{
+    BenchSession session("bingen", argc, argv);
+    const size_t kernelsNum = size_t(session.getScale()) * 200;
+    
+    benchFormat(session, "amd", BinaryFormat::AMD,
+                generateAmdSource(kernelsNum), kernelsNum);
+    benchFormat(session, "amdcl2", BinaryFormat::AMDCL2,
+                generateAmdCL2Source(kernelsNum), kernelsNum);
+    benchFormat(session, "gallium", BinaryFormat::GALLIUM,
+                generateGalliumSource(kernelsNum), kernelsNum);
+    benchFormat(session, "rocm", BinaryFormat::ROCM,
+                generateROCmSource(kernelsNum), kernelsNum);
+    benchFileWrite(session, generateBigROCmSource(kernelsNum));
+    
+    session.writeJSON(std::cout);
+    return 0;
+}
+catch(const std::exception& ex)
+{
+    std::cerr << ex.what() << std::endl;
+    return 1;
+}
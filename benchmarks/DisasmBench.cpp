@@ -0,0 +1,91 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* disassembler throughput benchmark: instructions per second for GCNDisassembler
+ * for every GCN architecture. Code is generated by assembling synthetic source */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/GPUId.h>
+#include <CLRX/amdasm/Assembler.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include "BenchUtils.h"
+
+using namespace CLRX;
+
+static const GPUDeviceType benchDevices[] =
+{
+    GPUDeviceType::PITCAIRN, GPUDeviceType::HAWAII, GPUDeviceType::FIJI,
+    GPUDeviceType::GFX900, GPUDeviceType::GFX906, GPUDeviceType::GFX1010,
+    GPUDeviceType::GFX1011
+};
+
+static void assembleCode(const std::string& source, GPUDeviceType deviceType,
+            Array<cxbyte>& code)
+{
+    std::istringstream iss(source);
+    std::ostringstream errorStream;
+    Assembler assembler("bench.s", iss, ASM_ALL&~(ASM_ALTMACRO|ASM_WAVE32),
+                    BinaryFormat::RAWCODE, deviceType, errorStream);
+    if (!assembler.assemble() || assembler.getSections().empty())
+        throw Exception("Assembler failed: " + errorStream.str());
+    const AsmSection& section = assembler.getSections()[0];
+    code.assign(section.content.begin(), section.content.end());
+}
+
+static uint64_t disassembleCode(GPUDeviceType deviceType, const Array<cxbyte>& code,
+            Flags flags)
+{
+    std::ostringstream oss;
+    const BenchClock::time_point start = BenchClock::now();
+    Disassembler disasm(deviceType, code.size(), code.data(), oss, flags);
+    disasm.disassemble();
+    return benchNanos(start, BenchClock::now());
+}
+
+int main(int argc, const char** argv)
+try
+{
+    BenchSession session("disassembler", argc, argv);
+    const size_t instrsNum = size_t(session.getScale()) * 50000;
+    const std::string source = generateGCNCode(instrsNum);
+    
+    for (GPUDeviceType deviceType: benchDevices)
+    {
+        Array<cxbyte> code;
+        assembleCode(source, deviceType, code);
+        const std::string archName = getGPUDeviceTypeName(deviceType);
+        session.run(archName, "instrs", instrsNum, [deviceType, &code]()
+            { return disassembleCode(deviceType, code, DISASM_DUMPCODE); });
+        session.run(archName+"-hexcode", "instrs", instrsNum, [deviceType, &code]()
+            { return disassembleCode(deviceType, code,
+                        DISASM_DUMPCODE|DISASM_HEXCODE|DISASM_CODEPOS); });
+    }
+    
+    session.writeJSON(std::cout);
+    return 0;
+}
+catch(const std::exception& ex)
+{
+    std::cerr << ex.what() << std::endl;
+    return 1;
+}
@@ -0,0 +1,146 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* metadata parsing benchmark: time of the parsing ROCm metadata (YAML and MsgPack)
+ * for many kernels with many kernel arguments */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdbin/ROCmBinaries.h>
+#include "BenchUtils.h"
+
+using namespace CLRX;
+
+static const size_t kernelArgsNum = 100;
+
+// generate metadata with kernels, kernel arguments and printf infos
+static ROCmMetadata generateMetadata(size_t kernelsNum)
+{
+    ROCmMetadata metadata;
+    metadata.initialize();
+    for (size_t i = 0; i < 10; i++)
+        metadata.printfInfos.push_back({ uint32_t(i), Array<uint32_t>({ 4, 4 }),
+                    CString("value=%d, other=%d\n") });
+    metadata.kernels.resize(kernelsNum);
+    for (size_t k = 0; k < kernelsNum; k++)
+    {
+        ROCmKernelMetadata& kernel = metadata.kernels[k];
+        kernel.initialize();
+        kernel.name = "kernel" + std::to_string(k);
+        kernel.symbolName = "kernel" + std::to_string(k) + "@kd";
+        kernel.language = "OpenCL C";
+        kernel.langVersion[0] = 1;
+        kernel.langVersion[1] = 2;
+        kernel.argInfos.resize(kernelArgsNum);
+        for (size_t i = 0; i < kernelArgsNum; i++)
+        {
+            ROCmKernelArgInfo& arg = kernel.argInfos[i];
+            const bool isPointer = (i&1) != 0;
+            arg.name = "argument" + std::to_string(i);
+            arg.typeName = isPointer ? "float*" : "uint";
+            arg.size = isPointer ? 8 : 4;
+            arg.align = arg.size;
+            arg.pointeeAlign = 0;
+            arg.valueKind = isPointer ? ROCmValueKind::GLOBAL_BUFFER :
+                    ROCmValueKind::BY_VALUE;
+            arg.valueType = isPointer ? ROCmValueType::FLOAT32 : ROCmValueType::UINT32;
+            arg.addressSpace = isPointer ? ROCmAddressSpace::GLOBAL :
+                    ROCmAddressSpace::NONE;
+            arg.accessQual = isPointer ? ROCmAccessQual::READ_WRITE :
+                    ROCmAccessQual::DEFAULT;
+            arg.actualAccessQual = arg.accessQual;
+            arg.isConst = (i%3) == 0 && isPointer;
+            arg.isRestrict = false;
+            arg.isVolatile = false;
+            arg.isPipe = false;
+        }
+    }
+    return metadata;
+}
+
+int main(int argc, const char** argv)
+try
+{
+    BenchSession session("metadata", argc, argv);
+    const size_t kernelsNum = size_t(session.getScale()) * 20;
+    const ROCmMetadata metadata = generateMetadata(kernelsNum);
+    const size_t argsNum = kernelsNum * kernelArgsNum;
+
+    // kernel configs are needed only by generator
+    ROCmKernelConfig kconfig{};
+    std::vector<const ROCmKernelConfig*> kconfigs(kernelsNum, &kconfig);
+    std::string yaml;
+    generateROCmMetadata(metadata, kconfigs.data(), yaml);
+
+    session.run("rocm_yaml", "args", argsNum, [&yaml, argsNum]()
+        {
+            ROCmMetadata parsed;
+            const BenchClock::time_point start = BenchClock::now();
+            parsed.parse(yaml.size(), yaml.c_str());
+            const uint64_t nanos = benchNanos(start, BenchClock::now());
+            if (parsed.kernels.size() * kernelArgsNum != argsNum)
+                throw Exception("Wrong number of parsed kernels");
+            return nanos;
+        });
+
+    std::vector<ROCmKernelDescriptor> kdescs(kernelsNum);
+    std::vector<const ROCmKernelDescriptor*> kdescPtrs(kernelsNum);
+    for (size_t k = 0; k < kernelsNum; k++)
+    {
+        kdescs[k] = ROCmKernelDescriptor{};
+        kdescPtrs[k] = kdescs.data() + k;
+    }
+    std::vector<cxbyte> msgPack;
+    generateROCmMetadataMsgPack(metadata, kdescPtrs.data(), msgPack);
+
+    session.run("rocm_msgpack", "args", argsNum, [&msgPack, argsNum]()
+        {
+            ROCmMetadata parsed;
+            const BenchClock::time_point start = BenchClock::now();
+            parsed.parseMsgPack(msgPack.size(), msgPack.data());
+            const uint64_t nanos = benchNanos(start, BenchClock::now());
+            if (parsed.kernels.size() * kernelArgsNum != argsNum)
+                throw Exception("Wrong number of parsed kernels");
+            return nanos;
+        });
+    // get metadata of last kernel only
+    const std::string lastKernelName = metadata.kernels.back().name.c_str();
+    session.run("rocm_msgpack_kernel", "args", argsNum, [&msgPack, &lastKernelName]()
+        {
+            ROCmKernelMetadata kernel;
+            const BenchClock::time_point start = BenchClock::now();
+            const bool found = parseROCmKernelMetadataMsgPack(msgPack.size(),
+                        msgPack.data(), lastKernelName.c_str(), kernel);
+            const uint64_t nanos = benchNanos(start, BenchClock::now());
+            if (!found || kernel.argInfos.size() != kernelArgsNum)
+                throw Exception("Kernel metadata not found");
+            return nanos;
+        });
+
+    session.writeJSON(std::cout);
+    return 0;
+}
+catch(const std::exception& ex)
+{
+    std::cerr << ex.what() << std::endl;
+    return 1;
+}
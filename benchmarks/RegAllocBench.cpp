@@ -0,0 +1,148 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* register allocator benchmark: time of the phases of AsmRegAllocator
+ * (code structure, SSA, liveness, interference graph, coloring)
+ * for synthetic control flow graphs with scaled number of code blocks */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdasm/Assembler.h>
+#include "BenchUtils.h"
+
+using namespace CLRX;
+
+// generate code with branches (if-else-like skips and loops) between code blocks
+static std::string generateCFGCode(size_t blocksNum, size_t& instrsNum)
+{
+    std::ostringstream oss;
+    oss << ".regvar sa:s:16, va:v:32\n"
+        "    s_mov_b32 sa[0], s0\n"
+        "    v_mov_b32 va[0], v0\n";
+    instrsNum = 2;
+    for (size_t b = 0; b < blocksNum; b++)
+    {
+        oss << "L" << b << ":\n"
+            "    v_add_f32 va[" << ((b*3)&31) << "], va[" << ((b*5+1)&31) <<
+                    "], va[" << ((b*7+2)&31) << "]\n"
+            "    s_add_u32 sa[" << (b&15) << "], sa[" << ((b+1)&15) << "], " <<
+                    (b&63) << "\n"
+            "    v_mul_f32 va[" << ((b*11+3)&31) << "], sa[" << ((b+2)&15) <<
+                    "], va[" << ((b*3)&31) << "]\n"
+            "    s_cmp_lt_u32 sa[" << (b&15) << "], " << (b&31) << "\n";
+        instrsNum += 4;
+        if ((b&3) == 1 && b+2 < blocksNum)
+        {
+            oss << "    s_cbranch_scc0 L" << (b+2) << "\n";
+            instrsNum++;
+        }
+        else if ((b&7) == 7)
+        {
+            oss << "    s_cbranch_scc1 L" << (b-3) << "\n";
+            instrsNum++;
+        }
+    }
+    oss << "    s_endpgm\n";
+    instrsNum++;
+    return oss.str();
+}
+
+enum : cxuint
+{
+    PHASE_CODESTRUCT = 0,
+    PHASE_SSA,
+    PHASE_LIVENESS,
+    PHASE_INTERFERENCE,
+    PHASE_COLORING,
+    PHASES_NUM
+};
+
+static const char* phaseNames[PHASES_NUM] =
+{ "codestruct", "ssa", "liveness", "interference", "coloring" };
+
+static void runRegAllocPhases(const std::string& source, uint64_t* phaseNanos)
+{
+    std::istringstream iss(source);
+    std::ostringstream errorStream;
+    Assembler assembler("bench.s", iss,
+                    (ASM_ALL&~ASM_ALTMACRO) | ASM_TESTRUN | ASM_TESTRESOLVE,
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+    if (!assembler.assemble() || assembler.getSections().empty())
+        throw Exception("Assembler failed: " + errorStream.str());
+    const AsmSection& section = assembler.getSections()[0];
+    
+    AsmRegAllocator regAlloc(assembler);
+    BenchClock::time_point t0 = BenchClock::now();
+    regAlloc.createCodeStructure(section.codeFlow, section.getSize(),
+                            section.content.data());
+    BenchClock::time_point t1 = BenchClock::now();
+    phaseNanos[PHASE_CODESTRUCT] = benchNanos(t0, t1);
+    regAlloc.createSSAData(*section.usageHandler, *section.linearDepHandler);
+    regAlloc.applySSAReplaces();
+    t0 = BenchClock::now();
+    phaseNanos[PHASE_SSA] = benchNanos(t1, t0);
+    regAlloc.createLivenesses(*section.usageHandler, *section.linearDepHandler);
+    t1 = BenchClock::now();
+    phaseNanos[PHASE_LIVENESS] = benchNanos(t0, t1);
+    regAlloc.createInterferenceGraph();
+    t0 = BenchClock::now();
+    phaseNanos[PHASE_INTERFERENCE] = benchNanos(t1, t0);
+    regAlloc.colorInterferenceGraph();
+    t1 = BenchClock::now();
+    phaseNanos[PHASE_COLORING] = benchNanos(t0, t1);
+}
+
+int main(int argc, const char** argv)
+try
+{
+    BenchSession session("regalloc", argc, argv);
+    // scaled CFGs: 1x, 4x, 16x of base number of code blocks
+    for (size_t factor = 1; factor <= 16; factor *= 4)
+    {
+        const size_t blocksNum = size_t(session.getScale()) * 100 * factor;
+        size_t instrsNum = 0;
+        const std::string source = generateCFGCode(blocksNum, instrsNum);
+        std::vector<uint64_t> phaseNanos[PHASES_NUM];
+        for (cxuint r = 0; r < session.getRepeats(); r++)
+        {
+            uint64_t nanos[PHASES_NUM];
+            runRegAllocPhases(source, nanos);
+            for (cxuint p = 0; p < PHASES_NUM; p++)
+                phaseNanos[p].push_back(nanos[p]);
+        }
+        for (cxuint p = 0; p < PHASES_NUM; p++)
+        {
+            std::ostringstream nameOss;
+            nameOss << phaseNames[p] << "-" << blocksNum << "blocks";
+            session.addResult(nameOss.str(), "instrs", instrsNum, phaseNanos[p]);
+        }
+    }
+    
+    session.writeJSON(std::cout);
+    return 0;
+}
+catch(const std::exception& ex)
+{
+    std::cerr << ex.what() << std::endl;
+    return 1;
+}
@@ -1328,18 +1328,48 @@ clrxclBuildProgram(cl_program           program,
     CLRXProgram* p = static_cast<CLRXProgram*>(program);
     if (options!=nullptr && detectCLRXCompilerCall(options))
     try
-    {   {
+    {
+        // check arguments and options before building (also for asynchronous build)
+        CLRXAsmBuildSetup buildSetup;
+        const cl_int prepError = clrxPrepareCompilerCall(p, options, num_devices,
+                    device_list, buildSetup);
+        if (prepError != CL_SUCCESS)
+        {
+            std::lock_guard<std::mutex> lock(p->mutex);
+            if (p->concurrentBuilds == 0)
+            {
+                // no build in progress, so this build failed
+                p->asmState.store(CLRXAsmState::FAILED);
+                p->asmProgEntries.reset();
+            }
+            return prepError;
+        }
+        {
             std::lock_guard<std::mutex> lock(p->mutex);
             if (p->kernelsAttached != 0) // if kernels attached
                 return CL_INVALID_OPERATION;
+            if (pfn_notify!=nullptr)
+            {
+                // asynchronous build: previous build must be finished
+                if (p->asmState.load() == CLRXAsmState::IN_PROGRESS)
+                    return CL_INVALID_OPERATION;
+                // build status must be in progress after returning from this call
+                p->asmState.store(CLRXAsmState::IN_PROGRESS);
+                p->asmProgEntries.reset();
+            }
             p->concurrentBuilds++;
             p->kernelArgFlagsInitialized = false;
         }
+        if (pfn_notify!=nullptr)
+        {
+            // call own compiler in background and notify after building
+            clrxAsyncCompilerCall(p, std::move(buildSetup), num_devices,
+                        (CLRXDevice* const*)device_list, pfn_notify, user_data);
+            return CL_SUCCESS;
+        }
         // call own compiler
-        cl_int error = clrxCompilerCall(p, options, num_devices,
+        cl_int error = clrxCompilerCall(p, buildSetup, num_devices,
                             (CLRXDevice* const*)device_list);
-        if (pfn_notify!=nullptr)
-            pfn_notify(program, user_data);
         
         {
             std::lock_guard<std::mutex> lock(p->mutex);
@@ -1720,9 +1750,13 @@ clrxclGetProgramBuildInfo(cl_program            program,
                     *reinterpret_cast<cl_build_status*>(param_value) =
                             progDevIt->second.status;
                 else // if not
+                {
+                    const CLRXAsmState asmState = p->asmState.load();
                     *reinterpret_cast<cl_build_status*>(param_value) =
-                            (p->asmState.load() == CLRXAsmState::IN_PROGRESS) ?
-                            CL_BUILD_IN_PROGRESS : CL_BUILD_NONE;
+                            (asmState == CLRXAsmState::IN_PROGRESS) ?
+                            CL_BUILD_IN_PROGRESS : (asmState == CLRXAsmState::FAILED) ?
+                            CL_BUILD_ERROR : CL_BUILD_NONE;
+                }
             }
             if (param_value_size_ret != nullptr)
                 *param_value_size_ret = sizeof(cl_build_status);
@@ -23,6 +23,10 @@
 #include <exception>
 #include <cstdio>
 #include <vector>
+#include <map>
+#include <list>
+#include <atomic>
+#include <system_error>
 #include <utility>
 #include <thread>
 #include <mutex>
@@ -34,6 +38,7 @@
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/Containers.h>
 #include <CLRX/amdasm/Assembler.h>
+#include <CLRX/amdasm/AsmBinaryCache.h>
 #include <CLRX/amdbin/AmdBinaries.h>
 #include <CLRX/amdbin/AmdCL2Binaries.h>
 #include <CLRX/utils/InputOutput.h>
@@ -1477,7 +1482,8 @@ static std::pair<CString, uint64_t> getDefSym(const CString& word)
     return defSym;
 }
 
-struct CLRX_INTERNAL CLProgBinEntry: public FastRefCountable
+// atomic reference counter, because entry can be shared by builds in many threads
+struct CLRX_INTERNAL CLProgBinEntry: public RefCountable
 {
     Array<cxbyte> binary;
     CLProgBinEntry() { }
@@ -1524,6 +1530,184 @@ static cl_int genDeviceOrder(cl_uint devicesNum, const cl_device_id* devices,
     return CL_SUCCESS;
 }
 
+/* on-disk cache of assembled binaries (enabled by CLRX_ASM_CACHE_DIR)
+ * use pure pointer - cache must be available to end of program */
+static OnceFlag asmBinaryCacheOnceFlag;
+static AsmBinaryCache* asmBinaryCache = nullptr;
+
+static void clrxInitializeAsmBinaryCache()
+{
+    const std::string cacheDir = parseEnvVariable<std::string>("CLRX_ASM_CACHE_DIR", "");
+    if (cacheDir.empty())
+        return;
+    try
+    {
+        asmBinaryCache = new AsmBinaryCache(cacheDir.c_str(),
+                    parseEnvVariable<cxullong>("CLRX_ASM_CACHE_MAXSIZE", 0));
+    }
+    catch(const Exception& ex)
+    { } // if cache directory is not available, then do not use cache
+}
+
+/* process-wide in-memory cache of assembled binaries (shared by all contexts),
+ * key is computed from source code and assembler setup (from options and device) */
+struct CLRX_INTERNAL CLAsmMemCacheDepFile
+{
+    CString path;
+    uint64_t timestamp; // modification time (content is checked only if it changed)
+    AsmCacheKey hash;   // hash of content
+};
+
+struct CLRX_INTERNAL CLAsmMemCacheEntry
+{
+    RefPtr<CLProgBinEntry> binary;
+    std::string log;
+    std::vector<CLAsmMemCacheDepFile> depFiles;
+    // paths not found while searching included files
+    std::vector<CString> failedPaths;
+    std::list<AsmCacheKey>::iterator lruIt; // place in LRU list
+};
+
+static OnceFlag asmMemCacheOnceFlag;
+static std::mutex asmMemCacheMutex;
+static std::map<AsmCacheKey, CLAsmMemCacheEntry>* asmMemCache = nullptr;
+// keys of entries, most recently used at front
+static std::list<AsmCacheKey>* asmMemCacheLRU = nullptr;
+static uint64_t asmMemCacheMaxSize = 0;
+static uint64_t asmMemCacheSize = 0;
+
+static void clrxInitializeAsmMemCache()
+{
+    asmMemCacheMaxSize = parseEnvVariable<cxullong>("CLRX_ASM_MEMCACHE_MAXSIZE",
+                64ULL<<20);
+    if (asmMemCacheMaxSize != 0)
+    {
+        asmMemCache = new std::map<AsmCacheKey, CLAsmMemCacheEntry>();
+        asmMemCacheLRU = new std::list<AsmCacheKey>();
+    }
+}
+
+static AsmCacheKey clrxComputeFileHash(const CString& filename)
+{
+    const Array<cxbyte> content = loadDataFromFile(filename.c_str());
+    AsmCacheHasher hasher;
+    hasher.updateValue(content.size());
+    hasher.update(content.size(), content.data());
+    return hasher.finish();
+}
+
+static bool clrxFindInAsmMemCache(const AsmCacheKey& key, RefPtr<CLProgBinEntry>& binary,
+            std::string& log)
+{
+    std::vector<CLAsmMemCacheDepFile> depFiles;
+    std::vector<CString> failedPaths;
+    {
+        std::lock_guard<std::mutex> lock(asmMemCacheMutex);
+        auto it = asmMemCache->find(key);
+        if (it == asmMemCache->end())
+            return false;
+        // move to front of LRU list
+        asmMemCacheLRU->splice(asmMemCacheLRU->begin(), *asmMemCacheLRU,
+                    it->second.lruIt);
+        binary = it->second.binary;
+        log = it->second.log;
+        depFiles = it->second.depFiles;
+        failedPaths = it->second.failedPaths;
+    }
+    // check included files (outside lock), outdated entry will be replaced by next store
+    bool timestampsChanged = false;
+    try
+    {
+        for (CLAsmMemCacheDepFile& depFile: depFiles)
+        {
+            const uint64_t timestamp = getFileTimestamp(depFile.path.c_str());
+            if (timestamp == depFile.timestamp)
+                continue;
+            // file has been touched, check whether content has been changed
+            if (clrxComputeFileHash(depFile.path) != depFile.hash)
+            {
+                binary.reset();
+                return false;
+            }
+            depFile.timestamp = timestamp;
+            timestampsChanged = true;
+        }
+        // if file appeared in path searched before, then assembler includes it
+        for (const CString& failedPath: failedPaths)
+            if (isFileExists(failedPath.c_str()))
+            {
+                binary.reset();
+                return false;
+            }
+    }
+    catch(const Exception& ex)
+    {
+        binary.reset();
+        return false;
+    }
+    if (timestampsChanged)
+    {
+        // keep new timestamps to avoid hashing content at next find
+        std::lock_guard<std::mutex> lock(asmMemCacheMutex);
+        auto it = asmMemCache->find(key);
+        if (it != asmMemCache->end() && it->second.depFiles.size() == depFiles.size())
+            for (size_t i = 0; i < depFiles.size(); i++)
+            {
+                CLAsmMemCacheDepFile& entryDepFile = it->second.depFiles[i];
+                if (entryDepFile.path == depFiles[i].path &&
+                    entryDepFile.hash == depFiles[i].hash)
+                    entryDepFile.timestamp = depFiles[i].timestamp;
+            }
+    }
+    return true;
+}
+
+static void clrxStoreInAsmMemCache(const AsmCacheKey& key,
+            const std::vector<CString>& depFiles, const std::vector<CString>& failedPaths,
+            const RefPtr<CLProgBinEntry>& binary, const std::string& log)
+{
+    const uint64_t entrySize = binary->binary.size() + log.size();
+    if (entrySize > asmMemCacheMaxSize)
+        return;
+    CLAsmMemCacheEntry entry;
+    entry.binary = binary;
+    entry.log = log;
+    for (const CString& depFile: depFiles)
+    {
+        // get timestamp before hashing, later modification changes timestamp
+        const uint64_t timestamp = getFileTimestamp(depFile.c_str());
+        entry.depFiles.push_back({ depFile, timestamp, clrxComputeFileHash(depFile) });
+    }
+    entry.failedPaths = failedPaths;
+    
+    std::lock_guard<std::mutex> lock(asmMemCacheMutex);
+    auto res = asmMemCache->insert(std::make_pair(key, entry));
+    if (!res.second)
+    {
+        // replace old entry
+        asmMemCacheSize -= res.first->second.binary->binary.size() +
+                    res.first->second.log.size();
+        entry.lruIt = res.first->second.lruIt;
+        res.first->second = std::move(entry);
+        asmMemCacheLRU->splice(asmMemCacheLRU->begin(), *asmMemCacheLRU,
+                    res.first->second.lruIt);
+    }
+    else
+    {
+        asmMemCacheLRU->push_front(key);
+        res.first->second.lruIt = asmMemCacheLRU->begin();
+    }
+    asmMemCacheSize += entrySize;
+    // remove least recently used entries
+    while (asmMemCacheSize > asmMemCacheMaxSize)
+    {
+        auto lruIt = asmMemCache->find(asmMemCacheLRU->back());
+        asmMemCacheSize -= lruIt->second.binary->binary.size() + lruIt->second.log.size();
+        asmMemCache->erase(lruIt);
+        asmMemCacheLRU->pop_back();
+    }
+}
+
 static const char* stripCString(char* str)
 {
     while (*str==' ') str++;
@@ -1534,56 +1718,49 @@ static const char* stripCString(char* str)
     return str;
 }
 
-cl_int clrxCompilerCall(CLRXProgram* program, const char* compilerOptions,
-            cl_uint devicesNum, CLRXDevice* const* devices)
+cl_int clrxPrepareCompilerCall(CLRXProgram* program, const char* compilerOptions,
+            cl_uint devicesNum, const cl_device_id* devices, CLRXAsmBuildSetup& setup)
 try
 {
-    std::lock_guard<std::mutex> lock(program->asmMutex);
-    if (devices==nullptr)
-    {
-        devicesNum = program->assocDevicesNum;
-        devices = program->assocDevices.get();
-    }
+    // devices must be in program context
+    const CLRXContext* context = program->context;
+    for (cl_uint i = 0; i < devicesNum; i++)
+        if (devices[i] == nullptr || std::find(context->devices.get(),
+                context->devices.get()+context->devicesNum, devices[i]) ==
+                context->devices.get()+context->devicesNum)
+            return CL_INVALID_DEVICE;
+    
     /* get source code */
-    size_t sourceCodeSize;
-    std::unique_ptr<char[]> sourceCode;
     const cl_program amdp = program->amdOclProgram;
-    {
-        std::lock_guard<std::mutex> clock(program->mutex);
-        program->asmState.store(CLRXAsmState::IN_PROGRESS);
-        program->asmProgEntries.reset();
-    }
-    
     cl_int error = amdp->dispatch->clGetProgramInfo(amdp, CL_PROGRAM_SOURCE,
-                    0, nullptr, &sourceCodeSize);
+                    0, nullptr, &setup.sourceCodeSize);
     if (error!=CL_SUCCESS)
         clrxAbort("Fatal error from clGetProgramInfo in clrxCompilerCall");
-    if (sourceCodeSize==0)
-    {
-        program->asmState.store(CLRXAsmState::FAILED);
+    if (setup.sourceCodeSize==0)
         return CL_INVALID_OPERATION;
-    }
     
-    sourceCode.reset(new char[sourceCodeSize]);
-    error = amdp->dispatch->clGetProgramInfo(amdp, CL_PROGRAM_SOURCE, sourceCodeSize,
-                             sourceCode.get(), nullptr);
+    setup.sourceCode.reset(new char[setup.sourceCodeSize]);
+    error = amdp->dispatch->clGetProgramInfo(amdp, CL_PROGRAM_SOURCE,
+                setup.sourceCodeSize, setup.sourceCode.get(), nullptr);
     if (error!=CL_SUCCESS)
         clrxAbort("Fatal error from clGetProgramInfo in clrxCompilerCall");
     
-    Flags asmFlags = ASM_WARNINGS;
+    setup.options = compilerOptions;
+    Flags& asmFlags = setup.asmFlags;
+    asmFlags = ASM_WARNINGS;
     // parsing compile options
     const char* co = compilerOptions;
-    std::vector<CString> includePaths;
-    std::vector<std::pair<CString, uint64_t> > defSyms;
+    std::vector<CString>& includePaths = setup.includePaths;
+    std::vector<std::pair<CString, uint64_t> >& defSyms = setup.defSyms;
     bool nextIsIncludePath = false;
     bool nextIsDefSym = false;
     bool nextIsLang = false;
-    bool useCL20Std = false;
-    bool useLegacy = false;
+    setup.useCL20Std = false;
+    setup.useLegacy = false;
     // drivers since 200406 version uses AmdCL2 binary format by default for >=GCN1.1
-    bool useCL2StdForGCN11 = detectAmdDriverVersion() >= 200406;
-    bool havePolicy = false;
-    cxuint policyVersion = 0;
+    setup.useCL2StdForGCN11 = detectAmdDriverVersion() >= 200406;
+    setup.havePolicy = false;
+    setup.policyVersion = 0;
     
     try
     {
@@ -1617,8 +1794,8 @@ try
                 asmFlags |= ASM_MACRONOCASE;
             else if (word == "-legacy")
             {
-                useCL2StdForGCN11 = false;
-                useLegacy = true;
+                setup.useCL2StdForGCN11 = false;
+                setup.useLegacy = true;
             }
             else if (word == "-forceAddSymbols")
                 asmFlags |= ASM_FORCE_ADD_SYMBOLS;
@@ -1642,47 +1819,64 @@ try
             {
                 const CString stdName = word.substr(8, word.size()-8);
                 if (stdName=="CL2.0")
-                    useCL20Std = true;
+                    setup.useCL20Std = true;
                 else if (stdName!="CL1.1" && stdName!="CL1.1" && stdName!="CL1.2")
-                {
-                    program->asmState.store(CLRXAsmState::FAILED);
                     return CL_INVALID_BUILD_OPTIONS;
-                }
             }
             else if (word == "-policy=")
             {
                 const CString policyVersionStr = word.substr(8, word.size()-8);
                 const char* str = policyVersionStr.c_str();
                 const char* outStr;
-                policyVersion = cstrtoui(str, nullptr, outStr);
-                havePolicy = true;
+                setup.policyVersion = cstrtoui(str, nullptr, outStr);
+                setup.havePolicy = true;
             }
             else if (word == "-x" )
                 nextIsLang = true;
             else if (word != "-xasm")
-            {
                 // if not language selection to asm
-                program->asmState.store(CLRXAsmState::FAILED);
                 return CL_INVALID_BUILD_OPTIONS;
-            }
         }
         else
-        {
-            program->asmState.store(CLRXAsmState::FAILED);
             return CL_INVALID_BUILD_OPTIONS;
-        }
     }
     if (nextIsDefSym || nextIsIncludePath || nextIsLang)
-    {
-        program->asmState.store(CLRXAsmState::FAILED);
         return CL_INVALID_BUILD_OPTIONS;
-    }
     } // error
     catch(const Exception& ex)
+    { return CL_INVALID_BUILD_OPTIONS; }
+    return CL_SUCCESS;
+}
+catch(const std::bad_alloc& ex)
+{ return CL_OUT_OF_HOST_MEMORY; }
+
+cl_int clrxCompilerCall(CLRXProgram* program, const CLRXAsmBuildSetup& setup,
+            cl_uint devicesNum, CLRXDevice* const* devices)
+try
+{
+    std::lock_guard<std::mutex> lock(program->asmMutex);
+    if (devices==nullptr)
     {
-        program->asmState.store(CLRXAsmState::FAILED);
-        return CL_INVALID_BUILD_OPTIONS;
+        devicesNum = program->assocDevicesNum;
+        devices = program->assocDevices.get();
     }
+    const cl_program amdp = program->amdOclProgram;
+    {
+        std::lock_guard<std::mutex> clock(program->mutex);
+        program->asmState.store(CLRXAsmState::IN_PROGRESS);
+        program->asmProgEntries.reset();
+    }
+    cl_int error = CL_SUCCESS;
+    const size_t sourceCodeSize = setup.sourceCodeSize;
+    const std::unique_ptr<char[]>& sourceCode = setup.sourceCode;
+    const Flags asmFlags = setup.asmFlags;
+    const std::vector<CString>& includePaths = setup.includePaths;
+    const std::vector<std::pair<CString, uint64_t> >& defSyms = setup.defSyms;
+    const bool useCL20Std = setup.useCL20Std;
+    const bool useLegacy = setup.useLegacy;
+    const bool useCL2StdForGCN11 = setup.useCL2StdForGCN11;
+    const bool havePolicy = setup.havePolicy;
+    const cxuint policyVersion = setup.policyVersion;
     
     /* compiling programs */
     struct OutDevEntry {
@@ -1732,33 +1926,54 @@ try
     for (cxuint i = 0; i < devicesNum; i++)
         progDeviceEntries[i].status = CL_BUILD_IN_PROGRESS;
     
+    callOnce(asmBinaryCacheOnceFlag, clrxInitializeAsmBinaryCache);
+    callOnce(asmMemCacheOnceFlag, clrxInitializeAsmMemCache);
     bool asmFailure = false;
     bool asmNotAvailable = false;
-    cxuint prevDeviceType = -1;
+    /* determine device types and bitnesses. assemble only once for devices
+     * with this same device type and bitness (in whole list of devices) */
+    std::unique_ptr<cxuint[]> devTypes(new cxuint[devicesNum]);
+    std::unique_ptr<bool[]> devIs64Bits(new bool[devicesNum]);
+    // index of device from which binary will be taken (UINT_MAX if asm not available)
+    std::unique_ptr<cxuint[]> asmSrcDevIndices(new cxuint[devicesNum]);
+    std::vector<cxuint> asmDevIndices; // indices of devices to assemble
     for (cxuint i = 0; i < devicesNum; i++)
     {
         const auto& entry = outDeviceIndexMap[i];
-        ProgDeviceEntry& progDevEntry = progDeviceEntries[i];
-        cxuint devType = -1;
         try
-        { devType = cxuint(getGPUDeviceTypeFromName(entry.devName.c_str())); }
+        { devTypes[i] = cxuint(getGPUDeviceTypeFromName(entry.devName.c_str())); }
         catch(const Exception& ex)
         {
             // if assembler not available for this device
-            progDevEntry.status = CL_BUILD_ERROR;
+            progDeviceEntries[i].status = CL_BUILD_ERROR;
             asmNotAvailable = true;
-            prevDeviceType = devType;
+            asmSrcDevIndices[i] = UINT_MAX;
             continue;
         }
-        // make duplicate only if not first entry
-        if (i!=0 && devType == prevDeviceType)
-        {
-            // copy from previous device (if this same device type)
-            compiledProgBins[i] = compiledProgBins[i-1];
-            progDevEntry = progDeviceEntries[i-1];
-            continue; // skip if this same architecture
-        }
-        prevDeviceType = devType;
+        // get address bit - for bitness
+        cl_uint addressBits;
+        error = amdp->dispatch->clGetDeviceInfo(entry.second,
+                    CL_DEVICE_ADDRESS_BITS, sizeof(cl_uint), &addressBits, nullptr);
+        if (error != CL_SUCCESS)
+            clrxAbort("Fatal error at clCompilerCall (clGetDeviceInfo)");
+        devIs64Bits[i] = (addressBits==64);
+        
+        asmSrcDevIndices[i] = i;
+        for (cxuint k: asmDevIndices)
+            if (devTypes[k] == devTypes[i] && devIs64Bits[k] == devIs64Bits[i])
+            {
+                asmSrcDevIndices[i] = k;
+                break;
+            }
+        if (asmSrcDevIndices[i] == i)
+            asmDevIndices.push_back(i);
+    }
+    
+    // assemble for device, returns false if assembling failed
+    auto assembleForDevice = [&](cxuint i) -> bool
+    {
+        ProgDeviceEntry& progDevEntry = progDeviceEntries[i];
+        const cxuint devType = devTypes[i];
         // assemble it
         ArrayIStream astream(sourceCodeSize-1, sourceCode.get());
         std::string msgString;
@@ -1770,14 +1985,7 @@ try
         Assembler assembler("", astream, asmFlags,
                     (useCL20StdByDev) ? BinaryFormat::AMDCL2 : BinaryFormat::AMD,
                     GPUDeviceType(devType), msgStream);
-        
-        // get address bit - for bitness
-        cl_uint addressBits;
-        error = amdp->dispatch->clGetDeviceInfo(entry.second,
-                    CL_DEVICE_ADDRESS_BITS, sizeof(cl_uint), &addressBits, nullptr);
-        if (error != CL_SUCCESS)
-            clrxAbort("Fatal error at clCompilerCall (clGetDeviceInfo)");
-        assembler.set64Bit(addressBits==64);
+        assembler.set64Bit(devIs64Bits[i]);
         
         for (const CString& incPath: includePaths)
             assembler.addIncludeDir(incPath);
@@ -1786,6 +1994,63 @@ try
         if (havePolicy)
             assembler.setPolicyVersion(policyVersion);
         
+        AsmCacheKey cacheKey = { { 0, 0 } };
+        bool useMemCache = (asmMemCache != nullptr);
+        bool useCache = (asmBinaryCache != nullptr);
+        if (useMemCache || useCache)
+        {
+            try
+            {
+                cacheKey = AsmBinaryCache::computeKey(assembler, sourceCodeSize-1,
+                            sourceCode.get());
+            }
+            catch(const Exception& ex)
+            { useMemCache = useCache = false; }
+        }
+        if (useMemCache)
+        {
+            // try to get binary from in-memory cache (built before for any context)
+            std::string cachedLog;
+            if (clrxFindInAsmMemCache(cacheKey, compiledProgBins[i], cachedLog))
+            {
+                progDevEntry.log = RefPtr<CLProgLogEntry>(
+                            new CLProgLogEntry(std::move(cachedLog)));
+                progDevEntry.status = CL_BUILD_SUCCESS;
+                return true;
+            }
+        }
+        if (useCache)
+        {
+            // try to get binary from on-disk cache
+            try
+            {
+                Array<cxbyte> output;
+                std::vector<CString> depFiles, failedPaths;
+                if (asmBinaryCache->find(cacheKey, output, &depFiles, &failedPaths))
+                {
+                    progDevEntry.log = RefPtr<CLProgLogEntry>(
+                                new CLProgLogEntry(std::move(msgString)));
+                    progDevEntry.status = CL_BUILD_SUCCESS;
+                    compiledProgBins[i] = RefPtr<CLProgBinEntry>(
+                                new CLProgBinEntry(std::move(output)));
+                    if (useMemCache)
+                    {
+                        // put to in-memory cache to avoid loading from disk next time
+                        try
+                        {
+                            clrxStoreInAsmMemCache(cacheKey, depFiles, failedPaths,
+                                        compiledProgBins[i], progDevEntry.log->log);
+                        }
+                        catch(const Exception& ex)
+                        { } // ignore cache failures
+                    }
+                    return true;
+                }
+            }
+            catch(const Exception& ex)
+            { useCache = false; }
+        }
+        
         /// call main assembler routine
         bool good = false;
         try
@@ -1796,40 +2061,100 @@ try
             progDevEntry.log = RefPtr<CLProgLogEntry>(
                             new CLProgLogEntry(std::move(msgString)));
             progDevEntry.status = CL_BUILD_ERROR;
-            asmFailure = true;
-            continue;
+            return false;
         }
         /// set up logs
         progDevEntry.log = RefPtr<CLProgLogEntry>(
                             new CLProgLogEntry(std::move(msgString)));
-        if (good)
+        if (!good)
         {
-            // try to write binary and keep it in compiled program binaries
-            try
+            progDevEntry.status = CL_BUILD_ERROR;
+            return false;
+        }
+        // try to write binary and keep it in compiled program binaries
+        try
+        {
+            progDevEntry.status = CL_BUILD_SUCCESS;
+            Array<cxbyte> output;
+            assembler.writeBinary(output);
+            if (useCache)
             {
-                progDevEntry.status = CL_BUILD_SUCCESS;
-                Array<cxbyte> output;
-                assembler.writeBinary(output);
-                compiledProgBins[i] = RefPtr<CLProgBinEntry>(
-                            new CLProgBinEntry(std::move(output)));
+                try
+                { asmBinaryCache->store(cacheKey, assembler, output); }
+                catch(const Exception& ex)
+                { } // ignore cache failures
             }
-            catch(const Exception& ex)
+            compiledProgBins[i] = RefPtr<CLProgBinEntry>(
+                        new CLProgBinEntry(std::move(output)));
+            if (useMemCache)
             {
-                // if exception during writing binary
-                compiledProgBins[i].reset();
-                msgString.append(ex.what());
-                progDevEntry.log = RefPtr<CLProgLogEntry>(
-                            new CLProgLogEntry(std::move(msgString)));
-                progDevEntry.status = CL_BUILD_ERROR;
-                asmFailure = true;
+                try
+                {
+                    clrxStoreInAsmMemCache(cacheKey, assembler.getDependencyFiles(),
+                                assembler.getFailedIncludePaths(), compiledProgBins[i],
+                                progDevEntry.log->log);
+                }
+                catch(const Exception& ex)
+                { } // ignore cache failures
             }
         }
-        else // error
+        catch(const Exception& ex)
         {
+            // if exception during writing binary
+            compiledProgBins[i].reset();
+            progDevEntry.log->log.append(ex.what());
             progDevEntry.status = CL_BUILD_ERROR;
+            return false;
+        }
+        return true;
+    };
+    
+    /* assemble for distinct devices concurrently (every job has own assembler).
+     * current thread also assembles */
+    const size_t asmJobsNum = asmDevIndices.size();
+    std::unique_ptr<bool[]> asmGoods(new bool[asmJobsNum]);
+    std::atomic<size_t> nextAsmJob(0);
+    std::mutex asmExceptionMutex;
+    std::exception_ptr asmException;
+    auto asmWorker = [&]()
+    {
+        size_t job;
+        while ((job = nextAsmJob.fetch_add(1)) < asmJobsNum)
+            try
+            { asmGoods[job] = assembleForDevice(asmDevIndices[job]); }
+            catch(...)
+            {
+                // keep first exception to rethrow it in caller thread
+                asmGoods[job] = false;
+                std::lock_guard<std::mutex> lock(asmExceptionMutex);
+                if (!asmException)
+                    asmException = std::current_exception();
+            }
+    };
+    const size_t asmThreadsNum = std::min(asmJobsNum,
+                size_t(std::max(std::thread::hardware_concurrency(), 1U)));
+    std::vector<std::thread> asmThreads;
+    for (size_t t = 1; t < asmThreadsNum; t++)
+        try
+        { asmThreads.push_back(std::thread(asmWorker)); }
+        catch(const std::system_error& ex)
+        { break; } // if no more threads, remaining jobs will be done by other threads
+    asmWorker();
+    for (std::thread& thread: asmThreads)
+        thread.join();
+    if (asmException)
+        std::rethrow_exception(asmException);
+    
+    for (size_t job = 0; job < asmJobsNum; job++)
+        if (!asmGoods[job])
             asmFailure = true;
+    // copy results to devices with this same device type and bitness
+    for (cxuint i = 0; i < devicesNum; i++)
+        if (asmSrcDevIndices[i] != UINT_MAX && asmSrcDevIndices[i] != i)
+        {
+            compiledProgBins[i] = compiledProgBins[asmSrcDevIndices[i]];
+            progDeviceEntries[i] = progDeviceEntries[asmSrcDevIndices[i]];
         }
-    }
     /* set program binaries in order of original devices list */
     std::unique_ptr<size_t[]> programBinSizes(new size_t[devicesNum]);
     std::unique_ptr<cxbyte*[]> programBinaries(new cxbyte*[devicesNum]);
@@ -1941,7 +2266,7 @@ try
     mapSort(program->asmProgEntries.get(), program->asmProgEntries.get() +
                 program->assocDevicesNum);
     
-    program->asmOptions = compilerOptions;
+    program->asmOptions = setup.options;
     program->asmState.store((errorLast!=CL_SUCCESS) ?
                 CLRXAsmState::FAILED : CLRXAsmState::SUCCESS);
     return errorLast;
@@ -1956,3 +2281,51 @@ catch(const std::exception& ex)
     clrxAbort("Fatal error at CLRX compiler call:", ex.what());
     return -1;
 }
+
+void clrxAsyncCompilerCall(CLRXProgram* program, CLRXAsmBuildSetup&& setup,
+            cl_uint devicesNum, CLRXDevice* const* devices,
+            void (CL_CALLBACK* pfnNotify)(cl_program, void*), void* userData)
+{
+    // keep program (and original program) to end of building
+    if (program->amdOclProgram->dispatch->clRetainProgram(
+                program->amdOclProgram) != CL_SUCCESS)
+        clrxAbort("Fatal error on clRetainProgram(amdProg)");
+    clrxRetainOnlyCLRXProgramNTimes(program, 1);
+    
+    CLRXBuildProgramUserData* wrappedData = new CLRXBuildProgramUserData;
+    wrappedData->realNotify = pfnNotify;
+    wrappedData->clrxProgram = program;
+    wrappedData->realUserData = userData;
+    wrappedData->callDone = false;
+    // associated devices are updated by clrxCompilerCall
+    wrappedData->inClFunction = true;
+    
+    // build setup is moved to build thread
+    std::shared_ptr<CLRXAsmBuildSetup> buildSetup(
+                new CLRXAsmBuildSetup(std::move(setup)));
+    std::vector<CLRXDevice*> devicesList;
+    if (devices != nullptr)
+        devicesList.assign(devices, devices+devicesNum);
+    auto buildProgram = [program, buildSetup, devicesList, wrappedData]()
+    {
+        clrxCompilerCall(program, *buildSetup, devicesList.size(),
+                (!devicesList.empty()) ? devicesList.data() : nullptr);
+        {
+            std::lock_guard<std::mutex> lock(program->mutex);
+            program->concurrentBuilds--;
+        }
+        clrxBuildProgramNotifyWrapper(program, wrappedData);
+        // release program
+        if (program->amdOclProgram->dispatch->clReleaseProgram(
+                    program->amdOclProgram) != CL_SUCCESS)
+            clrxAbort("Fatal error on clReleaseProgram(amdProg)");
+        clrxReleaseOnlyCLRXProgram(program);
+    };
+    try
+    {
+        std::thread buildThread(buildProgram);
+        buildThread.detach();
+    }
+    catch(const std::system_error& ex)
+    { buildProgram(); } // if thread can not be created, then build synchronously
+}
@@ -514,8 +514,34 @@ CLRX_INTERNAL void clrxClearProgramAsmState(CLRXProgram* p);
 /* main compiler options */
 CLRX_INTERNAL bool detectCLRXCompilerCall(const char* compilerOptions);
 
-CLRX_INTERNAL cl_int clrxCompilerCall(CLRXProgram* program, const char* compilerOptions,
+/* source code and parsed build options of program to assemble */
+struct CLRX_INTERNAL CLRXAsmBuildSetup
+{
+    std::string options;
+    size_t sourceCodeSize;
+    std::unique_ptr<char[]> sourceCode;
+    CLRX::Flags asmFlags;
+    std::vector<CLRX::CString> includePaths;
+    std::vector<std::pair<CLRX::CString, uint64_t> > defSyms;
+    bool useCL20Std;
+    bool useLegacy;
+    bool useCL2StdForGCN11;
+    bool havePolicy;
+    cxuint policyVersion;
+};
+
+/* check devices, get source code and parse build options (errors that should be
+ * returned by clBuildProgram), does not change program state */
+CLRX_INTERNAL cl_int clrxPrepareCompilerCall(CLRXProgram* program,
+            const char* compilerOptions, cl_uint devicesNum, const cl_device_id* devices,
+            CLRXAsmBuildSetup& setup);
+CLRX_INTERNAL cl_int clrxCompilerCall(CLRXProgram* program, const CLRXAsmBuildSetup& setup,
             cl_uint devicesNum, CLRXDevice* const* devices);
+/* run clrxCompilerCall in background thread, and call notify after building
+ * (program must be in IN_PROGRESS state and concurrentBuilds must be incremented) */
+CLRX_INTERNAL void clrxAsyncCompilerCall(CLRXProgram* program, CLRXAsmBuildSetup&& setup,
+            cl_uint devicesNum, CLRXDevice* const* devices,
+            void (CL_CALLBACK* pfnNotify)(cl_program, void*), void* userData);
 
 CLRX_INTERNAL void clrxAbort(const char* abortStr);
 CLRX_INTERNAL void clrxAbort(const char* abortStr, const char* exStr);
@@ -0,0 +1,228 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with this program; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <streambuf>
+#include <memory>
+#include <vector>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/CLIParser.h>
+#include <CLRX/amdbin/AmdBinaries.h>
+#include <CLRX/amdbin/AmdCL2Binaries.h>
+#include <CLRX/amdbin/ROCmBinaries.h>
+#include <CLRX/amdbin/GalliumBinaries.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include <CLRX/amdasm/GCNAnalyzer.h>
+
+using namespace CLRX;
+
+static const CLIOption programOptions[] =
+{
+    { "raw", 'r', CLIArgType::NONE, false, false, "treat input as raw GCN code", nullptr },
+    { "gpuType", 'g', CLIArgType::TRIMMED_STRING, false, false,
+        "set GPU type for Gallium/raw binaries", "DEVICE" },
+    { "arch", 'A', CLIArgType::TRIMMED_STRING, false, false,
+        "set GPU architecture for Gallium/raw binaries", "ARCH" },
+    { "driverVersion", 't', CLIArgType::UINT, false, false,
+        "set driver version (for AmdCL2)", "VERSION" },
+    { "llvmVersion", 0, CLIArgType::UINT, false, false,
+        "set LLVM version (for Gallium)", "VERSION" },
+    { "kernel", 'k', CLIArgType::TRIMMED_STRING_ARRAY, false, true,
+        "analyze only specified kernel", "KERNEL" },
+    { "dpFactor", 'D', CLIArgType::UINT, false, false,
+        "set DPFACTOR (1, 2, 4 or 8)", "FACTOR" },
+    { "groupWaves", 'w', CLIArgType::UINT, false, false,
+        "set number of waves per work group", "WAVES" },
+    { "summary", 's', CLIArgType::NONE, false, false,
+        "print only kernel summaries (without blocks)", nullptr },
+    CLRX_CLI_AUTOHELP
+    { nullptr, 0 }
+};
+
+// stream buffer that discards disassembled text
+class NullStreamBuf: public std::streambuf
+{
+protected:
+    int overflow(int c)
+    { return c; }
+    std::streamsize xsputn(const char* s, std::streamsize n)
+    { return n; }
+};
+
+int main(int argc, const char** argv)
+try
+{
+    CLIParser cli("clrxanalyze", programOptions, argc, argv);
+    cli.parse();
+    if (cli.handleHelpOrUsage())
+        return 0;
+    
+    if (cli.getArgsNum() == 0)
+    {
+        std::cerr << "No input files." << std::endl;
+        return 1;
+    }
+    
+    // code, kernel configuration (for occupancy) and control flow graph
+    const Flags disasmFlags = DISASM_DUMPCODE|DISASM_CONFIG|DISASM_CFG;
+    
+    bool hasGPUDeviceType = false;
+    GPUDeviceType gpuDeviceType = GPUDeviceType::CAPE_VERDE;
+    const bool fromRawCode = cli.hasShortOption('r');
+    if (cli.hasShortOption('g'))
+    {
+        gpuDeviceType = getGPUDeviceTypeFromName(cli.getShortOptArg<const char*>('g'));
+        hasGPUDeviceType = true;
+    }
+    else if (cli.hasShortOption('A'))
+    {
+        gpuDeviceType = getLowestGPUDeviceTypeFromArchitecture(
+                    getGPUArchitectureFromName(cli.getShortOptArg<const char*>('A')));
+        hasGPUDeviceType = true;
+    }
+    
+    cxuint driverVersion = 0;
+    if (cli.hasShortOption('t'))
+        driverVersion = cli.getShortOptArg<cxuint>('t');
+    cxuint llvmVersion = 0;
+    if (cli.hasLongOption("llvmVersion"))
+        llvmVersion = cli.getLongOptArg<cxuint>("llvmVersion");
+    cxuint dpFactor = 0;
+    if (cli.hasShortOption('D'))
+        dpFactor = cli.getShortOptArg<cxuint>('D');
+    cxuint groupWaves = 1;
+    if (cli.hasShortOption('w'))
+        groupWaves = cli.getShortOptArg<cxuint>('w');
+    const bool printBlocks = !cli.hasShortOption('s');
+    
+    // kernels to analyze (empty - all kernels)
+    std::vector<CString> kernelNames;
+    if (cli.hasShortOption('k'))
+    {
+        size_t kernelNamesNum = 0;
+        const char* const* kernelNamesArr =
+                cli.getShortOptArgArray<const char*>('k', kernelNamesNum);
+        kernelNames.assign(kernelNamesArr, kernelNamesArr + kernelNamesNum);
+    }
+    
+    NullStreamBuf nullBuf;
+    std::ostream nullStream(&nullBuf);
+    int ret = 0;
+    for (const char* const* args = cli.getArgs();*args != nullptr; args++)
+    {
+        std::cout << "Analyzing '" << *args << "'" << std::endl;
+        try
+        {
+            Array<cxbyte> binaryData = loadDataFromFile(*args);
+            std::unique_ptr<AmdMainBinaryBase> base = nullptr;
+            std::unique_ptr<ROCmBinary> rocmBin;
+            std::unique_ptr<GalliumBinary> galliumBin;
+            std::unique_ptr<Disassembler> disasm;
+            if (fromRawCode)
+                disasm.reset(new Disassembler(gpuDeviceType, binaryData.size(),
+                        binaryData.data(), nullStream, disasmFlags));
+            else if (isAmdBinary(binaryData.size(), binaryData.data()))
+            {
+                // with CAL notes and info strings needed by kernel configuration
+                base.reset(createAmdBinaryFromCode(binaryData.size(), binaryData.data(),
+                        AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_KERNELINFOMAP |
+                        AMDBIN_CREATE_INNERBINMAP | AMDBIN_CREATE_KERNELHEADERS |
+                        AMDBIN_CREATE_KERNELHEADERMAP | AMDBIN_CREATE_INFOSTRINGS |
+                        (kernelNames.empty() ? AMDBIN_INNER_CREATE_CALNOTES : 0)));
+                if (base->getType() == AmdMainType::GPU_BINARY)
+                    disasm.reset(new Disassembler(
+                            *static_cast<AmdMainGPUBinary32*>(base.get()),
+                            nullStream, disasmFlags, kernelNames));
+                else if (base->getType() == AmdMainType::GPU_64_BINARY)
+                    disasm.reset(new Disassembler(
+                            *static_cast<AmdMainGPUBinary64*>(base.get()),
+                            nullStream, disasmFlags, kernelNames));
+                else
+                    throw Exception("This is not AMDGPU binary file!");
+            }
+            else if (isAmdCL2Binary(binaryData.size(), binaryData.data()))
+            {
+                base.reset(createAmdCL2BinaryFromCode(binaryData.size(), binaryData.data(),
+                        AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_KERNELINFOMAP |
+                        AMDBIN_CREATE_INNERBINMAP | AMDBIN_CREATE_KERNELHEADERS |
+                        AMDBIN_CREATE_KERNELHEADERMAP | AMDBIN_CREATE_INFOSTRINGS |
+                        AMDCL2BIN_INNER_CREATE_KERNELDATA |
+                        AMDCL2BIN_INNER_CREATE_KERNELDATAMAP |
+                        AMDCL2BIN_INNER_CREATE_KERNELSTUBS));
+                if (base->getType() == AmdMainType::GPU_CL2_BINARY)
+                    disasm.reset(new Disassembler(
+                            *static_cast<AmdCL2MainGPUBinary32*>(base.get()),
+                            nullStream, disasmFlags, driverVersion, kernelNames));
+                else if (base->getType() == AmdMainType::GPU_CL2_64_BINARY)
+                    disasm.reset(new Disassembler(
+                            *static_cast<AmdCL2MainGPUBinary64*>(base.get()),
+                            nullStream, disasmFlags, driverVersion, kernelNames));
+                else
+                    throw Exception("This is not AMDGPU binary file!");
+            }
+            else if (isROCmBinary(binaryData.size(), binaryData.data()))
+            {
+                rocmBin.reset(new ROCmBinary(binaryData.size(), binaryData.data(), 0));
+                disasm.reset(new Disassembler(*rocmBin, nullStream, hasGPUDeviceType,
+                        gpuDeviceType, disasmFlags, kernelNames));
+            }
+            else
+            {
+                galliumBin.reset(new GalliumBinary(binaryData.size(),
+                        binaryData.data(), 0));
+                disasm.reset(new Disassembler(gpuDeviceType, *galliumBin, nullStream,
+                        disasmFlags, llvmVersion));
+                disasm->setKernelNames(kernelNames);
+            }
+            disasm->disassemble();
+            
+            GCNCodeAnalyzer analyzer(disasm->getDeviceType(), dpFactor);
+            writeGCNTimingReport(std::cout, analyzer.analyze(disasm->getCFGs(),
+                        disasm->getKernelResources(), groupWaves), printBlocks);
+        }
+        catch(const std::exception& ex)
+        {
+            ret = 1;
+            std::cerr << "Error during analyzing '" << *args << "': " <<
+                    ex.what() << std::endl;
+        }
+    }
+    return ret;
+}
+catch(const Exception& ex)
+{
+    std::cerr << ex.what() << std::endl;
+    return 1;
+}
+catch(const std::bad_alloc& ex)
+{
+    std::cerr << "Out of memory" << std::endl;
+    return 1;
+}
+catch(const std::exception& ex)
+{
+    std::cerr << "System exception: " << ex.what() << std::endl;
+    return 1;
+}
+catch(...)
+{
+    std::cerr << "Unknown exception" << std::endl;
+    return 1;
+}
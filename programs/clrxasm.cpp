@@ -19,14 +19,17 @@
 
 #include <CLRX/Config.h>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <fstream>
 #include <cstring>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/CLIParser.h>
+#include <CLRX/utils/InputOutput.h>
 #include <CLRX/amdbin/AmdBinaries.h>
 #include <CLRX/amdbin/GalliumBinaries.h>
 #include <CLRX/amdasm/Assembler.h>
+#include <CLRX/amdasm/AsmBinaryCache.h>
 
 using namespace CLRX;
 
@@ -61,10 +64,20 @@ static const CLIOption programOptions[] =
         "use old and buggy fplit rules", nullptr },
     { "oldModParam", 0, CLIArgType::NONE, false, false,
         "use old modifier parametrization", nullptr },
+    { "alignOpt", 0, CLIArgType::NONE, false, false,
+        "align code labels to avoid jump penalties (GCN1.0/1.1)", nullptr },
+    { "shrinkCode", 0, CLIArgType::NONE, false, false,
+        "choose shortest encoding by swapping operands and folding literals", nullptr },
+    { "stats", 0, CLIArgType::NONE, false, false,
+        "print assembler statistics (phase timings and counters)", nullptr },
     { "noMacroCase", 'm', CLIArgType::NONE, false, false,
         "do not ignore letter's case in macro names", nullptr },
     { "policy", 0, CLIArgType::UINT, false, false,
         "set policy version", "VERSION" },
+    { "cacheDir", 0, CLIArgType::STRING, false, false,
+        "use binary cache in directory", "DIR" },
+    { "cacheMaxSize", 0, CLIArgType::UINT64, false, false,
+        "set maximal size of binary cache in bytes", "SIZE" },
     { "noWarnings", 'w', CLIArgType::NONE, false, false, "disable warnings", nullptr },
     CLRX_CLI_AUTOHELP
     { nullptr, 0 }
@@ -81,6 +94,18 @@ static bool verifySymbolName(const CString& symbolName)
     return *c==0;
 }
 
+// write binary (from cache or assembler) to output file
+static void writeOutputFile(const char* outputName, const Array<cxbyte>& binary)
+{
+    FileOStream ofs(outputName);
+    if (!ofs)
+        throw Exception(std::string("Can't open output file '")+outputName+"'");
+    ofs.write((const char*)binary.data(), binary.size());
+    ofs.close();
+    if (!ofs)
+        throw Exception(std::string("Can't write output file '")+outputName+"'");
+}
+
 int main(int argc, const char** argv)
 try
 {
@@ -139,6 +164,12 @@ try
         flags |= ASM_MACRONOCASE;
     if (cli.hasLongOption("oldModParam"))
         flags |= ASM_OLDMODPARAM;
+    if (cli.hasLongOption("alignOpt"))
+        flags |= ASM_ALIGNOPT;
+    if (cli.hasLongOption("shrinkCode"))
+        flags |= ASM_SHRINKCODE;
+    if (cli.hasLongOption("stats"))
+        flags |= ASM_STATS;
     if (cli.hasShortOption('3'))
         flags |= ASM_WAVE32;
     if (cli.hasLongOption("newROCmBinFormat"))
@@ -154,9 +185,25 @@ try
     for (cxuint i = 0; i < argsNum; i++)
         filenames[i] = cli.getArgs()[i];
     
+    // statistics are collected only while assembling, hence do not use cache
+    const bool useCache = cli.hasLongOption("cacheDir") && !cli.hasLongOption("stats");
+    // source from stdin must be in memory to compute cache key
+    std::string stdinSource;
+    std::unique_ptr<ArrayIStream> stdinSourceStream;
+    if (useCache && filenames.empty())
+    {
+        stdinSource.assign(std::istreambuf_iterator<char>(std::cin),
+                    std::istreambuf_iterator<char>());
+        stdinSourceStream.reset(new ArrayIStream(stdinSource.size(),
+                    stdinSource.data()));
+    }
+    
     std::unique_ptr<Assembler> assembler;
     if (!filenames.empty())
         assembler.reset(new Assembler(filenames, flags, binFormat, deviceType));
+    else if (stdinSourceStream)
+        assembler.reset(new Assembler(nullptr, *stdinSourceStream, flags,
+                    binFormat, deviceType));
     else // if from stdin
         assembler.reset(new Assembler(nullptr, std::cin, flags, binFormat, deviceType));
     assembler->set64Bit(is64Bit);
@@ -224,14 +271,65 @@ try
     // exit if errors occurred
     if (ret!=0)
         return ret;
+    
+    const char* outputName = "a.out";
+    if (cli.hasShortOption('o'))
+        outputName = cli.getShortOptArg<const char*>('o');
+    
+    std::unique_ptr<AsmBinaryCache> binCache;
+    AsmCacheKey cacheKey = { { 0, 0 } };
+    if (useCache)
+    {
+        try
+        {
+            binCache.reset(new AsmBinaryCache(cli.getLongOptArg<const char*>("cacheDir"),
+                    cli.hasLongOption("cacheMaxSize") ?
+                    cli.getLongOptArg<uint64_t>("cacheMaxSize") : 0));
+            cacheKey = (stdinSourceStream) ? AsmBinaryCache::computeKey(*assembler,
+                    stdinSource.size(), stdinSource.data()) :
+                    AsmBinaryCache::computeKey(*assembler);
+        }
+        catch(const Exception& ex)
+        {
+            std::cerr << "Binary cache is not used: " << ex.what() << std::endl;
+            binCache.reset();
+        }
+    }
+    Array<cxbyte> binary;
+    if (binCache && binCache->find(cacheKey, binary))
+    {
+        // just write binary from cache
+        writeOutputFile(outputName, binary);
+        return 0;
+    }
+    
     /// run assembling
     if (!assembler->assemble())
+    {
+        if (cli.hasLongOption("stats"))
+            assembler->printStats(std::cerr);
         return 1;
+    }
+    if (cli.hasLongOption("alignOpt"))
+        std::cerr << "Alignment optimisation removed " <<
+                assembler->getAlignOptPenaltyCycles() << " penalty cycles" << std::endl;
+    if (cli.hasLongOption("shrinkCode"))
+        std::cerr << "Code shrinking saved " <<
+                assembler->getShrinkCodeSavedBytes() << " bytes" << std::endl;
     /// write output to file
-    const char* outputName = "a.out";
-    if (cli.hasShortOption('o'))
-        outputName = cli.getShortOptArg<const char*>('o');
-    assembler->writeBinary(outputName);
+    if (binCache)
+    {
+        assembler->writeBinary(binary);
+        try
+        { binCache->store(cacheKey, *assembler, binary); }
+        catch(const Exception& ex)
+        { std::cerr << "Can't store binary in cache: " << ex.what() << std::endl; }
+        writeOutputFile(outputName, binary);
+    }
+    else
+        assembler->writeBinary(outputName);
+    if (cli.hasLongOption("stats"))
+        assembler->printStats(std::cerr);
     return 0;
 }
 catch(const Exception& ex)
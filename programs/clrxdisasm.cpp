@@ -19,9 +19,13 @@
 
 #include <CLRX/Config.h>
 #include <iostream>
+#include <fstream>
+#include <cstring>
 #include <memory>
+#include <vector>
 #include <CLRX/utils/Utilities.h>
 #include <CLRX/utils/CLIParser.h>
+#include <CLRX/utils/InputOutput.h>
 #include <CLRX/amdbin/AmdBinaries.h>
 #include <CLRX/amdbin/AmdCL2Binaries.h>
 #include <CLRX/amdbin/ROCmBinaries.h>
@@ -59,10 +63,41 @@ static const CLIOption programOptions[] =
         "set LLVM version (for Gallium)", "VERSION" },
     { "buggyFPLit", 0, CLIArgType::NONE, false, false,
         "use old and buggy fplit rules", nullptr },
+    { "kernel", 'k', CLIArgType::TRIMMED_STRING_ARRAY, false, true,
+        "disassemble only specified kernel", "KERNEL" },
+    { "dataFile", 'D', CLIArgType::TRIMMED_STRING, false, false,
+        "write big global data blocks to raw data file", "FILE" },
+    { "dataFileMinSize", 0, CLIArgType::SIZE, false, false,
+        "minimal size of data block written to data file", "SIZE" },
+    { "cfg", 0, CLIArgType::TRIMMED_STRING, false, false,
+        "write control flow graph of code to file", "FILE" },
+    { "cfgFormat", 0, CLIArgType::TRIMMED_STRING, false, false,
+        "control flow graph format (dot or json)", "FORMAT" },
+    { "output", 'o', CLIArgType::TRIMMED_STRING, false, false,
+        "write disassembly to file", "FILE" },
+    { "outputBufSize", 0, CLIArgType::SIZE, false, false,
+        "size of output buffers", "SIZE" },
     CLRX_CLI_AUTOHELP
     { nullptr, 0 }
 };
 
+// disassemble and append control flow graphs to list (if needed)
+static void runDisassembler(Disassembler& disasm, const CString& dataFile,
+            size_t dataFileMinSize, size_t outBufSize, std::vector<DisasmCFG>& cfgs)
+{
+    disasm.setDataFile(dataFile, dataFileMinSize);
+    if (outBufSize != 0)
+        disasm.setOutputBufferSize(outBufSize);
+    disasm.disassemble();
+    // kernels of next binaries have own code indices
+    const size_t codeBase = cfgs.empty() ? 0 : cfgs.back().codeIndex+1;
+    for (const DisasmCFG& cfg: disasm.getCFGs())
+    {
+        cfgs.push_back(cfg);
+        cfgs.back().codeIndex += codeBase;
+    }
+}
+
 int main(int argc, const char** argv)
 try
 {
@@ -115,10 +150,75 @@ try
     if (cli.hasLongOption("llvmVersion"))
         llvmVersion = cli.getLongOptArg<cxuint>("llvmVersion");
     
+    // kernels to disassemble (empty - all kernels)
+    std::vector<CString> kernelNames;
+    if (cli.hasShortOption('k'))
+    {
+        size_t kernelNamesNum = 0;
+        const char* const* kernelNamesArr =
+                cli.getShortOptArgArray<const char*>('k', kernelNamesNum);
+        kernelNames.assign(kernelNamesArr, kernelNamesArr + kernelNamesNum);
+    }
+    
+    // file for big global data blocks (included by '.incbin')
+    CString dataFile;
+    size_t dataFileMinSize = 256;
+    if (cli.hasShortOption('D'))
+        dataFile = cli.getShortOptArg<const char*>('D');
+    if (cli.hasLongOption("dataFileMinSize"))
+        dataFileMinSize = cli.getLongOptArg<size_t>("dataFileMinSize");
+    
+    // control flow graph file
+    CString cfgFile;
+    DisasmCFGFormat cfgFormat = DisasmCFGFormat::DOT;
+    if (cli.hasLongOption("cfg"))
+    {
+        cfgFile = cli.getLongOptArg<const char*>("cfg");
+        disasmFlags |= DISASM_CFG;
+    }
+    if (cli.hasLongOption("cfgFormat"))
+    {
+        const char* formatName = cli.getLongOptArg<const char*>("cfgFormat");
+        if (::strcasecmp(formatName, "json") == 0)
+            cfgFormat = DisasmCFGFormat::JSON;
+        else if (::strcasecmp(formatName, "dot") != 0)
+        {
+            std::cerr << "Unknown control flow graph format '" << formatName <<
+                    "'" << std::endl;
+            return 1;
+        }
+    }
+    std::vector<DisasmCFG> cfgs;
+    
+    // output file (standard output if not given)
+    size_t outBufSize = 0;
+    if (cli.hasLongOption("outputBufSize"))
+    {
+        outBufSize = cli.getLongOptArg<size_t>("outputBufSize");
+        if (outBufSize < Disassembler::minOutputBufferSize || outBufSize > UINT32_MAX)
+        {
+            std::cerr << "Output buffer size out of range" << std::endl;
+            return 1;
+        }
+    }
+    std::unique_ptr<FileOStream> outputFile;
+    if (cli.hasShortOption('o'))
+    {
+        const char* outputName = cli.getShortOptArg<const char*>('o');
+        outputFile.reset(new FileOStream(outputName, (outBufSize != 0) ? outBufSize :
+                    FileOutStreamBuf::defaultBufSize));
+        if (!outputFile->isOpen())
+        {
+            std::cerr << "Can't open file '" << outputName << "'" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = outputFile ? *outputFile : std::cout;
+    
     int ret = 0;
     for (const char* const* args = cli.getArgs();*args != nullptr; args++)
     {
-        std::cout << "/* Disassembling '" << *args << "\' */" << std::endl;
+        output << "/* Disassembling '" << *args << "\' */" << std::endl;
         Array<cxbyte> binaryData;
         std::unique_ptr<AmdMainBinaryBase> base = nullptr;
         try
@@ -132,6 +232,9 @@ try
                 Flags binFlags = AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_KERNELINFOMAP |
                         AMDBIN_CREATE_INNERBINMAP | AMDBIN_CREATE_KERNELHEADERS |
                         AMDBIN_CREATE_KERNELHEADERMAP;
+                // if kernels selected then parse only their inner binaries
+                if (!kernelNames.empty())
+                    binFlags |= AMDBIN_CREATE_LAZY;
                 // supply additional flags for CALNotes and info strings
                 if ((disasmFlags & (DISASM_CALNOTES|DISASM_CONFIG)) != 0)
                     binFlags |= AMDBIN_INNER_CREATE_CALNOTES;
@@ -147,15 +250,17 @@ try
                     {
                         AmdMainGPUBinary32* amdGpuBin =
                                 static_cast<AmdMainGPUBinary32*>(base.get());
-                        Disassembler disasm(*amdGpuBin, std::cout, disasmFlags);
-                        disasm.disassemble();
+                        Disassembler disasm(*amdGpuBin, output, disasmFlags,
+                                            kernelNames);
+                        runDisassembler(disasm, dataFile, dataFileMinSize, outBufSize, cfgs);
                     }
                     else if (base->getType() == AmdMainType::GPU_64_BINARY)
                     {
                         AmdMainGPUBinary64* amdGpuBin =
                                 static_cast<AmdMainGPUBinary64*>(base.get());
-                        Disassembler disasm(*amdGpuBin, std::cout, disasmFlags);
-                        disasm.disassemble();
+                        Disassembler disasm(*amdGpuBin, output, disasmFlags,
+                                            kernelNames);
+                        runDisassembler(disasm, dataFile, dataFileMinSize, outBufSize, cfgs);
                     }
                     else
                         throw Exception("This is not AMDGPU binary file!");
@@ -172,17 +277,17 @@ try
                     {
                         AmdCL2MainGPUBinary32* amdGpuBin =
                                 static_cast<AmdCL2MainGPUBinary32*>(base.get());
-                        Disassembler disasm(*amdGpuBin, std::cout, disasmFlags,
-                                            driverVersion);
-                        disasm.disassemble();
+                        Disassembler disasm(*amdGpuBin, output, disasmFlags,
+                                            driverVersion, kernelNames);
+                        runDisassembler(disasm, dataFile, dataFileMinSize, outBufSize, cfgs);
                     }
                     else if (base->getType() == AmdMainType::GPU_CL2_64_BINARY)
                     {
                         AmdCL2MainGPUBinary64* amdGpuBin =
                                 static_cast<AmdCL2MainGPUBinary64*>(base.get());
-                        Disassembler disasm(*amdGpuBin, std::cout, disasmFlags,
-                                            driverVersion);
-                        disasm.disassemble();
+                        Disassembler disasm(*amdGpuBin, output, disasmFlags,
+                                            driverVersion, kernelNames);
+                        runDisassembler(disasm, dataFile, dataFileMinSize, outBufSize, cfgs);
                     }
                     else
                         throw Exception("This is not AMDGPU binary file!");
@@ -191,36 +296,63 @@ try
                 {
                     // ROCm binary
                     ROCmBinary rocmBin(binaryData.size(), binaryData.data(), 0);
-                    Disassembler disasm(rocmBin, std::cout, hasGPUDeviceType, gpuDeviceType,
-                                        disasmFlags);
-                    disasm.disassemble();
+                    Disassembler disasm(rocmBin, output, hasGPUDeviceType, gpuDeviceType,
+                                        disasmFlags, kernelNames);
+                    runDisassembler(disasm, dataFile, dataFileMinSize, outBufSize, cfgs);
                 }
                 else
                 {
                     // if gallium binary
                     GalliumBinary galliumBin(binaryData.size(),binaryData.data(), 0);
-                    Disassembler disasm(gpuDeviceType, galliumBin, std::cout,
+                    Disassembler disasm(gpuDeviceType, galliumBin, output,
                             disasmFlags, llvmVersion);
-                    disasm.disassemble();
+                    disasm.setKernelNames(kernelNames);
+                    runDisassembler(disasm, dataFile, dataFileMinSize, outBufSize, cfgs);
                 }
             }
             else
             {
                 /* raw binaries */
                 Disassembler disasm(gpuDeviceType, binaryData.size(), binaryData.data(),
-                        std::cout, disasmFlags);
-                disasm.disassemble();
+                        output, disasmFlags);
+                runDisassembler(disasm, dataFile, dataFileMinSize, outBufSize, cfgs);
             }
         }
         catch(const std::exception& ex)
         {
             ret = 1;
-            std::cout << "/* ERROR for '" << *args << "\' */" << std::endl;
+            output << "/* ERROR for '" << *args << "\' */" << std::endl;
             std::cerr << "Error during disassemblying '" << *args << "': " <<
                     ex.what() << std::endl;
         }
     }
     
+    if (outputFile)
+    {
+        outputFile->close();
+        if (!*outputFile)
+        {
+            std::cerr << "Can't write file '" << cli.getShortOptArg<const char*>('o') <<
+                    "'" << std::endl;
+            return 1;
+        }
+    }
+    
+    if (!cfgFile.empty())
+    {
+        std::ofstream cfgOs(cfgFile.c_str());
+        if (!cfgOs)
+        {
+            std::cerr << "Can't open file '" << cfgFile.c_str() << "'" << std::endl;
+            return 1;
+        }
+        writeDisasmCFG(cfgOs, cfgs, cfgFormat);
+        if (!cfgOs)
+        {
+            std::cerr << "Can't write file '" << cfgFile.c_str() << "'" << std::endl;
+            return 1;
+        }
+    }
     return ret;
 }
 catch(const Exception& ex)
@@ -2499,5 +2499,183 @@ aa2=6
         { }, { }, { { ".", 0, 0, 0, true, false, false, 0, 0 } }, true,
         "", "isNotGCN1.4.1\n",
     },
+    /* 92 - alignment optimisation of code labels (only jump targets) */
+    {   R"ffDXD(            .rawcode
+            .text
+            .alignopt
+            s_branch a
+            s_cbranch_scc0 1f
+            .int 1,2,3
+            s_nop 0
+b:          .int 6
+a:          .int 7
+            .int 8,9,10,11,12
+1:          .int 13
+            .noalignopt
+            s_branch c
+            .int 1,1,1,1
+c:          .int 14)ffDXD",
+        BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, false, { },
+        { { ".text", ASMKERN_GLOBAL, AsmSectionType::CODE,
+            {
+                0x07, 0x00, 0x82, 0xbf, 0x0e, 0x00, 0x84, 0xbf,
+                0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00,
+                0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xbf,
+                0x06, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xbf,
+                0x07, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00,
+                0x09, 0x00, 0x00, 0x00, 0x0a, 0x00, 0x00, 0x00,
+                0x0b, 0x00, 0x00, 0x00, 0x0c, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x80, 0xbf, 0x00, 0x00, 0x80, 0xbf,
+                0x0d, 0x00, 0x00, 0x00, 0x04, 0x00, 0x82, 0xbf,
+                0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+                0x01, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00,
+                0x0e, 0x00, 0x00, 0x00
+            } } },
+        {
+            { ".", 92U, 0, 0U, true, false, false, 0, 0 },
+            { "1b", 64U, 0, 0U, true, false, false, 0, 0 },
+            { "1f", 64U, 0, 0U, false, false, false, 0, 0 },
+            { "a", 32U, 0, 0U, true, true, false, 0, 0 },
+            { "b", 24U, 0, 0U, true, true, false, 0, 0 },
+            { "c", 88U, 0, 0U, true, true, false, 0, 0 }
+        }, true, "", ""
+    },
+    /* 93 - code shrinking */
+    {   R"ffDXD(            .rawcode
+            .gpu Fiji
+            .shrinkcode
+            v_add_f32 v0, v1, s1
+            v_add_f32 v0, v1, 0.5
+            v_sub_f32 v0, v1, s2
+            v_subrev_f32 v0, v1, s2
+            v_cmp_lt_f32 vcc, v1, s1
+            v_cmp_eq_u32 vcc, v1, 5
+            v_cmp_class_f32 vcc, v1, s1
+            v_add_f32 v0, 0x3f800000, v1
+            v_and_b32 v0, 0xffffffff, v1
+            v_and_b32 v0, 0x3f800000, v1
+            v_add_f16 v0, 0x3c00, v1
+            v_add_f32 v0, lit(0x3f800000), v1
+            v_add_f32_e64 v0, v1, s1)ffDXD",
+        BinaryFormat::RAWCODE, GPUDeviceType::FIJI, false, { },
+        { { ".text", ASMKERN_GLOBAL, AsmSectionType::CODE,
+            {
+                0x01, 0x02, 0x00, 0x02, 0xf0, 0x02, 0x00, 0x02,
+                0x02, 0x02, 0x00, 0x06, 0x02, 0x02, 0x00, 0x04,
+                0x01, 0x02, 0x88, 0x7c, 0x85, 0x02, 0x94, 0x7d,
+                0x6a, 0x00, 0x10, 0xd0, 0x01, 0x03, 0x00, 0x00,
+                0xf2, 0x02, 0x00, 0x02, 0xc1, 0x02, 0x00, 0x26,
+                0xff, 0x02, 0x00, 0x26, 0x00, 0x00, 0x80, 0x3f,
+                0xf2, 0x02, 0x00, 0x3e, 0xff, 0x02, 0x00, 0x02,
+                0x00, 0x00, 0x80, 0x3f, 0x00, 0x00, 0x01, 0xd1,
+                0x01, 0x03, 0x00, 0x00
+            } } },
+        { { ".", 68U, 0, 0U, true, false, false, 0, 0 } },
+        true, "", ""
+    },
+    /* 94 - temporary scope with pending symbols (outside code section) */
+    {   R"ffDXD(            .amdcl2
+            .gpu Bonaire
+            .driver_version 200406
+            .globaldata
+            .int 1
+            .scope
+                x = y + 4
+y:              .int 2
+            .ends
+            .kernel k
+            .config
+            .text
+            s_endpgm)ffDXD",
+        BinaryFormat::AMDCL2, GPUDeviceType::BONAIRE, false, { "k" },
+        {
+            { ".rodata", ASMKERN_GLOBAL, AsmSectionType::DATA,
+                { 0x01, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00 } },
+            { ".text", 0, AsmSectionType::CODE, { 0x00, 0x00, 0x81, 0xbf } },
+            { nullptr, 0, AsmSectionType::CONFIG, { } }
+        },
+        { { ".", 4U, 1, 0U, true, false, false, 0, 0 } },
+        true, "", ""
+    },
+    /* 95 - nested temporary scopes with chained unresolved symbols */
+    {   R"ffDXD(            .amdcl2
+            .gpu Bonaire
+            .driver_version 200406
+            .globaldata
+            .int 1
+            .scope
+                a = b + 1
+                b = c + 2
+                d = a - c
+c:              .int 5
+                .scope
+                    e = f + 8
+f:                  .int 7
+                .ends
+            .ends
+            .scope
+g:              .int 3
+                .scope
+                    h = g + 4
+                .ends
+            .ends
+            .scope
+                i = 2f
+                .int 3
+2:              .int 4
+            .ends
+            .kernel k
+            .config
+            .text
+            s_endpgm)ffDXD",
+        BinaryFormat::AMDCL2, GPUDeviceType::BONAIRE, false, { "k" },
+        {
+            { ".rodata", ASMKERN_GLOBAL, AsmSectionType::DATA,
+                { 0x01, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+                  0x07, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+                  0x03, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00 } },
+            { ".text", 0, AsmSectionType::CODE, { 0x00, 0x00, 0x81, 0xbf } },
+            { nullptr, 0, AsmSectionType::CONFIG, { } }
+        },
+        {
+            { ".", 4U, 1, 0U, true, false, false, 0, 0 },
+            { "2b", 20U, 0, 0U, true, false, false, 0, 0 },
+            { "2f", 20U, 0, 0U, true, false, false, 0, 0 }
+        },
+        true, "", ""
+    },
+    /* 96 - temporary scopes with symbols resolved after scope closing */
+    {   R"ffDXD(            .rawcode
+            .scope
+                .int a, b
+                .scope
+                    .int c+a
+                    c = 7
+                .ends
+                a = 3
+                b = a*2
+            .ends
+            .scope
+                x1 = x2+1
+                x2 = 4
+                .int x1
+            .ends
+            .scope
+                .int z
+            .ends
+            .int x1)ffDXD",
+        BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, false, { },
+        { { ".text", ASMKERN_GLOBAL, AsmSectionType::CODE,
+            {
+                0x03, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00,
+                0x0a, 0x00, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00,
+                0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+            } } },
+        {
+            { ".", 24U, 0, 0U, true, false, false, 0, 0 },
+            { "x1", 0U, ASMSECT_ABS, 0U, false, false, false, 0, 0 }
+        },
+        true, "", ""
+    },
     { nullptr }
 };
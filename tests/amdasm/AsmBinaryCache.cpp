@@ -0,0 +1,294 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#ifdef HAVE_WINDOWS
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/InputOutput.h>
+#include <CLRX/amdasm/AsmBinaryCache.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+static const char* cacheDir = "AsmBinaryCacheTest.dir";
+static const char* includeFile = "AsmBinaryCacheTest.inc";
+
+static void testAsmCacheHasher()
+{
+    // reference values of the MurmurHash3 x64 128-bit with zero seed
+    AsmCacheHasher hasher;
+    assertValue("AsmCacheHasher", "empty", std::string("00000000000000000000000000000000"),
+                hasher.finish().toString());
+    hasher.update(5, "hello");
+    assertValue("AsmCacheHasher", "hello", std::string("cbd8a7b341bd9b025b1e906a48ae1d19"),
+                hasher.finish().toString());
+    
+    // incremental hashing must give this same result
+    std::vector<cxbyte> data(1000);
+    for (size_t i = 0; i < data.size(); i++)
+        data[i] = (i*7)^(i>>3);
+    AsmCacheHasher oneHasher;
+    oneHasher.update(data.size(), data.data());
+    const AsmCacheKey expectedKey = oneHasher.finish();
+    for (size_t step: { 1, 3, 7, 15, 16, 17, 100 })
+    {
+        AsmCacheHasher stepHasher;
+        for (size_t pos = 0; pos < data.size(); pos += step)
+            stepHasher.update(std::min(step, data.size()-pos), data.data()+pos);
+        assertTrue("AsmCacheHasher", "incremental#" + std::to_string(step),
+                   stepHasher.finish() == expectedKey);
+    }
+}
+
+static void writeTextFile(const char* filename, const char* content)
+{
+    std::ofstream ofs(filename, std::ios::binary);
+    ofs << content;
+}
+
+// assemble source or get binary from cache, returns true if binary found in cache
+static bool assembleByCache(const AsmBinaryCache& cache, const char* source,
+            uint64_t value, Array<cxbyte>& binary, AsmCacheKey& key)
+{
+    ArrayIStream input(::strlen(source), source);
+    std::ostringstream msgStream;
+    Assembler assembler("", input, 0, BinaryFormat::RAWCODE, GPUDeviceType::PITCAIRN,
+                msgStream);
+    assembler.setDriverVersion(200406);
+    assembler.setLLVMVersion(40000);
+    assembler.addInitialDefSym("VALUE", value);
+    key = AsmBinaryCache::computeKey(assembler, ::strlen(source), source);
+    if (cache.find(key, binary))
+        return true;
+    if (!assembler.assemble())
+        throw Exception("Assembler failed: " + msgStream.str());
+    assembler.writeBinary(binary);
+    if (assembler.getDependencyFiles().size() != 1 ||
+        assembler.getDependencyFiles()[0] != includeFile)
+        throw Exception("Wrong dependency files");
+    cache.store(key, assembler, binary);
+    return false;
+}
+
+static std::string getEntryPath(const AsmCacheKey& key)
+{ return joinPaths(cacheDir, key.toString() + ".clrxbc"); }
+
+static void setFileTime(const std::string& path, time_t time)
+{
+#ifdef HAVE_WINDOWS
+    struct _utimbuf times = { time, time };
+    _utime(path.c_str(), &times);
+#else
+    struct utimbuf times = { time, time };
+    ::utime(path.c_str(), &times);
+#endif
+}
+
+static void testAsmBinaryCache()
+{
+    const char* source = ".include \"AsmBinaryCacheTest.inc\"\n.int VALUE\n";
+    writeTextFile(includeFile, ".byte 1,2,3,4\n");
+    const cxbyte expected1[8] = { 1, 2, 3, 4, 11, 0, 0, 0 };
+    const cxbyte expected2[8] = { 5, 6, 7, 8, 11, 0, 0, 0 };
+    AsmCacheKey otherKey;
+    {
+        AsmBinaryCache cache(cacheDir);
+        Array<cxbyte> binary;
+        AsmCacheKey key, key2;
+        assertTrue("AsmBinaryCache", "firstMiss",
+                !assembleByCache(cache, source, 11, binary, key));
+        assertArray("AsmBinaryCache", "firstBinary", Array<cxbyte>(expected1, expected1+8),
+                binary);
+        assertTrue("AsmBinaryCache", "hit", assembleByCache(cache, source, 11, binary, key2));
+        assertTrue("AsmBinaryCache", "hitKey", key == key2);
+        assertArray("AsmBinaryCache", "hitBinary", Array<cxbyte>(expected1, expected1+8),
+                binary);
+        // other defsym value
+        assertTrue("AsmBinaryCache", "otherDefSym",
+                !assembleByCache(cache, source, 12, binary, otherKey));
+        assertTrue("AsmBinaryCache", "otherDefSymKey", key != otherKey);
+        // changed included file (this same key, but entry is not valid)
+        writeTextFile(includeFile, ".byte 5,6,7,8\n");
+        assertTrue("AsmBinaryCache", "changedInclude",
+                !assembleByCache(cache, source, 11, binary, key2));
+        assertTrue("AsmBinaryCache", "changedIncludeKey", key == key2);
+        assertArray("AsmBinaryCache", "changedIncludeBinary",
+                Array<cxbyte>(expected2, expected2+8), binary);
+        assertTrue("AsmBinaryCache", "changedIncludeHit",
+                assembleByCache(cache, source, 11, binary, key2));
+        // corrupted entry
+        const std::string entryPath = getEntryPath(key);
+        Array<cxbyte> content = loadDataFromFile(entryPath.c_str());
+        content[content.size()-20] ^= 1;
+        {
+            std::ofstream ofs(entryPath.c_str(), std::ios::binary);
+            ofs.write((const char*)content.data(), content.size());
+        }
+        assertTrue("AsmBinaryCache", "corrupted", !cache.find(key, binary));
+        std::remove(entryPath.c_str());
+    }
+    {
+        // eviction of least recently used entries (4 entries fit in cache)
+        const std::string otherEntryPath = getEntryPath(otherKey);
+        const uint64_t entrySize = loadDataFromFile(otherEntryPath.c_str()).size();
+        AsmBinaryCache cache(cacheDir, entrySize*4 + entrySize/2);
+        Array<cxbyte> binary;
+        AsmCacheKey key;
+        const time_t now = ::time(nullptr);
+        setFileTime(otherEntryPath, now-1000);
+        // entry is recently used after hit
+        writeTextFile(includeFile, ".byte 1,2,3,4\n");
+        assertTrue("AsmBinaryCacheEvict", "hit",
+                assembleByCache(cache, source, 12, binary, key));
+        std::vector<AsmCacheKey> keys;
+        for (cxuint i = 0; i < 4; i++)
+        {
+            assertTrue("AsmBinaryCacheEvict", "miss#" + std::to_string(i),
+                    !assembleByCache(cache, source, 13+i, binary, key));
+            setFileTime(getEntryPath(key), now-500+i*10);
+            keys.push_back(key);
+        }
+        // last store removes the oldest entry
+        assertTrue("AsmBinaryCacheEvict", "keptHitEntry",
+                isFileExists(otherEntryPath.c_str()));
+        assertTrue("AsmBinaryCacheEvict", "evictedOldest",
+                !isFileExists(getEntryPath(keys[0]).c_str()));
+        for (cxuint i = 1; i < 4; i++)
+            assertTrue("AsmBinaryCacheEvict", "kept#" + std::to_string(i),
+                    isFileExists(getEntryPath(keys[i]).c_str()));
+        std::remove(otherEntryPath.c_str());
+        for (const AsmCacheKey& k: keys)
+            std::remove(getEntryPath(k).c_str());
+    }
+    std::remove(includeFile);
+    std::remove(cacheDir);
+}
+
+static const char* includeDir = "AsmBinaryCacheTest.incdir";
+static const char* includeFile2 = "AsmBinaryCacheTest2.inc";
+static const char* binaryFile2 = "AsmBinaryCacheTest2.bin";
+
+// assemble source with include directory or get binary from cache
+static bool assembleByCacheIncDir(const AsmBinaryCache& cache, const char* source,
+            Array<cxbyte>& binary, AsmCacheKey& key, std::vector<CString>& failedPaths)
+{
+    ArrayIStream input(::strlen(source), source);
+    std::ostringstream msgStream;
+    Assembler assembler("", input, 0, BinaryFormat::RAWCODE, GPUDeviceType::PITCAIRN,
+                msgStream);
+    assembler.setDriverVersion(200406);
+    assembler.setLLVMVersion(40000);
+    assembler.addIncludeDir(includeDir);
+    key = AsmBinaryCache::computeKey(assembler, ::strlen(source), source);
+    if (cache.find(key, binary))
+        return true;
+    if (!assembler.assemble())
+        throw Exception("Assembler failed: " + msgStream.str());
+    assembler.writeBinary(binary);
+    failedPaths = assembler.getFailedIncludePaths();
+    cache.store(key, assembler, binary);
+    return false;
+}
+
+static void testAsmBinaryCacheIncludePaths()
+{
+    const char* source = ".include \"AsmBinaryCacheTest2.inc\"\n"
+            ".incbin \"AsmBinaryCacheTest2.bin\"\n";
+    if (!isFileExists(includeDir))
+        makeDir(includeDir);
+    const std::string incDirFile = joinPaths(includeDir, includeFile2);
+    const std::string incDirBinFile = joinPaths(includeDir, binaryFile2);
+    writeTextFile(incDirFile.c_str(), ".byte 1,2\n");
+    writeTextFile(incDirBinFile.c_str(), "ab");
+    const cxbyte expected1[4] = { 1, 2, 'a', 'b' };
+    const cxbyte expected2[4] = { 3, 4, 'a', 'b' };
+    const cxbyte expected3[4] = { 3, 4, 'c', 'd' };
+    AsmBinaryCache cache(cacheDir);
+    Array<cxbyte> binary;
+    AsmCacheKey key;
+    std::vector<CString> failedPaths;
+    assertTrue("AsmBinaryCacheIncDir", "firstMiss",
+            !assembleByCacheIncDir(cache, source, binary, key, failedPaths));
+    assertArray("AsmBinaryCacheIncDir", "firstBinary",
+            Array<cxbyte>(expected1, expected1+4), binary);
+    // files not found in current directory
+    assertValue("AsmBinaryCacheIncDir", "failedPathsNum", size_t(2), failedPaths.size());
+    assertString("AsmBinaryCacheIncDir", "failedPath0", includeFile2, failedPaths[0]);
+    assertString("AsmBinaryCacheIncDir", "failedPath1", binaryFile2, failedPaths[1]);
+    assertTrue("AsmBinaryCacheIncDir", "hit",
+            assembleByCacheIncDir(cache, source, binary, key, failedPaths));
+    assertArray("AsmBinaryCacheIncDir", "hitBinary",
+            Array<cxbyte>(expected1, expected1+4), binary);
+    // included file appeared in current directory (searched before include dir)
+    writeTextFile(includeFile2, ".byte 3,4\n");
+    assertTrue("AsmBinaryCacheIncDir", "newInclude",
+            !assembleByCacheIncDir(cache, source, binary, key, failedPaths));
+    assertArray("AsmBinaryCacheIncDir", "newIncludeBinary",
+            Array<cxbyte>(expected2, expected2+4), binary);
+    assertValue("AsmBinaryCacheIncDir", "newIncludeFailedNum", size_t(1),
+            failedPaths.size());
+    assertTrue("AsmBinaryCacheIncDir", "newIncludeHit",
+            assembleByCacheIncDir(cache, source, binary, key, failedPaths));
+    // binary file appeared in current directory
+    writeTextFile(binaryFile2, "cd");
+    assertTrue("AsmBinaryCacheIncDir", "newIncBin",
+            !assembleByCacheIncDir(cache, source, binary, key, failedPaths));
+    assertArray("AsmBinaryCacheIncDir", "newIncBinBinary",
+            Array<cxbyte>(expected3, expected3+4), binary);
+    assertTrue("AsmBinaryCacheIncDir", "newIncBinHit",
+            assembleByCacheIncDir(cache, source, binary, key, failedPaths));
+    // included files and failed paths of entry
+    std::vector<CString> entryDepFiles, entryFailedPaths;
+    assertTrue("AsmBinaryCacheIncDir", "findDeps",
+            cache.find(key, binary, &entryDepFiles, &entryFailedPaths));
+    assertValue("AsmBinaryCacheIncDir", "depFilesNum", size_t(2), entryDepFiles.size());
+    assertString("AsmBinaryCacheIncDir", "depFile0", includeFile2, entryDepFiles[0]);
+    assertString("AsmBinaryCacheIncDir", "depFile1", binaryFile2, entryDepFiles[1]);
+    assertValue("AsmBinaryCacheIncDir", "entryFailedNum", size_t(0),
+            entryFailedPaths.size());
+    
+    std::remove(getEntryPath(key).c_str());
+    std::remove(includeFile2);
+    std::remove(binaryFile2);
+    std::remove(incDirFile.c_str());
+    std::remove(incDirBinFile.c_str());
+    std::remove(includeDir);
+    std::remove(cacheDir);
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    retVal |= callTest(testAsmCacheHasher);
+    retVal |= callTest(testAsmBinaryCache);
+    retVal |= callTest(testAsmBinaryCacheIncludePaths);
+    return retVal;
+}
@@ -406,7 +406,16 @@ static AsmExprParseCase asmExprParseCases[] =
     { "( ala + .,. )", "", false, 0, "<stdin>:1:11: Error: Garbages at end of expression\n"
         "<stdin>:1:12: Error: Garbages at end of expression\n", "" },
     /* with ',' */
-    { "123+45*,", "", false, 0, "<stdin>:1:8: Error: Unterminated expression\n", "," }
+    { "123+45*,", "", false, 0, "<stdin>:1:8: Error: Unterminated expression\n", "," },
+    /* constant folding in expressions with undefined symbols */
+    { "x+2*9+11*5", "x 18 + 55 +", false, 0, "", "" },
+    { "a*(4-7+8)", "a 5 *", false, 0, "", "" },
+    { "-(3*4)+~z", "18446744073709551604 z ~ +", false, 0, "", "" },
+    { "(2<7)?x:y", "18446744073709551615 x y ?", false, 0, "", "" },
+    { "(1?5:6)+x", "5 x +", false, 0, "", "" },
+    /* ops with message are not folded */
+    { "x+8/2", "x 8 2 / +", false, 0, "", "" },
+    { "x+(8%3)*(1<<64)", "x 8 3 % 1 64 << * +", false, 0, "", "" }
 };
 
 /* fast expression evaluation test cases */
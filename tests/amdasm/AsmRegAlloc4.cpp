@@ -0,0 +1,353 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <climits>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdasm/Assembler.h>
+#include <CLRX/utils/Containers.h>
+#include "../TestUtils.h"
+#include "AsmRegAlloc.h"
+
+using namespace CLRX;
+
+typedef AsmRegAllocator::VarIndexMap VarIndexMap;
+typedef AsmRegAllocator::InterGraph InterGraph;
+
+struct AsmInterGraphCase
+{
+    const char* input;
+    // neighbours of nodes (indices of vars sorted by name, index and SSA id)
+    Array<Array<size_t> > interGraphs[MAX_REGTYPES_NUM];
+    // colors of nodes (indices of vars sorted by name, index and SSA id)
+    Array<cxuint> graphColorMaps[MAX_REGTYPES_NUM];
+    bool good;
+    const char* errorMessages;
+};
+
+static const AsmInterGraphCase interGraphTestCasesTbl[] =
+{
+    {   // 0 - simple case
+        R"ffDXD(.regvar sa:s:8, va:v:10
+        s_mov_b32 sa[4], sa[2]  # 0
+        s_add_u32 sa[4], sa[4], s3
+        v_xor_b32 va[4], va[2], v3
+        s_endpgm
+)ffDXD",
+        {   // interference graphs
+            {   // for SGPRs
+                { 1, 2 },   // S3
+                { 0 },      // sa[2]'0
+                { 0 },      // sa[4]'0
+                { }         // sa[4]'1
+            },
+            {   // for VGPRs
+                { 1 },      // V3
+                { 0 },      // va[2]'0
+                { }         // va[4]'0
+            },
+            { },
+            { }
+        },
+        {   // graph colors
+            { 0, 1, 1, 0 },
+            { 0, 1, 0 },
+            { },
+            { }
+        },
+        true, ""
+    },
+    {   // 1 - chain of variables (nodes with equal degrees)
+        R"ffDXD(.regvar sa:s:8
+        s_mov_b32 sa[0], s1
+        s_add_u32 sa[1], sa[0], 3
+        s_add_u32 sa[2], sa[0], sa[1]
+        s_add_u32 sa[3], sa[1], sa[2]
+        s_add_u32 sa[4], sa[2], sa[3]
+        s_add_u32 sa[5], sa[3], sa[4]
+        s_cmp_eq_u32 sa[5], 0
+        s_endpgm
+)ffDXD",
+        {   // interference graphs
+            {   // for SGPRs
+                { },        // S1
+                { 2 },      // sa[0]'0
+                { 1, 3 },   // sa[1]'0
+                { 2, 4 },   // sa[2]'0
+                { 3, 5 },   // sa[3]'0
+                { 4 },      // sa[4]'0
+                { }         // sa[5]'0
+            },
+            { },
+            { },
+            { }
+        },
+        {   // graph colors
+            { 0, 1, 0, 1, 0, 1, 0 },
+            { },
+            { },
+            { }
+        },
+        true, ""
+    },
+    {   // 2 - nested live ranges
+        R"ffDXD(.regvar sa:s:8
+        s_mov_b32 sa[0], s1
+        s_add_u32 sa[1], sa[0], 1
+        s_add_u32 sa[2], sa[0], 2
+        s_add_u32 sa[3], sa[0], 3
+        s_add_u32 sa[4], sa[0], sa[1]
+        s_add_u32 sa[5], sa[2], sa[3]
+        s_add_u32 sa[6], sa[4], sa[5]
+        s_cmp_eq_u32 sa[6], 0
+        s_endpgm
+)ffDXD",
+        {   // interference graphs
+            {   // for SGPRs
+                { },            // S1
+                { 2, 3, 4 },    // sa[0]'0
+                { 1, 3, 4 },    // sa[1]'0
+                { 1, 2, 4, 5 }, // sa[2]'0
+                { 1, 2, 3, 5 }, // sa[3]'0
+                { 3, 4, 6 },    // sa[4]'0
+                { 5 },          // sa[5]'0
+                { }             // sa[6]'0
+            },
+            { },
+            { },
+            { }
+        },
+        {   // graph colors
+            { 0, 2, 3, 0, 1, 2, 0, 0 },
+            { },
+            { },
+            { }
+        },
+        true, ""
+    },
+    {   // 3 - branches
+        R"ffDXD(.regvar sa:s:8, va:v:8
+        s_mov_b32 sa[0], s4
+        v_mov_b32 va[0], v1
+        s_cmp_eq_u32 sa[0], 0
+        s_cbranch_scc1 b1
+        v_add_f32 va[1], va[0], va[0]
+        v_mov_b32 va[2], va[1]
+        s_branch end
+b1:     v_sub_f32 va[1], sa[0], va[0]
+        v_mov_b32 va[3], va[1]
+        v_add_f32 va[2], va[3], va[0]
+end:    v_add_f32 va[4], sa[0], va[2]
+        s_endpgm
+)ffDXD",
+        {   // interference graphs
+            {   // for SGPRs
+                { },        // S4
+                { }         // sa[0]'0
+            },
+            {   // for VGPRs
+                { },        // V1
+                { 3, 5 },   // va[0]'0
+                { },        // va[1]'0
+                { 1 },      // va[1]'1
+                { },        // va[2]'0
+                { 1 },      // va[3]'0
+                { }         // va[4]'0
+            },
+            { },
+            { }
+        },
+        {   // graph colors
+            { 0, 0 },
+            { 0, 0, 0, 1, 0, 1, 0 },
+            { },
+            { }
+        },
+        true, ""
+    },
+    {   // 4 - loop
+        R"ffDXD(.regvar sa:s:4
+        s_mov_b32 sa[0], s4
+        s_mov_b32 sa[1], 0
+loop:   s_add_u32 sa[1], sa[1], sa[0]
+        s_sub_u32 sa[0], sa[0], 1
+        s_cmp_eq_u32 sa[0], 0
+        s_cbranch_scc0 loop
+        s_mov_b32 sa[2], sa[1]
+        s_endpgm
+)ffDXD",
+        {   // interference graphs
+            {   // for SGPRs
+                { },        // S4
+                { 2 },      // sa[0]'0
+                { 1 },      // sa[1]'0
+                { }         // sa[2]'0
+            },
+            { },
+            { },
+            { }
+        },
+        {   // graph colors
+            { 0, 0, 1, 0 },
+            { },
+            { },
+            { }
+        },
+        true, ""
+    }
+};
+
+static TestSingleVReg getTestSingleVReg(const AsmSingleVReg& vr,
+        const std::unordered_map<const AsmRegVar*, CString>& rvMap)
+{
+    if (vr.regVar == nullptr)
+        return { "", vr.index };
+    
+    auto it = rvMap.find(vr.regVar);
+    if (it == rvMap.end())
+        throw Exception("getTestSingleVReg: RegVar not found!!");
+    return { it->second, vr.index };
+}
+
+static void testInterGraphCase(cxuint i, const AsmInterGraphCase& testCase)
+{
+    std::istringstream input(testCase.input);
+    std::ostringstream errorStream;
+    
+    Assembler assembler("test.s", input,
+                    (ASM_ALL&~ASM_ALTMACRO) | ASM_TESTRUN | ASM_TESTRESOLVE,
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+    bool good = assembler.assemble();
+    if (assembler.getSections().size()<1)
+    {
+        std::ostringstream oss;
+        oss << "FAILED for " << " testAsmInterGraph#" << i;
+        throw Exception(oss.str());
+    }
+    const AsmSection& section = assembler.getSections()[0];
+    
+    AsmRegAllocator regAlloc(assembler);
+    
+    // call phases separately (without allocateRegisters)
+    regAlloc.createCodeStructure(section.codeFlow, section.getSize(),
+                            section.content.data());
+    regAlloc.createSSAData(*section.usageHandler, *section.linearDepHandler);
+    regAlloc.applySSAReplaces();
+    regAlloc.createLivenesses(*section.usageHandler, *section.linearDepHandler);
+    regAlloc.createInterferenceGraph();
+    regAlloc.colorInterferenceGraph();
+    
+    std::ostringstream oss;
+    oss << " testAsmInterGraph case#" << i;
+    const std::string testCaseName = oss.str();
+    
+    assertValue<bool>("testAsmInterGraph", testCaseName+".good",
+                      testCase.good, good);
+    assertString("testAsmInterGraph", testCaseName+".errorMessages",
+              testCase.errorMessages, errorStream.str());
+    
+    std::unordered_map<const AsmRegVar*, CString> regVarNamesMap;
+    for (const auto& rvEntry: assembler.getRegVarMap())
+        regVarNamesMap.insert(std::make_pair(&rvEntry.second, rvEntry.first));
+    
+    // generate node indices conversion table
+    const VarIndexMap* vregIndexMaps = regAlloc.getVregIndexMaps();
+    const InterGraph* resInterGraphs = regAlloc.getInterGraphs();
+    const Array<cxuint>* resGraphColorMaps = regAlloc.getGraphColorMaps();
+    for (size_t r = 0; r < MAX_REGTYPES_NUM; r++)
+    {
+        const VarIndexMap& vregIndexMap = vregIndexMaps[r];
+        Array<std::pair<TestSingleVReg, const std::vector<size_t>*> > outVregIdxMap(
+                    vregIndexMap.size());
+        
+        size_t j = 0;
+        for (const auto& entry: vregIndexMap)
+        {
+            TestSingleVReg vreg = getTestSingleVReg(entry.first, regVarNamesMap);
+            outVregIdxMap[j++] = std::make_pair(vreg, &entry.second);
+        }
+        mapSort(outVregIdxMap.begin(), outVregIdxMap.end());
+        
+        std::vector<size_t> nodeCvtTable;
+        std::vector<size_t> revNodeCvtTable;
+        for (const auto& entry: outVregIdxMap)
+            for (size_t v: *entry.second)
+                if (v != SIZE_MAX)
+                {
+                    size_t j = nodeCvtTable.size();
+                    nodeCvtTable.push_back(v);
+                    if (v+1 > revNodeCvtTable.size())
+                        revNodeCvtTable.resize(v+1);
+                    revNodeCvtTable[v] = j;
+                }
+        
+        std::ostringstream rOss;
+        rOss << ".regtype#" << r;
+        const std::string rtname(testCaseName + rOss.str());
+        
+        const InterGraph& resInterGraph = resInterGraphs[r];
+        const Array<cxuint>& resGcMap = resGraphColorMaps[r];
+        assertValue("testAsmInterGraph", rtname + ".igraph.size",
+                    testCase.interGraphs[r].size(), resInterGraph.size());
+        assertValue("testAsmInterGraph", rtname + ".gcMap.size",
+                    testCase.graphColorMaps[r].size(), resGcMap.size());
+        
+        for (size_t ni = 0; ni < resInterGraph.size(); ni++)
+        {
+            std::ostringstream nOss;
+            nOss << ".node#" << ni;
+            const std::string nname(rtname + nOss.str());
+            const size_t node = nodeCvtTable[ni];
+            
+            Array<size_t> resNeighbours(resInterGraph[node].size());
+            size_t k = 0;
+            for (size_t nb: resInterGraph[node])
+                resNeighbours[k++] = revNodeCvtTable[nb];
+            std::sort(resNeighbours.begin(), resNeighbours.end());
+            assertArray("testAsmInterGraph", nname + ".neighbours",
+                        testCase.interGraphs[r][ni], resNeighbours);
+            
+            assertValue("testAsmInterGraph", nname + ".color",
+                        testCase.graphColorMaps[r][ni], resGcMap[node]);
+            // neighbours must have other colors
+            for (size_t nb: resInterGraph[node])
+                assertTrue("testAsmInterGraph", nname + ".colorConflict",
+                        resGcMap[nb] != resGcMap[node]);
+        }
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (size_t i = 0; i < sizeof(interGraphTestCasesTbl)/sizeof(AsmInterGraphCase); i++)
+        try
+        { testInterGraphCase(i, interGraphTestCasesTbl[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
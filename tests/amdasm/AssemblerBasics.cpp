@@ -154,6 +154,68 @@ static void testAssembler(cxuint testSuiteId, cxuint testId, const AsmTestCase&
     assertString(testName, "printMessages", testCase.printMessages, printMsgs);
 }
 
+static void testAssemblerStats()
+{
+    static const char* statsSource = R"ffDXD(.macro mm a
+    .int \a+1
+.endm
+x = 5
+mm 3
+mm x
+y = x*2
+.int y
+)ffDXD";
+    for (bool enabled: { false, true })
+    {
+        std::istringstream input(statsSource);
+        std::ostringstream errorStream;
+        Assembler assembler("test.s", input,
+                    ((ASM_ALL&~ASM_ALTMACRO) | (enabled ? ASM_STATS : 0)),
+                    BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+        const std::string testName = enabled ? "testAsmStats" : "testAsmNoStats";
+        assertTrue(testName, "good", assembler.assemble());
+        const AsmStats& stats = assembler.getStats();
+        assertValue(testName, "linesRead", uint64_t(enabled ? 10 : 0), stats.linesRead);
+        assertValue(testName, "macroSubsts", uint64_t(enabled ? 2 : 0),
+                    stats.macroSubsts);
+        assertValue(testName, "exprsCreated", uint64_t(enabled ? 3 : 0),
+                    stats.exprsCreated);
+        assertValue(testName, "symbolsNum", uint64_t(enabled ? 3 : 0), stats.symbolsNum);
+        assertValue(testName, "peakSectionBytes", uint64_t(enabled ? 12 : 0),
+                    stats.peakSectionBytes);
+        if (!enabled)
+            for (cxuint i = 0; i <= ASMPHASE_MAX; i++)
+                assertValue(testName, std::string("phaseNanos.")+getAsmPhaseName(i),
+                            uint64_t(0), stats.phaseNanos[i]);
+    }
+}
+
+// penalty cycles must be counted only for aligned jump targets
+static void testAlignOptPenalty()
+{
+    static const char* alignOptSource = R"ffDXD(.text
+    .alignopt
+    s_branch a
+    s_cbranch_scc0 1f
+    .int 1,2,3
+    s_nop 0
+b:  .int 6
+a:  .int 7
+    .int 8,9,10,11,12
+1:  .int 13
+    s_branch b
+    .int 1,2
+c:  s_branch c
+)ffDXD";
+    std::istringstream input(alignOptSource);
+    std::ostringstream errorStream;
+    Assembler assembler("test.s", input, (ASM_ALL&~ASM_ALTMACRO),
+                BinaryFormat::RAWCODE, GPUDeviceType::CAPE_VERDE, errorStream);
+    assertTrue("testAlignOptPenalty", "good", assembler.assemble());
+    assertValue("testAlignOptPenalty", "penaltyCycles", uint64_t(20),
+                assembler.getAlignOptPenaltyCycles());
+}
+
 int main(int argc, const char** argv)
 {
     int retVal = 0;
@@ -173,5 +235,19 @@ int main(int argc, const char** argv)
             std::cerr << ex.what() << std::endl;
             retVal = 1;
         }
+    try
+    { testAssemblerStats(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
+    try
+    { testAlignOptPenalty(); }
+    catch(const std::exception& ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        retVal = 1;
+    }
     return retVal;
 }
@@ -0,0 +1,443 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/amdbin/AmdBinaries.h>
+#include <CLRX/amdbin/AmdBinGen.h>
+#include <CLRX/amdbin/AmdCL2Binaries.h>
+#include <CLRX/amdbin/AmdCL2BinGen.h>
+#include <CLRX/amdbin/GalliumBinaries.h>
+#include <CLRX/amdbin/ROCmBinaries.h>
+#include <CLRX/amdasm/Assembler.h>
+#include <CLRX/amdasm/AsmFormats.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+// reference to code in input
+struct CodeRef
+{
+    size_t* size;
+    const cxbyte** code;
+};
+
+struct BinTemplateTestCase
+{
+    const char* input;
+    BinaryFormat format;
+};
+
+static const BinTemplateTestCase binTemplateTestCasesTbl[] =
+{
+    {   /* 0 - AMD Catalyst */
+        R"ffDXD(            .amd; .gpu pitcairn
+            .kernel aaa
+            .config
+                .dims x
+            .text
+                s_mov_b32 s4, s1
+                v_mov_b32 v2, v0
+                s_endpgm
+            .kernel bbb
+            .config
+                .dims xy
+            .text
+                s_mov_b32 s7, s2
+                v_mov_b32 v3, v1
+                s_nop 2
+                s_endpgm
+)ffDXD", BinaryFormat::AMD
+    },
+    {   /* 1 - AMD OpenCL 2.0 (new binaries) */
+        R"ffDXD(            .amdcl2; .gpu bonaire
+            .driver_version 200406
+            .kernel aaa
+            .config
+                .dims x
+                .setupargs
+                .arg n, uint
+            .text
+                s_mov_b32 s4, s1
+                v_mov_b32 v2, v0
+                s_endpgm
+            .kernel bbb
+            .config
+                .dims xy
+                .setupargs
+            .text
+                s_mov_b32 s7, s2
+                s_nop 2
+                s_endpgm
+)ffDXD", BinaryFormat::AMDCL2
+    },
+    {   /* 2 - AMD OpenCL 2.0 (HSA layout) */
+        R"ffDXD(            .amdcl2; .gpu bonaire
+            .driver_version 240000
+            .hsalayout
+            .kernel aaa
+            .config
+                .dims x
+                .setupargs
+                .arg n, int
+            .kernel bbb
+            .config
+                .dims x
+                .setupargs
+            .text
+bbb:        .skip 256
+                s_mov_b32 s27, s1
+                v_mov_b32 v16, v1
+                s_endpgm
+            .p2align 8
+aaa:        .skip 256
+                s_mov_b32 s14, s1
+                s_endpgm
+)ffDXD", BinaryFormat::AMDCL2
+    },
+    {   /* 3 - AMD OpenCL 2.0 (old binaries, always full generation) */
+        R"ffDXD(            .amdcl2; .gpu bonaire
+            .driver_version 191203
+            .kernel aaa
+            .config
+                .dims x
+                .setupargs
+            .text
+                s_mov_b32 s4, s1
+                s_endpgm
+)ffDXD", BinaryFormat::AMDCL2
+    },
+    {   /* 4 - GalliumCompute */
+        R"ffDXD(            .gallium; .gpu pitcairn
+            .driver_version 160000
+            .llvm_version 30800
+            .kernel aaa
+            .config
+                .dims x
+            .kernel bbb
+            .config
+                .dims xy
+            .text
+aaa:            s_mov_b32 s4, s1
+                s_endpgm
+            .p2align 4
+bbb:            s_mov_b32 s7, s2
+                s_nop 2
+                s_endpgm
+)ffDXD", BinaryFormat::GALLIUM
+    },
+    {   /* 5 - ROCm */
+        R"ffDXD(            .rocm; .gpu fiji
+            .kernel aaa
+            .config
+                .dims x
+            .kernel bbb
+            .config
+                .dims xy
+            .text
+aaa:            .skip 256
+                s_mov_b32 s4, s1
+                s_endpgm
+            .p2align 8
+bbb:            .skip 256
+                s_mov_b32 s7, s2
+                s_endpgm
+)ffDXD", BinaryFormat::ROCM
+    },
+    {   /* 6 - ROCm (LLVM 10 binary format, metadata V3) */
+        R"ffDXD(            .rocm; .gpu gfx1010
+            .llvm10binfmt
+            .metadatav3
+            .kernel aaa
+            .config
+                .use_wave32
+            .kernel bbb
+            .config
+            .globaldata
+            .skip 128
+            .text
+            .p2align 8
+aaa:            v_cmp_gt_i32 vcc_lo, s1, v1
+                s_endpgm
+            .p2align 8
+bbb:            v_cmp_gt_i32 vcc, s5, v2
+                s_endpgm
+            .p2align 8
+            .skip 256   # reader requires 256 bytes after last kernel
+)ffDXD", BinaryFormat::ROCM
+    },
+    {   /* 7 - ROCm with GOT symbols */
+        R"ffDXD(            .rocm; .gpu fiji
+            .globaldata
+            .gotsym gdata2
+gdata1:     .global gdata1
+            .int 1,2,3,4
+gdata2:     .global gdata2
+            .int 11,21,13,14
+            .gotsym gdata1
+            .kernel aaa
+            .config
+                .dims x
+            .text
+aaa:            .skip 256
+                s_mov_b32 s4, s1
+                s_endpgm
+)ffDXD", BinaryFormat::ROCM
+    },
+    {   /* 8 - ROCm (metadata from kernel configs, always full generation) */
+        R"ffDXD(            .rocm; .gpu fiji
+            .newbinfmt
+            .kernel aaa
+            .config
+                .dims x
+            .text
+aaa:            .skip 256
+                s_mov_b32 s4, s1
+                s_endpgm
+)ffDXD", BinaryFormat::ROCM
+    }
+};
+
+// disassemble binary (used to compare binaries with different code capacities)
+static std::string disassembleBinary(BinaryFormat format, Array<cxbyte>& binary)
+{
+    std::ostringstream disasmOss;
+    const Flags disasmFlags = DISASM_DUMPCODE | DISASM_METADATA | DISASM_DUMPDATA |
+            DISASM_CALNOTES | DISASM_SETUP | DISASM_CONFIG;
+    if (format == BinaryFormat::AMD)
+    {
+        std::unique_ptr<AmdMainBinaryBase> base(createAmdBinaryFromCode(
+                binary.size(), binary.data(),
+                AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_KERNELINFOMAP |
+                AMDBIN_CREATE_INNERBINMAP | AMDBIN_CREATE_KERNELHEADERS |
+                AMDBIN_CREATE_KERNELHEADERMAP | AMDBIN_INNER_CREATE_CALNOTES |
+                AMDBIN_CREATE_INFOSTRINGS));
+        Disassembler disasm(*static_cast<AmdMainGPUBinary32*>(base.get()),
+                disasmOss, disasmFlags);
+        disasm.disassemble();
+    }
+    else if (format == BinaryFormat::AMDCL2)
+    {
+        std::unique_ptr<AmdCL2MainGPUBinaryBase> base(createAmdCL2BinaryFromCode(
+                binary.size(), binary.data(),
+                AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_KERNELINFOMAP |
+                AMDBIN_CREATE_INNERBINMAP | AMDBIN_CREATE_KERNELHEADERS |
+                AMDBIN_CREATE_KERNELHEADERMAP | AMDBIN_INNER_CREATE_CALNOTES |
+                AMDBIN_CREATE_INFOSTRINGS | AMDCL2BIN_INNER_CREATE_KERNELDATA |
+                AMDCL2BIN_INNER_CREATE_KERNELDATAMAP | AMDCL2BIN_INNER_CREATE_KERNELSTUBS));
+        if (base->getType() == AmdMainType::GPU_CL2_BINARY)
+        {
+            Disassembler disasm(*static_cast<AmdCL2MainGPUBinary32*>(base.get()),
+                    disasmOss, disasmFlags);
+            disasm.disassemble();
+        }
+        else
+        {
+            Disassembler disasm(*static_cast<AmdCL2MainGPUBinary64*>(base.get()),
+                    disasmOss, disasmFlags);
+            disasm.disassemble();
+        }
+    }
+    else if (format == BinaryFormat::GALLIUM)
+    {
+        GalliumBinary galliumBin(binary.size(), binary.data(), 0);
+        Disassembler disasm(GPUDeviceType::PITCAIRN, galliumBin, disasmOss, disasmFlags);
+        disasm.disassemble();
+    }
+    else
+    {
+        ROCmBinary rocmBin(binary.size(), binary.data(), ROCMBIN_CREATE_METADATAINFO);
+        Disassembler disasm(rocmBin, disasmOss, disasmFlags);
+        disasm.disassemble();
+    }
+    return disasmOss.str();
+}
+
+/* compare output of generator in template mode with output of full generation.
+ * template output can have code regions larger than code (capacity), hence
+ * binaries are compared by disassembly */
+template<typename BinGen, typename Input>
+static void checkTemplateGen(const std::string& testName, const std::string& caseName,
+            BinaryFormat format, BinaryTemplate& binTemplate, const Input& input,
+            Array<cxbyte>& output)
+{
+    BinGen fullGen(&input);
+    Array<cxbyte> expected;
+    fullGen.generate(expected);
+    
+    BinGen templateGen(&input);
+    templateGen.generate(output, binTemplate);
+    assertString(testName, caseName+".disasm",
+                disassembleBinary(format, expected).c_str(),
+                disassembleBinary(format, output));
+    // other outputs must be same as array output
+    std::vector<char> vOutput;
+    templateGen.generate(vOutput, binTemplate);
+    assertArray(testName, caseName+".vector", output,
+                Array<cxbyte>(vOutput.begin(), vOutput.end()));
+    std::ostringstream oss;
+    templateGen.generate(oss, binTemplate);
+    const std::string sOutput = oss.str();
+    assertArray(testName, caseName+".stream", output,
+                Array<cxbyte>(sOutput.begin(), sOutput.end()));
+    // generation without template is unchanged
+    Array<cxbyte> noTemplateOutput;
+    templateGen.generate(noTemplateOutput);
+    assertArray(testName, caseName+".noTemplate", expected, noTemplateOutput);
+}
+
+template<typename BinGen, typename Input, typename ChangeInput>
+static void testTemplateGen(const std::string& testName, BinaryFormat format,
+            Input& input, const std::vector<CodeRef>& codeRefs, bool useTemplate,
+            ChangeInput changeInput)
+{
+    assertTrue(testName, "codesNum", !codeRefs.empty());
+    // copy codes to modifiable buffers
+    std::vector<std::vector<cxbyte> > codes(codeRefs.size());
+    for (size_t i = 0; i < codeRefs.size(); i++)
+    {
+        codes[i].assign(*codeRefs[i].code, *codeRefs[i].code + *codeRefs[i].size);
+        *codeRefs[i].code = codes[i].data();
+    }
+    auto updateCode = [&codes, &codeRefs](size_t i)
+    {
+        *codeRefs[i].code = codes[i].data();
+        *codeRefs[i].size = codes[i].size();
+    };
+    
+    BinaryTemplate binTemplate;
+    Array<cxbyte> output;
+    checkTemplateGen<BinGen>(testName, "first", format, binTemplate, input, output);
+    assertTrue(testName, "first.prepared", binTemplate.isPrepared() == useTemplate);
+    const size_t templateSize = output.size();
+    
+    // change code content (this same sizes)
+    for (std::vector<cxbyte>& code: codes)
+        code.back() ^= 0x5a;
+    checkTemplateGen<BinGen>(testName, "changedCode", format, binTemplate, input, output);
+    
+    // change code size (code fits in capacity, binary layout is not changed)
+    const cxbyte nopCode[4] = { 0, 0, 0x80, 0xbf };
+    codes[0].insert(codes[0].end(), nopCode, nopCode+4);
+    updateCode(0);
+    checkTemplateGen<BinGen>(testName, "changedSize", format, binTemplate, input, output);
+    if (useTemplate)
+        assertValue(testName, "changedSize.size", templateSize, output.size());
+    codes[0].back() ^= 0x3c;
+    checkTemplateGen<BinGen>(testName, "changedSizeCode", format, binTemplate,
+                input, output);
+    // shrink code
+    codes[0].resize(codes[0].size()-4);
+    updateCode(0);
+    checkTemplateGen<BinGen>(testName, "shrinkedSize", format, binTemplate,
+                input, output);
+    if (useTemplate)
+        assertValue(testName, "shrinkedSize.size", templateSize, output.size());
+    
+    // code does not fit in capacity (binary must be regenerated)
+    for (cxuint k = 0; k < 256; k++)
+        codes[0].insert(codes[0].end()-4, nopCode, nopCode+4);
+    updateCode(0);
+    checkTemplateGen<BinGen>(testName, "overCapacity", format, binTemplate,
+                input, output);
+    
+    // change non-code input (binary must be regenerated)
+    changeInput(input);
+    checkTemplateGen<BinGen>(testName, "changedInput", format, binTemplate,
+                input, output);
+}
+
+static void testBinTemplate(cxuint testId, const BinTemplateTestCase& testCase)
+{
+    std::ostringstream testNameOss;
+    testNameOss << "BinTemplate#" << testId;
+    const std::string testName = testNameOss.str();
+    
+    std::istringstream input(testCase.input);
+    std::ostringstream errorStream;
+    Assembler assembler("test.s", input, ASM_ALL&~ASM_ALTMACRO,
+            BinaryFormat::AMD, GPUDeviceType::CAPE_VERDE, errorStream);
+    if (!assembler.assemble())
+        throw Exception("Assembler failed: " + errorStream.str());
+    assertValue(testName, "format", cxuint(testCase.format),
+                cxuint(assembler.getBinaryFormat()));
+    
+    std::vector<CodeRef> codeRefs;
+    if (testCase.format == BinaryFormat::AMD)
+    {
+        AmdInput amdInput = *static_cast<const AsmAmdHandler*>(
+                    assembler.getFormatHandler())->getOutput();
+        for (AmdKernelInput& kernel: amdInput.kernels)
+            codeRefs.push_back({ &kernel.codeSize, &kernel.code });
+        testTemplateGen<AmdGPUBinGenerator>(testName, testCase.format, amdInput,
+                codeRefs, true, [](AmdInput& input)
+                { input.kernels[0].config.dimMask = 7; });
+    }
+    else if (testCase.format == BinaryFormat::AMDCL2)
+    {
+        AmdCL2Input amdCL2Input = *static_cast<const AsmAmdCL2Handler*>(
+                    assembler.getFormatHandler())->getOutput();
+        if (amdCL2Input.code != nullptr && amdCL2Input.codeSize != 0)
+            // HSA layout
+            codeRefs.push_back({ &amdCL2Input.codeSize, &amdCL2Input.code });
+        for (AmdCL2KernelInput& kernel: amdCL2Input.kernels)
+            if (kernel.code != nullptr && kernel.codeSize != 0)
+                codeRefs.push_back({ &kernel.codeSize, &kernel.code });
+        // old binaries with kernel configs are always fully generated
+        const bool useTemplate = amdCL2Input.driverVersion >= 191205;
+        testTemplateGen<AmdCL2GPUBinGenerator>(testName, testCase.format, amdCL2Input,
+                codeRefs, useTemplate, [](AmdCL2Input& input)
+                { input.kernels[0].config.dimMask = 7; });
+    }
+    else if (testCase.format == BinaryFormat::GALLIUM)
+    {
+        GalliumInput galliumInput = *static_cast<const AsmGalliumHandler*>(
+                    assembler.getFormatHandler())->getOutput();
+        codeRefs.push_back({ &galliumInput.codeSize, &galliumInput.code });
+        testTemplateGen<GalliumBinGenerator>(testName, testCase.format, galliumInput,
+                codeRefs, true, [](GalliumInput& input)
+                { input.kernels[0].config.dimMask = 7; });
+    }
+    else if (testCase.format == BinaryFormat::ROCM)
+    {
+        ROCmInput rocmInput = *static_cast<const AsmROCmHandler*>(
+                    assembler.getFormatHandler())->getOutput();
+        codeRefs.push_back({ &rocmInput.codeSize, &rocmInput.code });
+        // metadata generated from kernel configs forces full generation
+        const bool useTemplate = !rocmInput.useMetadataInfo ||
+                rocmInput.metadataV3Format;
+        testTemplateGen<ROCmBinGenerator>(testName, testCase.format, rocmInput,
+                codeRefs, useTemplate, [](ROCmInput& input)
+                { input.archStepping ^= 1; });
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (cxuint i = 0; i < sizeof(binTemplateTestCasesTbl)/sizeof(BinTemplateTestCase); i++)
+        retVal |= callTest(testBinTemplate, i, binTemplateTestCasesTbl[i]);
+    return retVal;
+}
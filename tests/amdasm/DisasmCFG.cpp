@@ -0,0 +1,178 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdbin/GalliumBinaries.h>
+#include <CLRX/amdasm/Assembler.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+struct DisasmCFGCase
+{
+    const char* input;
+    BinaryFormat format;
+    GPUDeviceType deviceType;
+    const char* expectedJSON;   // CFG in JSON format
+};
+
+static const DisasmCFGCase disasmCFGTestCases[] =
+{
+    {   /* 0 - loop, jumps, swappc and setpc */
+        R"ffDXD(
+    s_mov_b32 s0, 1
+loop:
+    s_add_u32 s0, s0, 1
+    s_cmp_lt_u32 s0, 10
+    s_cbranch_scc1 loop
+    s_swappc_b64 s[2:3], s[4:5]
+    s_branch end
+    v_mov_b32 v0, 1
+end:
+    s_endpgm
+    s_nop 0
+    s_setpc_b64 s[0:1]
+)ffDXD", BinaryFormat::RAWCODE, GPUDeviceType::FIJI,
+        "{\"kernels\":[\n"
+        "{\"name\":\"\",\"code\":0,\"blocks\":[\n"
+        "{\"offset\":0,\"size\":4,\"instrs\":1,\"end\":\"fallthrough\"},\n"
+        "{\"offset\":4,\"size\":12,\"instrs\":3,\"end\":\"cjump\"},\n"
+        "{\"offset\":16,\"size\":4,\"instrs\":1,\"end\":\"swappc\"},\n"
+        "{\"offset\":20,\"size\":4,\"instrs\":1,\"end\":\"jump\"},\n"
+        "{\"offset\":24,\"size\":4,\"instrs\":1,\"end\":\"fallthrough\"},\n"
+        "{\"offset\":28,\"size\":4,\"instrs\":1,\"end\":\"end\"},\n"
+        "{\"offset\":32,\"size\":8,\"instrs\":2,\"end\":\"setpc\"}],\"edges\":[\n"
+        "{\"from\":0,\"to\":4,\"type\":\"next\"},\n"
+        "{\"from\":4,\"to\":4,\"type\":\"jump\"},\n"
+        "{\"from\":4,\"to\":16,\"type\":\"next\"},\n"
+        "{\"from\":16,\"to\":20,\"type\":\"next\"},\n"
+        "{\"from\":20,\"to\":28,\"type\":\"jump\"},\n"
+        "{\"from\":24,\"to\":28,\"type\":\"next\"}]}]}\n"
+    },
+    {   /* 1 - gallium kernels (split at kernel names) */
+        R"ffDXD(.kernel a
+.kernel b
+.text
+a:
+    s_mov_b32 s0, 0
+    s_cbranch_execz 1f
+    v_mov_b32 v0, 0
+1:  s_endpgm
+b:
+    s_getpc_b64 s[0:1]
+    s_swappc_b64 s[2:3], s[0:1]
+    s_branch a
+)ffDXD", BinaryFormat::GALLIUM, GPUDeviceType::PITCAIRN,
+        "{\"kernels\":[\n"
+        "{\"name\":\"a\",\"code\":0,\"blocks\":[\n"
+        "{\"offset\":0,\"size\":8,\"instrs\":2,\"end\":\"cjump\"},\n"
+        "{\"offset\":8,\"size\":4,\"instrs\":1,\"end\":\"fallthrough\"},\n"
+        "{\"offset\":12,\"size\":4,\"instrs\":1,\"end\":\"end\"}],\"edges\":[\n"
+        "{\"from\":0,\"to\":12,\"type\":\"jump\"},\n"
+        "{\"from\":0,\"to\":8,\"type\":\"next\"},\n"
+        "{\"from\":8,\"to\":12,\"type\":\"next\"}]},\n"
+        "{\"name\":\"b\",\"code\":0,\"blocks\":[\n"
+        "{\"offset\":16,\"size\":8,\"instrs\":2,\"end\":\"swappc\"},\n"
+        "{\"offset\":24,\"size\":4,\"instrs\":1,\"end\":\"jump\"}],\"edges\":[\n"
+        "{\"from\":16,\"to\":24,\"type\":\"next\"},\n"
+        "{\"from\":24,\"to\":0,\"type\":\"jump\"}]}]}\n"
+    },
+    {   /* 2 - GCN1.5 s_call and subvector loop */
+        R"ffDXD(
+    s_call_b64 s[4:5], sub
+    s_subvector_loop_begin s2, 2f
+    v_mov_b32 v0, 1
+2:  s_subvector_loop_end s2, 2b
+    s_endpgm
+sub:
+    s_add_u32 s0, s0, 0x1234
+    s_setpc_b64 s[4:5]
+)ffDXD", BinaryFormat::RAWCODE, GPUDeviceType::GFX1010,
+        "{\"kernels\":[\n"
+        "{\"name\":\"\",\"code\":0,\"blocks\":[\n"
+        "{\"offset\":0,\"size\":4,\"instrs\":1,\"end\":\"call\"},\n"
+        "{\"offset\":4,\"size\":4,\"instrs\":1,\"end\":\"cjump\"},\n"
+        "{\"offset\":8,\"size\":4,\"instrs\":1,\"end\":\"fallthrough\"},\n"
+        "{\"offset\":12,\"size\":4,\"instrs\":1,\"end\":\"cjump\"},\n"
+        "{\"offset\":16,\"size\":4,\"instrs\":1,\"end\":\"end\"},\n"
+        "{\"offset\":20,\"size\":12,\"instrs\":2,\"end\":\"setpc\"}],\"edges\":[\n"
+        "{\"from\":0,\"to\":20,\"type\":\"call\"},\n"
+        "{\"from\":0,\"to\":4,\"type\":\"next\"},\n"
+        "{\"from\":4,\"to\":12,\"type\":\"jump\"},\n"
+        "{\"from\":4,\"to\":8,\"type\":\"next\"},\n"
+        "{\"from\":8,\"to\":12,\"type\":\"next\"},\n"
+        "{\"from\":12,\"to\":12,\"type\":\"jump\"},\n"
+        "{\"from\":12,\"to\":16,\"type\":\"next\"}]}]}\n"
+    }
+};
+
+static void testDisasmCFG(cxuint i, const DisasmCFGCase& testCase)
+{
+    std::istringstream input(testCase.input);
+    std::ostringstream errorStream;
+    Assembler assembler("test.s", input, ASM_ALL&~ASM_ALTMACRO,
+                    testCase.format, testCase.deviceType, errorStream);
+    
+    std::ostringstream oss;
+    oss << " testDisasmCFGCase#" << i;
+    const std::string testCaseName = oss.str();
+    assertTrue("testDisasmCFG", testCaseName+".good", assembler.assemble());
+    
+    std::ostringstream disasmOss;
+    std::ostringstream cfgOss;
+    if (testCase.format == BinaryFormat::GALLIUM)
+    {
+        Array<cxbyte> binary;
+        assembler.writeBinary(binary);
+        GalliumBinary galliumBin(binary.size(), binary.data(), 0);
+        Disassembler disasm(testCase.deviceType, galliumBin, disasmOss,
+                    DISASM_DUMPCODE|DISASM_CFG);
+        disasm.disassemble();
+        writeDisasmCFG(cfgOss, disasm.getCFGs(), DisasmCFGFormat::JSON);
+    }
+    else
+    {
+        const AsmSection& section = assembler.getSections()[0];
+        Disassembler disasm(testCase.deviceType, section.content.size(),
+                    section.content.data(), disasmOss, DISASM_DUMPCODE|DISASM_CFG);
+        disasm.disassemble();
+        writeDisasmCFG(cfgOss, disasm.getCFGs(), DisasmCFGFormat::JSON);
+    }
+    assertString("testDisasmCFG", testCaseName+".cfg", testCase.expectedJSON,
+                 cfgOss.str());
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (cxuint i = 0; i < sizeof(disasmCFGTestCases)/sizeof(DisasmCFGCase); i++)
+        try
+        { testDisasmCFG(i, disasmCFGTestCases[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
@@ -21,7 +21,11 @@
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <cstdio>
 #include <cstring>
+#include <vector>
+#include <memory>
+#include <algorithm>
 #include <CLRX/amdbin/AmdBinaries.h>
 #include <CLRX/amdbin/AmdCL2Binaries.h>
 #include <CLRX/amdbin/GalliumBinaries.h>
@@ -246,6 +250,7 @@ struct DisasmAmdTestCase
     bool hsaConfig;
     cxuint llvmVersion;
     const char* exceptionString;
+    const char* kernelName; // disassemble only this kernel
 };
 
 // disasm testcases
@@ -2203,7 +2208,64 @@ sample_kernel2:
 /*bf9f0000         */ s_code_end
 /*bf9f0000         */ s_code_end
 /*bf9f0000         */ s_code_end
-)ffDXD", true, false }
+)ffDXD", true, false },
+    /* selected kernels */
+    { nullptr, nullptr, CLRX_SOURCE_DIR "/tests/amdasm/amdbins/rocm-fiji.hsaco",
+        R"ffDXD(.rocm
+.gpu Fiji
+.arch_minor 0
+.arch_stepping 3
+.kernel test2
+.text
+test2:
+/*c0020082 00000004*/ s_load_dword    s2, s[4:5], 0x4
+/*c0060003 00000000*/ s_load_dwordx2  s[0:1], s[6:7], 0x0
+/*bf8c007f         */ s_waitcnt       lgkmcnt(0)
+/*8602ff02 0000ffff*/ s_and_b32       s2, s2, 0xffff
+/*92020802         */ s_mul_i32       s2, s2, s8
+/*32000002         */ v_add_u32       v0, vcc, s2, v0
+/*2202009f         */ v_ashrrev_i32   v1, 31, v0
+/*d28f0001 00020082*/ v_lshlrev_b64   v[1:2], 2, v[0:1]
+/*32060200         */ v_add_u32       v3, vcc, s0, v1
+/*7e020201         */ v_mov_b32       v1, s1
+/*38080302         */ v_addc_u32      v4, vcc, v2, v1, vcc
+/*2600008f         */ v_and_b32       v0, 15, v0
+/*7e020280         */ v_mov_b32       v1, 0
+/*dc500000 02000003*/ flat_load_dword v2, v[3:4]
+/*d28f0000 00020082*/ v_lshlrev_b64   v[0:1], 2, v[0:1]
+/*be801c00         */ s_getpc_b64     s[0:1]
+/*8000ff00 00000074*/ s_add_u32       s0, s0, 0x74
+/*82018001         */ s_addc_u32      s1, s1, 0
+/*320a0000         */ v_add_u32       v5, vcc, s0, v0
+/*7e000201         */ v_mov_b32       v0, s1
+/*380c0101         */ v_addc_u32      v6, vcc, v1, v0, vcc
+/*dc500000 00000005*/ flat_load_dword v0, v[5:6]
+/*bf8c0070         */ s_waitcnt       vmcnt(0) & lgkmcnt(0)
+/*02000500         */ v_add_f32       v0, v0, v2
+/*dc700000 00000003*/ flat_store_dword v[3:4], v0
+/*bf810000         */ s_endpgm
+)ffDXD", false, false, 0, nullptr, "test2" },
+    { nullptr, nullptr, CLRX_SOURCE_DIR "/tests/amdasm/amdbins/amdcl2.clo",
+        R"ffDXD(.amdcl2
+.gpu Bonaire
+.64bit
+.arch_minor 0
+.arch_stepping 0
+.driver_version 191205
+.kernel aaa2
+    .text
+/*8709ac05         */ s_and_b32       s9, s5, 44
+/*bf810000         */ s_endpgm
+)ffDXD", false, false, 0, nullptr, "aaa2" },
+    { nullptr, nullptr, CLRX_SOURCE_DIR "/tests/amdasm/amdbins/amd1.clo",
+        R"ffDXD(.amd
+.gpu Bonaire
+.32bit
+.kernel xT1
+    .text
+/*bf810000         */ s_endpgm
+/*4a040501         */ v_add_i32       v2, vcc, v1, v2
+)ffDXD", false, false, 0, nullptr, "xT1" }
 };
 
 static void testDisasmData(cxuint testId, const DisasmAmdTestCase& testCase)
@@ -2216,6 +2278,14 @@ static void testDisasmData(cxuint testId, const DisasmAmdTestCase& testCase)
     if (testCase.hsaConfig)
         disasmFlags |= DISASM_HSACONFIG;
     
+    std::vector<CString> kernelNames;
+    if (testCase.kernelName != nullptr)
+    {
+        kernelNames.push_back(testCase.kernelName);
+        // selected kernel: check only code
+        disasmFlags = DISASM_DUMPCODE | DISASM_HEXCODE;
+    }
+    
     bool haveException = false;
     std::string resExceptionStr;
     try
@@ -2242,15 +2312,16 @@ static void testDisasmData(cxuint testId, const DisasmAmdTestCase& testCase)
         Array<cxbyte> binaryData = loadDataFromFile(testCase.filename);
         if (isAmdBinary(binaryData.size(), binaryData.data()))
         {
-            // if AMD OpenCL binary
+            // if AMD OpenCL binary (lazy if kernels selected, like clrxdisasm)
             std::unique_ptr<AmdMainBinaryBase> base(createAmdBinaryFromCode(
                     binaryData.size(), binaryData.data(),
                     AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_KERNELINFOMAP |
                     AMDBIN_CREATE_INNERBINMAP | AMDBIN_CREATE_KERNELHEADERS |
                     AMDBIN_CREATE_KERNELHEADERMAP | AMDBIN_INNER_CREATE_CALNOTES |
-                    AMDBIN_CREATE_INFOSTRINGS));
+                    AMDBIN_CREATE_INFOSTRINGS |
+                    (kernelNames.empty() ? 0 : AMDBIN_CREATE_LAZY)));
             AmdMainGPUBinary32* amdGpuBin = static_cast<AmdMainGPUBinary32*>(base.get());
-            Disassembler disasm(*amdGpuBin, disasmOss, disasmFlags);
+            Disassembler disasm(*amdGpuBin, disasmOss, disasmFlags, kernelNames);
             disasm.disassemble();
             resultStr = disasmOss.str();
         }
@@ -2263,7 +2334,7 @@ static void testDisasmData(cxuint testId, const DisasmAmdTestCase& testCase)
                 AMDBIN_CREATE_KERNELHEADERMAP | AMDBIN_INNER_CREATE_CALNOTES |
                 AMDBIN_CREATE_INFOSTRINGS | AMDCL2BIN_INNER_CREATE_KERNELDATA |
                 AMDCL2BIN_INNER_CREATE_KERNELDATAMAP | AMDCL2BIN_INNER_CREATE_KERNELSTUBS);
-            Disassembler disasm(amdBin, disasmOss, disasmFlags);
+            Disassembler disasm(amdBin, disasmOss, disasmFlags, 0, kernelNames);
             disasm.disassemble();
             resultStr = disasmOss.str();
         }
@@ -2271,7 +2342,7 @@ static void testDisasmData(cxuint testId, const DisasmAmdTestCase& testCase)
         {
             // if ROCm (HSACO) binary
             ROCmBinary rocmBin(binaryData.size(), binaryData.data(), 0);
-            Disassembler disasm(rocmBin, disasmOss, disasmFlags);
+            Disassembler disasm(rocmBin, disasmOss, disasmFlags, kernelNames);
             disasm.disassemble();
             resultStr = disasmOss.str();
         }
@@ -2320,6 +2391,303 @@ static void testDisasmData(cxuint testId, const DisasmAmdTestCase& testCase)
     }
 }
 
+// CAL notes of selected kernel from lazy binary must be same as from full binary
+static void testAmdSelectedKernelCALNotes()
+{
+    const char* testName = "AmdSelectedKernelCALNotes";
+    Array<cxbyte> binaryData = loadDataFromFile(
+                CLRX_SOURCE_DIR "/tests/amdasm/amdbins/samplekernels.clo");
+    const Flags binFlags = AMDBIN_CREATE_KERNELINFO | AMDBIN_CREATE_KERNELINFOMAP |
+            AMDBIN_CREATE_INNERBINMAP | AMDBIN_CREATE_KERNELHEADERS |
+            AMDBIN_CREATE_KERNELHEADERMAP | AMDBIN_INNER_CREATE_CALNOTES;
+    AmdMainGPUBinary32 fullBin(binaryData.size(), binaryData.data(), binFlags);
+    AmdMainGPUBinary32 lazyBin(binaryData.size(), binaryData.data(),
+                binFlags | AMDBIN_CREATE_LAZY);
+    
+    const std::vector<CString> kernelNames = { "multiply" };
+    std::unique_ptr<AmdDisasmInput> fullInput(getAmdDisasmInputFromBinary32(
+                fullBin, DISASM_CALNOTES));
+    std::unique_ptr<AmdDisasmInput> lazyInput(getAmdDisasmInputFromBinary32(
+                lazyBin, DISASM_CALNOTES, kernelNames));
+    assertValue(testName, "kernelsNum", size_t(1), lazyInput->kernels.size());
+    const AmdDisasmKernelInput& lazyKernel = lazyInput->kernels[0];
+    assertString(testName, "kernelName", "multiply", lazyKernel.kernelName);
+    
+    auto fullKernelIt = std::find_if(fullInput->kernels.begin(), fullInput->kernels.end(),
+            [](const AmdDisasmKernelInput& kernel)
+            { return kernel.kernelName == "multiply"; });
+    assertTrue(testName, "fullKernelFound", fullKernelIt != fullInput->kernels.end());
+    assertTrue(testName, "calNotesNotEmpty", !fullKernelIt->calNotes.empty());
+    assertValue(testName, "calNotesNum", fullKernelIt->calNotes.size(),
+                lazyKernel.calNotes.size());
+    for (size_t i = 0; i < lazyKernel.calNotes.size(); i++)
+    {
+        const CALNoteInput& expNote = fullKernelIt->calNotes[i];
+        const CALNoteInput& resNote = lazyKernel.calNotes[i];
+        std::ostringstream caseOss;
+        caseOss << "calNote#" << i << ".";
+        const std::string caseName = caseOss.str();
+        assertValue(testName, caseName+"type", expNote.header.type, resNote.header.type);
+        assertValue(testName, caseName+"descSize", expNote.header.descSize,
+                    resNote.header.descSize);
+        assertTrue(testName, caseName+"data", expNote.data == resNote.data);
+    }
+    assertValue(testName, "codeSize", fullKernelIt->codeSize, lazyKernel.codeSize);
+    assertTrue(testName, "code", fullKernelIt->code == lazyKernel.code);
+}
+
+/* reference data printers (scalar, line by line),
+ * output of the disassembler must be byte-identical */
+static std::string refDisasmData(size_t size, const cxbyte* data, bool secondAlign)
+{
+    std::ostringstream oss;
+    const char* indent = secondAlign ? "        " : "    ";
+    char buf[32];
+    for (size_t p = 0; p < size;)
+    {
+        size_t fillEnd;
+        for (fillEnd = p+1; fillEnd < size && data[fillEnd]==data[p]; fillEnd++);
+        if (fillEnd >= p+8)
+        {
+            // repeated bytes in at least one line
+            const size_t oldP = p;
+            p = (fillEnd != size) ? fillEnd&~size_t(7) : fillEnd;
+            ::snprintf(buf, 32, "0x%02x", data[oldP]);
+            oss << indent << ".fill " << (p-oldP) << ", 1, " << buf << "\n";
+            continue;
+        }
+        const size_t lineEnd = std::min(p+8, size);
+        oss << indent << ".byte ";
+        for (; p < lineEnd; p++)
+        {
+            ::snprintf(buf, 32, "0x%02x", data[p]);
+            oss << buf << ((p+1 < lineEnd) ? ", " : "");
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+static std::string refDisasmDataU32(size_t size, const cxbyte* data, bool secondAlign)
+{
+    std::ostringstream oss;
+    const char* indent = secondAlign ? "        " : "    ";
+    char buf[32];
+    // read dwords in little endian
+    std::vector<uint32_t> words(size);
+    for (size_t i = 0; i < size; i++)
+        words[i] = uint32_t(data[i*4]) | (uint32_t(data[i*4+1])<<8) |
+                (uint32_t(data[i*4+2])<<16) | (uint32_t(data[i*4+3])<<24);
+    for (size_t p = 0; p < size;)
+    {
+        size_t fillEnd;
+        for (fillEnd = p+1; fillEnd < size && words[fillEnd]==words[p]; fillEnd++);
+        if (fillEnd >= p+4)
+        {
+            // repeated dwords in at least one line
+            const size_t oldP = p;
+            p = (fillEnd != size) ? fillEnd&~size_t(3) : fillEnd;
+            ::snprintf(buf, 32, "0x%08x", words[oldP]);
+            oss << indent << ".fill " << (p-oldP) << ", 4, " << buf << "\n";
+            continue;
+        }
+        const size_t lineEnd = std::min(p+4, size);
+        oss << indent << ".int ";
+        for (; p < lineEnd; p++)
+        {
+            ::snprintf(buf, 32, "0x%08x", words[p]);
+            oss << buf << ((p+1 < lineEnd) ? ", " : "");
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
+
+static std::string refDisasmLongString(size_t size, const char* data, bool secondAlign)
+{
+    std::ostringstream oss;
+    const char* indent = secondAlign ? "        " : "    ";
+    char buf[96];
+    for (size_t pos = 0; pos < size; )
+    {
+        const size_t end = std::min(pos+72, size);
+        const size_t oldPos = pos;
+        // go to end of data, or newline
+        while (pos < end && data[pos] != '\n') pos++;
+        if (pos < end && data[pos] == '\n') pos++; // embrace newline
+        size_t escapeSize;
+        pos = oldPos + escapeStringCStyle(pos-oldPos, data+oldPos, 76, buf, escapeSize);
+        oss << indent << ".ascii \"" << std::string(buf, escapeSize) << "\"\n";
+    }
+    return oss.str();
+}
+
+// fill test data: 0 - random bytes, 1 - runs of bytes, 2 - runs of dwords, 3 - text
+static void fillDumpTestData(size_t size, cxbyte* data, cxuint pattern, uint32_t seed)
+{
+    uint32_t rnd = seed*2654435761U + 1;
+    for (size_t i = 0; i < size; )
+    {
+        rnd = rnd*1103515245U + 12345U;
+        const cxbyte value = rnd>>16;
+        if (pattern == 0)
+            data[i++] = value;
+        else if (pattern == 1)
+        {
+            // runs of 1-20 bytes
+            for (size_t end = std::min(i + ((rnd>>8)%20) + 1, size); i < end; i++)
+                data[i] = value;
+        }
+        else if (pattern == 2)
+        {
+            // runs of 1-10 dwords with this same value
+            const size_t runSize = (((rnd>>8)%10) + 1)*4;
+            for (size_t end = std::min(i + runSize, size); i < end; i++)
+                data[i] = cxbyte(value + (i&3));
+        }
+        else
+        {
+            // text with newlines, tabs and quotes
+            static const char* textChars = "abcdefgh IJKL0123\n\t\"\\\x01\xc8";
+            data[i++] = textChars[(rnd>>8) % ::strlen(textChars)];
+        }
+    }
+}
+
+static const size_t dataDumpTestSizes[] =
+{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+  21, 23, 24, 25, 28, 31, 32, 33, 35, 39, 40, 47, 48, 49, 63, 64, 65, 71, 72, 73,
+  79, 80, 81, 127, 128, 129, 143, 144, 145, 255, 256, 257, 1000, 4095, 4096,
+  4097, 10003 };
+
+static const size_t dataDumpTestOffsets[] = { 0, 1, 2, 3, 5, 7, 13, 15, 16 };
+
+// Disassembler::printDataBlock (without data file) for various sizes and alignments
+static void testDisasmDataDump()
+{
+    std::vector<cxbyte> buffer(10003 + 32);
+    for (cxuint pattern = 0; pattern < 3; pattern++)
+        for (size_t size: dataDumpTestSizes)
+            for (size_t offset: dataDumpTestOffsets)
+            {
+                cxbyte* data = buffer.data() + offset;
+                fillDumpTestData(size, data, pattern, size+offset);
+                std::ostringstream oss;
+                AmdDisasmInput input{ GPUDeviceType::PITCAIRN, false };
+                Disassembler disasm(&input, oss, DISASM_DUMPDATA);
+                disasm.printDataBlock(size, data);
+                
+                std::ostringstream caseOss;
+                caseOss << "pattern=" << pattern << ",size=" << size <<
+                        ",offset=" << offset;
+                assertString("DisasmDataDump", caseOss.str(),
+                        refDisasmData(size, data, false).c_str(), oss.str());
+            }
+}
+
+// kernel data (header, metadata, data and CAL notes) with double indentation
+static void testDisasmKernelDataDump()
+{
+    std::vector<cxbyte> buffer(10003 + 32);
+    std::vector<cxbyte> buffer2(10003 + 32);
+    for (cxuint pattern = 0; pattern < 3; pattern++)
+        for (size_t size: dataDumpTestSizes)
+            for (size_t offset: { 0, 1, 2, 3, 16 })
+            {
+                cxbyte* data = buffer.data() + offset;
+                char* text = reinterpret_cast<char*>(buffer2.data() + offset);
+                fillDumpTestData(size, data, pattern, size+offset);
+                fillDumpTestData(size, reinterpret_cast<cxbyte*>(text), 3, size);
+                
+                AmdDisasmInput input{ GPUDeviceType::PITCAIRN, false };
+                CALNoteInput calNote{ { 8, uint32_t(size), CALNOTE_ATI_INPUTS,
+                        "ATI CAL" }, data };
+                input.kernels.push_back({ "aaa", size, text, size, data,
+                        { calNote }, size, data, 0, nullptr });
+                std::ostringstream oss;
+                Disassembler disasm(&input, oss,
+                        DISASM_DUMPDATA | DISASM_METADATA | DISASM_CALNOTES);
+                disasm.disassemble();
+                
+                std::string expected = ".amd\n.gpu Pitcairn\n.32bit\n"
+                        ".compile_options \"\"\n.driver_info \"\"\n.kernel aaa\n";
+                if (size != 0)
+                {
+                    expected += "    .header\n" + refDisasmData(size, data, true);
+                    expected += "    .metadata\n" + refDisasmLongString(size, text, true);
+                    expected += "    .data\n" + refDisasmData(size, data, true);
+                    expected += "    .inputs\n" +
+                            refDisasmDataU32(size>>2, data, true) +
+                            refDisasmData(size&3, data + (size&~size_t(3)), true);
+                }
+                else
+                    expected += "    .inputs\n";
+                
+                std::ostringstream caseOss;
+                caseOss << "pattern=" << pattern << ",size=" << size <<
+                        ",offset=" << offset;
+                assertString("DisasmKernelDataDump", caseOss.str(), expected.c_str(),
+                        oss.str());
+            }
+}
+
+// data file mode: big data blocks are written to data file and included by '.incbin'
+static void testDisasmDataFile()
+{
+    const char* dataFileName = "DisasmDataTest.bin";
+    std::vector<cxbyte> globalData(300);
+    std::vector<cxbyte> rwData(517);
+    fillDumpTestData(globalData.size(), globalData.data(), 0, 1);
+    fillDumpTestData(rwData.size(), rwData.data(), 1, 2);
+    AmdCL2DisasmInput input{ GPUDeviceType::BONAIRE, 0, 0, false, 200406 };
+    input.globalDataSize = globalData.size();
+    input.globalData = globalData.data();
+    input.rwDataSize = rwData.size();
+    input.rwData = rwData.data();
+    
+    const std::string outputHeader = ".amdcl2\n.gpu Bonaire\n.32bit\n"
+            ".arch_minor 0\n.arch_stepping 0\n"
+            ".driver_version 200406\n";
+    for (size_t minSize: { 256, 400, 1000 })
+    {
+        std::ostringstream caseOss;
+        caseOss << "minSize=" << minSize;
+        const std::string caseName = caseOss.str();
+        std::ostringstream oss;
+        {
+            Disassembler disasm(&input, oss, DISASM_DUMPDATA);
+            disasm.setDataFile(dataFileName, minSize);
+            disasm.disassemble();
+        }
+        std::string expected = outputHeader + ".globaldata\n.gdata:\n";
+        std::vector<cxbyte> expectedFile;
+        if (globalData.size() >= minSize)
+        {
+            expected += "    .incbin \"DisasmDataTest.bin\", 0, 300\n";
+            expectedFile.insert(expectedFile.end(), globalData.begin(), globalData.end());
+        }
+        else
+            expected += refDisasmData(globalData.size(), globalData.data(), false);
+        expected += ".data\n.ddata:\n";
+        if (rwData.size() >= minSize)
+        {
+            std::ostringstream incOss;
+            incOss << "    .incbin \"DisasmDataTest.bin\", " << expectedFile.size() <<
+                    ", 517\n";
+            expected += incOss.str();
+            expectedFile.insert(expectedFile.end(), rwData.begin(), rwData.end());
+        }
+        else
+            expected += refDisasmData(rwData.size(), rwData.data(), false);
+        assertString("DisasmDataFile", caseName+".output", expected.c_str(), oss.str());
+        
+        const Array<cxbyte> fileContent = loadDataFromFile(dataFileName);
+        assertArray("DisasmDataFile", caseName+".fileContent",
+                Array<cxbyte>(expectedFile.begin(), expectedFile.end()), fileContent);
+    }
+    std::remove(dataFileName);
+}
+
 int main(int argc, const char** argv)
 {
     int retVal = 0;
@@ -2331,5 +2699,9 @@ int main(int argc, const char** argv)
             std::cerr << ex.what() << std::endl;
             retVal = 1;
         }
+    retVal |= callTest(testAmdSelectedKernelCALNotes);
+    retVal |= callTest(testDisasmDataDump);
+    retVal |= callTest(testDisasmKernelDataDump);
+    retVal |= callTest(testDisasmDataFile);
     return retVal;
 }
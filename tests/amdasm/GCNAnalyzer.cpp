@@ -0,0 +1,219 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdasm/Assembler.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include <CLRX/amdasm/GCNAnalyzer.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+struct GCNBlockTimingCase
+{
+    size_t offset;
+    size_t instrsNum;
+    uint64_t cycles;
+    cxuint alignPenalties;
+};
+
+struct GCNAnalyzerCase
+{
+    const char* input;
+    GPUDeviceType deviceType;
+    cxuint dpFactor;
+    Array<GCNBlockTimingCase> blocks;
+};
+
+static const GCNAnalyzerCase gcnAnalyzerTestCases[] =
+{
+    {   /* 0 - GCN 1.0 (DP, GLC, alignment penalties) */
+        R"ffDXD(
+    s_mov_b32 s0, 0
+    v_mov_b32 v3, 1.5e10
+    v_rcp_f64 v[0:1], v[0:1]
+    s_cbranch_execz 1f
+    v_mov_b32 v0, 0
+    buffer_atomic_add v1, v2, s[4:7], 0 offen glc
+    v_mul_lo_u32 v1, v2, v3
+    v_mov_b32 v4, 1.5e10
+1:  s_endpgm
+)ffDXD", GPUDeviceType::PITCAIRN, 0,
+        { { 0, 4, 76, 1 }, { 20, 4, 41, 1 }, { 48, 1, 4, 0 } }
+    },
+    {   /* 1 - GCN 1.2 (no alignment penalties), DPFACTOR=2 */
+        R"ffDXD(
+    s_mov_b32 s0, 0
+    v_mov_b32 v3, 1.5e10
+    v_rcp_f64 v[0:1], v[0:1]
+    v_cmp_lt_f64 vcc, v[0:1], v[2:3]
+    s_and_saveexec_b64 s[2:3], vcc
+    s_cbranch_execz 1f
+    v_mov_b32 v0, 0
+    s_branch 1f
+    v_mov_b32 v0, 0
+1:  s_endpgm
+)ffDXD", GPUDeviceType::FIJI, 2,
+        { { 0, 6, 44, 0 }, { 28, 2, 24, 0 }, { 36, 1, 4, 0 }, { 40, 1, 4, 0 } }
+    }
+};
+
+static void testGCNAnalyzer(cxuint i, const GCNAnalyzerCase& testCase)
+{
+    std::istringstream input(testCase.input);
+    std::ostringstream errorStream;
+    Assembler assembler("test.s", input, ASM_ALL&~ASM_ALTMACRO,
+                    BinaryFormat::RAWCODE, testCase.deviceType, errorStream);
+    
+    std::ostringstream oss;
+    oss << " testGCNAnalyzerCase#" << i;
+    const std::string testCaseName = oss.str();
+    assertTrue("testGCNAnalyzer", testCaseName+".good", assembler.assemble());
+    
+    const AsmSection& section = assembler.getSections()[0];
+    std::ostringstream disasmOss;
+    Disassembler disasm(testCase.deviceType, section.content.size(),
+                section.content.data(), disasmOss, DISASM_DUMPCODE|DISASM_CFG);
+    disasm.disassemble();
+    assertValue("testGCNAnalyzer", testCaseName+".cfgsNum", size_t(1),
+                disasm.getCFGs().size());
+    
+    GCNCodeAnalyzer analyzer(testCase.deviceType, testCase.dpFactor);
+    const GCNKernelTiming timing = analyzer.analyzeKernel(disasm.getCFGs()[0]);
+    assertValue("testGCNAnalyzer", testCaseName+".blocksNum", testCase.blocks.size(),
+                timing.blocks.size());
+    for (size_t j = 0; j < timing.blocks.size(); j++)
+    {
+        const GCNBlockTimingCase& expBlock = testCase.blocks[j];
+        const GCNBlockTiming& resBlock = timing.blocks[j];
+        std::ostringstream bOss;
+        bOss << ".block#" << j << ".";
+        const std::string blockName = testCaseName + bOss.str();
+        assertValue("testGCNAnalyzer", blockName+"offset", expBlock.offset,
+                    resBlock.offset);
+        assertValue("testGCNAnalyzer", blockName+"instrsNum", expBlock.instrsNum,
+                    resBlock.instrsNum);
+        assertValue("testGCNAnalyzer", blockName+"cycles", expBlock.cycles,
+                    resBlock.cycles);
+        assertValue("testGCNAnalyzer", blockName+"alignPenalties",
+                    expBlock.alignPenalties, resBlock.alignPenalties);
+    }
+}
+
+struct GCNOccupancyCase
+{
+    GPUDeviceType deviceType;
+    cxuint sgprsNum;
+    cxuint vgprsNum;
+    size_t localSize;
+    cxuint groupWaves;
+    cxuint waves;
+};
+
+// from occupancy table in GcnTimings
+static const GCNOccupancyCase gcnOccupancyTestCases[] =
+{
+    { GPUDeviceType::PITCAIRN, 16, 24, 0, 1, 10 },
+    { GPUDeviceType::PITCAIRN, 16, 28, 0, 1, 9 },
+    { GPUDeviceType::PITCAIRN, 16, 36, 0, 1, 7 },
+    { GPUDeviceType::PITCAIRN, 16, 84, 0, 1, 3 },
+    { GPUDeviceType::PITCAIRN, 16, 256, 0, 1, 1 },
+    { GPUDeviceType::PITCAIRN, 56, 4, 0, 1, 9 },
+    { GPUDeviceType::PITCAIRN, 80, 4, 0, 1, 6 },
+    { GPUDeviceType::PITCAIRN, 96, 4, 0, 1, 5 },
+    { GPUDeviceType::PITCAIRN, 104, 4, 0, 1, 4 },
+    { GPUDeviceType::PITCAIRN, 16, 4, 16384, 1, 1 },
+    { GPUDeviceType::PITCAIRN, 16, 4, 16384, 4, 4 },
+    { GPUDeviceType::PITCAIRN, 16, 4, 32768, 1, 1 },
+    { GPUDeviceType::PITCAIRN, 16, 4, 65536, 1, 1 },
+    { GPUDeviceType::PITCAIRN, 16, 4, 20000, 2, 2 },
+    { GPUDeviceType::PITCAIRN, 16, 4, 40000, 3, 1 },
+    { GPUDeviceType::FIJI, 80, 4, 0, 1, 10 },
+    { GPUDeviceType::FIJI, 96, 4, 0, 1, 8 }
+};
+
+struct GCNOccupancyErrorCase
+{
+    cxuint vgprsNum;
+    size_t localSize;
+    const char* errorMessage;
+};
+
+// kernels which does not fit in SIMD or compute unit
+static const GCNOccupancyErrorCase gcnOccupancyErrorTestCases[] =
+{
+    { 257, 0, "VGPRs number out of range (max 256)" },
+    { 4, 65537, "Local size out of range (max 65536)" },
+    { 300, 100000, "VGPRs number out of range (max 256)" }
+};
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (cxuint i = 0; i < sizeof(gcnAnalyzerTestCases)/sizeof(GCNAnalyzerCase); i++)
+        try
+        { testGCNAnalyzer(i, gcnAnalyzerTestCases[i]); }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    for (cxuint i = 0; i < sizeof(gcnOccupancyTestCases)/sizeof(GCNOccupancyCase); i++)
+        try
+        {
+            const GCNOccupancyCase& testCase = gcnOccupancyTestCases[i];
+            GCNCodeAnalyzer analyzer(testCase.deviceType);
+            std::ostringstream oss;
+            oss << "occupancy#" << i;
+            assertValue("testGCNOccupancy", oss.str(), testCase.waves,
+                    analyzer.getOccupancy(testCase.sgprsNum, testCase.vgprsNum,
+                        testCase.localSize, testCase.groupWaves));
+        }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    for (cxuint i = 0; i < sizeof(gcnOccupancyErrorTestCases)/
+                sizeof(GCNOccupancyErrorCase); i++)
+        try
+        {
+            const GCNOccupancyErrorCase& testCase = gcnOccupancyErrorTestCases[i];
+            GCNCodeAnalyzer analyzer(GPUDeviceType::PITCAIRN);
+            std::ostringstream oss;
+            oss << "occupancyError#" << i;
+            std::string errorMessage;
+            try
+            { analyzer.getOccupancy(16, testCase.vgprsNum, testCase.localSize); }
+            catch(const DisasmException& ex)
+            { errorMessage = ex.what(); }
+            assertString("testGCNOccupancy", oss.str(), testCase.errorMessage,
+                    errorMessage);
+        }
+        catch(const std::exception& ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            retVal = 1;
+        }
+    return retVal;
+}
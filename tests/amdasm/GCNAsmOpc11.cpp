@@ -535,6 +535,7 @@ const GCNAsmOpcodeCase encGCNOpcodeCases[] =
     { "    s_sendmsg  sendmsg(MSG_SYSTEM)", 0xbf90000fU, 0, false, true, "" },
     { "    s_sendmsg  sendmsg(MSG_SYSMSG)", 0xbf90000fU, 0, false, true, "" },
     { "    s_sendmsg  sendmsg(gs, nop)", 0xbf900002U, 0, false, true, "" },
+    { "    s_sendmsg  sendmsg(gs, nop, 3)", 0xbf900302U, 0, false, true, "" },
     { "    s_sendmsg  sendmsg(MSG_GS, GS_OP_NOP)", 0xbf900002U, 0, false, true, "" },
     { "    s_sendmsg  sendmsg(gs, cut, 0)", 0xbf900012U, 0, false, true, "" },
     { "    s_sendmsg  sendmsg(MSG_GS, GS_OP_CUT, 0)", 0xbf900012U, 0, false, true, "" },
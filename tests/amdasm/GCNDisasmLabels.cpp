@@ -468,6 +468,51 @@ static void testDecGCNRelocations()
         throw Exception("FAILED relocationTest: result: "+disOss.str());
 }
 
+static const uint32_t labelRelocCode[] =
+{
+    LEV(0x0934d6ffU), LEV(0x11110000U),
+    LEV(0x0934d6ffU), LEV(0x11110000U),
+    LEV(0x8015ff04U), LEV(0x11110000U),
+    LEV(0x90153d04U)
+};
+
+// testing disassemblying code with named labels and relocations at same places
+static void testDecGCNLabelsAndRelocations()
+{
+    std::ostringstream disOss;
+    AmdDisasmInput input;
+    input.deviceType = GPUDeviceType::PITCAIRN;
+    input.is64BitMode = false;
+    Disassembler disasm(&input, disOss, DISASM_FLOATLITS);
+    
+    GCNDisassembler gcnDisasm(disasm);
+    gcnDisasm.setInput(sizeof(labelRelocCode),
+                   reinterpret_cast<const cxbyte*>(labelRelocCode));
+    gcnDisasm.addRelocation(20, RELTYPE_HIGH_32BIT, 2, 0);
+    gcnDisasm.addRelocation(4, RELTYPE_LOW_32BIT, 0, 0);
+    gcnDisasm.addRelocation(12, RELTYPE_LOW_32BIT, 1, 122);
+    for (const char* symName: relocSymbolNames)
+        gcnDisasm.addRelSymbol(symName);
+    gcnDisasm.addNamedLabel(20, "thirdLit");
+    gcnDisasm.addNamedLabel(4, "firstLit");
+    gcnDisasm.addNamedLabel(8, "second");
+    gcnDisasm.addNamedLabel(12, "secondLit");
+    
+    gcnDisasm.beforeDisassemble();
+    gcnDisasm.disassemble();
+    // compare output with this expected string
+    if (disOss.str() !=
+        "        v_sub_f32       v154, aaa0&0xffffffff, v107\n"
+        "firstLit=.-4\n"
+        "second:\n"
+        "        v_sub_f32       v154, (aaa1+122)&0xffffffff, v107\n"
+        "secondLit=.-4\n"
+        "        s_add_u32       s21, s4, aaa2>>32\n"
+        "thirdLit=.-4\n"
+        "        s_lshr_b32      s21, s4, s61\n")
+        throw Exception("FAILED labelsAndRelocationsTest: result: "+disOss.str());
+}
+
 int main(int argc, const char** argv)
 {
     int retVal = 0;
@@ -500,6 +545,7 @@ int main(int argc, const char** argv)
     {
         testDecGCNNamedLabels();
         testDecGCNRelocations();
+        testDecGCNLabelsAndRelocations();
     }
     catch(const std::exception& ex)
     {
@@ -0,0 +1,714 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/* round-trip test: generate random instructions from GCN instruction table,
+ * disassemble them, assemble disassembled code and compare with original code.
+ * assembler rejections not listed in knownRejectionsTable are failures.
+ * usage: GCNRoundTrip [INSTRSNUM [SEED]] - INSTRSNUM - instructions per architecture */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <utility>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/utils/MemAccess.h>
+#include <CLRX/amdasm/Assembler.h>
+#include <CLRX/amdasm/Disassembler.h>
+#include "amdasm/GCNInternals.h"
+
+using namespace CLRX;
+
+// encoding families
+enum: cxuint
+{
+    GCNFAM_GCN11 = 0,   // GCN 1.0/1.1
+    GCNFAM_GCN12,       // GCN 1.2/1.4
+    GCNFAM_GCN15        // GCN 1.5
+};
+
+struct GCNEncodingInfo
+{
+    uint32_t prefix;    // encoding prefix
+    uint32_t prefixMask;
+    cxbyte opcodePos;   // position of opcode
+    cxbyte opcodeBits;
+    cxbyte bitPos2; // position of next bits of opcode (in second word)
+    cxbyte words;   // base number of words (0 - encoding not supported)
+};
+
+static const GCNEncodingInfo gcnEncodingInfoTable[3][GCNENC_VOP3P+1] =
+{
+    {   // GCN 1.0/1.1
+        { 0, 0, 0, 0, 0, 0 },
+        { 0xbf000000U, 0xff800000U, 16, 7, 0, 1 }, /* GCNENC_SOPC */
+        { 0xbf800000U, 0xff800000U, 16, 7, 0, 1 }, /* GCNENC_SOPP */
+        { 0xbe800000U, 0xff800000U, 8, 8, 0, 1 }, /* GCNENC_SOP1 */
+        { 0x80000000U, 0xc0000000U, 23, 7, 0, 1 }, /* GCNENC_SOP2 */
+        { 0xb0000000U, 0xf0000000U, 23, 5, 0, 1 }, /* GCNENC_SOPK */
+        { 0xc0000000U, 0xf8000000U, 22, 5, 0, 1 }, /* GCNENC_SMRD */
+        { 0x7c000000U, 0xfe000000U, 17, 8, 0, 1 }, /* GCNENC_VOPC */
+        { 0x7e000000U, 0xfe000000U, 9, 8, 0, 1 }, /* GCNENC_VOP1 */
+        { 0x00000000U, 0x80000000U, 25, 6, 0, 1 }, /* GCNENC_VOP2 */
+        { 0xd0000000U, 0xfc000000U, 17, 9, 0, 2 }, /* GCNENC_VOP3A */
+        { 0xd0000000U, 0xfc000000U, 17, 9, 0, 2 }, /* GCNENC_VOP3B */
+        { 0xc8000000U, 0xfc000000U, 16, 2, 0, 1 }, /* GCNENC_VINTRP */
+        { 0xd8000000U, 0xfc000000U, 18, 8, 0, 2 }, /* GCNENC_DS */
+        { 0xe0000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_MUBUF */
+        { 0xe8000000U, 0xfc000000U, 16, 3, 0, 2 }, /* GCNENC_MTBUF */
+        { 0xf0000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_MIMG */
+        { 0xf8000000U, 0xfc000000U, 0, 0, 0, 2 }, /* GCNENC_EXP */
+        { 0xdc000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_FLAT */
+        { 0, 0, 0, 0, 0, 0 } /* GCNENC_VOP3P */
+    },
+    {   // GCN 1.2/1.4
+        { 0, 0, 0, 0, 0, 0 },
+        { 0xbf000000U, 0xff800000U, 16, 7, 0, 1 }, /* GCNENC_SOPC */
+        { 0xbf800000U, 0xff800000U, 16, 7, 0, 1 }, /* GCNENC_SOPP */
+        { 0xbe800000U, 0xff800000U, 8, 8, 0, 1 }, /* GCNENC_SOP1 */
+        { 0x80000000U, 0xc0000000U, 23, 7, 0, 1 }, /* GCNENC_SOP2 */
+        { 0xb0000000U, 0xf0000000U, 23, 5, 0, 1 }, /* GCNENC_SOPK */
+        { 0xc0000000U, 0xfc000000U, 18, 8, 0, 2 }, /* GCNENC_SMEM */
+        { 0x7c000000U, 0xfe000000U, 17, 8, 0, 1 }, /* GCNENC_VOPC */
+        { 0x7e000000U, 0xfe000000U, 9, 8, 0, 1 }, /* GCNENC_VOP1 */
+        { 0x00000000U, 0x80000000U, 25, 6, 0, 1 }, /* GCNENC_VOP2 */
+        { 0xd0000000U, 0xfc000000U, 16, 10, 0, 2 }, /* GCNENC_VOP3A */
+        { 0xd0000000U, 0xfc000000U, 16, 10, 0, 2 }, /* GCNENC_VOP3B */
+        { 0xd4000000U, 0xfc000000U, 16, 2, 0, 1 }, /* GCNENC_VINTRP */
+        { 0xd8000000U, 0xfc000000U, 17, 8, 0, 2 }, /* GCNENC_DS */
+        { 0xe0000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_MUBUF */
+        { 0xe8000000U, 0xfc000000U, 15, 4, 0, 2 }, /* GCNENC_MTBUF */
+        { 0xf0000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_MIMG */
+        { 0xc4000000U, 0xfc000000U, 0, 0, 0, 2 }, /* GCNENC_EXP */
+        { 0xdc000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_FLAT */
+        { 0, 0, 0, 0, 0, 0 } /* GCNENC_VOP3P */
+    },
+    {   // GCN 1.5
+        { 0, 0, 0, 0, 0, 0 },
+        { 0xbf000000U, 0xff800000U, 16, 7, 0, 1 }, /* GCNENC_SOPC */
+        { 0xbf800000U, 0xff800000U, 16, 7, 0, 1 }, /* GCNENC_SOPP */
+        { 0xbe800000U, 0xff800000U, 8, 8, 0, 1 }, /* GCNENC_SOP1 */
+        { 0x80000000U, 0xc0000000U, 23, 7, 0, 1 }, /* GCNENC_SOP2 */
+        { 0xb0000000U, 0xf0000000U, 23, 5, 0, 1 }, /* GCNENC_SOPK */
+        { 0xf4000000U, 0xfc000000U, 18, 8, 0, 2 }, /* GCNENC_SMEM */
+        { 0x7c000000U, 0xfe000000U, 17, 8, 0, 1 }, /* GCNENC_VOPC */
+        { 0x7e000000U, 0xfe000000U, 9, 8, 0, 1 }, /* GCNENC_VOP1 */
+        { 0x00000000U, 0x80000000U, 25, 6, 0, 1 }, /* GCNENC_VOP2 */
+        { 0xd4000000U, 0xfc000000U, 16, 10, 0, 2 }, /* GCNENC_VOP3A */
+        { 0xd4000000U, 0xfc000000U, 16, 10, 0, 2 }, /* GCNENC_VOP3B */
+        { 0xc8000000U, 0xfc000000U, 16, 2, 0, 1 }, /* GCNENC_VINTRP */
+        { 0xd8000000U, 0xfc000000U, 18, 8, 0, 2 }, /* GCNENC_DS */
+        { 0xe0000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_MUBUF */
+        { 0xe8000000U, 0xfc000000U, 16, 3, 53, 2 }, /* GCNENC_MTBUF */
+        { 0, 0, 0, 0, 0, 0 }, /* GCNENC_MIMG (NSA not supported by generator) */
+        { 0xf8000000U, 0xfc000000U, 0, 0, 0, 2 }, /* GCNENC_EXP */
+        { 0xdc000000U, 0xfc000000U, 18, 7, 0, 2 }, /* GCNENC_FLAT */
+        { 0xcc000000U, 0xfc000000U, 16, 7, 0, 2 } /* GCNENC_VOP3P */
+    }
+};
+
+struct RoundTripArch
+{
+    GPUDeviceType deviceType;
+    cxuint family;
+};
+
+static const RoundTripArch roundTripArchs[] =
+{
+    { GPUDeviceType::PITCAIRN, GCNFAM_GCN11 },
+    { GPUDeviceType::HAWAII, GCNFAM_GCN11 },
+    { GPUDeviceType::TONGA, GCNFAM_GCN12 },
+    { GPUDeviceType::GFX900, GCNFAM_GCN12 },
+    { GPUDeviceType::GFX906, GCNFAM_GCN12 },
+    { GPUDeviceType::GFX1010, GCNFAM_GCN15 },
+    { GPUDeviceType::GFX1011, GCNFAM_GCN15 }
+};
+
+typedef std::mt19937 RandomGen;
+
+// generate random instruction (put words to code)
+static void generateInstruction(RandomGen& rgen, const RoundTripArch& arch,
+            const GCNInstruction& insn, std::vector<uint32_t>& code)
+{
+    const cxuint family = arch.family;
+    const GCNEncodingInfo& encInfo = gcnEncodingInfoTable[family][insn.encoding];
+    const uint32_t opcodeMask = ((1U<<encInfo.opcodeBits)-1U) << encInfo.opcodePos;
+    uint32_t word0 = (rgen() & ~(encInfo.prefixMask|opcodeMask)) | encInfo.prefix |
+            ((uint32_t(insn.code)<<encInfo.opcodePos) & opcodeMask);
+    uint32_t word1 = rgen();
+    if (encInfo.bitPos2 != 0)
+    {
+        // next bits of opcode in second word
+        const cxuint bitPos2 = encInfo.bitPos2-32;
+        word1 = (word1 & ~(1U<<bitPos2)) |
+                (((insn.code>>encInfo.opcodeBits)&1U)<<bitPos2);
+    }
+    const bool isGCN11 = getGPUArchitectureFromDeviceType(arch.deviceType) ==
+                GPUArchitecture::GCN1_1;
+    const bool isGCN124 = family != GCNFAM_GCN11;
+    const bool isGCN15 = family == GCNFAM_GCN15;
+    cxuint words = encInfo.words;
+    switch (insn.encoding)
+    {
+        case GCNENC_SOPP:
+            if ((insn.mode & GCN_MASK1) == GCN_IMM_REL)
+                word0 &= ~0xffffU; // branch to next instruction
+            break;
+        case GCNENC_SOPK:
+            if ((insn.mode & GCN_MASK1) == GCN_IMM_REL)
+                word0 &= ~0xffffU; // branch to next instruction
+            if ((insn.mode & GCN_SOPK_SRIMM32) == GCN_SOPK_SRIMM32)
+                words++;
+            break;
+        case GCNENC_SOP1:
+            if ((word0 & 0xff) == 0xff)
+                words++;
+            break;
+        case GCNENC_SOPC:
+            if ((insn.mode & GCN_MASK1) == GCN_SRC1_IMM)
+                word0 &= ~0xf000U; // only 4-bit immediate
+            // fall through
+        case GCNENC_SOP2:
+            if ((word0 & 0xff) == 0xff || (word0 & 0xff00) == 0xff00)
+                words++;
+            break;
+        case GCNENC_SMRD:
+            if (!isGCN124)
+            {
+                // SMRD: constant in soffset is printed like immediate offset
+                if ((word0 & 0x180) == 0x80 && (!isGCN11 || (word0 & 0xff) != 0xff))
+                    word0 &= ~0x80U;
+                if (isGCN11 && (word0 & 0x1ff) == 0xff)
+                    words++;
+            }
+            else if (!isGCN15 && (word0 & 0x20000U) == 0)
+                // SMEM: constant in soffset is printed like immediate offset
+                word1 &= ~0x80U;
+            break;
+        case GCNENC_VOPC:
+        case GCNENC_VOP1:
+        case GCNENC_VOP2:
+        {
+            const uint32_t src0 = word0 & 0x1ff;
+            if (insn.encoding == GCNENC_VOP2 && ((insn.mode & GCN_MASK1) == GCN_ARG1_IMM ||
+                (insn.mode & GCN_MASK1) == GCN_ARG2_IMM))
+                words++;
+            else if (src0 == 0xff || (isGCN124 && (src0 == 0xf9 || src0 == 0xfa)) ||
+                    (isGCN15 && (src0 == 0xe9 || src0 == 0xea)))
+                words++;
+            if (insn.encoding == GCNENC_VOP2 && ((insn.mode & GCN_MASK1) == GCN_DS1_SGPR ||
+                (insn.mode & GCN_MASK1) == GCN_SRC1_SGPR) && (word0 & 0x1fe00U) == 0x1fe00U)
+                // no literal in SGPR source1, replace by zero
+                word0 &= ~0xfe00U;
+            if (isGCN124 && src0 == 0xfa && (word1 & 0x1ff00U) == 0x10000U)
+                // DPP: row_shl:0 is illegal and not printed, replace by identity
+                word1 = (word1 & ~0x1ff00U) | 0xe400U;
+            if (isGCN124 && src0 == 0xf9)
+            {
+                if (isGCN15 && insn.encoding == GCNENC_VOPC &&
+                    ::strncmp(insn.mnemonic, "v_cmpx_", 7) == 0)
+                    // V_CMPX doesn't have SDST
+                    word1 = (word1 & ~0xff00U) | 0x8000U;
+                // SDWA: clear abs/neg modifiers for constant operands
+                if ((word1 & 0x800080U) == 0x800080U)
+                    word1 &= ~0x300000U;
+                if (insn.encoding != GCNENC_VOP1 && (word1 & 0x80000000U) != 0 &&
+                    (word0 & 0x10000U) != 0)
+                    word1 &= ~0x30000000U;
+            }
+            break;
+        }
+        case GCNENC_VOP3A:
+        case GCNENC_VOP3B:
+        case GCNENC_VOP3P:
+            // clear abs/neg modifiers for constant operands, because assembler
+            // includes them in constant value
+            for (cxuint i = 0; i < 3; i++)
+                if (((word1 >> (9*i)) & 0x100) == 0 && ((word1 >> (9*i)) & 0x80) != 0)
+                {
+                    if (!isGCN15 && ((word1 >> (9*i)) & 0xff) == 0xff)
+                        // no literal in VOP3 before GCN 1.5, replace by zero
+                        word1 &= ~(0x7fU << (9*i));
+                    word1 &= ~(1U<<(29+i));
+                    if (insn.encoding != GCNENC_VOP3B)
+                        word0 &= ~(1U<<(8+i));
+                }
+            if (isGCN15 && ((word1 & 0x1ff) == 0xff || ((word1>>9) & 0x1ff) == 0xff ||
+                ((word1>>18) & 0x1ff) == 0xff))
+                words++;
+            break;
+        case GCNENC_MUBUF:
+        case GCNENC_MTBUF:
+            if ((word1 >> 24) == 0xff)
+                // no literal in soffset, replace by zero
+                word1 &= ~0x7f000000U;
+            break;
+        case GCNENC_FLAT:
+            if (isGCN124)
+                // set FLAT mode (FLAT, SCRATCH, GLOBAL)
+                word0 = (word0 & ~0xc000U) | ((insn.mode & GCN_FLAT_MODEMASK)<<14);
+            break;
+        default:
+            break;
+    }
+    code.push_back(word0);
+    if (words >= 2)
+        code.push_back(word1);
+    if (words >= 3)
+        code.push_back(rgen());
+}
+
+// disassemble code, return number of nanoseconds
+static uint64_t disassembleCode(GPUDeviceType deviceType, const std::vector<uint32_t>& code,
+            std::string& output, Flags flags = DISASM_DUMPCODE)
+{
+    std::ostringstream oss;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        Disassembler disasm(deviceType, code.size()<<2,
+                    reinterpret_cast<const cxbyte*>(code.data()), oss, flags);
+        disasm.disassemble();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    output = oss.str();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+}
+
+// assemble code, return number of nanoseconds
+static uint64_t assembleCode(GPUDeviceType deviceType, const std::string& source,
+            bool& good, std::vector<uint32_t>& code, std::string& errors)
+{
+    std::istringstream iss(source);
+    std::ostringstream errorStream;
+    const auto start = std::chrono::steady_clock::now();
+    Assembler assembler("test.s", iss, ASM_ALL&~(ASM_ALTMACRO|ASM_WAVE32),
+                    BinaryFormat::RAWCODE, deviceType, errorStream);
+    good = assembler.assemble();
+    const auto end = std::chrono::steady_clock::now();
+    code.clear();
+    if (good && assembler.getSections().size() >= 1)
+    {
+        const AsmSection& section = assembler.getSections()[0];
+        code.resize(section.content.size()>>2);
+        for (size_t i = 0; i < code.size(); i++)
+            code[i] = ULEV(reinterpret_cast<const uint32_t*>(section.content.data())[i]);
+    }
+    errors = errorStream.str();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(end-start).count();
+}
+
+struct InstrLine
+{
+    size_t lineNo;
+    size_t offset;  // code offset (only if disassembled with DISASM_CODEPOS)
+    std::string text;
+};
+
+// split disassembler output to instruction lines (skip labels and pseudo-ops)
+static std::vector<InstrLine> getInstrLines(const std::string& output)
+{
+    std::vector<InstrLine> lines;
+    std::istringstream iss(output);
+    std::string line;
+    for (size_t lineNo = 1; std::getline(iss, line); lineNo++)
+        if (line.compare(0, 8, "        ") == 0)
+            lines.push_back({ lineNo, 0, line });
+        else if (line.compare(0, 2, "/*") == 0)
+            // line with code position
+            lines.push_back({ lineNo, size_t(::strtoull(line.c_str()+2, nullptr, 16)),
+                    line });
+    return lines;
+}
+
+// return true if disassembler marked instruction as illegal or printed unused fields
+static bool isIllegalInstrLine(const std::string& line)
+{
+    return line.find(".int ") != std::string::npos ||
+        line.find("ill_") != std::string::npos || line.find("&ill!") != std::string::npos ||
+        line.find("invalid_") != std::string::npos || line.find("=0x") != std::string::npos;
+}
+
+// get first error message for every line from assembler errors (sorted by line number)
+static std::vector<std::pair<size_t, std::string> > getErrorLines(const std::string& errors)
+{
+    std::vector<std::pair<size_t, std::string> > errLines;
+    std::istringstream iss(errors);
+    std::string line;
+    while (std::getline(iss, line))
+        if (line.compare(0, 7, "test.s:") == 0)
+        {
+            char* end;
+            const size_t lineNo = ::strtoul(line.c_str()+7, &end, 10);
+            // skip column number
+            const size_t msgPos = line.find(": ", end-line.c_str());
+            errLines.push_back({ lineNo, msgPos != std::string::npos ?
+                        line.substr(msgPos+2) : std::string() });
+        }
+    std::stable_sort(errLines.begin(), errLines.end(),
+        [](const std::pair<size_t, std::string>& a,
+           const std::pair<size_t, std::string>& b)
+        { return a.first < b.first; });
+    errLines.resize(std::unique(errLines.begin(), errLines.end(),
+        [](const std::pair<size_t, std::string>& a,
+           const std::pair<size_t, std::string>& b)
+        { return a.first == b.first; }) - errLines.begin());
+    return errLines;
+}
+
+struct KnownRejection
+{
+    const char* error;  // part of assembler error message (null - any error)
+    const char* text;   // part of disassembled instruction (null - any instruction)
+};
+
+/* assembler rejections of disassembled random instructions that are expected.
+ * any other rejection is encoder/decoder mismatch and fails the test */
+static const KnownRejection knownRejectionsTable[] =
+{
+    /* hardware illegal combinations of fields, checked only by assembler */
+    { "Unaligned scalar register range", nullptr },
+    { "Scalar register range cross two register lines", nullptr },
+    { "Some scalar register number out of range", nullptr },
+    { "Some TTMPRegister number out of range", nullptr },
+    { "scalar register", nullptr }, // Expected/Required N scalar registers
+    { "vector register", nullptr }, // Required N vector registers, illegal range
+    { "Some garbages at register name place", nullptr }, // constant in SGPR place
+    { "SGPR to read in instruction", nullptr },
+    { "SGPRs to read in instruction", nullptr },
+    { "No SGPR can be readed in vccImplRead", nullptr },
+    { "Literal in VOP", nullptr },
+    { "Literal in MUBUF is illegal", nullptr },
+    { "Literal with SDWA or DPP word is illegal", nullptr },
+    { "Literal with SGPR or M0 is illegal", nullptr },
+    { "encoding is illegal for this instruction", nullptr }, // DPP/SDWA
+    { "Both LDS and TFE is illegal", nullptr },
+    { "Idxen and offen must be zero", nullptr },
+    { "LDS is allowed only for SCRATCH and GLOBAL", nullptr },
+    { "Zero in dmask is illegal", nullptr },
+    { "Unorm is not set", nullptr },
+    { "Store/Atomic SMEM instructions accepts only", nullptr },
+    // literal shared by two operands or LDS direct in scalar instruction
+    { "Only one literal can be used in instruction", nullptr },
+    /* reserved or unused fields printed by disassembler in non-assemblable form */
+    { "Garbages at end of line", " 0x" },   // immediate in SOPP without operands
+    { "Garbages at end of line", ") :0x" }, // unused bits of sendmsg/waitcnt
+    { "Some garbages at function name place", "s_waitcnt " }, // or raw waitcnt value
+    { "Unterminated sendmsg function", ") :0x" },
+    { "Unterminated sendmsg function", "sendmsg(@" },   // unknown message
+    // unused GSOP and STREAMID bits for messages other than GS and GS_DONE
+    { "Unterminated sendmsg function", "sendmsg(interrupt, " },
+    { "Unterminated sendmsg function", "sendmsg(system, " },
+    { "Unterminated sendmsg function", "sendmsg(savewave, " },
+    { "Unterminated sendmsg function", "sendmsg(stall_wave_gen, " },
+    { "Unterminated sendmsg function", "sendmsg(halt_waves, " },
+    { "Unterminated sendmsg function", "sendmsg(ordered_ps_done, " },
+    { "Unterminated sendmsg function", "sendmsg(early_prim_dealloc, " },
+    { "Unterminated sendmsg function", "sendmsg(gs_alloc_req, " },
+    { "Unterminated sendmsg function", "sendmsg(get_doorbell, " },
+    { nullptr, "_u!" }, // unknown register
+    { "Unknown data/number format", "format:[reserved" },
+    { "Unknown data/number format", "format:[invalid" },
+    { "_sel", "_sel:invalid" },
+    { "Unknown dst_unused", "dst_unused:invalid" },
+    { "Unknown VOP modifier", "dppctrl:0x" },   // reserved DPP control
+    // modifiers for nonexistent operands
+    { nullptr, " abs1" },
+    { nullptr, " neg1" },
+    { nullptr, " sext1" },
+    { nullptr, " abs2" },
+    { nullptr, " neg2" },
+    { "Unresolved symbol 'lds'", "lds" },   // LDS direct in scalar instruction
+    { "Unknown operand", "v_interp_p" },    // constant in VINTRP in VOP3 encoding
+    // 3-element op_sel in VINTRP in VOP3 encoding
+    { "Expected ',' before bit value", "v_interp_p" },
+    // instructions with K constant (madak, fmamk, ...) in VOP3 encoding
+    { "Expected operator", " vop3" },
+    { "Unterminated bit array", " vop3" },
+    /* known mismatches between decoder and encoder */
+    // op_sel for all operands in VOP3 instruction without op_sel
+    { "Unterminated bit array", "op_sel:[" },
+    { "Unknown FLAT modifier", " nv" },     // NV bit is not accepted for GCN 1.5
+    // SDWA sext of constant
+    { "Some garbages at VOP modifier place", "sext(" },
+    { "Expected ',' before argument", "sext(" },
+    // SDWAB SDST in GCN 1.5 V_CMPX (assembler accepts only EXEC as destination)
+    { "Some garbages at VOP modifier place", "v_cmpx_" }
+};
+
+// return true if assembler rejection is expected
+static bool isKnownRejection(const std::string& error, const std::string& text)
+{
+    for (const KnownRejection& known: knownRejectionsTable)
+        if ((known.error == nullptr || error.find(known.error) != std::string::npos) &&
+            (known.text == nullptr || text.find(known.text) != std::string::npos))
+            return true;
+    return false;
+}
+
+struct RoundTripStats
+{
+    size_t instrsNum;   // all instructions
+    size_t exactNum;    // instructions assembled to this same code
+    size_t canonNum;    // instructions assembled to other code with this same meaning
+    size_t invalidNum;  // generated instructions illegal or rejected by assembler
+    size_t failsNum;    // failed instructions
+    uint64_t disasmTime;
+    uint64_t asmTime;
+};
+
+static void printCode(std::ostream& os, const std::vector<uint32_t>& code)
+{
+    for (uint32_t word: code)
+        os << " 0x" << std::hex << word << std::dec;
+}
+
+// check single instruction (if batch round trip failed), return true if no failure
+static bool checkSingleInstr(GPUDeviceType deviceType, const std::vector<uint32_t>& code,
+            RoundTripStats& stats)
+{
+    std::string disasmOut, disasmOut2, errors;
+    disassembleCode(deviceType, code, disasmOut);
+    bool good = false;
+    std::vector<uint32_t> newCode;
+    assembleCode(deviceType, disasmOut, good, newCode, errors);
+    if (good && newCode == code)
+    {
+        stats.exactNum++;
+        return true;
+    }
+    if (good)
+    {
+        // check whether new code is disassembled to this same text
+        disassembleCode(deviceType, newCode, disasmOut2);
+        if (disasmOut2 == disasmOut)
+        {
+            stats.canonNum++;
+            return true;
+        }
+    }
+    stats.failsNum++;
+    const std::vector<InstrLine> lines = getInstrLines(disasmOut);
+    std::ostringstream oss;
+    oss << "FAILED for " << getGPUDeviceTypeName(deviceType) << " code:";
+    printCode(oss, code);
+    oss << ", disasm: '" << (lines.empty() ? std::string() : lines[0].text) << "'";
+    if (!good)
+        oss << ", errors: " << errors;
+    else
+    {
+        oss << ", reassembled:";
+        printCode(oss, newCode);
+    }
+    std::cerr << oss.str() << std::endl;
+    return false;
+}
+
+/* generate batch of instructions. instructions marked by disassembler as illegal or
+ * rejected by assembler (known rejections) will be skipped.
+ * return false if assembler rejected instruction with unexpected error */
+static bool generateBatch(RandomGen& rgen, const RoundTripArch& arch,
+            const std::vector<const GCNInstruction*>& instrs, size_t candsNum,
+            std::vector<uint32_t>& code, std::vector<size_t>& instrPos,
+            RoundTripStats& stats)
+{
+    std::uniform_int_distribution<size_t> instrDist(0, instrs.size()-1);
+    std::vector<uint32_t> candCode;
+    std::vector<size_t> candPos;
+    for (size_t i = 0; i < candsNum; i++)
+    {
+        candPos.push_back(candCode.size());
+        generateInstruction(rgen, arch, *instrs[instrDist(rgen)], candCode);
+    }
+    candPos.push_back(candCode.size());
+    std::vector<bool> candValid(candsNum, true);
+    bool good = true;
+    for (size_t i = 0; i < candsNum; i++)
+        if (candCode[candPos[i]] == 0)
+            // zero words will be disassembled as .fill
+            candValid[i] = false;
+    
+    while (true)
+    {
+        code.clear();
+        instrPos.clear();
+        std::vector<size_t> candIndices;
+        for (size_t i = 0; i < candsNum; i++)
+            if (candValid[i])
+            {
+                candIndices.push_back(i);
+                instrPos.push_back(code.size());
+                code.insert(code.end(), candCode.begin()+candPos[i],
+                            candCode.begin()+candPos[i+1]);
+            }
+        instrPos.push_back(code.size());
+        if (candIndices.empty())
+            return good;
+        
+        std::string disasmOut, errors;
+        disassembleCode(arch.deviceType, code, disasmOut,
+                    DISASM_DUMPCODE|DISASM_CODEPOS);
+        const std::vector<InstrLine> lines = getInstrLines(disasmOut);
+        bool changed = false;
+        // check whether disassembler decoded instructions with same sizes
+        auto lineIt = lines.begin();
+        for (size_t i = 0; i < candIndices.size(); i++)
+        {
+            const size_t offset = instrPos[i]<<2;
+            while (lineIt != lines.end() && lineIt->offset < offset)
+                ++lineIt;
+            if (lineIt == lines.end() || lineIt->offset != offset ||
+                (lineIt+1 != lines.end() && (lineIt+1)->offset != (instrPos[i+1]<<2)) ||
+                isIllegalInstrLine(lineIt->text))
+            {
+                candValid[candIndices[i]] = false;
+                stats.invalidNum++;
+                changed = true;
+            }
+        }
+        if (changed)
+            continue;
+        
+        bool asmGood = false;
+        std::vector<uint32_t> newCode;
+        assembleCode(arch.deviceType, disasmOut, asmGood, newCode, errors);
+        if (asmGood)
+            return good;
+        // remove instructions rejected by assembler
+        for (const auto& errLine: getErrorLines(errors))
+        {
+            auto it = std::lower_bound(lines.begin(), lines.end(), errLine.first,
+                [](const InstrLine& l, size_t lineNo) { return l.lineNo < lineNo; });
+            if (it == lines.end() || it->lineNo != errLine.first)
+            {
+                std::istringstream iss(disasmOut);
+                std::string line;
+                for (size_t i = 0; i < errLine.first; i++)
+                    std::getline(iss, line);
+                throw Exception("Assembler error outside instruction: " + line);
+            }
+            candValid[candIndices[it-lines.begin()]] = false;
+            changed = true;
+            if (isKnownRejection(errLine.second, it->text))
+            {
+                stats.invalidNum++;
+                continue;
+            }
+            stats.failsNum++;
+            good = false;
+            std::cerr << "REJECTED for " << getGPUDeviceTypeName(arch.deviceType) <<
+                    ": '" << it->text << "', error: " << errLine.second << std::endl;
+        }
+        if (!changed)
+            throw Exception("Can't find rejected instructions");
+    }
+}
+
+static bool testRoundTrip(const RoundTripArch& arch, size_t instrsNum, uint32_t seed,
+            RoundTripStats& stats)
+{
+    const GPUArchMask archMask = 1U<<int(getGPUArchitectureFromDeviceType(
+                arch.deviceType));
+    // collect instructions for this architecture
+    std::vector<const GCNInstruction*> instrs;
+    for (cxuint i = 0; gcnInstrsTable[i].mnemonic != nullptr; i++)
+    {
+        const GCNInstruction& insn = gcnInstrsTable[i];
+        if ((insn.archMask & archMask) != 0 && insn.encoding <= GCNENC_VOP3P &&
+            gcnEncodingInfoTable[arch.family][insn.encoding].words != 0)
+            instrs.push_back(&insn);
+    }
+
+    RandomGen rgen(seed);
+    stats = RoundTripStats{ 0, 0, 0, 0, 0, 0, 0 };
+    bool good = true;
+    const size_t batchSize = 1024;
+    for (size_t done = 0; done < instrsNum; done += batchSize)
+    {
+        std::vector<uint32_t> code;
+        std::vector<size_t> instrPos;
+        good &= generateBatch(rgen, arch, instrs, std::min(batchSize, instrsNum-done),
+                    code, instrPos, stats);
+        const size_t codeInstrsNum = instrPos.size()-1;
+        if (codeInstrsNum == 0)
+            continue;
+        stats.instrsNum += codeInstrsNum;
+        
+        // real round trip: disassemble and assemble
+        std::string disasmOut, errors;
+        stats.disasmTime += disassembleCode(arch.deviceType, code, disasmOut);
+        bool asmGood = false;
+        std::vector<uint32_t> newCode;
+        stats.asmTime += assembleCode(arch.deviceType, disasmOut, asmGood, newCode,
+                    errors);
+        if (asmGood && newCode == code)
+        {
+            stats.exactNum += codeInstrsNum;
+            continue;
+        }
+        // check instructions separately
+        for (size_t i = 0; i < codeInstrsNum; i++)
+            good &= checkSingleInstr(arch.deviceType,
+                    std::vector<uint32_t>(code.begin()+instrPos[i],
+                                code.begin()+instrPos[i+1]), stats);
+    }
+    return good;
+}
+
+int main(int argc, const char** argv)
+{
+    size_t instrsNum = 20000;
+    uint32_t seed = 1234;
+    if (argc >= 2)
+        instrsNum = ::strtoul(argv[1], nullptr, 10);
+    if (argc >= 3)
+        seed = ::strtoul(argv[2], nullptr, 10);
+    
+    int retVal = 0;
+    for (const RoundTripArch& arch: roundTripArchs)
+    {
+        RoundTripStats stats{ 0, 0, 0, 0, 0, 0, 0 };
+        try
+        {
+            if (!testRoundTrip(arch, instrsNum, seed, stats))
+                retVal = 1;
+        }
+        catch(const std::exception& ex)
+        {
+            std::cerr << "Exception for " << getGPUDeviceTypeName(arch.deviceType) <<
+                    ": " << ex.what() << std::endl;
+            retVal = 1;
+        }
+        // print statistics
+        std::cout << getGPUDeviceTypeName(arch.deviceType) << ": instrs=" <<
+            stats.instrsNum << ", exact=" << stats.exactNum << ", canonicalized=" <<
+            stats.canonNum << ", failed=" << stats.failsNum << ", invalid=" <<
+            stats.invalidNum << ", disasm=" <<
+            (stats.disasmTime!=0 ? stats.instrsNum*1000000000.0/stats.disasmTime : 0.0) <<
+            " instrs/s, asm=" <<
+            (stats.asmTime!=0 ? stats.instrsNum*1000000000.0/stats.asmTime : 0.0) <<
+            " instrs/s" << std::endl;
+    }
+    return retVal;
+}
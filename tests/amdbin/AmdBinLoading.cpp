@@ -491,6 +491,60 @@ static void testKernelArgs(const char* filename, const char* kernelName,
     }
 }
 
+// compare binary loaded lazily with binary loaded eagerly
+static void testLazyAmdBinLoading(const char* filename)
+{
+    const std::string testName = std::string("testLazyAmdBinLoading:") + filename;
+    Array<cxbyte> data = loadDataFromFile(filename);
+    Array<cxbyte> data2 = data;
+    std::unique_ptr<AmdMainBinaryBase> base(createAmdBinaryFromCode(
+                data.size(), data.data(), AMDBIN_CREATE_ALL));
+    std::unique_ptr<AmdMainBinaryBase> lazyBase(createAmdBinaryFromCode(
+                data2.size(), data2.data(), AMDBIN_CREATE_ALL|AMDBIN_CREATE_LAZY));
+    const AmdMainGPUBinaryBase& gpuBin =
+                *static_cast<const AmdMainGPUBinaryBase*>(base.get());
+    const AmdMainGPUBinaryBase& lazyGpuBin =
+                *static_cast<const AmdMainGPUBinaryBase*>(lazyBase.get());
+    
+    assertValue(testName, "kernelInfosNum", base->getKernelInfosNum(),
+                lazyBase->getKernelInfosNum());
+    // access in reverse order and by name
+    for (size_t i = base->getKernelInfosNum(); i > 0; i--)
+    {
+        const KernelInfo& kinfo = base->getKernelInfo(i-1);
+        const KernelInfo& lazyKinfo = lazyBase->getKernelInfo(kinfo.kernelName.c_str());
+        assertValue(testName, "kernelName", kinfo.kernelName, lazyKinfo.kernelName);
+        assertValue(testName, "argsNum", kinfo.argInfos.size(), lazyKinfo.argInfos.size());
+        for (size_t k = 0; k < kinfo.argInfos.size(); k++)
+        {
+            assertValue(testName, "argName", kinfo.argInfos[k].argName,
+                        lazyKinfo.argInfos[k].argName);
+            assertValue(testName, "argType", cxuint(kinfo.argInfos[k].argType),
+                        cxuint(lazyKinfo.argInfos[k].argType));
+        }
+        assertTrue(testName, "sameKernelInfo", &lazyKinfo == &lazyBase->getKernelInfo(i-1));
+    }
+    
+    assertValue(testName, "innerBinariesNum", gpuBin.getInnerBinariesNum(),
+                lazyGpuBin.getInnerBinariesNum());
+    for (size_t i = gpuBin.getInnerBinariesNum(); i > 0; i--)
+    {
+        const AmdInnerGPUBinary32& inner = gpuBin.getInnerBinary(i-1);
+        const AmdInnerGPUBinary32& lazyInner =
+                lazyGpuBin.getInnerBinary(inner.getKernelName().c_str());
+        assertValue(testName, "innerName", inner.getKernelName(),
+                    lazyInner.getKernelName());
+        assertTrue(testName, "innerCode", inner.getBinaryCode() ==
+                    data.data() + (lazyInner.getBinaryCode() - data2.data()));
+        assertValue(testName, "innerSize", inner.getSize(), lazyInner.getSize());
+        assertValue(testName, "encodingsNum", inner.getCALEncodingEntriesNum(),
+                    lazyInner.getCALEncodingEntriesNum());
+        for (cxuint k = 0; k < inner.getCALEncodingEntriesNum(); k++)
+            assertValue(testName, "calNotesNum", inner.getCALNotesNum(k),
+                        lazyInner.getCALNotesNum(k));
+    }
+}
+
 static const cxbyte defaultHeader[32] = { };
 
 static AmdMainGPUBinaryBase* genAmdBinWithMetadata(const std::string& metadata)
@@ -611,6 +665,10 @@ static void testBinLoadingFailCase(cxuint testCaseId, const BinLoadingFailCase&
 int main(int argc, const char** argv)
 {
     int retVal = 0;
+    retVal |= callTest(testLazyAmdBinLoading, CLRX_SOURCE_DIR
+            "/tests/amdbin/amdbins/alltypes.clo");
+    retVal |= callTest(testLazyAmdBinLoading, CLRX_SOURCE_DIR
+            "/tests/amdbin/amdbins/prginfo8_14_12.clo.1_0.reconf");
     retVal |= callTest(testKernelArgs, CLRX_SOURCE_DIR
             "/tests/amdbin/amdbins/alltypes.clo",
             "myKernel", sizeof(expectedKernelArgs1)/sizeof(AmdKernelArg),
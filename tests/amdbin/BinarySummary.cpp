@@ -0,0 +1,199 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <algorithm>
+#include <climits>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/utils/Utilities.h>
+#include <CLRX/amdbin/ROCmBinaries.h>
+#include <CLRX/amdbin/BinarySummary.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+struct BinarySummaryTestCase
+{
+    const char* filename;
+    SummaryBinaryFormat format;
+    bool is64Bit;
+    GPUDeviceType deviceType;
+    size_t kernelsNum;
+    // expected summaries of first kernels
+    std::vector<KernelSummary> kernels;
+};
+
+static const BinarySummaryTestCase binSummaryTestCases[] =
+{
+    {   /* 0 - AMD Catalyst 32-bit */
+        CLRX_SOURCE_DIR "/tests/amdbin/amdbins/prginfo8_14_12.clo.1_0.reconf",
+        SummaryBinaryFormat::AMD, false, GPUDeviceType::PITCAIRN, 11,
+        {
+            { "imageTransform", 9306, 184, 28, 11, 0, 0, { 0, 0, 0 } },
+            { "imageTransformS", 15764, 204, 28, 7, 0, 0, { 0, 0, 0 } },
+            { "imageTransformX", 22234, 184, 28, 11, 0, 0, { 0, 0, 0 } },
+            { "imageTransform5MS", 28772, 744, 60, 35, 0, 0, { 0, 0, 0 } }
+        }
+    },
+    {   /* 1 - AMD Catalyst 64-bit */
+        CLRX_SOURCE_DIR "/tests/amdbin/amdbins/alltypes_64.clo",
+        SummaryBinaryFormat::AMD, true, GPUDeviceType::PITCAIRN, 1,
+        { { "myKernel", 11640, 4, 3, 3, 0, 0, { 0, 0, 0 } } }
+    },
+    {   /* 2 - AMD OpenCL 2.0 with local memory */
+        CLRX_SOURCE_DIR "/tests/amdbin/amdcl2bins/locals.clo.reconf",
+        SummaryBinaryFormat::AMDCL2, true, GPUDeviceType::BONAIRE, 2,
+        {
+            { "kernelArgs", 4388, 280, 9, 8, 1156, 0, { 0, 0, 0 } },
+            { "kernelArgs2", 5156, 224, 8, 5, 2180, 0, { 0, 0, 0 } }
+        }
+    },
+    {   /* 3 - AMD OpenCL 2.0 with scratch buffer */
+        CLRX_SOURCE_DIR "/tests/amdbin/amdcl2bins/scratch.clo.regen",
+        SummaryBinaryFormat::AMDCL2, true, GPUDeviceType::BONAIRE, 2,
+        {
+            { "testkernel1", 4973, 12800, 13, 35, 0, 2672, { 0, 0, 0 } },
+            { "testkernel2", 18029, 23136, 28, 37, 0, 2768, { 0, 0, 0 } }
+        }
+    },
+    {   /* 4 - AMD OpenCL 2.0 with reqd_work_group_size */
+        CLRX_SOURCE_DIR "/tests/amdbin/amdcl2bins/simplecopy-kattrs-248203.clo.reconf",
+        SummaryBinaryFormat::AMDCL2, true, GPUDeviceType::BONAIRE, 1,
+        { { "copy", 3023, 92, 8, 4, 0, 0, { 3, 7, 2 } } }
+    },
+    {   /* 5 - ROCm */
+        CLRX_SOURCE_DIR "/tests/amdbin/rocmbins/vectoradd-rocm.clo.regen",
+        SummaryBinaryFormat::ROCM, true, GPUDeviceType::FIJI, 1,
+        { { "vectorAdd", 4352, 180, 11, 6, 0, 0, { 0, 0, 0 } } }
+    },
+    {   /* 6 - ROCm with local memory and scratch */
+        CLRX_SOURCE_DIR "/tests/amdbin/rocmbins/rijndael.hsaco.regen",
+        SummaryBinaryFormat::ROCM, true, GPUDeviceType::FIJI, 6,
+        {
+            { "rijndael128_decrypt_kernel", 39168, 8472, 36, 94, 5296, 52, { 0, 0, 0 } },
+            { "rijndael128_encrypt_kernel", 16896, 14908, 34, 89, 5296, 36, { 0, 0, 0 } }
+        }
+    },
+    {   /* 7 - GalliumCompute */
+        CLRX_SOURCE_DIR "/tests/amdbin/galliumbins/MatrixMultiplication.0.reconf.orig",
+        SummaryBinaryFormat::GALLIUM, false, GPUDeviceType::CAPE_VERDE, 2,
+        {
+            { "mmmKernel", 676, 1280, 32, 68, 0, 0, { 0, 0, 0 } },
+            { "mmmKernel_local", 1956, 1992, 40, 76, 0, 0, { 0, 0, 0 } }
+        }
+    },
+    {   /* 8 - GalliumCompute 64-bit */
+        CLRX_SOURCE_DIR "/tests/amdbin/galliumbins/vectoradd-64bit.clo.reconf",
+        SummaryBinaryFormat::GALLIUM, true, GPUDeviceType::CAPE_VERDE, 1,
+        { { "vectorAdd", 453, 132, 24, 4, 0, 0, { 0, 0, 0 } } }
+    }
+};
+
+static void testBinarySummary(cxuint testId, const BinarySummaryTestCase& testCase)
+{
+    std::ostringstream testNameOss;
+    testNameOss << "BinarySummary#" << testId;
+    const std::string testName = testNameOss.str();
+    Array<cxbyte> data = loadDataFromFile(testCase.filename);
+    BinarySummary summary;
+    getBinarySummary(data.size(), data.data(), summary);
+    assertValue(testName, "format", cxuint(testCase.format), cxuint(summary.format));
+    assertValue(testName, "is64Bit", int(testCase.is64Bit), int(summary.is64Bit));
+    assertValue(testName, "deviceType", cxuint(testCase.deviceType),
+                cxuint(summary.deviceType));
+    assertValue(testName, "kernelsNum", testCase.kernelsNum, summary.kernels.size());
+    
+    for (size_t i = 0; i < testCase.kernels.size(); i++)
+    {
+        const KernelSummary& expected = testCase.kernels[i];
+        const KernelSummary& result = summary.kernels[i];
+        std::ostringstream kOss;
+        kOss << "kernel#" << i << ".";
+        const std::string kname = kOss.str();
+        assertString(testName, kname+"name", expected.kernelName.c_str(),
+                    result.kernelName.c_str());
+        assertValue(testName, kname+"codeOffset", expected.codeOffset, result.codeOffset);
+        assertValue(testName, kname+"codeSize", expected.codeSize, result.codeSize);
+        assertValue(testName, kname+"sgprsNum", expected.sgprsNum, result.sgprsNum);
+        assertValue(testName, kname+"vgprsNum", expected.vgprsNum, result.vgprsNum);
+        assertValue(testName, kname+"localSize", expected.localSize, result.localSize);
+        assertValue(testName, kname+"scratchSize", expected.scratchSize,
+                    result.scratchSize);
+        for (cxuint k = 0; k < 3; k++)
+        {
+            std::ostringstream cwsOss;
+            cwsOss << kname << "reqdWorkGroupSize[" << k << "]";
+            assertValue(testName, cwsOss.str(), expected.reqdWorkGroupSize[k],
+                        result.reqdWorkGroupSize[k]);
+        }
+        // code must lie inside binary
+        assertTrue(testName, kname+"codeInBinary",
+                    result.codeOffset + result.codeSize <= data.size());
+    }
+}
+
+static void testBinarySummaryFail()
+{
+    Array<cxbyte> data = loadDataFromFile(CLRX_SOURCE_DIR
+                "/tests/amdbin/amdbins/alltypes_cpu.clo");
+    assertCLRXException("BinarySummaryFail", "cpuBinary", "This is not AMD GPU binary",
+            [&data]()
+            {
+                BinarySummary summary;
+                getBinarySummary(data.size(), data.data(), summary);
+            });
+}
+
+static void testROCmSmallKernelRegion()
+{
+    // kernel symbol smaller than kernel config
+    Array<cxbyte> code(512);
+    std::fill(code.begin(), code.end(), cxbyte(0));
+    ROCmInput input{};
+    input.deviceType = GPUDeviceType::FIJI;
+    input.archMinor = input.archStepping = UINT32_MAX;
+    input.eflags = BINGEN_DEFAULT;
+    input.codeSize = code.size();
+    input.code = code.data();
+    input.symbols.push_back({ "smallKernel", 0, 0x40, ROCmRegionType::KERNEL });
+    ROCmBinGenerator binGen(&input);
+    Array<cxbyte> binary;
+    binGen.generate(binary);
+    assertCLRXException("BinarySummaryROCm", "smallKernelRegion",
+            "Kernel region is too small for kernel config",
+            [&binary]()
+            {
+                BinarySummary summary;
+                getBinarySummary(binary.size(), binary.data(), summary);
+            });
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    for (cxuint i = 0; i < sizeof(binSummaryTestCases)/sizeof(BinarySummaryTestCase); i++)
+        retVal |= callTest(testBinarySummary, i, binSummaryTestCases[i]);
+    retVal |= callTest(testBinarySummaryFail);
+    retVal |= callTest(testROCmSmallKernelRegion);
+    return retVal;
+}
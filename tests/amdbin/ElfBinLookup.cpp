@@ -0,0 +1,159 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <CLRX/utils/Containers.h>
+#include <CLRX/amdbin/ElfBinaries.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+static const char* sectionNames[] = { ".text", ".shstrtab", ".symtab", ".strtab",
+        ".dynsym", ".dynstr", ".hash" };
+
+// generate ELF binary with many symbols, dynamic symbols have hash table
+static Array<cxbyte> generateElfBinary(size_t symbolsNum,
+            std::vector<std::string>& symNames, std::vector<std::string>& dynSymNames)
+{
+    static const cxbyte code[16] = { };
+    ElfBinaryGen64 elfBinGen({ 0, 0, ELFOSABI_SYSV, 0, ET_DYN, 0xe0, EV_CURRENT,
+            UINT_MAX, 0, 0 });
+    elfBinGen.addRegion(ElfRegion64(sizeof code, code, 256, ".text",
+            SHT_PROGBITS, SHF_ALLOC|SHF_EXECINSTR));
+    elfBinGen.addRegion(ElfRegion64::shstrtabSection());
+    elfBinGen.addRegion(ElfRegion64::symtabSection());
+    elfBinGen.addRegion(ElfRegion64::strtabSection());
+    elfBinGen.addRegion(ElfRegion64::dynsymSection());
+    elfBinGen.addRegion(ElfRegion64::dynstrSection());
+    elfBinGen.addRegion(ElfRegion64::hashSection(5));
+    elfBinGen.addRegion(ElfRegion64::sectionHeaderTable());
+
+    symNames.resize(symbolsNum);
+    dynSymNames.resize(symbolsNum);
+    for (size_t i = 0; i < symbolsNum; i++)
+    {
+        symNames[i] = "symbol" + std::to_string(i*7);
+        dynSymNames[i] = "dynSymbol_" + std::to_string(i*3);
+    }
+    for (size_t i = 0; i < symbolsNum; i++)
+    {
+        elfBinGen.addSymbol({ symNames[i].c_str(), 1,
+                ELF64_ST_INFO(STB_GLOBAL, STT_NOTYPE), 0, false, i, 0 });
+        elfBinGen.addDynSymbol({ dynSymNames[i].c_str(), 1,
+                ELF64_ST_INFO(STB_GLOBAL, STT_NOTYPE), 0, false, i, 0 });
+    }
+    std::ostringstream oss;
+    elfBinGen.generate(oss);
+    const std::string out = oss.str();
+    return Array<cxbyte>((const cxbyte*)out.data(), (const cxbyte*)out.data()+out.size());
+}
+
+static void testElfLookup(size_t symbolsNum)
+{
+    std::ostringstream testNameOss;
+    testNameOss << "ElfLookup#" << symbolsNum;
+    const std::string testName = testNameOss.str();
+    std::vector<std::string> symNames, dynSymNames;
+    Array<cxbyte> binary = generateElfBinary(symbolsNum, symNames, dynSymNames);
+    Array<cxbyte> binary2 = binary;
+    // binary with index maps
+    ElfBinary64 mapElf(binary.size(), binary.data(), ELF_CREATE_ALL);
+    // binary without index maps (lookup by hash table or by lazily built index)
+    ElfBinary64 elf(binary2.size(), binary2.data(), 0);
+    assertTrue(testName, "noSymbolHashTable", !elf.hasSymbolHashTable());
+    assertTrue(testName, "hasDynSymbolHashTable", elf.hasDynSymbolHashTable());
+    assertValue(testName, "symbolsNum", symbolsNum+1, size_t(elf.getSymbolsNum()));
+    assertValue(testName, "dynSymbolsNum", symbolsNum+1, size_t(elf.getDynSymbolsNum()));
+
+    for (const char* sectName: sectionNames)
+        assertValue(testName, std::string("section ")+sectName,
+                    cxuint(mapElf.getSectionIndex(sectName)),
+                    cxuint(elf.getSectionIndex(sectName)));
+    for (size_t i = 0; i < symbolsNum; i++)
+    {
+        const char* symName = symNames[i].c_str();
+        const char* dynSymName = dynSymNames[i].c_str();
+        assertValue(testName, std::string("symbol ")+symName, i+1,
+                    size_t(mapElf.getSymbolIndex(symName)));
+        assertValue(testName, std::string("symbol ")+symName, i+1,
+                    size_t(elf.getSymbolIndex(symName)));
+        assertValue(testName, std::string("dynSymbol ")+dynSymName, i+1,
+                    size_t(mapElf.getDynSymbolIndex(dynSymName)));
+        assertValue(testName, std::string("dynSymbol ")+dynSymName, i+1,
+                    size_t(elf.getDynSymbolIndex(dynSymName)));
+    }
+    // check not found names
+    assertCLRXException(testName, "noSection", "Can't find Elf64 Section",
+                [&elf]() { elf.getSectionIndex(".data"); });
+    assertCLRXException(testName, "noSymbol", "Can't find Elf64 Symbol",
+                [&elf]() { elf.getSymbolIndex("symbol1"); });
+    assertCLRXException(testName, "noDynSymbol", "Can't find Elf64 DynSymbol",
+                [&elf]() { elf.getDynSymbolIndex("dynSymbol_1"); });
+    assertCLRXException(testName, "noSymbol2", "Can't find Elf64 Symbol",
+                [&elf]() { elf.getSymbolIndex("dynSymbol_0"); });
+    assertCLRXException(testName, "noDynSymbol2", "Can't find Elf64 DynSymbol",
+                [&elf]() { elf.getDynSymbolIndex("symbol0"); });
+}
+
+static void testElfLookupThreads()
+{
+    const size_t symbolsNum = 2000;
+    std::vector<std::string> symNames, dynSymNames;
+    Array<cxbyte> binary = generateElfBinary(symbolsNum, symNames, dynSymNames);
+    // name indices are built at first lookup by one of the threads
+    ElfBinary64 elf(binary.size(), binary.data(), 0);
+    const cxuint threadsNum = 8;
+    size_t failures[threadsNum] = { };
+    std::vector<std::thread> threads;
+    for (cxuint t = 0; t < threadsNum; t++)
+        threads.push_back(std::thread([&elf, &symNames, &failures, symbolsNum, t]()
+        {
+            try
+            {
+                if (elf.getSectionIndex(".text") != 1)
+                    failures[t]++;
+                for (size_t i = 0; i < symbolsNum; i++)
+                    if (elf.getSymbolIndex(symNames[(i+t*97)%symbolsNum].c_str()) !=
+                                (i+t*97)%symbolsNum+1)
+                        failures[t]++;
+            }
+            catch(...)
+            { failures[t]++; }
+        }));
+    for (std::thread& thread: threads)
+        thread.join();
+    for (cxuint t = 0; t < threadsNum; t++)
+        assertValue("ElfLookupThreads", "failures#" + std::to_string(t),
+                    size_t(0), failures[t]);
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    retVal |= callTest(testElfLookup, 1);
+    retVal |= callTest(testElfLookup, 10);
+    retVal |= callTest(testElfLookup, 3000);
+    retVal |= callTest(testElfLookupThreads);
+    return retVal;
+}
@@ -1340,6 +1340,24 @@ Kernels:
 )ffDXD",
         { },
         false, "8: Expected value of string type"
+    },
+    {   // test 13 - value with null character (error)
+        R"ffDXD(---
+Version:         [ 1, 0 ]
+Kernels:         
+  - Name:            vectorAdd
+    SymbolName:      'vectorAdd@kd'
+    Args:            
+      - Name:            a
+        TypeName:        'float*'
+        Size:            8
+        Align:           8
+        ValueKind:       "GlobalBuffer\0"
+        ValueType:       F32
+        AddrSpaceQual:   Global
+)ffDXD",
+        { },
+        false, "11: Wrong argument value kind"
     }
 };
 
@@ -1438,6 +1438,102 @@ static void testMsgPackSkip()
     }
 }
 
+static void testMsgPackStringRef()
+{
+    // map: { "key": "value", "arr": [ "ab", "" ] }
+    const cxbyte tc0[] = { 0x82, 0xa3, 'k', 'e', 'y', 0xd9, 5, 'v', 'a', 'l', 'u', 'e',
+            0xa3, 'a', 'r', 'r', 0x92, 0xa2, 'a', 'b', 0xa0 };
+    const cxbyte* dataPtr = tc0;
+    {
+        MsgPackMapParser mapParser(dataPtr, dataPtr + sizeof(tc0));
+        MsgPackStringRef key = mapParser.parseKeyStringRef();
+        assertTrue("MsgPackStringRef", "tc0.key", key == "key");
+        assertTrue("MsgPackStringRef", "tc0.keyPtr",
+                    key.ptr == reinterpret_cast<const char*>(tc0 + 2));
+        MsgPackStringRef value = mapParser.parseValueStringRef();
+        assertValue("MsgPackStringRef", "tc0.value", std::string("value"),
+                    value.toString());
+        assertTrue("MsgPackStringRef", "tc0.valuePtr",
+                    value.ptr == reinterpret_cast<const char*>(tc0 + 7));
+        key = mapParser.parseKeyStringRef();
+        assertTrue("MsgPackStringRef", "tc0.key2", key == "arr" && key != "ar");
+        MsgPackArrayParser arrParser = mapParser.parseValueArray();
+        assertTrue("MsgPackStringRef", "tc0.elem0", arrParser.parseStringRef() == "ab");
+        assertTrue("MsgPackStringRef", "tc0.elem1", arrParser.parseStringRef().empty());
+        assertValue("MsgPackStringRef", "tc0.DataPtr", dataPtr, tc0 + sizeof(tc0));
+    }
+    // truncated string
+    dataPtr = tc0;
+    {
+        MsgPackMapParser mapParser(dataPtr, dataPtr + 10);
+        mapParser.parseKeyStringRef();
+        assertCLRXException("MsgPackStringRef", "tc1", "MsgPack: Can't parse string",
+                    [&mapParser]() { mapParser.parseValueStringRef(); });
+    }
+    // skip elements of array
+    const cxbyte tc2[] = { 0x93, 0x81, 0xa1, 'a', 0x91, 0xc0, 0xcd, 1, 2, 0xa1, 'x' };
+    dataPtr = tc2;
+    {
+        MsgPackArrayParser arrParser(dataPtr, dataPtr + sizeof(tc2));
+        arrParser.skipElement();
+        arrParser.skipElement();
+        assertTrue("MsgPackStringRef", "tc2.elem2", arrParser.parseStringRef() == "x");
+        assertTrue("MsgPackStringRef", "tc2.noElems", !arrParser.haveElements());
+    }
+}
+
+static void testMsgPackSkipDeep()
+{
+    // very deeply nested arrays and maps: { nil: [ { nil: [ ... nil ] } ] }
+    const size_t depth = 500000;
+    Array<cxbyte> tc0(2 + depth*3 + 1);
+    tc0[0] = 0x81;
+    tc0[1] = 0xc0;
+    for (size_t i = 0; i < depth; i++)
+    {
+        tc0[2+i*3] = 0x91;
+        tc0[2+i*3+1] = 0x81;
+        tc0[2+i*3+2] = 0xc0;
+    }
+    tc0[tc0.size()-1] = 0xc0;
+    const cxbyte* dataPtr = tc0.data();
+    {
+        MsgPackMapParser mapParser(dataPtr, dataPtr + tc0.size());
+        mapParser.parseKeyNil();
+        mapParser.skipValue();
+        const cxbyte* dataEnd = tc0.end();
+        assertValue("MsgPackSkipDeep", "tc0.DataPtr", dataPtr, dataEnd);
+    }
+    dataPtr = tc0.data();
+    {
+        MsgPackMapParser mapParser(dataPtr, dataPtr + tc0.size()-1);
+        mapParser.parseKeyNil();
+        assertCLRXException("MsgPackSkipDeep", "tc0_1", "MsgPack: Can't skip object",
+                    [&mapParser]() { mapParser.skipValue(); });
+    }
+    // array with too many elements for data
+    const cxbyte tc1[] = { 0x81, 0xc0, 0xdd, 0xff, 0xff, 0xff, 0xff, 0xc0, 0xc0 };
+    dataPtr = tc1;
+    {
+        MsgPackMapParser mapParser(dataPtr, dataPtr + sizeof(tc1));
+        mapParser.parseKeyNil();
+        assertCLRXException("MsgPackSkipDeep", "tc1", "MsgPack: Can't skip object",
+                    [&mapParser]() { mapParser.skipValue(); });
+    }
+    // map end after parsed key skips only rest of map
+    const cxbyte tc2[] = { 0x92, 0x82, 0xc0, 0x91, 0xc0, 0xc2, 0xc3, 0xa1, 'z' };
+    dataPtr = tc2;
+    {
+        MsgPackArrayParser arrParser(dataPtr, dataPtr + sizeof(tc2));
+        {
+            MsgPackMapParser mapParser = arrParser.parseMap();
+            mapParser.parseKeyNil();
+            mapParser.end();
+        }
+        assertTrue("MsgPackSkipDeep", "tc2.elem1", arrParser.parseStringRef() == "z");
+    }
+}
+
 struct ROCmMsgPackMDTestCase
 {
     size_t inputSize;
@@ -2407,11 +2503,60 @@ static void testParseROCmMsgPackMDCase(cxuint testId, const ROCmMsgPackMDTestCas
     }
 };
 
+// parse single kernels and compare with metadata parsed by parseMsgPack
+static void testParseROCmMsgPackKernelCase(cxuint testId,
+                const ROCmMsgPackMDTestCase& testCase)
+{
+    if (!testCase.good)
+        return;
+    char testName[40];
+    snprintf(testName, 40, "KernelTest #%u", testId);
+    ROCmMetadata metadata{};
+    metadata.parseMsgPack(testCase.inputSize, testCase.input);
+    for (const ROCmKernelMetadata& expKernel: metadata.kernels)
+    {
+        const std::string caseName = std::string(expKernel.name.c_str()) + ".";
+        ROCmKernelMetadata resKernel{};
+        assertTrue(testName, caseName+"found", parseROCmKernelMetadataMsgPack(
+                testCase.inputSize, testCase.input, expKernel.name.c_str(), resKernel));
+        assertValue(testName, caseName+"name", expKernel.name, resKernel.name);
+        assertValue(testName, caseName+"symbolName",
+                    expKernel.symbolName, resKernel.symbolName);
+        assertValue(testName, caseName+"argsNum",
+                    expKernel.argInfos.size(), resKernel.argInfos.size());
+        for (size_t j = 0; j < expKernel.argInfos.size(); j++)
+        {
+            const ROCmKernelArgInfo& expArgInfo = expKernel.argInfos[j];
+            const ROCmKernelArgInfo& resArgInfo = resKernel.argInfos[j];
+            assertValue(testName, caseName+"argName", expArgInfo.name, resArgInfo.name);
+            assertValue(testName, caseName+"argOffset",
+                        expArgInfo.offset, resArgInfo.offset);
+            assertValue(testName, caseName+"argValueKind",
+                        cxuint(expArgInfo.valueKind), cxuint(resArgInfo.valueKind));
+        }
+        assertValue(testName, caseName+"language", expKernel.language, resKernel.language);
+        assertValue(testName, caseName+"kernargSegmentSize",
+                    expKernel.kernargSegmentSize, resKernel.kernargSegmentSize);
+        assertValue(testName, caseName+"sgprsNum", expKernel.sgprsNum, resKernel.sgprsNum);
+        assertValue(testName, caseName+"vgprsNum", expKernel.vgprsNum, resKernel.vgprsNum);
+        assertValue(testName, caseName+"wavefrontSize",
+                    expKernel.wavefrontSize, resKernel.wavefrontSize);
+    }
+    ROCmKernelMetadata resKernel{};
+    assertTrue(testName, "notFound", !parseROCmKernelMetadataMsgPack(
+                testCase.inputSize, testCase.input, "xxxunknown", resKernel));
+}
+
 int main(int argc, const char** argv)
 {
     int retVal = 0;
     retVal |= callTest(testMsgPackBytes);
     retVal |= callTest(testMsgPackSkip);
+    retVal |= callTest(testMsgPackStringRef);
+    retVal |= callTest(testMsgPackSkipDeep);
+    for (cxuint i = 0; i < sizeof(rocmMsgPackMDTestCases)/
+                            sizeof(ROCmMsgPackMDTestCase); i++)
+        retVal |= callTest(testParseROCmMsgPackKernelCase, i, rocmMsgPackMDTestCases[i]);
     for (cxuint i = 0; i < sizeof(rocmMsgPackMDTestCases)/
                             sizeof(ROCmMsgPackMDTestCase); i++)
         try
@@ -102,6 +102,9 @@ gpuDeviceEntryTable[] =
     { "Gfx905", GPUDeviceType::GFX905 },
     { "Gfx906", GPUDeviceType::GFX906 },
     { "Gfx907", GPUDeviceType::GFX907 },
+    { "GFx1000", GPUDeviceType::GFX1000 },
+    { "gfX1010", GPUDeviceType::GFX1010 },
+    { "gFX1011", GPUDeviceType::GFX1011 },
     { "goOSe", GPUDeviceType::GOOSE },
     { "hAINAn", GPUDeviceType::HAINAN },
     { "hAWaII", GPUDeviceType::HAWAII },
@@ -0,0 +1,149 @@
+/*
+ *  CLRadeonExtender - Unofficial OpenCL Radeon Extensions Library
+ *  Copyright (C) 2014-2018 Mateusz Szpakowski
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2.1 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <CLRX/Config.h>
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <CLRX/utils/InputOutput.h>
+#include "../TestUtils.h"
+
+using namespace CLRX;
+
+// fill some data with simple pattern
+static std::vector<char> makePattern(size_t size, cxuint seed)
+{
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = char((i*7 + seed*13) ^ (i>>8));
+    return data;
+}
+
+// write data by given output buffer: small objects, big array, fill and single chars
+static void writeByFastOutputBuffer(FastOutputBuffer& fob,
+            const std::vector<char>& bigData, std::vector<char>& expected)
+{
+    const uint32_t value = 0x12345678U;
+    fob.writeObject(value);
+    expected.insert(expected.end(), reinterpret_cast<const char*>(&value),
+                reinterpret_cast<const char*>(&value)+4);
+    fob.writeString("ala ma kota");
+    const char* str = "ala ma kota";
+    expected.insert(expected.end(), str, str+::strlen(str));
+    fob.writeArray(bigData.size(), bigData.data());
+    expected.insert(expected.end(), bigData.begin(), bigData.end());
+    fob.fill(1000, 'x');
+    expected.insert(expected.end(), 1000, 'x');
+    for (cxuint i = 0; i < 300; i++)
+    {
+        fob.put(char(i));
+        expected.push_back(char(i));
+    }
+    char* buf = fob.reserve(10);
+    ::memcpy(buf, "0123456789", 10);
+    fob.forward(10);
+    expected.insert(expected.end(), buf, buf+10);
+}
+
+static void testFastOutputBufferMemory()
+{
+    const std::vector<char> bigData = makePattern(5000, 1);
+    std::vector<char> expected;
+    std::vector<char> output(4+11+5000+1000+300+10);
+    {
+        FastOutputBuffer fob(output.size(), output.data());
+        assertTrue("FastOutputBufferMemory", "isMemoryOutput", fob.isMemoryOutput());
+        writeByFastOutputBuffer(fob, bigData, expected);
+        assertValue("FastOutputBufferMemory", "written", uint64_t(output.size()),
+                    fob.getWritten());
+    }
+    assertTrue("FastOutputBufferMemory", "content", expected == output);
+
+    // writing beyond output memory
+    std::vector<char> smallOutput(100);
+    FastOutputBuffer fob(smallOutput.size(), smallOutput.data());
+    fob.fill(96, 'a');
+    assertCLRXException("FastOutputBufferMemory", "tooSmall",
+            "Output memory is too small", [&fob]() { fob.writeObject(uint64_t(1)); });
+}
+
+static void testFastOutputBufferStream()
+{
+    const std::vector<char> bigData = makePattern(5000, 2);
+    std::vector<char> expected;
+    std::ostringstream oss;
+    {
+        FastOutputBuffer fob(256, oss);
+        assertTrue("FastOutputBufferStream", "isMemoryOutput", !fob.isMemoryOutput());
+        writeByFastOutputBuffer(fob, bigData, expected);
+    }
+    const std::string result = oss.str();
+    assertTrue("FastOutputBufferStream", "content",
+            std::vector<char>(result.begin(), result.end()) == expected);
+}
+
+static void testFileOStream()
+{
+    const char* filename = "OutputBuffersTest.tmp";
+    const std::vector<char> bigData = makePattern(100000, 3);
+    std::vector<char> expected;
+    {
+        // small buffer to check writing big data without buffering
+        FileOStream fos(filename, 4096);
+        assertTrue("FileOStream", "isOpen", fos.isOpen() && bool(fos));
+        fos.write("abc", 3);
+        expected.insert(expected.end(), "abc", "abc"+3);
+        for (cxuint i = 0; i < 5000; i++)
+        {
+            fos.put(char(i*3));
+            expected.push_back(char(i*3));
+        }
+        fos.write(bigData.data(), bigData.size());
+        expected.insert(expected.end(), bigData.begin(), bigData.end());
+        fos.write(bigData.data(), 3000);
+        expected.insert(expected.end(), bigData.begin(), bigData.begin()+3000);
+        fos << "end" << 123;
+        expected.insert(expected.end(), "end123", "end123"+6);
+        fos.close();
+        assertTrue("FileOStream", "afterClose", bool(fos));
+    }
+    std::ifstream ifs(filename, std::ios::binary);
+    const std::vector<char> result((std::istreambuf_iterator<char>(ifs)),
+                std::istreambuf_iterator<char>());
+    ifs.close();
+    std::remove(filename);
+    assertValue("FileOStream", "size", expected.size(), result.size());
+    assertTrue("FileOStream", "content", expected == result);
+
+    FileOStream badFos("nonexistent-dir/OutputBuffersTest.tmp");
+    assertTrue("FileOStream", "notOpened", !badFos.isOpen() && !badFos);
+}
+
+int main(int argc, const char** argv)
+{
+    int retVal = 0;
+    retVal |= callTest(testFastOutputBufferMemory);
+    retVal |= callTest(testFastOutputBufferStream);
+    retVal |= callTest(testFileOStream);
+    return retVal;
+}
@@ -83,7 +83,7 @@ lowerCaseGpuDeviceEntryTable[] =
     { "fiji", GPUDeviceType::FIJI },
     { "gfx1000", GPUDeviceType::GFX1000 },
     { "gfx1010", GPUDeviceType::GFX1010 },
-    { "gfx1011", GPUDeviceType::GFX1010 },
+    { "gfx1011", GPUDeviceType::GFX1011 },
     { "gfx700", GPUDeviceType::SPECTRE },
     { "gfx701", GPUDeviceType::HAWAII },
     { "gfx801", GPUDeviceType::CARRIZO },
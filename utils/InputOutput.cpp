@@ -18,7 +18,16 @@
  */
 
 #include <CLRX/Config.h>
+#ifdef HAVE_WINDOWS
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+#include <fcntl.h>
+#include <sys/stat.h>
 #include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <climits>
 #include <string>
@@ -292,3 +301,159 @@ VectorIOStream::VectorIOStream(std::vector<char>& vector)
 {
     rdbuf(&buffer);
 }
+
+/*
+ * file output stream buffer
+ */
+
+FileOutStreamBuf::FileOutStreamBuf(const char* filename, size_t _bufSize)
+        : fd(-1), bufSize(_bufSize), buffer(new char[_bufSize])
+{
+#ifdef HAVE_WINDOWS
+    fd = ::_open(filename, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                 _S_IREAD | _S_IWRITE);
+#else
+    fd = ::open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+#endif
+    setp(buffer.get(), buffer.get() + bufSize);
+}
+
+FileOutStreamBuf::~FileOutStreamBuf()
+{
+    close();
+}
+
+bool FileOutStreamBuf::close()
+{
+    if (fd < 0)
+        return true;
+    bool good = (sync() == 0);
+#ifdef HAVE_WINDOWS
+    good &= (::_close(fd) == 0);
+#else
+    good &= (::close(fd) == 0);
+#endif
+    fd = -1;
+    return good;
+}
+
+// write whole data (repeat writing if partially written)
+bool FileOutStreamBuf::writeAll(const char* data, size_t size)
+{
+    while (size != 0)
+    {
+#ifdef HAVE_WINDOWS
+        const int ret = ::_write(fd, data, unsigned(std::min(size, size_t(INT_MAX))));
+#else
+        const ssize_t ret = ::write(fd, data, size);
+#endif
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+// write two data chunks (buffered data and big data) by single vectored write
+bool FileOutStreamBuf::writeAll2(const char* data1, size_t size1,
+            const char* data2, size_t size2)
+{
+#ifndef HAVE_WINDOWS
+    while (size1 != 0)
+    {
+        struct iovec iov[2] = { { const_cast<char*>(data1), size1 },
+                { const_cast<char*>(data2), size2 } };
+        const ssize_t ret = ::writev(fd, iov, 2);
+        if (ret < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        if (size_t(ret) >= size1)
+        {
+            // first chunk has been written, rest of second chunk will be written later
+            data2 += size_t(ret) - size1;
+            size2 -= size_t(ret) - size1;
+            size1 = 0;
+        }
+        else
+        {
+            data1 += ret;
+            size1 -= ret;
+        }
+    }
+#else
+    if (!writeAll(data1, size1))
+        return false;
+#endif
+    return writeAll(data2, size2);
+}
+
+std::streambuf::int_type FileOutStreamBuf::overflow(std::streambuf::int_type ch)
+{
+    if (fd < 0 || !writeAll(pbase(), pptr()-pbase()))
+        return traits_type::eof();
+    setp(buffer.get(), buffer.get() + bufSize);
+    if (traits_type::eq_int_type(ch, traits_type::eof()))
+        return traits_type::not_eof(ch);
+    *pptr() = traits_type::to_char_type(ch);
+    pbump(1);
+    return ch;
+}
+
+std::streamsize FileOutStreamBuf::xsputn(const char_type* s, std::streamsize n)
+{
+    if (fd < 0)
+        return 0;
+    const size_t size = n;
+    if (size <= size_t(epptr()-pptr()))
+    {
+        // just put to buffer
+        ::memcpy(pptr(), s, size);
+        pbump(int(size));
+        return n;
+    }
+    if (size < bufSize)
+    {
+        // write out buffer and put data to buffer
+        if (!writeAll(pbase(), pptr()-pbase()))
+            return 0;
+        setp(buffer.get(), buffer.get() + bufSize);
+        ::memcpy(pptr(), s, size);
+        pbump(int(size));
+        return n;
+    }
+    // big data: write buffered data and this data without copying
+    if (!writeAll2(pbase(), pptr()-pbase(), s, size))
+        return 0;
+    setp(buffer.get(), buffer.get() + bufSize);
+    return n;
+}
+
+int FileOutStreamBuf::sync()
+{
+    if (fd < 0 || !writeAll(pbase(), pptr()-pbase()))
+        return -1;
+    setp(buffer.get(), buffer.get() + bufSize);
+    return 0;
+}
+
+FileOStream::FileOStream(const char* filename, size_t bufSize)
+        : std::ostream(nullptr), buffer(filename, bufSize)
+{
+    rdbuf(&buffer);
+    if (!buffer.isOpen())
+        setstate(std::ios::failbit);
+}
+
+void FileOStream::close()
+{
+    if (!buffer.close())
+        setstate(std::ios::badbit);
+}